@@ -88,6 +88,16 @@ int config::voice::clientConnectLimit;
 bool config::voice::notifyMuted;
 bool config::voice::suppress_myts_warnings;
 bool config::voice::allow_session_reinitialize;
+size_t config::voice::receive_batch_size;
+size_t config::voice::send_batch_size;
+bool config::voice::send_gso;
+size_t config::voice::socket_shards;
+std::string config::voice::io_backend;
+size_t config::voice::io_uring_queue_depth;
+size_t config::voice::flood_source_rate;
+size_t config::voice::flood_source_burst;
+size_t config::voice::flood_prefix_rate;
+size_t config::voice::flood_prefix_burst;
 
 std::string config::query::motd;
 std::string config::query::newlineCharacter;
@@ -124,6 +134,7 @@ size_t config::threads::ticking;
 size_t config::threads::command_execute;
 size_t config::threads::network_events;
 size_t config::threads::voice::events_per_server;
+size_t config::threads::voice::encrypt;
 size_t config::threads::music::execute_limit;
 size_t config::threads::music::execute_per_bot;
 std::string config::messages::teamspeak_permission_editor;
@@ -144,6 +155,7 @@ std::string config::log::path;
 spdlog::level::level_enum config::log::terminalLevel;
 spdlog::level::level_enum config::log::logfileLevel;
 bool config::log::logfileColored;
+size_t config::log::slow_command_threshold;
 
 std::string config::geo::countryFlag;
 std::string config::geo::mappingFile;
@@ -156,6 +168,10 @@ std::string config::geo::vpn_file;
 std::string config::crash_path = ".";
 
 bool config::music::enabled;
+
+bool config::metrics::enabled;
+std::string config::metrics::host;
+uint16_t config::metrics::port;
 std::string config::music::command_prefix;
 
 //Parse stuff
@@ -1071,6 +1087,14 @@ std::deque<std::shared_ptr<EntryBinding>> config::create_bindings() {
             BIND_STRING(config::log::path, "logs/log_${time}(%Y-%m-%d_%H:%M:%S)_${group}.log");
             ADD_DESCRIPTION("The log file path");
         }
+        {
+            CREATE_BINDING("slow_command_threshold", FLAG_RELOADABLE);
+            BIND_INTEGRAL(config::log::slow_command_threshold, 10, 0, 3600000);
+            ADD_DESCRIPTION("Log a warning for every command which took longer than the given amount of milliseconds to execute");
+            ADD_DESCRIPTION("Commands which took ten times longer will be logged as error. A value of 0 disables the slow command log.");
+            ADD_NOTE("Use the terminal command \"commandstats\" to list the most expensive commands.");
+            ADD_NOTE_RELOADABLE();
+        }
     }
     {
         BIND_GROUP(binding);
@@ -1192,6 +1216,80 @@ std::deque<std::shared_ptr<EntryBinding>> config::create_bindings() {
             ADD_DESCRIPTION("Enable/disable fast session reinitialisation.");
             ADD_SENSITIVE();
         }
+        {
+            CREATE_BINDING("network.receive_batch_size", 0);
+            BIND_INTEGRAL(config::voice::receive_batch_size, 1, 1, 1024);
+            ADD_DESCRIPTION("Max number of datagrams received with one system call (recvmmsg).");
+            ADD_DESCRIPTION("A value of 1 uses the classic one datagram per recvmsg read loop.");
+            ADD_NOTE("Every network event of a voice server binding preallocates receive_batch_size * 2KB of receive buffers.");
+            ADD_SENSITIVE();
+        }
+        {
+            CREATE_BINDING("network.send_batch_size", 0);
+            BIND_INTEGRAL(config::voice::send_batch_size, 1, 1, 1024);
+            ADD_DESCRIPTION("Max number of datagrams collected from all pending clients and send with one system call (sendmmsg).");
+            ADD_DESCRIPTION("A value of 1 uses the classic one datagram per sendmsg write loop.");
+            ADD_SENSITIVE();
+        }
+        {
+            CREATE_BINDING("network.send_gso", 0);
+            BIND_BOOL(config::voice::send_gso, true);
+            ADD_DESCRIPTION("Send runs of packets to the same client as one UDP GSO (UDP_SEGMENT) message.");
+            ADD_DESCRIPTION("Requires Linux 4.18 or newer and only applies if network.send_batch_size is greater than 1.");
+            ADD_NOTE("GSO will be disabled automatically if the kernel or network interface does not support it.");
+            ADD_SENSITIVE();
+        }
+        {
+            CREATE_BINDING("network.socket_shards", 0);
+            BIND_INTEGRAL(config::voice::socket_shards, 0, 0, 128);
+            ADD_DESCRIPTION("Number of SO_REUSEPORT sockets per voice server binding. Every socket is pinned to its own network event loop.");
+            ADD_DESCRIPTION("Incoming datagrams are steered by a BPF program based on the remote address, so a client is always handled by the same thread.");
+            ADD_DESCRIPTION("A value of 0 or 1 uses one shared socket for all network events (see threads.voice.events_per_server).");
+            ADD_NOTE("The value is capped by the number of network event loops (threads.network_events).");
+            ADD_SENSITIVE();
+        }
+        {
+            CREATE_BINDING("network.io_backend", 0);
+            BIND_STRING(config::voice::io_backend, "libevent");
+            ADD_DESCRIPTION("The backend used for the voice UDP traffic. Available: libevent, io_uring");
+            ADD_DESCRIPTION("io_uring uses a multishot receive into a provided buffer ring and batched send submissions.");
+            ADD_NOTE("io_uring requires Linux 6.0 or newer and a server build with io_uring support. Otherwise libevent will be used.");
+            ADD_SENSITIVE();
+        }
+        {
+            CREATE_BINDING("network.io_uring_queue_depth", 0);
+            BIND_INTEGRAL(config::voice::io_uring_queue_depth, 1024, 64, 32768);
+            ADD_DESCRIPTION("Submission queue size, receive buffers and send slots per network event when using io_uring.");
+            ADD_NOTE("The value will be rounded up to the next power of two. Every network event preallocates queue_depth * 2KB of receive buffers.");
+            ADD_SENSITIVE();
+        }
+        {
+            CREATE_BINDING("network.flood_source_rate", 0);
+            BIND_INTEGRAL(config::voice::flood_source_rate, 500, 0, 1000000);
+            ADD_DESCRIPTION("Max datagrams per second accepted from one remote address before the target client gets looked up.");
+            ADD_DESCRIPTION("A value of 0 disables the flood filter.");
+            ADD_NOTE("The limits apply per network event. Without socket sharding the datagrams of one address may be spread over multiple network events.");
+            ADD_SENSITIVE();
+        }
+        {
+            CREATE_BINDING("network.flood_source_burst", 0);
+            BIND_INTEGRAL(config::voice::flood_source_burst, 1000, 1, 1000000);
+            ADD_DESCRIPTION("Max datagrams accepted from one remote address at once.");
+            ADD_SENSITIVE();
+        }
+        {
+            CREATE_BINDING("network.flood_prefix_rate", 0);
+            BIND_INTEGRAL(config::voice::flood_prefix_rate, 20000, 0, 1000000);
+            ADD_DESCRIPTION("Max datagrams per second accepted from all addresses of one /24 (IPv4) or /64 (IPv6) network.");
+            ADD_DESCRIPTION("A value of 0 disables the network limit.");
+            ADD_SENSITIVE();
+        }
+        {
+            CREATE_BINDING("network.flood_prefix_burst", 0);
+            BIND_INTEGRAL(config::voice::flood_prefix_burst, 40000, 1, 1000000);
+            ADD_DESCRIPTION("Max datagrams accepted from all addresses of one /24 (IPv4) or /64 (IPv6) network at once.");
+            ADD_SENSITIVE();
+        }
         {
             CREATE_BINDING("rsa.puzzle_pool_size", 0);
             BIND_INTEGRAL(config::voice::DefaultPuzzlePrecomputeSize, 128, 1, 65536);
@@ -1627,6 +1725,27 @@ std::deque<std::shared_ptr<EntryBinding>> config::create_bindings() {
             ADD_DESCRIPTION("Enable/disable the music bots");
         }
     }
+    {
+        BIND_GROUP(metrics)
+        {
+            CREATE_BINDING("enabled", 0);
+            BIND_BOOL(config::metrics::enabled, false);
+            ADD_DESCRIPTION("Enable/disable the OpenMetrics endpoint (GET /metrics)");
+            ADD_DESCRIPTION("Exports latency histograms of the server ticks, commands, packet encryption, network event loops and database statements.");
+        }
+        {
+            CREATE_BINDING("host", 0);
+            BIND_STRING(config::metrics::host, "127.0.0.1");
+            ADD_DESCRIPTION("The address the metrics endpoint will be bound to");
+            ADD_NOTE("Multibinding supported here! Host delimiter is \",\"");
+            ADD_NOTE("The endpoint has no authentication. Only expose it to your monitoring system!");
+        }
+        {
+            CREATE_BINDING("port", 0);
+            BIND_INTEGRAL(config::metrics::port, 9102, 1, 65535);
+            ADD_DESCRIPTION("The port of the metrics endpoint");
+        }
+    }
     {
         BIND_GROUP(messages);
         {
@@ -1842,6 +1961,14 @@ std::deque<std::shared_ptr<EntryBinding>> config::create_bindings() {
                 ADD_DESCRIPTION("This value is upper bound to threads.network_events and should not exceed it.");
                 ADD_SENSITIVE();
             }
+            {
+                CREATE_BINDING("encrypt", 0);
+                BIND_INTEGRAL(config::threads::voice::encrypt, 0, 0, 64);
+                ADD_DESCRIPTION("Workers encrypting the outgoing voice client packets.");
+                ADD_DESCRIPTION("A value of 0 encrypts the packets within the network event loops right before sending them.");
+                ADD_NOTE("Enabling the workers takes the AES work off the network event loops.");
+                ADD_SENSITIVE();
+            }
         }
     }
     return _create_bindings = result;
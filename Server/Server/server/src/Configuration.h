@@ -140,6 +140,18 @@ namespace ts::config {
 
         extern bool warn_on_permission_editor;
         extern bool allow_session_reinitialize;
+
+        extern size_t receive_batch_size;
+        extern size_t send_batch_size;
+        extern bool send_gso;
+        extern size_t socket_shards;
+        extern std::string io_backend;
+        extern size_t io_uring_queue_depth;
+
+        extern size_t flood_source_rate;
+        extern size_t flood_source_burst;
+        extern size_t flood_prefix_rate;
+        extern size_t flood_prefix_burst;
     }
 
     namespace geo {
@@ -170,6 +182,12 @@ namespace ts::config {
         extern std::string command_prefix;
     }
 
+    namespace metrics {
+        extern bool enabled;
+        extern std::string host;
+        extern uint16_t port;
+    }
+
     namespace messages {
         extern std::string serverStopped;
         extern std::string applicationStopped;
@@ -235,6 +253,7 @@ namespace ts::config {
 
         namespace voice {
             extern size_t events_per_server;
+            extern size_t encrypt;
         }
 
         namespace music {
@@ -249,6 +268,9 @@ namespace ts::config {
         extern spdlog::level::level_enum logfileLevel;
         extern bool logfileColored;
         extern spdlog::level::level_enum terminalLevel;
+
+        /* milliseconds, 0 to disable */
+        extern size_t slow_command_threshold;
     }
 
     extern std::string crash_path;
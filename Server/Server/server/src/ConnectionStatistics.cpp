@@ -20,24 +20,69 @@ ConnectionStatistics::ConnectionStatistics(shared_ptr<ConnectionStatistics> hand
 
 ConnectionStatistics::~ConnectionStatistics() {
     memtrack::freed<ConnectionStatistics>(this);
+
+    if(this->handle) {
+        /* Don't lose the packets since the last tick */
+        BandwidthEntry<uint64_t> remaining{};
+        for(size_t index{0}; index < 3; index++) {
+            remaining.connection_packets_sent[index] = this->statistics_second_current.connection_packets_sent[index];
+            remaining.connection_bytes_sent[index] = this->statistics_second_current.connection_bytes_sent[index];
+            remaining.connection_packets_received[index] = this->statistics_second_current.connection_packets_received[index];
+            remaining.connection_bytes_received[index] = this->statistics_second_current.connection_bytes_received[index];
+        }
+        this->collect_shards(remaining);
+        this->handle->roll_up(remaining);
+    }
+}
+
+namespace {
+    std::atomic<size_t> shard_counter{0};
+
+    inline size_t shard_index() {
+        thread_local size_t index{shard_counter.fetch_add(1, std::memory_order_relaxed) % ConnectionStatistics::kShardCount};
+        return index;
+    }
+
+    inline void shard_increment(std::atomic<uint64_t>& counter, uint64_t value) {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
 }
 
+/*
+ * The hot path only touches the shard of the calling thread.
+ * Our parents (virtual server and instance) receive the counters when we're ticking (see roll_up).
+ */
 void ConnectionStatistics::logIncomingPacket(const category::value &category, size_t size) {
     assert(category >= 0 && category <= 2);
-    this->statistics_second_current.connection_bytes_received[category] += size;
-    this->statistics_second_current.connection_packets_received[category] += 1;
-
-    if(this->handle)
-        this->handle->logIncomingPacket(category, size);
+    auto& shard = this->shards[shard_index()];
+    shard_increment(shard.bytes_received[category], size);
+    shard_increment(shard.packets_received[category], 1);
 }
 
 void ConnectionStatistics::logOutgoingPacket(const category::value &category, size_t size) {
     assert(category >= 0 && category <= 2);
-    this->statistics_second_current.connection_bytes_sent[category] += size;
-    this->statistics_second_current.connection_packets_sent[category] += 1;
+    auto& shard = this->shards[shard_index()];
+    shard_increment(shard.bytes_sent[category], size);
+    shard_increment(shard.packets_sent[category], 1);
+}
 
-    if(this->handle) {
-        this->handle->logOutgoingPacket(category, size);
+void ConnectionStatistics::collect_shards(BandwidthEntry<uint64_t> &target) {
+    for(auto& shard : this->shards) {
+        for(size_t index{0}; index < 3; index++) {
+            target.connection_packets_sent[index] += shard.packets_sent[index].exchange(0, std::memory_order_relaxed);
+            target.connection_bytes_sent[index] += shard.bytes_sent[index].exchange(0, std::memory_order_relaxed);
+            target.connection_packets_received[index] += shard.packets_received[index].exchange(0, std::memory_order_relaxed);
+            target.connection_bytes_received[index] += shard.bytes_received[index].exchange(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void ConnectionStatistics::roll_up(const BandwidthEntry<uint64_t> &child) {
+    for(size_t index{0}; index < 3; index++) {
+        this->statistics_second_current.connection_packets_sent[index] += child.connection_packets_sent[index];
+        this->statistics_second_current.connection_bytes_sent[index] += child.connection_bytes_sent[index];
+        this->statistics_second_current.connection_packets_received[index] += child.connection_packets_received[index];
+        this->statistics_second_current.connection_bytes_received[index] += child.connection_bytes_received[index];
     }
 }
 
@@ -62,9 +107,15 @@ void ConnectionStatistics::tick() {
     auto now = std::chrono::system_clock::now();
     auto time_difference = this->last_second_tick.time_since_epoch().count() > 0 ? now - this->last_second_tick : std::chrono::seconds{1};
     if(time_difference >= std::chrono::seconds{1}) {
-        BandwidthEntry<uint32_t> current{};
+        BandwidthEntry<uint64_t> current{};
         current.atomic_exchange(this->statistics_second_current);
 
+        this->collect_shards(current);
+        if(this->handle) {
+            /* Forwards our packets and the packets rolled up from our children. File transfers are already accounted by the parent. */
+            this->handle->roll_up(current);
+        }
+
         auto period_ms = std::chrono::floor<std::chrono::milliseconds>(time_difference).count();
         auto current_normalized = current.mul<long double>(1000.0 / period_ms);
 
@@ -128,6 +128,9 @@ namespace ts {
                         return lookup_table[type & 0xFU];
                     }
                 };
+                /* Amount of per thread accumulators every statistics object holds */
+                constexpr static size_t kShardCount{8};
+
                 explicit ConnectionStatistics(std::shared_ptr<ConnectionStatistics>  /* root */);
                 ~ConnectionStatistics();
 
@@ -145,10 +148,30 @@ namespace ts {
                 FileTransferStatistics file_stats();
                 std::pair<uint64_t, uint64_t> mark_file_bytes();
             private:
+                /*
+                 * Packet counters of the current second.
+                 * Every network thread increments its own shard, the tick sums them up.
+                 * Padded to a cache line so threads don't bounce each other's lines.
+                 */
+                struct alignas(64) Shard {
+                    std::array<std::atomic<uint64_t>, 3> packets_sent{};
+                    std::array<std::atomic<uint64_t>, 3> bytes_sent{};
+                    std::array<std::atomic<uint64_t>, 3> packets_received{};
+                    std::array<std::atomic<uint64_t>, 3> bytes_received{};
+                };
+
                 std::shared_ptr<ConnectionStatistics> handle;
 
+                std::array<Shard, kShardCount> shards{};
+
+                /* Collect (and reset) the connection counters of all shards */
+                void collect_shards(BandwidthEntry<uint64_t>& /* target */);
+                /* Add the connection counters of a child to the current second. Called once per child tick. */
+                void roll_up(const BandwidthEntry<uint64_t>& /* child */);
+
                 BandwidthEntry<uint64_t> total_statistics{};
 
+                /* file transfers and the connection counters rolled up from our children */
                 BandwidthEntry<std::atomic<uint64_t>> statistics_second_current{};
                 BandwidthEntry<uint32_t> statistics_second{}; /* will be updated every second by the stats from the "current_second" */
                 std::array<BandwidthEntry<uint32_t>, 60> statistics_minute{};
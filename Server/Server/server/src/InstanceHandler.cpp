@@ -10,6 +10,7 @@
 #include "src/manager/PermissionNameMapper.h"
 #include "./FileServerHandler.h"
 #include "./server/GlobalNetworkEvents.h"
+#include "./server/MetricsServer.h"
 #include <ThreadPool/Timer.h>
 #include "ShutdownHelper.h"
 #include <sys/utsname.h>
@@ -18,6 +19,7 @@
 #include <misc/hex.h>
 #include <misc/rnd.h>
 #include <protocol/buffers.h>
+#include <protocol/CryptHandler.h>
 #include "./groups/GroupManager.h"
 
 #ifndef _POSIX_SOURCE
@@ -52,6 +54,10 @@ InstanceHandler::InstanceHandler(SqlDataManager *sql) : sql(sql) {
         logCritical(LOG_INSTANCE, "Instance task executor received exception: {}", message);
     });
 
+    if(ts::config::threads::voice::encrypt > 0) {
+        this->encrypt_task_executor_ = std::make_shared<task_executor>(ts::config::threads::voice::encrypt, "voice encrypt ");
+    }
+
     this->statistics = make_shared<stats::ConnectionStatistics>(nullptr);
 
     std::string error_message{};
@@ -279,6 +285,24 @@ bool InstanceHandler::startInstance() {
         return false;
     }
 
+    if(metrics::enabled()) {
+        connection::CryptHandler::crypt_timing_callback = [](bool encrypt, std::chrono::nanoseconds duration) {
+            auto& registry = metrics::registry();
+            (encrypt ? registry.packet_encrypt : registry.packet_decrypt).record(duration);
+        };
+        this->getSql()->statement_observer = [](const std::string& sql, std::chrono::nanoseconds duration) {
+            metrics::registry().sql_statement(sql).record(duration);
+        };
+
+        this->metrics_server_ = std::make_unique<MetricsServer>(&*this->network_event_loop_);
+        if(!this->metrics_server_->start(config::metrics::host, config::metrics::port, errorMessage)) {
+            logError(LOG_INSTANCE, "Failed to start the metrics server: {}", errorMessage);
+            this->metrics_server_ = nullptr;
+        } else {
+            logMessage(LOG_INSTANCE, "Metrics server started on {}:{}", config::metrics::host, config::metrics::port);
+        }
+    }
+
     this->permission_mapper = make_shared<permission::PermissionNameMapper>();
     if(!this->permission_mapper->initialize(config::permission_mapping_file, errorMessage)) {
         logCritical(LOG_INSTANCE, "Failed to initialize permission name mapping from file {}: {}", config::permission_mapping_file, errorMessage);
@@ -440,6 +464,12 @@ void InstanceHandler::stopInstance() {
     }
     this->server_command_executor_->shutdown();
 
+    /* The metrics server is accessing the virtual server manager */
+    if(this->metrics_server_) {
+        this->metrics_server_->stop();
+        this->metrics_server_ = nullptr;
+    }
+
     /* TODO: Block on canceling. */
     this->general_task_executor()->cancel_task(this->tick_task_id);
     this->tick_task_id = 0;
@@ -453,6 +483,11 @@ void InstanceHandler::stopInstance() {
     this->voiceServerManager = nullptr;
     debugMessage(LOG_INSTANCE, "All virtual server stopped");
 
+    if(this->encrypt_task_executor_) {
+        this->encrypt_task_executor_->shutdown(std::chrono::system_clock::now() + std::chrono::seconds{5});
+        this->encrypt_task_executor_ = nullptr;
+    }
+
     debugMessage(LOG_QUERY, "Stopping query server");
     if (this->queryServer) this->queryServer->stop();
     delete this->queryServer;
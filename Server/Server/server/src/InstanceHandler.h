@@ -32,6 +32,7 @@ namespace ts {
         }
 
         class NetworkEventLoop;
+        class MetricsServer;
         class ServerCommandExecutor;
         class InstanceHandler;
 
@@ -80,6 +81,8 @@ namespace ts {
                 bool resetMonthlyStats();
 
                 [[nodiscard]] inline const auto& general_task_executor(){ return this->general_task_executor_; }
+                /* Might be null if the voice packets are encrypted within the network event loop */
+                [[nodiscard]] inline const auto& encrypt_task_executor(){ return this->encrypt_task_executor_; }
                 [[nodiscard]] inline const auto& network_event_loop(){ return this->network_event_loop_; }
 
                 [[nodiscard]] inline std::shared_ptr<stats::ConnectionStatistics> getStatistics(){ return statistics; }
@@ -119,6 +122,7 @@ namespace ts {
                 file::FileServerHandler* file_server_handler_{nullptr};
                 std::unique_ptr<log::ActionLogger> action_logger_{nullptr};
                 std::unique_ptr<NetworkEventLoop> network_event_loop_{nullptr};
+                std::unique_ptr<MetricsServer> metrics_server_{nullptr};
 
                 std::shared_ptr<ts::PropertyManager> _properties{};
 
@@ -139,6 +143,7 @@ namespace ts {
                 std::shared_ptr<stats::ConnectionStatistics> statistics = nullptr;
 
                 std::shared_ptr<task_executor> general_task_executor_{nullptr};
+                std::shared_ptr<task_executor> encrypt_task_executor_{nullptr};
 
                 std::shared_ptr<permission::PermissionNameMapper> permission_mapper = nullptr;
                 std::shared_ptr<TeamSpeakLicense> teamspeak_license = nullptr;
@@ -0,0 +1,150 @@
+#include "./LockProfiler.h"
+#include <map>
+#include <memory>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#include <execinfo.h>
+
+using namespace ts;
+using namespace ts::lock_profiler;
+
+thread_local detail::HeldLocks detail::held_locks{};
+
+namespace {
+    struct LockRegistry {
+        std::mutex mutex{};
+        std::map<std::string, std::unique_ptr<LockStatistics>, std::less<>> locks{};
+    };
+
+    /* Never destructed since locks may be used while the static objects are getting destroyed */
+    LockRegistry& lock_registry() {
+        static auto registry = new LockRegistry{};
+        return *registry;
+    }
+
+    std::string demangle(const char* symbol) {
+        int status{0};
+        std::unique_ptr<char, void(*)(void*)> result{abi::__cxa_demangle(symbol, nullptr, nullptr, &status), std::free};
+        return status == 0 && result ? std::string{result.get()} : std::string{symbol};
+    }
+
+    std::string format_offset(uintptr_t offset) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "+0x%zx", (size_t) offset);
+        return std::string{buffer};
+    }
+}
+
+__attribute__((noinline)) CallSite LockStatistics::capture_call_site() {
+    CallSite result{};
+
+    /* The first frame is this function itself */
+    std::array<void*, kCallSiteDepth + 1> frames{};
+    auto frame_count = backtrace(frames.data(), (int) frames.size());
+    for(int index{1}; index < frame_count; index++) {
+        result.frames[index - 1] = frames[index];
+    }
+    return result;
+}
+
+void LockStatistics::record_contention(const CallSite &call_site, const std::chrono::nanoseconds &wait) {
+    std::lock_guard lock{this->call_site_mutex};
+    for(auto& entry : this->call_sites_) {
+        if(entry.frames != call_site.frames) {
+            continue;
+        }
+
+        entry.contentions++;
+        entry.wait_sum += wait.count();
+        return;
+    }
+
+    if(this->call_sites_.size() >= kMaxCallSites) {
+        this->untracked_contentions_++;
+        return;
+    }
+
+    auto& entry = this->call_sites_.emplace_back(call_site);
+    entry.contentions = 1;
+    entry.wait_sum = wait.count();
+}
+
+std::vector<CallSite> LockStatistics::call_sites() {
+    std::vector<CallSite> result{};
+    {
+        std::lock_guard lock{this->call_site_mutex};
+        result = this->call_sites_;
+    }
+
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) { return a.wait_sum > b.wait_sum; });
+    return result;
+}
+
+uint64_t LockStatistics::untracked_contentions() {
+    std::lock_guard lock{this->call_site_mutex};
+    return this->untracked_contentions_;
+}
+
+LockStatistics& lock_profiler::register_lock(const std::string_view &name) {
+    auto& registry = lock_registry();
+
+    std::lock_guard lock{registry.mutex};
+    auto it = registry.locks.find(name);
+    if(it != registry.locks.end()) {
+        return *it->second;
+    }
+
+    auto& statistics = registry.locks[std::string{name}];
+    statistics = std::make_unique<LockStatistics>(std::string{name});
+    return *statistics;
+}
+
+std::vector<LockStatistics*> lock_profiler::registered_locks() {
+    auto& registry = lock_registry();
+
+    std::vector<LockStatistics*> result{};
+    std::lock_guard lock{registry.mutex};
+    result.reserve(registry.locks.size());
+    for(const auto& [name, statistics] : registry.locks) {
+        result.push_back(&*statistics);
+    }
+    return result;
+}
+
+std::string lock_profiler::describe_frame(void *frame) {
+    Dl_info info{};
+    if(!frame || !dladdr(frame, &info)) {
+        return "unknown";
+    }
+
+    if(info.dli_sname) {
+        return demangle(info.dli_sname) + format_offset((uintptr_t) frame - (uintptr_t) info.dli_saddr);
+    }
+
+    /* symbol isn't exported (server hasn't been linked with -rdynamic), resolve it via addr2line */
+    std::string module{info.dli_fname ? info.dli_fname : "unknown"};
+    if(auto index = module.find_last_of('/'); index != std::string::npos) {
+        module = module.substr(index + 1);
+    }
+    return module + format_offset((uintptr_t) frame - (uintptr_t) info.dli_fbase);
+}
+
+bool lock_profiler::internal_frame(void *frame) {
+    Dl_info info{};
+    if(!frame || !dladdr(frame, &info) || !info.dli_sname) {
+        return false;
+    }
+
+    auto demangled = demangle(info.dli_sname);
+    std::string_view symbol{demangled};
+    /* template member functions are prefixed with their return type */
+    if(symbol.starts_with("void ") || symbol.starts_with("bool ")) {
+        symbol.remove_prefix(5);
+    }
+
+    return symbol.starts_with("ts::lock_profiler::") ||
+        symbol.starts_with("std::lock_guard<") ||
+        symbol.starts_with("std::unique_lock<") ||
+        symbol.starts_with("std::shared_lock<") ||
+        symbol.starts_with("std::scoped_lock<");
+}
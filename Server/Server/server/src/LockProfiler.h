@@ -0,0 +1,255 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <type_traits>
+#include <string_view>
+#include "./Metrics.h"
+
+/*
+ * Opt-in lock contention profiler.
+ * Locks declared via lock_profiler::profiled_mutex_t are plain mutexes unless the server has been compiled with COMPILE_LOCK_PROFILER.
+ * All instances sharing the same lock name will be accounted together (e.g. the clients mutex of every virtual server).
+ */
+namespace ts::lock_profiler {
+#ifdef COMPILE_LOCK_PROFILER
+    constexpr static bool kEnabled{true};
+#else
+    constexpr static bool kEnabled{false};
+#endif
+    constexpr static size_t kMaxCallSites{32};
+    constexpr static size_t kCallSiteDepth{8};
+    constexpr static size_t kMaxHeldLocks{16};
+    /* Acquisitions of mutexes without try_lock are considered contended if the wait exceeds this threshold */
+    constexpr static auto kContentionThreshold{std::chrono::microseconds{2}};
+
+    struct CallSite {
+        std::array<void*, kCallSiteDepth> frames{};
+        uint64_t contentions{0};
+        uint64_t wait_sum{0}; /* nanoseconds */
+    };
+
+    class LockStatistics {
+        public:
+            explicit LockStatistics(std::string name) : name{std::move(name)} {}
+
+            const std::string name;
+
+            metrics::Histogram wait_exclusive{};
+            metrics::Histogram wait_shared{};
+            metrics::Histogram hold_exclusive{};
+            metrics::Histogram hold_shared{};
+
+            std::atomic<uint64_t> contended_exclusive{0};
+            std::atomic<uint64_t> contended_shared{0};
+
+            /* Capture the call stack of the calling thread. Expensive, only call this on contention. */
+            [[nodiscard]] static CallSite capture_call_site();
+            void record_contention(const CallSite& /* call site */, const std::chrono::nanoseconds& /* wait */);
+
+            /* All recorded call sites sorted by their total wait time */
+            [[nodiscard]] std::vector<CallSite> call_sites();
+            /* Contentions which haven't been accounted to a call site because the call site table has been full */
+            [[nodiscard]] uint64_t untracked_contentions();
+        private:
+            std::mutex call_site_mutex{};
+            std::vector<CallSite> call_sites_{};
+            uint64_t untracked_contentions_{0};
+    };
+
+    [[nodiscard]] extern LockStatistics& register_lock(const std::string_view& /* name */);
+    /* All registered locks sorted by their name */
+    [[nodiscard]] extern std::vector<LockStatistics*> registered_locks();
+    /* Resolve a call site frame to "symbol+offset" or "module+offset" if the symbol isn't exported */
+    [[nodiscard]] extern std::string describe_frame(void* /* frame */);
+    /* Whatever the frame belongs to the profiler or the standard lock wrappers */
+    [[nodiscard]] extern bool internal_frame(void* /* frame */);
+
+    namespace detail {
+        struct HeldLock {
+            const void* mutex{nullptr};
+            std::chrono::steady_clock::time_point timestamp{};
+            uint32_t depth{0};
+        };
+
+        /* Locks held by the current thread, required to measure the hold time of recursive and shared locks */
+        struct HeldLocks {
+            std::array<HeldLock, kMaxHeldLocks> entries{};
+            size_t count{0};
+        };
+
+        extern thread_local HeldLocks held_locks;
+
+        inline void lock_acquired(const void* mutex) {
+            auto& locks = held_locks;
+            for(size_t index{0}; index < locks.count; index++) {
+                if(locks.entries[index].mutex == mutex) {
+                    locks.entries[index].depth++;
+                    return;
+                }
+            }
+
+            if(locks.count < kMaxHeldLocks) {
+                locks.entries[locks.count++] = HeldLock{mutex, std::chrono::steady_clock::now(), 1};
+            }
+        }
+
+        /* Returns true if the lock has been released completely. The hold time will be written into hold. */
+        inline bool lock_released(const void* mutex, std::chrono::nanoseconds& hold) {
+            auto& locks = held_locks;
+            for(size_t index{0}; index < locks.count; index++) {
+                auto& entry = locks.entries[index];
+                if(entry.mutex != mutex) {
+                    continue;
+                }
+
+                if(--entry.depth > 0) {
+                    return false;
+                }
+
+                hold = std::chrono::steady_clock::now() - entry.timestamp;
+                entry = locks.entries[--locks.count];
+                return true;
+            }
+
+            /* lock has been acquired while the held lock table was full or it's unlocked by another thread */
+            return false;
+        }
+    }
+
+    template <size_t length>
+    struct LockName {
+        constexpr LockName(const char (&name)[length]) { std::copy_n(name, length, this->value); }
+
+        [[nodiscard]] constexpr std::string_view view() const { return std::string_view{this->value, length - 1}; }
+
+        char value[length]{};
+    };
+
+    /**
+     * Mutex wrapper recording the acquisition wait time, the hold time and the contending call sites.
+     * The wrapper supports exclusive, recursive and shared mutexes (including ts::rw_mutex).
+     */
+    template <typename mutex_t, LockName name>
+    class ProfiledMutex {
+        public:
+            ProfiledMutex() = default;
+            ProfiledMutex(const ProfiledMutex&) = delete;
+            ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+            [[nodiscard]] static LockStatistics& statistics() {
+                static auto& statistics = register_lock(name.view());
+                return statistics;
+            }
+
+            inline void lock() { this->acquire<false>(); }
+            inline void unlock() { this->release<false>(); }
+
+            inline bool try_lock() requires requires(mutex_t& mutex) { mutex.try_lock(); } {
+                if(!this->mutex_.try_lock()) {
+                    return false;
+                }
+
+                ProfiledMutex::statistics().wait_exclusive.record(std::chrono::nanoseconds{0});
+                detail::lock_acquired(this);
+                return true;
+            }
+
+            inline void lock_shared() requires requires(mutex_t& mutex) { mutex.lock_shared(); } { this->acquire<true>(); }
+            inline void unlock_shared() requires requires(mutex_t& mutex) { mutex.unlock_shared(); } { this->release<true>(); }
+
+            inline bool try_lock_shared() requires requires(mutex_t& mutex) { mutex.try_lock_shared(); } {
+                if(!this->mutex_.try_lock_shared()) {
+                    return false;
+                }
+
+                ProfiledMutex::statistics().wait_shared.record(std::chrono::nanoseconds{0});
+                detail::lock_acquired(this);
+                return true;
+            }
+        private:
+            mutex_t mutex_{};
+
+            template <bool shared>
+            constexpr static bool try_lockable() {
+                if constexpr(shared) {
+                    return requires(mutex_t& mutex) { mutex.try_lock_shared(); };
+                } else {
+                    return requires(mutex_t& mutex) { mutex.try_lock(); };
+                }
+            }
+
+            template <bool shared>
+            inline void acquire() {
+                auto& statistics = ProfiledMutex::statistics();
+                auto& wait_histogram = shared ? statistics.wait_shared : statistics.wait_exclusive;
+
+                std::optional<CallSite> call_site{};
+                if constexpr(ProfiledMutex::try_lockable<shared>()) {
+                    bool acquired;
+                    if constexpr(shared) {
+                        acquired = this->mutex_.try_lock_shared();
+                    } else {
+                        acquired = this->mutex_.try_lock();
+                    }
+
+                    if(acquired) {
+                        wait_histogram.record(std::chrono::nanoseconds{0});
+                        detail::lock_acquired(this);
+                        return;
+                    }
+
+                    /* capture the call site before waiting so we don't extend the hold time */
+                    call_site.emplace(LockStatistics::capture_call_site());
+                }
+
+                auto wait_begin = std::chrono::steady_clock::now();
+                if constexpr(shared) {
+                    this->mutex_.lock_shared();
+                } else {
+                    this->mutex_.lock();
+                }
+                auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wait_begin);
+                detail::lock_acquired(this);
+                wait_histogram.record(wait);
+
+                if(!call_site.has_value()) {
+                    if(wait < kContentionThreshold) {
+                        return;
+                    }
+
+                    call_site.emplace(LockStatistics::capture_call_site());
+                }
+
+                (shared ? statistics.contended_shared : statistics.contended_exclusive).fetch_add(1, std::memory_order_relaxed);
+                statistics.record_contention(*call_site, wait);
+            }
+
+            template <bool shared>
+            inline void release() {
+                std::chrono::nanoseconds hold{};
+                auto released = detail::lock_released(this, hold);
+
+                if constexpr(shared) {
+                    this->mutex_.unlock_shared();
+                } else {
+                    this->mutex_.unlock();
+                }
+
+                if(released) {
+                    auto& statistics = ProfiledMutex::statistics();
+                    (shared ? statistics.hold_shared : statistics.hold_exclusive).record(hold);
+                }
+            }
+    };
+
+    /* Resolves to mutex_t if the lock profiler hasn't been compiled in */
+    template <typename mutex_t, LockName name>
+    using profiled_mutex_t = std::conditional_t<kEnabled, ProfiledMutex<mutex_t, name>, mutex_t>;
+}
@@ -0,0 +1,278 @@
+#include "./Metrics.h"
+#include <cmath>
+#include <algorithm>
+#include "./Configuration.h"
+
+using namespace ts;
+using namespace ts::metrics;
+
+namespace {
+    /* Bucket boundaries (in nanoseconds) of the exported histograms */
+    constexpr std::array<uint64_t, 21> kExportBoundaries{
+            1'000, 5'000, 10'000, 25'000, 50'000, 100'000, 250'000, 500'000,
+            1'000'000, 2'500'000, 5'000'000, 10'000'000, 25'000'000, 50'000'000, 100'000'000, 250'000'000, 500'000'000,
+            1'000'000'000, 2'500'000'000, 5'000'000'000, 10'000'000'000
+    };
+
+    inline bool valid_command_name(const std::string_view& name) {
+        if(name.empty() || name.length() > 64) {
+            return false;
+        }
+
+        return std::all_of(name.begin(), name.end(), [](char character) {
+            return (character >= 'a' && character <= 'z') || (character >= '0' && character <= '9') || character == '_';
+        });
+    }
+
+    /* Collapse all whitespace so multi line statements result in a readable label */
+    std::string normalize_statement(const std::string_view& sql) {
+        std::string result{};
+        result.reserve(sql.length());
+
+        bool whitespace{true};
+        for(auto character : sql) {
+            if(character == ' ' || character == '\t' || character == '\n' || character == '\r') {
+                if(!whitespace) {
+                    result.push_back(' ');
+                }
+                whitespace = true;
+            } else {
+                result.push_back(character);
+                whitespace = false;
+            }
+        }
+
+        if(!result.empty() && result.back() == ' ') {
+            result.pop_back();
+        }
+        return result;
+    }
+
+    inline std::string format_seconds(uint64_t nanoseconds) {
+        auto result = std::to_string(nanoseconds / 1'000'000'000ULL);
+        auto fraction = nanoseconds % 1'000'000'000ULL;
+        if(fraction > 0) {
+            auto fraction_string = std::to_string(fraction);
+            fraction_string.insert(0, 9 - fraction_string.length(), '0');
+            while(fraction_string.back() == '0') {
+                fraction_string.pop_back();
+            }
+
+            result += "." + fraction_string;
+        } else {
+            result += ".0";
+        }
+
+        return result;
+    }
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot result{};
+    for(size_t index{0}; index < kBucketCount; index++) {
+        result.buckets[index] = this->buckets[index].load(std::memory_order_relaxed);
+        result.count += result.buckets[index];
+    }
+    result.sum = this->sum.load(std::memory_order_relaxed);
+    return result;
+}
+
+uint64_t Histogram::Snapshot::quantile(double quantile) const {
+    if(this->count == 0) {
+        return 0;
+    }
+
+    auto target = (uint64_t) std::ceil((double) this->count * quantile);
+    uint64_t cumulative_count{0};
+    for(size_t index{0}; index < kBucketCount; index++) {
+        cumulative_count += this->buckets[index];
+        if(cumulative_count >= target && cumulative_count > 0) {
+            return Histogram::bucket_upper_bound(index);
+        }
+    }
+
+    return Histogram::bucket_upper_bound(kBucketCount - 1);
+}
+
+CommandMetrics& ServerMetrics::command(const std::string_view &name) {
+    auto key = valid_command_name(name) ? name : std::string_view{"other"};
+    {
+        std::shared_lock lock{this->command_mutex};
+        auto it = this->commands.find(key);
+        if(it != this->commands.end()) {
+            return *it->second;
+        }
+    }
+
+    std::lock_guard lock{this->command_mutex};
+    if(this->commands.size() >= kMaxCommandNames) {
+        key = "other";
+    }
+
+    auto& metrics = this->commands[std::string{key}];
+    if(!metrics) {
+        metrics = std::make_unique<CommandMetrics>();
+    }
+    return *metrics;
+}
+
+std::shared_ptr<ServerMetrics> Registry::register_server(ServerId server_id) {
+    auto result = std::make_shared<ServerMetrics>(server_id);
+
+    std::lock_guard lock{this->servers_mutex};
+    std::erase_if(this->servers, [](const auto& entry) { return entry.expired(); });
+    this->servers.push_back(result);
+    return result;
+}
+
+Histogram& Registry::sql_statement(const std::string &sql) {
+    {
+        std::shared_lock lock{this->sql_mutex};
+        auto it = this->sql_statements.find(sql);
+        if(it != this->sql_statements.end()) {
+            return *it->second;
+        }
+    }
+
+    std::lock_guard lock{this->sql_mutex};
+    auto key = this->sql_statements.size() >= kMaxSqlStatements ? std::string{"other"} : normalize_statement(sql);
+    auto& histogram = this->sql_histograms[key];
+    if(!histogram) {
+        histogram = std::make_unique<Histogram>();
+    }
+
+    if(this->sql_statements.size() < kMaxSqlStatements) {
+        this->sql_statements[sql] = &*histogram;
+    }
+    return *histogram;
+}
+
+std::vector<std::shared_ptr<ServerMetrics>> Registry::server_metrics() {
+    std::vector<std::shared_ptr<ServerMetrics>> result{};
+    result.push_back(this->instance_metrics_);
+    {
+        std::lock_guard lock{this->servers_mutex};
+        for(const auto& entry : this->servers) {
+            if(auto metrics = entry.lock(); metrics) {
+                result.push_back(std::move(metrics));
+            }
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) { return a->server_id < b->server_id; });
+    return result;
+}
+
+void Registry::render(std::string &output) {
+    auto server_metrics = this->server_metrics();
+
+    write_family(output, "teaspeak_server_tick_duration_seconds", "histogram", "seconds", "Time spent within one virtual server tick");
+    for(const auto& metrics : server_metrics) {
+        if(metrics->server_id == 0) {
+            continue;
+        }
+
+        write_histogram(output, "teaspeak_server_tick_duration_seconds", "server_id=\"" + std::to_string(metrics->server_id) + "\"", metrics->tick_duration);
+    }
+
+    write_family(output, "teaspeak_command_duration_seconds", "histogram", "seconds", "Command execution time by command name");
+    for(const auto& metrics : server_metrics) {
+        metrics->for_each_command([&](const std::string& command, const CommandMetrics& command_metrics) {
+            write_histogram(output, "teaspeak_command_duration_seconds", "server_id=\"" + std::to_string(metrics->server_id) + "\",command=\"" + command + "\"", command_metrics.execution);
+        });
+    }
+
+    write_family(output, "teaspeak_command_queue_wait_seconds", "histogram", "seconds", "Time a command has been waiting for a command executor");
+    for(const auto& metrics : server_metrics) {
+        metrics->for_each_command([&](const std::string& command, const CommandMetrics& command_metrics) {
+            write_histogram(output, "teaspeak_command_queue_wait_seconds", "server_id=\"" + std::to_string(metrics->server_id) + "\",command=\"" + command + "\"", command_metrics.queue_wait);
+        });
+    }
+
+    write_family(output, "teaspeak_packets_resent", "counter", "", "Voice packets which had to be resent");
+    for(const auto& metrics : server_metrics) {
+        if(metrics->server_id == 0) {
+            continue;
+        }
+
+        write_value(output, "teaspeak_packets_resent_total", "server_id=\"" + std::to_string(metrics->server_id) + "\"", metrics->packets_resent.load(std::memory_order_relaxed));
+    }
+
+    write_family(output, "teaspeak_packet_crypt_duration_seconds", "histogram", "seconds", "Time spent encrypting or decrypting one voice packet");
+    write_histogram(output, "teaspeak_packet_crypt_duration_seconds", "operation=\"encrypt\"", this->packet_encrypt);
+    write_histogram(output, "teaspeak_packet_crypt_duration_seconds", "operation=\"decrypt\"", this->packet_decrypt);
+
+    write_family(output, "teaspeak_sql_statement_duration_seconds", "histogram", "seconds", "Execution time of the database statements");
+    {
+        std::shared_lock lock{this->sql_mutex};
+        for(const auto& [statement, histogram] : this->sql_histograms) {
+            write_histogram(output, "teaspeak_sql_statement_duration_seconds", "statement=\"" + escape_label(statement) + "\"", *histogram);
+        }
+    }
+}
+
+bool metrics::enabled() {
+    return config::metrics::enabled;
+}
+
+Registry& metrics::registry() {
+    static Registry registry{};
+    return registry;
+}
+
+void metrics::write_family(std::string &output, const std::string_view &name, const std::string_view &type, const std::string_view &unit, const std::string_view &help) {
+    output.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+    if(!unit.empty()) {
+        output.append("# UNIT ").append(name).append(" ").append(unit).append("\n");
+    }
+    output.append("# HELP ").append(name).append(" ").append(help).append("\n");
+}
+
+void metrics::write_histogram(std::string &output, const std::string_view &name, const std::string_view &labels, const Histogram &histogram) {
+    auto snapshot = histogram.snapshot();
+    auto label_prefix = labels.empty() ? std::string{} : std::string{labels} + ",";
+
+    /*
+     * A bucket gets accounted to the first boundary its upper bound doesn't exceed.
+     * Values may therefore be reported within the next greater boundary (max 12.5% off).
+     */
+    size_t bucket_index{0};
+    uint64_t cumulative_count{0};
+    for(auto boundary : kExportBoundaries) {
+        while(bucket_index < Histogram::kBucketCount && Histogram::bucket_upper_bound(bucket_index) <= boundary) {
+            cumulative_count += snapshot.buckets[bucket_index++];
+        }
+
+        output.append(name).append("_bucket{").append(label_prefix).append("le=\"").append(format_seconds(boundary)).append("\"} ");
+        output.append(std::to_string(cumulative_count)).append("\n");
+    }
+
+    output.append(name).append("_bucket{").append(label_prefix).append("le=\"+Inf\"} ").append(std::to_string(snapshot.count)).append("\n");
+    output.append(name).append("_count{").append(labels).append("} ").append(std::to_string(snapshot.count)).append("\n");
+    output.append(name).append("_sum{").append(labels).append("} ").append(format_seconds(snapshot.sum)).append("\n");
+}
+
+void metrics::write_value(std::string &output, const std::string_view &name, const std::string_view &labels, uint64_t value) {
+    output.append(name).append("{").append(labels).append("} ").append(std::to_string(value)).append("\n");
+}
+
+std::string metrics::escape_label(const std::string_view &value) {
+    std::string result{};
+    result.reserve(value.length());
+    for(auto character : value) {
+        switch(character) {
+            case '\\':
+                result += "\\\\";
+                break;
+            case '"':
+                result += "\\\"";
+                break;
+            case '\n':
+                result += "\\n";
+                break;
+            default:
+                result.push_back(character);
+                break;
+        }
+    }
+    return result;
+}
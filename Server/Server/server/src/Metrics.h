@@ -0,0 +1,169 @@
+#pragma once
+
+#include <map>
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <shared_mutex>
+#include <string_view>
+#include <Definitions.h>
+
+namespace ts::metrics {
+    /**
+     * Lock free log-linear (HDR style) latency histogram.
+     * Every power of two is split into eight linear sub buckets which results in a max relative error of 12.5%.
+     * Recording a value is a single relaxed increment, so it's save to be used on the hot path from any thread.
+     */
+    class Histogram {
+        public:
+            constexpr static size_t kSubBucketBits{3};
+            constexpr static size_t kSubBuckets{1U << kSubBucketBits};
+            /* Values above 2^41 nanoseconds (~36 minutes) will be accounted into the last bucket */
+            constexpr static size_t kMaxMagnitude{40};
+            constexpr static size_t kBucketCount{(kMaxMagnitude - kSubBucketBits + 2) * kSubBuckets};
+
+            struct Snapshot {
+                std::array<uint64_t, kBucketCount> buckets{};
+                uint64_t count{0};
+                uint64_t sum{0}; /* nanoseconds */
+
+                /* Upper bound (in nanoseconds) of the bucket containing the quantile */
+                [[nodiscard]] uint64_t quantile(double /* quantile */) const;
+            };
+
+            inline void record(const std::chrono::nanoseconds& duration) {
+                auto value = duration.count() > 0 ? (uint64_t) duration.count() : 0ULL;
+                this->buckets[Histogram::bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+                this->sum.fetch_add(value, std::memory_order_relaxed);
+            }
+
+            template <typename duration_t>
+            inline void record(const duration_t& duration) {
+                this->record(std::chrono::duration_cast<std::chrono::nanoseconds>(duration));
+            }
+
+            [[nodiscard]] Snapshot snapshot() const;
+
+            [[nodiscard]] constexpr static size_t bucket_index(uint64_t value) {
+                if(value < kSubBuckets) {
+                    return value;
+                }
+
+                size_t magnitude = 63 - __builtin_clzll(value);
+                if(magnitude > kMaxMagnitude) {
+                    return kBucketCount - 1;
+                }
+
+                auto group = magnitude - kSubBucketBits + 1;
+                auto sub_bucket = (value >> (magnitude - kSubBucketBits)) - kSubBuckets;
+                return group * kSubBuckets + sub_bucket;
+            }
+
+            /* Exclusive upper bound of a bucket in nanoseconds */
+            [[nodiscard]] constexpr static uint64_t bucket_upper_bound(size_t index) {
+                auto group = index / kSubBuckets;
+                auto sub_bucket = index % kSubBuckets;
+                if(group == 0) {
+                    return sub_bucket + 1;
+                }
+
+                return (kSubBuckets + sub_bucket + 1) << (group - 1);
+            }
+        private:
+            std::array<std::atomic<uint64_t>, kBucketCount> buckets{};
+            std::atomic<uint64_t> sum{0};
+    };
+
+    struct CommandMetrics {
+        Histogram execution{};
+        Histogram queue_wait{};
+        std::atomic<uint64_t> max_execution{0}; /* nanoseconds */
+
+        inline void record(const std::chrono::nanoseconds& queue_wait_, const std::chrono::nanoseconds& execution_) {
+            this->queue_wait.record(queue_wait_);
+            this->execution.record(execution_);
+
+            auto value = (uint64_t) std::max(execution_.count(), (std::chrono::nanoseconds::rep) 0);
+            auto current_max = this->max_execution.load(std::memory_order_relaxed);
+            while(current_max < value && !this->max_execution.compare_exchange_weak(current_max, value, std::memory_order_relaxed)) {}
+        }
+    };
+
+    /**
+     * Metrics of one virtual server.
+     * The server id 0 contains the metrics of query clients which haven't selected any server.
+     */
+    class ServerMetrics {
+            friend class Registry;
+        public:
+            constexpr static size_t kMaxCommandNames{256};
+
+            explicit ServerMetrics(ServerId server_id) : server_id{server_id} {}
+
+            const ServerId server_id;
+
+            Histogram tick_duration{};
+            std::atomic<uint64_t> packets_resent{0};
+
+            /**
+             * Get the execution metrics of a command.
+             * The name should be the registered name of the command, unknown commands are accounted as "unknown".
+             * Invalid command names and command names exceeding kMaxCommandNames will be accounted as "other".
+             */
+            [[nodiscard]] CommandMetrics& command(const std::string_view& /* command */);
+
+            /* The command map will be locked while iterating */
+            template <typename callback_t>
+            inline void for_each_command(const callback_t& callback) {
+                std::shared_lock lock{this->command_mutex};
+                for(const auto& [name, metrics] : this->commands) {
+                    callback(name, *metrics);
+                }
+            }
+        private:
+            std::shared_mutex command_mutex{};
+            std::map<std::string, std::unique_ptr<CommandMetrics>, std::less<>> commands{};
+    };
+
+    class Registry {
+        public:
+            constexpr static size_t kMaxSqlStatements{512};
+
+            Histogram packet_encrypt{};
+            Histogram packet_decrypt{};
+
+            [[nodiscard]] std::shared_ptr<ServerMetrics> register_server(ServerId /* server id */);
+            [[nodiscard]] inline ServerMetrics& instance_metrics() { return *this->instance_metrics_; }
+            /* All alive server metrics including the instance metrics, sorted by their server id */
+            [[nodiscard]] std::vector<std::shared_ptr<ServerMetrics>> server_metrics();
+
+            [[nodiscard]] Histogram& sql_statement(const std::string& /* sql */);
+
+            /* Append all metrics in the OpenMetrics text format (without the trailing EOF) */
+            void render(std::string& /* output */);
+        private:
+            std::shared_ptr<ServerMetrics> instance_metrics_{std::make_shared<ServerMetrics>(0)};
+
+            std::mutex servers_mutex{};
+            std::vector<std::weak_ptr<ServerMetrics>> servers{};
+
+            std::shared_mutex sql_mutex{};
+            /* raw sql statement => histogram of the normalized statement */
+            std::map<std::string, Histogram*, std::less<>> sql_statements{};
+            std::map<std::string, std::unique_ptr<Histogram>, std::less<>> sql_histograms{};
+    };
+
+    [[nodiscard]] extern bool enabled();
+    [[nodiscard]] extern Registry& registry();
+
+    /* Helpers to write the OpenMetrics text format */
+    extern void write_family(std::string& /* output */, const std::string_view& /* name */, const std::string_view& /* type */, const std::string_view& /* unit */, const std::string_view& /* help */);
+    extern void write_histogram(std::string& /* output */, const std::string_view& /* name */, const std::string_view& /* labels */, const Histogram& /* histogram */);
+    extern void write_value(std::string& /* output */, const std::string_view& /* name */, const std::string_view& /* labels */, uint64_t /* value */);
+    [[nodiscard]] extern std::string escape_label(const std::string_view& /* value */);
+}
@@ -37,6 +37,11 @@ bool VirtualServer::registerClient(shared_ptr<ConnectedClient> client) {
         client->setClientId(client_id);
     }
 
+    if(auto voice_client = dynamic_pointer_cast<VoiceClient>(client); this->udpVoiceServer && voice_client) {
+        /* Make the client lookup able by its new client id */
+        this->udpVoiceServer->update_connection_client_id(voice_client, 0);
+    }
+
     {
         std::lock_guard lock{this->client_nickname_lock};
 
@@ -100,7 +105,7 @@ bool VirtualServer::registerClient(shared_ptr<ConnectedClient> client) {
     return true;
 }
 
-bool VirtualServer::unregisterClient(shared_ptr<ConnectedClient> client, std::string reason, std::unique_lock<std::shared_mutex>& chan_tree_lock) {
+bool VirtualServer::unregisterClient(shared_ptr<ConnectedClient> client, std::string reason, std::unique_lock<channel_tree_mutex_t>& chan_tree_lock) {
     /* FIXME: Reenable this for the web client as soon we've fixed the web client disconnect method */
     if(client->getType() == ClientType::CLIENT_TEAMSPEAK || client->getType() == ClientType::CLIENT_TEASPEAK/* || client->getType() == ClientType::CLIENT_WEB */) {
         sassert(client->state == ConnectionState::DISCONNECTED);
@@ -120,9 +125,10 @@ bool VirtualServer::unregisterClient(shared_ptr<ConnectedClient> client, std::st
         chan_tree_lock.unlock();
     }
 
+    auto client_id = client->getClientId();
     {
         std::lock_guard clients_lock{this->clients_mutex};
-        auto client_id = client->getClientId();
+        client_id = client->getClientId();
         if(client_id == 0) {
             return false; /* not registered */
         }
@@ -135,6 +141,10 @@ bool VirtualServer::unregisterClient(shared_ptr<ConnectedClient> client, std::st
         client->setClientId(0);
     }
 
+    if(auto voice_client = dynamic_pointer_cast<VoiceClient>(client); this->udpVoiceServer && voice_client) {
+        this->udpVoiceServer->update_connection_client_id(voice_client, client_id);
+    }
+
     auto current_time_seconds = std::chrono::duration_cast<seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
     switch(client->getType()) {
         case ClientType::CLIENT_TEAMSPEAK:
@@ -337,7 +347,7 @@ void VirtualServer::notify_client_kick(
  *
  * Note: channel cant be a ref because the channel itself gets deleted!
  */
-void VirtualServer::delete_channel(shared_ptr<ts::ServerChannel> channel, const shared_ptr<ConnectedClient> &invoker, const std::string& kick_message, unique_lock<std::shared_mutex> &tree_lock, bool temp_delete) {
+void VirtualServer::delete_channel(shared_ptr<ts::ServerChannel> channel, const shared_ptr<ConnectedClient> &invoker, const std::string& kick_message, unique_lock<channel_tree_mutex_t> &tree_lock, bool temp_delete) {
     if(!tree_lock.owns_lock()) {
         tree_lock.lock();
     }
@@ -362,7 +372,7 @@ void VirtualServer::delete_channel(shared_ptr<ts::ServerChannel> channel, const
     }
     auto default_channel = this->channelTree->getDefaultChannel();
 
-    deque<unique_lock<threads::Mutex>> command_locks;
+    deque<unique_lock<ConnectedClient::command_mutex_t>> command_locks;
     for(const auto& client : clients) {
         command_locks.push_back(move(unique_lock(client->command_lock)));
     }
@@ -421,7 +431,7 @@ void VirtualServer::client_move(
         const std::string &reason_message,
         ts::ViewReasonId reason_id,
         bool notify_client,
-        std::unique_lock<std::shared_mutex> &server_channel_write_lock) {
+        std::unique_lock<channel_tree_mutex_t> &server_channel_write_lock) {
 
     TIMING_START(timings);
     if(!server_channel_write_lock.owns_lock()) {
@@ -477,6 +487,9 @@ void VirtualServer::client_move(
         ClientPermissionCalculator target_client_permissions{&*target_client, target_channel};
         auto needed_view_power = target_client_permissions.calculate_permission(permission::i_client_needed_serverquery_view_power);
 
+        /* the moved notify is equal for every client, encode it only once */
+        ClientMovedBroadcast moved_notify{target_client, s_target_channel, reason_id, reason_message, invoker};
+
         /* ct_... is for client channel tree */
         this->forEachClient([&](const std::shared_ptr<ConnectedClient>& client) {
             if (!notify_client && client == target_client) {
@@ -498,7 +511,7 @@ void VirtualServer::client_move(
                     /* Source and target channel are visible for the client. Just a "normal" move. */
                     if (ct_target_channel->subscribed || client == target_client) {
                         if (client == target_client || client->isClientVisible(target_client, false)) {
-                            client->notifyClientMoved(target_client, s_target_channel, reason_id, reason_message, invoker, false);
+                            client->notifyClientMoved(moved_notify);
                         } else {
                             client->notifyClientEnterView(target_client, invoker, reason_message, s_target_channel, reason_id, s_source_channel, false);
                         }
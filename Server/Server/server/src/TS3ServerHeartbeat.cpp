@@ -268,6 +268,10 @@ void VirtualServer::executeServerTick() {
             END_TIMINGS(music_manager);
         }
 
+        if(metrics::enabled()) {
+            this->metrics_->tick_duration.record(system_clock::now() - tick_timestamp);
+        }
+
         if(system_clock::now() - lastTick > milliseconds(100)) {
             //milliseconds timing_update_states, timing_client_tick, timing_channel, timing_statistic;
             logError(this->serverId, "Server tick took to long ({}ms => Status updates: {}ms Client tick: {}ms, Channel tick: {}ms, Statistic tick: {}ms, Groups: {}ms, Conversation cache: {}ms)",
@@ -285,6 +285,7 @@ bool VirtualServer::initialize(bool test_properties) {
     letters = new letter::LetterManager(this);
 
     server_statistics_ = make_shared<stats::ConnectionStatistics>(serverInstance->getStatistics());
+    metrics_ = metrics::registry().register_server(this->serverId);
 
     this->serverRoot = std::make_shared<InternalClient>(this->sql, self.lock(),
                                                         this->properties()[property::VIRTUALSERVER_NAME].value(), false);
@@ -628,7 +629,7 @@ void VirtualServer::stop(const std::string& reason, bool disconnect_query) {
         if(cl->getType() == CLIENT_TEAMSPEAK || cl->getType() == CLIENT_TEASPEAK || cl->getType() == CLIENT_WEB) {
             cl->close_connection(chrono::system_clock::now() + chrono::seconds(1));
         } else if(cl->getType() == CLIENT_QUERY){
-            threads::MutexLock lock(cl->command_lock);
+            std::unique_lock lock{cl->command_lock};
             cl->currentChannel = nullptr;
 
             if(disconnect_query) {
@@ -898,18 +899,20 @@ bool VirtualServer::notifyServerEdited(std::shared_ptr<ConnectedClient> invoker,
         }
         cmd[key] = properties()[info].value();
     }
-    this->forEachClient([&cmd](shared_ptr<ConnectedClient> client){
-        client->sendCommand(cmd);
+    BroadcastCommand notify{cmd.build()};
+    this->forEachClient([&notify](shared_ptr<ConnectedClient> client){
+        client->sendCommand(notify);
     });
     return true;
 }
 
 bool VirtualServer::notifyClientPropertyUpdates(std::shared_ptr<ConnectedClient> client, const deque<const property::PropertyDescription*>& keys, bool selfNotify) {
     if(keys.empty() || !client) return false;
+    ClientUpdatedBroadcast notify{client, keys};
     this->forEachClient([&](const shared_ptr<ConnectedClient>& cl) {
         shared_lock client_channel_lock(cl->channel_tree_mutex);
         if(cl->isClientVisible(client, false) || (cl == client && selfNotify))
-            cl->notifyClientUpdated(client, keys, false);
+            cl->notifyClientUpdated(notify);
     });
     return true;
 }
@@ -919,8 +922,9 @@ void VirtualServer::broadcastMessage(std::shared_ptr<ConnectedClient> invoker, s
         logCritical(this->serverId, "Tried to broadcast with an invalid invoker!");
         return;
     }
+    TextMessageBroadcast notify{ChatMessageMode::TEXTMODE_SERVER, invoker, 0, 0, system_clock::now(), std::move(message)};
     this->forEachClient([&](shared_ptr<ConnectedClient> cl){
-        cl->notifyTextMessage(ChatMessageMode::TEXTMODE_SERVER, invoker, 0, 0, system_clock::now(), message);
+        cl->notifyTextMessage(notify);
     });
 }
 
@@ -1119,6 +1123,7 @@ void VirtualServer::send_text_message(const std::shared_ptr<BasicChannel> &chann
     }
 
     auto flag_password = channel->properties()[property::CHANNEL_FLAG_PASSWORD].as_or<bool>(false);
+    TextMessageBroadcast notify{ChatMessageMode::TEXTMODE_CHANNEL, sender, client_id, channel_id, now, message};
     for(const auto& client : this->getClients()) {
         if(client->connectionState() != ConnectionState::CONNECTED)
             continue;
@@ -1139,7 +1144,7 @@ void VirtualServer::send_text_message(const std::shared_ptr<BasicChannel> &chann
                 if(auto err_perm{client->calculate_and_get_join_state(channel)}; err_perm)
                     continue;
             }
-            client->notifyTextMessage(ChatMessageMode::TEXTMODE_CHANNEL, sender, client_id, channel_id, now, message);
+            client->notifyTextMessage(notify);
         }
     }
 
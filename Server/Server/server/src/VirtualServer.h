@@ -15,6 +15,8 @@
 #include "manager/BanManager.h"
 #include "Definitions.h"
 #include "ConnectionStatistics.h"
+#include "Metrics.h"
+#include "LockProfiler.h"
 #include "manager/TokenManager.h"
 #include "manager/ComplainManager.h"
 #include "DatabaseHelper.h"
@@ -157,6 +159,9 @@ namespace ts {
                     float average_ping{0};
                     float average_loss{0};
                 };
+
+                using clients_mutex_t = lock_profiler::profiled_mutex_t<std::mutex, "VirtualServer::clients_mutex">;
+                using channel_tree_mutex_t = lock_profiler::profiled_mutex_t<std::shared_mutex, "VirtualServer::channel_tree_mutex">;
                 
                 VirtualServer(ServerId serverId, sql::SqlManager*);
                 ~VirtualServer();
@@ -240,6 +245,7 @@ namespace ts {
                 std::string getDisplayName(){ return properties()[property::VIRTUALSERVER_NAME]; }
 
                 std::shared_ptr<stats::ConnectionStatistics> getServerStatistics(){ return server_statistics_; }
+                [[nodiscard]] inline const std::shared_ptr<metrics::ServerMetrics>& metrics() const { return this->metrics_; }
 
                 std::shared_ptr<VoiceServer> getVoiceServer(){ return this->udpVoiceServer; }
                 WebControlServer* getWebServer(){ return this->webControlServer; }
@@ -292,14 +298,14 @@ namespace ts {
                         const std::string& /* reason */,
                         ViewReasonId /* reason id */,
                         bool /* notify the client */,
-                        std::unique_lock<std::shared_mutex>& /* tree lock */
+                        std::unique_lock<channel_tree_mutex_t>& /* tree lock */
                 );
 
                 void delete_channel(
                         std::shared_ptr<ServerChannel> /* target channel */,
                         const std::shared_ptr<ConnectedClient>& /* invoker */,
                         const std::string& /* kick message */,
-                        std::unique_lock<std::shared_mutex>& /* tree lock */,
+                        std::unique_lock<channel_tree_mutex_t>& /* tree lock */,
                         bool temporary_auto_delete
                 );
 
@@ -316,7 +322,7 @@ namespace ts {
                 inline void enqueue_notify_server_group_list() {  this->task_notify_server_group_list.enqueue(); }
             protected:
                 bool registerClient(std::shared_ptr<ConnectedClient>);
-                bool unregisterClient(std::shared_ptr<ConnectedClient>, std::string, std::unique_lock<std::shared_mutex>& channel_tree_lock);
+                bool unregisterClient(std::shared_ptr<ConnectedClient>, std::string, std::unique_lock<channel_tree_mutex_t>& channel_tree_lock);
                 bool assignDefaultChannel(const std::shared_ptr<ConnectedClient>&, bool join);
 
             private:
@@ -337,6 +343,7 @@ namespace ts {
                 letter::LetterManager* letters = nullptr;
                 std::shared_ptr<music::MusicBotManager> music_manager_;
                 std::shared_ptr<stats::ConnectionStatistics> server_statistics_;
+                std::shared_ptr<metrics::ServerMetrics> metrics_;
                 std::shared_ptr<conversation::ConversationManager> conversation_manager_;
                 std::unique_ptr<rtc::Server> rtc_server_;
 
@@ -349,7 +356,7 @@ namespace ts {
                 std::chrono::system_clock::time_point conversation_cache_cleanup_timestamp;
 
                 //The client list
-                std::mutex clients_mutex{};
+                clients_mutex_t clients_mutex{};
                 btree::map<ClientId, std::shared_ptr<ConnectedClient>> clients{};
 
                 std::recursive_mutex client_nickname_lock;
@@ -360,7 +367,7 @@ namespace ts {
                 int _voice_encryption_mode = 2; /* */
 
                 ServerChannelTree* channelTree = nullptr;
-                std::shared_mutex channel_tree_mutex; /* lock if access channel tree! */
+                channel_tree_mutex_t channel_tree_mutex{}; /* lock if access channel tree! */
 
                 std::shared_ptr<groups::GroupManager> groups_manager_{};
 
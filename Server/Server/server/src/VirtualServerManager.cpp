@@ -24,14 +24,6 @@ VirtualServerManager::~VirtualServerManager() {
         this->instances.clear();
     }
 
-    {
-        this->acknowledge.condition.notify_all();
-        if(!threads::timed_join(this->acknowledge.executor,std::chrono::seconds{2})) {
-            logCritical(LOG_GENERAL, "Failed to shutdown packet resend thread.");
-            this->acknowledge.executor.detach();
-        }
-    }
-
     delete this->puzzles;
     this->puzzles = nullptr;
 }
@@ -136,25 +128,6 @@ bool VirtualServerManager::initialize(bool autostart) {
     );
     this->handle->databaseHelper()->clearStartupCache(0);
 
-    {
-        this->acknowledge.executor = std::thread([&]{
-            system_clock::time_point next_execute = system_clock::now() + milliseconds(500);
-            while(this->state == State::STARTED || this->state == State::STARTING) {
-                unique_lock<mutex> lock(this->acknowledge.lock);
-                this->acknowledge.condition.wait_until(lock, next_execute, [&](){ return this->state != State::STARTED && this->state != State::STARTING; });
-
-                auto now = system_clock::now();
-                next_execute = now + milliseconds(500);
-                for(const auto& server : this->serverInstances()) {
-                    auto vserver = server->getVoiceServer(); //Read this only once
-                    if(vserver)
-                        vserver->execute_resend(now, next_execute);
-                }
-            }
-            return 0;
-        });
-    }
-
     this->state = State::STARTED;
     return true;
 }
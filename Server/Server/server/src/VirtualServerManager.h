@@ -70,12 +70,6 @@ namespace ts::server {
             std::deque<std::shared_ptr<VirtualServer>> instances;
             udp::PuzzleManager* puzzles{nullptr};
 
-            struct {
-                std::thread executor{};
-                std::condition_variable condition;
-                std::mutex lock;
-            } acknowledge;
-
             void delete_server_in_db(ServerId /* server id */, bool /* data only */);
             void change_server_id_in_db(ServerId /* old id */, ServerId /* new id */);
 
@@ -0,0 +1,16 @@
+#include "BroadcastCommand.h"
+#include "./voice/PacketEncoder.h"
+
+using namespace ts::server;
+
+BroadcastCommand::BroadcastCommand(std::string command) : command_{std::move(command)} {}
+BroadcastCommand::~BroadcastCommand() = default;
+
+const std::shared_ptr<udp::CommandFragments>& BroadcastCommand::voice_fragments() {
+    if(!this->fragments_built) {
+        this->fragments_ = udp::CommandFragments::build(this->command_);
+        this->fragments_built = true;
+    }
+
+    return this->fragments_;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <memory>
+
+namespace ts::server {
+    namespace udp {
+        class CommandFragments;
+    }
+
+    /**
+     * A command which gets send to multiple clients (e.g. a notification).
+     * The command gets built once by the notify loop. Voice clients share its compressed and fragmented
+     * packet payloads which are getting built as soon the first voice client receives the command.
+     * Attention: A broadcast command must only be used by one thread.
+     */
+    class BroadcastCommand {
+        public:
+            explicit BroadcastCommand(std::string /* command */);
+            ~BroadcastCommand();
+
+            [[nodiscard]] inline const std::string& command() const { return this->command_; }
+
+            /* returns null if the command could not be compressed */
+            [[nodiscard]] const std::shared_ptr<udp::CommandFragments>& voice_fragments();
+        private:
+            std::string command_;
+
+            bool fragments_built{false};
+            std::shared_ptr<udp::CommandFragments> fragments_{};
+    };
+}
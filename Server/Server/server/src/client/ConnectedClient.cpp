@@ -5,6 +5,7 @@
 #include <Definitions.h>
 #include <misc/sassert.h>
 #include <misc/memtracker.h>
+#include <misc/utf8.h>
 #include <log/LogUtils.h>
 #include <ThreadPool/Timer.h>
 
@@ -13,6 +14,7 @@
 #include "../InstanceHandler.h"
 #include "../PermissionCalculator.h"
 #include "../groups/GroupManager.h"
+#include "./shared/ServerCommandExecutor.h"
 #include <event.h>
 
 using namespace std;
@@ -720,7 +722,7 @@ inline void send_channels(ConnectedClient* client, ChannelIT begin, const Channe
     if(begin == end)
         return;
 
-    ts::command_builder builder{"channellist", 512, 6};
+    ts::command_arena_builder builder{"channellist", 2048, 4};
     size_t index = 0;
 
     while(begin != end) {
@@ -732,10 +734,11 @@ inline void send_channels(ConnectedClient* client, ChannelIT begin, const Channe
 
         for (const auto &elm : channel->properties()->list_properties(property::FLAG_CHANNEL_VIEW, client->getType() == CLIENT_TEAMSPEAK ? property::FLAG_NEW : (uint16_t) 0)) {
             if(elm.type() == property::CHANNEL_ORDER)
-                builder.put_unchecked(index, elm.type().name, override_orderid ? 0 : (*begin)->previous_channel);
+                builder.put(elm.type().name, override_orderid ? 0 : (*begin)->previous_channel);
             else
-                builder.put_unchecked(index, elm.type().name, elm.value());
+                builder.put(elm.type().name, elm.value());
         }
+        builder.next_bulk();
 
         begin++;
         if(++index > 3)
@@ -875,16 +878,113 @@ void ConnectedClient::sendServerInit() {
     this->sendCommand(command);
 }
 
+command_result ConnectedClient::check_command_requirements(const CommandDescriptor &descriptor) {
+    /* getType() reads a property, so only resolve it when the command is restricted */
+    if(descriptor.client_types != 0xFF && !descriptor.client_allowed(this->getType())) {
+        return command_result{error::command_not_found};
+    }
+
+    if(descriptor.requires_server() && !this->server) {
+        return command_result{error::server_invalid_id};
+    }
+
+    if(descriptor.flood_check()) {
+        this->increaseFloodPoints(descriptor.flood_points);
+        if(this->shouldFloodBlock()) {
+            return command_result{error::ban_flooding};
+        }
+    }
+
+    if(descriptor.permission != permission::unknown && !permission::v2::permission_granted(1, this->calculate_permission(descriptor.permission, 0, false))) {
+        return command_result{descriptor.permission};
+    }
+
+    return command_result{error::ok};
+}
+
+namespace {
+    /* Only registered command names are used so a client can't create new metric entries */
+    inline std::string_view command_name(const CommandDescriptor& descriptor) {
+        return descriptor.id == CommandId::Unknown ? std::string_view{"unknown"} : descriptor.name;
+    }
+
+    inline std::optional<std::string> command_return_code(Command& command) {
+        if(command["return_code"].size() == 0) {
+            return std::nullopt;
+        }
+
+        return command["return_code"].first().as<std::string>();
+    }
+
+    inline std::optional<std::string> command_return_code(const ts::command_parser& command) {
+        for(const auto& bulk : command.bulks()) {
+            bool found;
+            auto value = bulk.value("return_code", found);
+            if(found) {
+                return value;
+            }
+        }
+
+        return std::nullopt;
+    }
+}
+
 bool ConnectedClient::handleCommandFull(Command& cmd, bool disconnectOnFail) {
+    return this->handle_command_full(cmd, command_registry::find(cmd.command()), disconnectOnFail);
+}
+
+bool ConnectedClient::handleCommandFull(const ts::command_parser& cmd, const CommandDescriptor& descriptor, bool disconnectOnFail) {
+    assert(descriptor.parser_view());
+    return this->handle_command_full(cmd, descriptor, disconnectOnFail);
+}
+
+command_result ConnectedClient::dispatch_command(Command &cmd, const CommandDescriptor &descriptor) {
+    if(!descriptor.parser_view()) {
+        return this->handleCommand(cmd, descriptor.id);
+    }
+
+    /* The handler has been migrated to the command parser but we've received a legacy command (e.g. from the web client) */
+    auto command_string = cmd.build();
+    ts::command_parser parser{std::string_view{command_string}};
+    if(!parser.parse(true)) {
+        return command_result{error::vs_critical};
+    }
+
+    return this->handleCommandView(parser, descriptor.id);
+}
+
+command_result ConnectedClient::dispatch_command(const ts::command_parser &cmd, const CommandDescriptor &descriptor) {
+    /* Command::parse rejects the whole command in strict mode. Escape sequences are plain ASCII, so validating the raw payload is sufficient. */
+    if(config::server::strict_ut8_mode && utf8::count_characters(cmd.payload_view(0)) < 0) {
+        return command_result{error::parameter_convert, "invalid UTF-8 character"};
+    }
+
+    return this->handleCommandView(cmd, descriptor.id);
+}
+
+template <typename command_t>
+bool ConnectedClient::handle_command_full(command_t& cmd, const CommandDescriptor& descriptor, bool disconnectOnFail) {
     system_clock::time_point start, end;
     start = system_clock::now();
 #ifdef PKT_LOG_CMD
-    logTrace(this->getServerId() == 0 ? LOG_QUERY : this->getServerId(), "{}[Command][Client -> Server] Processing command: {}", CLIENT_STR_LOG_PREFIX, cmd.build(false));
+    if constexpr(std::is_same_v<command_t, Command>) {
+        logTrace(this->getServerId() == 0 ? LOG_QUERY : this->getServerId(), "{}[Command][Client -> Server] Processing command: {}", CLIENT_STR_LOG_PREFIX, cmd.build(false));
+    } else {
+        logTrace(this->getServerId() == 0 ? LOG_QUERY : this->getServerId(), "{}[Command][Client -> Server] Processing command: {} {}", CLIENT_STR_LOG_PREFIX, cmd.identifier(), cmd.payload_view(0));
+    }
 #endif
 
+    std::unique_lock command_lock{this->command_lock, std::defer_lock};
+    if(!descriptor.lockless()) {
+        command_lock.lock();
+    }
+
     command_result result;
     try {
-        result.reset(this->handleCommand(cmd));
+        result.reset(this->check_command_requirements(descriptor));
+        if(!result.has_error()) {
+            result.reset(this->dispatch_command(cmd, descriptor));
+        }
     } catch(command_value_cast_failed& ex){
         auto message = ex.key() + " at " + std::to_string(ex.index()) + " could not be casted to " + ex.target_type().name();
         if(disconnectOnFail) {
@@ -930,15 +1030,20 @@ bool ConnectedClient::handleCommandFull(Command& cmd, bool disconnectOnFail) {
         return false;
     }
 
+    if(command_lock.owns_lock()) {
+        command_lock.unlock();
+    }
+
+    auto return_code = command_return_code(cmd);
     bool generateReturnStatus = false;
     if(result.has_error() || this->getType() == ClientType::CLIENT_QUERY){
         generateReturnStatus = true;
-    } else if(cmd["return_code"].size() > 0) {
-        generateReturnStatus = !cmd["return_code"].string().empty();
+    } else if(return_code.has_value()) {
+        generateReturnStatus = !return_code->empty();
     }
 
     if(generateReturnStatus)
-        this->notifyError(result, cmd["return_code"].size() > 0 ? cmd["return_code"].first().as<std::string>() : "");
+        this->notifyError(result, return_code.value_or(""));
 
     if(result.has_error() && this->state == ConnectionState::INIT_HIGH) {
         this->close_connection(system_clock::now()); //Disconnect now
@@ -949,11 +1054,21 @@ bool ConnectedClient::handleCommandFull(Command& cmd, bool disconnectOnFail) {
 
     postCommandHandler.clear();
     end = system_clock::now();
-    if(end - start > milliseconds(10)) {
-        if(end - start > milliseconds(100))
-            logError(this->getServerId(), "Command handling of command {} needs {}ms. This could be an issue!", cmd.command(), duration_cast<milliseconds>(end - start).count());
-        else
-            logWarning(this->getServerId(), "Command handling of command {} needs {}ms.", cmd.command(), duration_cast<milliseconds>(end - start).count());
+
+    auto execution_time = duration_cast<nanoseconds>(end - start);
+    auto queue_wait = ServerCommandHandler::current_queue_wait();
+    auto& server_metrics = this->server && this->server->metrics() ? *this->server->metrics() : metrics::registry().instance_metrics();
+    server_metrics.command(command_name(descriptor)).record(queue_wait, execution_time);
+
+    auto slow_threshold = milliseconds{config::log::slow_command_threshold};
+    if(slow_threshold.count() > 0 && execution_time >= slow_threshold) {
+        if(execution_time >= slow_threshold * 10) {
+            logError(this->getServerId(), "{}[Command] Command handling of command {} on server {} needs {}ms (queued for {}ms). This could be an issue!",
+                     CLIENT_STR_LOG_PREFIX, command_name(descriptor), this->getServerId(), duration_cast<milliseconds>(execution_time).count(), duration_cast<milliseconds>(queue_wait).count());
+        } else {
+            logWarning(this->getServerId(), "{}[Command] Command handling of command {} on server {} needs {}ms (queued for {}ms).",
+                       CLIENT_STR_LOG_PREFIX, command_name(descriptor), this->getServerId(), duration_cast<milliseconds>(execution_time).count(), duration_cast<milliseconds>(queue_wait).count());
+        }
     }
     result.release_data();
     return true;
@@ -9,7 +9,10 @@
 #include "music/Song.h"
 #include "../channel/ClientChannelView.h"
 #include "DataClient.h"
+#include "../LockProfiler.h"
 #include "query/command3.h"
+#include "BroadcastCommand.h"
+#include "./command_handler/CommandRegistry.h"
 
 #define CLIENT_STR_LOG_PREFIX_(this) (this->getLoggingPrefix())
 #define CLIENT_STR_LOG_PREFIX CLIENT_STR_LOG_PREFIX_(this)
@@ -69,6 +72,71 @@ namespace ts {
             std::map<std::string, std::string> properties;
         };
 
+        class ConnectedClient;
+
+        /**
+         * A text message notify which gets send to multiple clients.
+         * Every variant of the notify will only be built once. TeamSpeak clients don't receive the channel id.
+         */
+        class TextMessageBroadcast {
+            public:
+                TextMessageBroadcast(ChatMessageMode /* mode */, std::shared_ptr<ConnectedClient> /* sender */, uint64_t /* target id */, ChannelId /* channel id */,
+                                     const std::chrono::system_clock::time_point& /* timestamp */, std::string /* message */);
+
+                [[nodiscard]] inline ChatMessageMode mode() const { return this->mode_; }
+                [[nodiscard]] BroadcastCommand& notify(ConnectedClient& /* recipient */);
+            private:
+                ChatMessageMode mode_;
+                std::shared_ptr<ConnectedClient> sender;
+                uint64_t target_id;
+                ChannelId channel_id;
+                std::chrono::system_clock::time_point timestamp;
+                std::string message;
+
+                /* index 1 contains the notify for TeamSpeak clients */
+                std::array<std::optional<BroadcastCommand>, 2> notifies{};
+        };
+
+        /**
+         * A client moved notify which gets send to every client seeing the move.
+         * The notify is equal for all recipients and will only be built once.
+         */
+        class ClientMovedBroadcast {
+            public:
+                ClientMovedBroadcast(std::shared_ptr<ConnectedClient> /* client */, std::shared_ptr<BasicChannel> /* target channel */, ViewReasonId /* reason */,
+                                     std::string /* message */, std::shared_ptr<ConnectedClient> /* invoker */);
+
+                [[nodiscard]] inline const std::shared_ptr<ConnectedClient>& client() const { return this->client_; }
+                [[nodiscard]] inline const std::shared_ptr<BasicChannel>& target_channel() const { return this->target_channel_; }
+                [[nodiscard]] BroadcastCommand& notify();
+            private:
+                std::shared_ptr<ConnectedClient> client_;
+                std::shared_ptr<BasicChannel> target_channel_;
+                ViewReasonId reason;
+                std::string message;
+                std::shared_ptr<ConnectedClient> invoker;
+
+                std::optional<BroadcastCommand> notify_{};
+        };
+
+        /**
+         * A client updated notify which gets send to every client seeing the updated client.
+         * Recipients which are tracking their own online time receive the online times including the current session.
+         */
+        class ClientUpdatedBroadcast {
+            public:
+                ClientUpdatedBroadcast(std::shared_ptr<ConnectedClient> /* client */, const std::deque<const property::PropertyDescription*>& /* properties */);
+
+                [[nodiscard]] inline const std::shared_ptr<ConnectedClient>& client() const { return this->client_; }
+                [[nodiscard]] BroadcastCommand& notify(bool /* include session online time */);
+            private:
+                std::shared_ptr<ConnectedClient> client_;
+                const std::deque<const property::PropertyDescription*>& properties;
+
+                /* index 1 contains the notify including the session online time */
+                std::array<std::optional<BroadcastCommand>, 2> notifies{};
+        };
+
         class ConnectedClient : public DataClient {
                 friend class VirtualServer;
                 friend class VoiceClient;
@@ -81,7 +149,10 @@ namespace ts {
                 friend class SpeakingClient;
                 friend class connection::VoiceClientConnection;
                 friend class VirtualServerManager;
+                friend class ClientUpdatedBroadcast;
             public:
+                using command_mutex_t = lock_profiler::profiled_mutex_t<threads::Mutex, "ConnectedClient::command_lock">;
+
                 explicit ConnectedClient(sql::SqlManager*, const std::shared_ptr<VirtualServer>& server);
                 ~ConnectedClient() override;
 
@@ -104,6 +175,8 @@ namespace ts {
                 /* Note: Order is not guaranteed here! */
                 virtual void sendCommand(const ts::Command& command, bool low = false) = 0;
                 virtual void sendCommand(const ts::command_builder& command, bool low = false) = 0;
+                virtual void sendCommand(const ts::command_arena_builder& command, bool low = false) = 0;
+                virtual void sendCommand(BroadcastCommand& command, bool low = false) = 0;
 
                 //General manager stuff
                 //FIXME cache the client id for speedup
@@ -154,12 +227,14 @@ namespace ts {
                         const std::deque<const property::PropertyDescription*> &,
                         bool lock_channel_tree
                 ); /* invalid client id causes error: invalid clientID */
+                virtual bool notifyClientUpdated(ClientUpdatedBroadcast& /* notify */); /* channel lock must be shared locked */
 
                 virtual bool notifyPluginCmd(std::string name, std::string msg, std::shared_ptr<ConnectedClient>);
                 //Group manager chat
                 virtual bool notifyClientChatComposing(const std::shared_ptr<ConnectedClient> &);
                 virtual bool notifyClientChatClosed(const std::shared_ptr<ConnectedClient> &);
                 virtual bool notifyTextMessage(ChatMessageMode mode, const std::shared_ptr<ConnectedClient> &sender, uint64_t targetId, ChannelId channel_id, const std::chrono::system_clock::time_point& /* timestamp */, const std::string &textMessage);
+                virtual bool notifyTextMessage(TextMessageBroadcast& /* notify */);
                 inline void sendChannelMessage(const std::shared_ptr<ConnectedClient>& sender, const std::string& textMessage){
                     this->notifyTextMessage(ChatMessageMode::TEXTMODE_CHANNEL, sender, this->currentChannel ? this->currentChannel->channelId() : 0, 0, std::chrono::system_clock::now(), textMessage);
                 }
@@ -235,6 +310,7 @@ namespace ts {
                         std::shared_ptr<ConnectedClient> invoker,
                         bool lock_channel_tree
                 );
+                virtual bool notifyClientMoved(ClientMovedBroadcast& /* notify */); /* channel lock must be shared locked */
                 virtual bool notifyClientLeftView(
                         const std::shared_ptr<ConnectedClient> &client,
                         const std::shared_ptr<BasicChannel> &target_channel,
@@ -444,10 +520,20 @@ namespace ts {
 
                 virtual void tick_server(const std::chrono::system_clock::time_point &time);
                 //Locked by everything who has something todo with command handling
-                threads::Mutex command_lock; /* Note: This mutex must be recursive! */
+                command_mutex_t command_lock{}; /* Note: This mutex must be recursive! */
                 std::vector<std::function<void()>> postCommandHandler;
                 virtual bool handleCommandFull(Command&, bool disconnectOnFail = false);
-                virtual command_result handleCommand(Command&);
+                /* Handles a command flagged with CommandDescriptor::kFlagParserView directly from its raw payload */
+                bool handleCommandFull(const ts::command_parser&, const CommandDescriptor& /* descriptor */, bool disconnectOnFail = false);
+                virtual command_result handleCommand(Command&, CommandId /* command id */);
+                virtual command_result handleCommandView(const ts::command_parser&, CommandId /* command id */);
+                /* Validates the client type, server, flood and permission requirements of the command registry */
+                command_result check_command_requirements(const CommandDescriptor& /* descriptor */);
+
+                template <typename command_t>
+                bool handle_command_full(command_t& /* command */, const CommandDescriptor& /* descriptor */, bool /* disconnect on fail */);
+                command_result dispatch_command(Command&, const CommandDescriptor& /* descriptor */);
+                command_result dispatch_command(const ts::command_parser&, const CommandDescriptor& /* descriptor */);
 
                 command_result handleCommandServerGetVariables(Command&);
                 command_result handleCommandServerEdit(Command&);
@@ -462,15 +548,15 @@ namespace ts {
                 command_result handleCommandServerGroupList(Command&);
 
                 command_result handleCommandClientGetIds(Command&);
-                command_result handleCommandClientUpdate(Command&);
-                command_result handleCommandClientEdit(Command&);
-                command_result handleCommandClientEdit(Command&, const std::shared_ptr<ConnectedClient>& /* target */);
-                command_result handleCommandClientMove(Command&);
+                command_result handleCommandClientUpdate(const ts::command_parser&);
+                command_result handleCommandClientEdit(const ts::command_parser&);
+                command_result handleCommandClientEdit(const ts::command_parser&, const std::shared_ptr<ConnectedClient>& /* target */);
+                command_result handleCommandClientMove(const ts::command_parser&);
                 command_result handleCommandClientGetVariables(Command&);
                 command_result handleCommandClientKick(Command&);
                 command_result handleCommandClientPoke(Command&);
 
-                command_result handleCommandChannelSubscribe(Command&);
+                command_result handleCommandChannelSubscribe(const ts::command_parser&);
                 command_result handleCommandChannelSubscribeAll(Command&);
                 command_result handleCommandChannelUnsubscribe(Command&);
                 command_result handleCommandChannelUnsubscribeAll(Command&);
@@ -517,7 +603,7 @@ namespace ts {
                 command_result handleCommandChannelGroupDelPerm(Command&);
                 command_result handleCommandSetClientChannelGroup(Command&);
 
-                command_result handleCommandSendTextMessage(Command&);
+                command_result handleCommandSendTextMessage(const ts::command_parser&);
                 command_result handleCommandClientChatComposing(Command&);
                 command_result handleCommandClientChatClosed(Command&);
 
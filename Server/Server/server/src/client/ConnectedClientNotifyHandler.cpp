@@ -211,7 +211,7 @@ bool ConnectedClient::notifyClientPermList(ClientDbId cldbid, const std::shared_
     return true;
 }
 
-bool ConnectedClient::notifyTextMessage(ChatMessageMode mode, const shared_ptr<ConnectedClient> &invoker, uint64_t targetId, ChannelId channel_id, const std::chrono::system_clock::time_point& timestamp, const string &textMessage) {
+inline Command build_text_message_notify(ChatMessageMode mode, const shared_ptr<ConnectedClient> &invoker, uint64_t targetId, ChannelId channel_id, const std::chrono::system_clock::time_point& timestamp, const string &textMessage, bool teamspeak_client) {
     //notifytextmessage targetmode=1 msg=asdasd target=2 invokerid=1 invokername=WolverinDEV invokeruid=xxjnc14LmvTk+Lyrm8OOeo4tOqw=
     Command cmd("notifytextmessage");
     INVOKER(cmd, invoker);
@@ -219,12 +219,34 @@ bool ConnectedClient::notifyTextMessage(ChatMessageMode mode, const shared_ptr<C
     cmd["target"] = targetId;
     cmd["msg"] = textMessage;
     cmd["timestamp"] = floor<milliseconds>(timestamp.time_since_epoch()).count();
-    if(this->getType() != ClientType::CLIENT_TEAMSPEAK)
+    if(!teamspeak_client)
         cmd["cid"] = channel_id;
-    this->sendCommand(cmd);
+    return cmd;
+}
+
+bool ConnectedClient::notifyTextMessage(ChatMessageMode mode, const shared_ptr<ConnectedClient> &invoker, uint64_t targetId, ChannelId channel_id, const std::chrono::system_clock::time_point& timestamp, const string &textMessage) {
+    this->sendCommand(build_text_message_notify(mode, invoker, targetId, channel_id, timestamp, textMessage, this->getType() == ClientType::CLIENT_TEAMSPEAK));
     return true;
 }
 
+bool ConnectedClient::notifyTextMessage(TextMessageBroadcast &notify) {
+    this->sendCommand(notify.notify(*this));
+    return true;
+}
+
+TextMessageBroadcast::TextMessageBroadcast(ChatMessageMode mode, std::shared_ptr<ConnectedClient> sender, uint64_t target_id, ChannelId channel_id,
+                                           const std::chrono::system_clock::time_point &timestamp, std::string message) :
+        mode_{mode}, sender{std::move(sender)}, target_id{target_id}, channel_id{channel_id}, timestamp{timestamp}, message{std::move(message)} {}
+
+BroadcastCommand& TextMessageBroadcast::notify(ConnectedClient &recipient) {
+    auto teamspeak_client = recipient.getType() == ClientType::CLIENT_TEAMSPEAK;
+    auto& notify = this->notifies[teamspeak_client];
+    if(!notify.has_value()) {
+        notify.emplace(build_text_message_notify(this->mode_, this->sender, this->target_id, this->channel_id, this->timestamp, this->message, teamspeak_client).build());
+    }
+    return *notify;
+}
+
 bool ConnectedClient::notifyServerGroupClientAdd(
         std::optional<ts::command_builder>& notify,
         const std::shared_ptr<ConnectedClient> &invoker,
@@ -232,7 +254,7 @@ bool ConnectedClient::notifyServerGroupClientAdd(
         const GroupId& group_id) {
 
     /* Deny any client moves 'till we've send the notify */
-    std::shared_lock<std::shared_mutex> channel_tree_lock{};
+    std::shared_lock<VirtualServer::channel_tree_mutex_t> channel_tree_lock{};
     if(this->server) {
         channel_tree_lock = std::shared_lock{this->server->channel_tree_mutex};
     }
@@ -262,7 +284,7 @@ bool ConnectedClient::notifyServerGroupClientRemove(
         const GroupId& group_id) {
 
     /* Deny any client moves 'till we've send the notify */
-    std::shared_lock<std::shared_mutex> channel_tree_lock{};
+    std::shared_lock<VirtualServer::channel_tree_mutex_t> channel_tree_lock{};
     if(this->server) {
         channel_tree_lock = std::shared_lock{this->server->channel_tree_mutex};
     }
@@ -292,7 +314,7 @@ bool ConnectedClient::notifyClientChannelGroupChanged(std::optional<ts::command_
                                                       const ChannelId &inherited_channel_id,
                                                       const GroupId &group_id) {
     /* Deny any client moves 'till we've send the notify */
-    std::shared_lock<std::shared_mutex> channel_tree_lock{};
+    std::shared_lock<VirtualServer::channel_tree_mutex_t> channel_tree_lock{};
     if(this->server) {
         channel_tree_lock = std::shared_lock{this->server->channel_tree_mutex};
     }
@@ -435,6 +457,20 @@ bool ConnectedClient::notifyConnectionInfo(const shared_ptr<ConnectedClient> &ta
     return true;
 }
 
+inline Command build_client_moved_notify(const shared_ptr<ConnectedClient> &client, const std::shared_ptr<BasicChannel> &target_channel, ViewReasonId reason, const std::string& msg, const std::shared_ptr<ConnectedClient>& invoker) {
+    Command mv("notifyclientmoved");
+
+    mv["clid"] = client->getClientId();
+    mv["cfid"] = client->currentChannel->channelId();
+    mv["ctid"] = target_channel->channelId();
+    mv["reasonid"] = reason;
+    if (invoker)
+        INVOKER(mv, invoker);
+    if (!msg.empty()) mv["reasonmsg"] = msg;
+    else mv["reasonmsg"] = "";
+    return mv;
+}
+
 bool ConnectedClient::notifyClientMoved(const shared_ptr<ConnectedClient> &client,
                                         const std::shared_ptr<BasicChannel> &target_channel,
                                         ViewReasonId reason,
@@ -449,21 +485,47 @@ bool ConnectedClient::notifyClientMoved(const shared_ptr<ConnectedClient> &clien
     sassert(mutex_shared_locked(client->channel_tree_mutex));
     assert(this->isClientVisible(client, false) || &*client == this);
 
-    Command mv("notifyclientmoved");
+    this->sendCommand(build_client_moved_notify(client, target_channel, reason, msg, invoker));
+    return true;
+}
 
-    mv["clid"] = client->getClientId();
-    mv["cfid"] = client->currentChannel->channelId();
-    mv["ctid"] = target_channel->channelId();
-    mv["reasonid"] = reason;
-    if (invoker)
-        INVOKER(mv, invoker);
-    if (!msg.empty()) mv["reasonmsg"] = msg;
-    else mv["reasonmsg"] = "";
+bool ConnectedClient::notifyClientMoved(ClientMovedBroadcast &notify) {
+    assert(notify.client()->getClientId() > 0);
+    assert(notify.client()->currentChannel);
+    assert(notify.target_channel());
+    sassert(mutex_shared_locked(this->channel_tree_mutex));
+    sassert(mutex_shared_locked(notify.client()->channel_tree_mutex));
+    assert(this->isClientVisible(notify.client(), false) || &*notify.client() == this);
 
-    this->sendCommand(mv);
+    this->sendCommand(notify.notify());
     return true;
 }
 
+ClientMovedBroadcast::ClientMovedBroadcast(std::shared_ptr<ConnectedClient> client, std::shared_ptr<BasicChannel> target_channel, ViewReasonId reason,
+                                           std::string message, std::shared_ptr<ConnectedClient> invoker) :
+        client_{std::move(client)}, target_channel_{std::move(target_channel)}, reason{reason}, message{std::move(message)}, invoker{std::move(invoker)} {}
+
+BroadcastCommand& ClientMovedBroadcast::notify() {
+    /* build it with the first recipient since the source channel of the client is still the old one */
+    if(!this->notify_.has_value()) {
+        this->notify_.emplace(build_client_moved_notify(this->client_, this->target_channel_, this->reason, this->message, this->invoker).build());
+    }
+    return *this->notify_;
+}
+
+/* the session online time will be added to the online time properties if set */
+inline Command build_client_updated_notify(const std::shared_ptr<ConnectedClient> &client, const deque<const property::PropertyDescription*> &props, const std::optional<int64_t>& session_online_time) {
+    Command response("notifyclientupdated");
+    response["clid"] = client->getClientId();
+    for (const auto &prop : props) {
+        if(session_online_time && (*prop == property::CLIENT_TOTAL_ONLINE_TIME || *prop == property::CLIENT_MONTH_ONLINE_TIME))
+            response[prop->name] = client->properties()[prop].as_or<int64_t>(0) + *session_online_time;
+        else
+            response[prop->name] = client->properties()[prop].value();
+    }
+    return response;
+}
+
 bool ConnectedClient::notifyClientUpdated(const std::shared_ptr<ConnectedClient> &client, const deque<const property::PropertyDescription*> &props, bool lock) {
     std::shared_lock channel_lock(this->channel_tree_mutex, defer_lock);
     if(lock) {
@@ -479,19 +541,45 @@ bool ConnectedClient::notifyClientUpdated(const std::shared_ptr<ConnectedClient>
         logError(this->getServerId(), "{} Attempted to send a clientupdate for client id 0. Updated client: {}", CLIENT_STR_LOG_PREFIX, CLIENT_STR_LOG_PREFIX_(client));
         return false;
     }
-    Command response("notifyclientupdated");
-    response["clid"] = client_id;
-    for (const auto &prop : props) {
-        if(lastOnlineTimestamp.time_since_epoch().count() > 0 && (*prop == property::CLIENT_TOTAL_ONLINE_TIME || *prop == property::CLIENT_MONTH_ONLINE_TIME))
-            response[prop->name] = client->properties()[prop].as_or<int64_t>(0) + duration_cast<seconds>(system_clock::now() - client->lastOnlineTimestamp).count();
-        else
-            response[prop->name] = client->properties()[prop].value();
+
+    std::optional<int64_t> session_online_time{};
+    if(lastOnlineTimestamp.time_since_epoch().count() > 0) {
+        session_online_time = duration_cast<seconds>(system_clock::now() - client->lastOnlineTimestamp).count();
     }
+    this->sendCommand(build_client_updated_notify(client, props, session_online_time));
+    return true;
+}
 
-    this->sendCommand(response);
+bool ConnectedClient::notifyClientUpdated(ClientUpdatedBroadcast &notify) {
+    sassert(mutex_shared_locked(this->channel_tree_mutex));
+    const auto& client = notify.client();
+    if(!this->isClientVisible(client, false) && client != this)
+        return false;
+
+    if(client->getClientId() == 0) {
+        logError(this->getServerId(), "{} Attempted to send a clientupdate for client id 0. Updated client: {}", CLIENT_STR_LOG_PREFIX, CLIENT_STR_LOG_PREFIX_(client));
+        return false;
+    }
+
+    this->sendCommand(notify.notify(lastOnlineTimestamp.time_since_epoch().count() > 0));
     return true;
 }
 
+ClientUpdatedBroadcast::ClientUpdatedBroadcast(std::shared_ptr<ConnectedClient> client, const std::deque<const property::PropertyDescription*> &properties) :
+        client_{std::move(client)}, properties{properties} {}
+
+BroadcastCommand& ClientUpdatedBroadcast::notify(bool session_online_time) {
+    auto& notify = this->notifies[session_online_time];
+    if(!notify.has_value()) {
+        std::optional<int64_t> online_time{};
+        if(session_online_time) {
+            online_time = duration_cast<seconds>(system_clock::now() - this->client_->lastOnlineTimestamp).count();
+        }
+        notify.emplace(build_client_updated_notify(this->client_, this->properties, online_time).build());
+    }
+    return *notify;
+}
+
 bool ConnectedClient::notifyPluginCmd(std::string name, std::string msg, std::shared_ptr<ConnectedClient> sender) {
     Command notify("notifyplugincmd");
     notify["name"] = name;
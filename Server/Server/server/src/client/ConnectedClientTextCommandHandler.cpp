@@ -3,6 +3,7 @@
 #include <netinet/in.h>
 #include <log/LogUtils.h>
 #include <misc/strobf.h>
+#include <query/escape.h>
 
 #include "../InstanceHandler.h"
 #include "../manager/ConversationManager.h"
@@ -217,8 +218,9 @@ bool ConnectedClient::handle_text_command(
                 ss << *it << (it + 1 == arguments.end() ? "" : " ");
             string name = ss.str();
 
-            Command cmd("");
-            cmd["client_nickname"] = ss.str();
+            auto command_string = "client_nickname=" + query::escape(name);
+            ts::command_parser cmd{std::string_view{command_string}};
+            (void) cmd.parse(false);
             auto result = this->handleCommandClientEdit(cmd, bot);
             if(result.has_error()) {
                 HANDLE_CMD_ERROR("Failed to rename bot");
@@ -504,9 +506,10 @@ bool ConnectedClient::handle_text_command(
                     send_message(bot, "Bot property " + std::string{property_info.name} + " = " + prop.value() + " " + (property_info.default_value == prop.value() ? "(default)" : ""));
                     return true;
                 } else {
-                    Command cmd("");
                     JOIN_ARGS(value, 3);
-                    cmd[arguments[2]] = value;
+                    auto command_string = arguments[2] + "=" + query::escape(value);
+                    ts::command_parser cmd{std::string_view{command_string}};
+                    (void) cmd.parse(false);
                     auto result = this->handleCommandClientEdit(cmd, bot);
                     if(result.has_error()) {
                         HANDLE_CMD_ERROR("Failed to change bot property");
@@ -24,6 +24,8 @@ InternalClient::~InternalClient() {
 
 void InternalClient::sendCommand(const ts::Command &command, bool low) { }
 void InternalClient::sendCommand(const ts::command_builder &command, bool low) { }
+void InternalClient::sendCommand(const ts::command_arena_builder &command, bool low) { }
+void InternalClient::sendCommand(BroadcastCommand &command, bool low) { }
 
 bool InternalClient::close_connection(const std::chrono::system_clock::time_point& timeout) {
     logError(this->getServerId(), "Internal client is force to disconnect?");
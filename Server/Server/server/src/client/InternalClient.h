@@ -15,6 +15,8 @@ namespace ts::server {
 
             void sendCommand(const ts::Command &command, bool low) override;
             void sendCommand(const ts::command_builder &command, bool low) override;
+            void sendCommand(const ts::command_arena_builder &command, bool low) override;
+            void sendCommand(BroadcastCommand &command, bool low) override;
             bool close_connection(const std::chrono::system_clock::time_point& timeout = std::chrono::system_clock::time_point()) override;
             bool disconnect(const std::string &reason) override;
         protected:
@@ -762,16 +762,22 @@ void SpeakingClient::updateChannelClientProperties(bool channel_lock, bool notif
     this->max_idle_time = this->calculate_permission(permission::i_client_max_idletime, this->currentChannel ? this->currentChannel->channelId() : 0);
 }
 
-command_result SpeakingClient::handleCommand(Command &command) {
+command_result SpeakingClient::handleCommand(Command &command, CommandId command_id) {
     if(this->connectionState() == ConnectionState::INIT_HIGH) {
         if(this->handshake.state == HandshakeState::BEGIN || this->handshake.state == HandshakeState::IDENTITY_PROOF) {
             command_result result;
-            if(command.command() == "handshakebegin") {
-                result.reset(this->handleCommandHandshakeBegin(command));
-            } else if(command.command() == "handshakeindentityproof") {
-                result.reset(this->handleCommandHandshakeIdentityProof(command));
-            } else {
-                result.reset(command_result{error::client_not_logged_in});
+            switch(command_id) {
+                case CommandId::HandshakeBegin:
+                    result.reset(this->handleCommandHandshakeBegin(command));
+                    break;
+
+                case CommandId::HandshakeIdentityProof:
+                    result.reset(this->handleCommandHandshakeIdentityProof(command));
+                    break;
+
+                default:
+                    result.reset(command_result{error::client_not_logged_in});
+                    break;
             }
 
             if(result.has_error()) {
@@ -782,27 +788,34 @@ command_result SpeakingClient::handleCommand(Command &command) {
             return result;
         }
     } else if(this->connectionState() == ConnectionState::CONNECTED) {
-        if(command.command() == "rtcsessiondescribe") {
-            return this->handleCommandRtcSessionDescribe(command);
-        } else if(command.command() == "rtcicecandidate") {
-            return this->handleCommandRtcIceCandidate(command);
-        } else if(command.command() == "rtcsessionreset") {
-            return this->handleCommandRtcSessionReset(command);
-        } else if(command.command() == "broadcastaudio") {
-            return this->handleCommandBroadcastAudio(command);
-        } else if(command.command() == "broadcastvideo") {
-            return this->handleCommandBroadcastVideo(command);
-        } else if(command.command() == "broadcastvideojoin") {
-            return this->handleCommandBroadcastVideoJoin(command);
-        } else if(command.command() == "broadcastvideoleave") {
-            return this->handleCommandBroadcastVideoLeave(command);
-        } else if(command.command() == "broadcastvideoconfig") {
-            return this->handleCommandBroadcastVideoConfig(command);
-        } else if(command.command() == "broadcastvideoconfigure") {
-            return this->handleCommandBroadcastVideoConfigure(command);
+        switch(command_id) {
+            case CommandId::RtcSessionDescribe: return this->handleCommandRtcSessionDescribe(command);
+            case CommandId::RtcIceCandidate: return this->handleCommandRtcIceCandidate(command);
+            case CommandId::RtcSessionReset: return this->handleCommandRtcSessionReset(command);
+            case CommandId::BroadcastAudio: return this->handleCommandBroadcastAudio(command);
+            case CommandId::BroadcastVideo: return this->handleCommandBroadcastVideo(command);
+            case CommandId::BroadcastVideoJoin: return this->handleCommandBroadcastVideoJoin(command);
+            case CommandId::BroadcastVideoLeave: return this->handleCommandBroadcastVideoLeave(command);
+            case CommandId::BroadcastVideoConfig: return this->handleCommandBroadcastVideoConfig(command);
+            case CommandId::BroadcastVideoConfigure: return this->handleCommandBroadcastVideoConfigure(command);
+            default:
+                break;
+        }
+    }
+    return ConnectedClient::handleCommand(command, command_id);
+}
+
+command_result SpeakingClient::handleCommandView(const ts::command_parser &command, CommandId command_id) {
+    if(this->connectionState() == ConnectionState::INIT_HIGH) {
+        if(this->handshake.state == HandshakeState::BEGIN || this->handshake.state == HandshakeState::IDENTITY_PROOF) {
+            /* None of the handshake commands has been migrated to the command parser */
+            this->postCommandHandler.push_back([&]{
+                this->close_connection(system_clock::now() + seconds(1));
+            });
+            return command_result{error::client_not_logged_in};
         }
     }
-    return ConnectedClient::handleCommand(command);
+    return ConnectedClient::handleCommandView(command, command_id);
 }
 
 command_result SpeakingClient::handleCommandRtcSessionDescribe(Command &command) {
@@ -843,9 +856,6 @@ command_result SpeakingClient::handleCommandRtcSessionDescribe(Command &command)
 }
 
 command_result SpeakingClient::handleCommandRtcSessionReset(Command &command) {
-    CMD_REQ_SERVER;
-    CMD_CHK_AND_INC_FLOOD_POINTS(15);
-
     this->server->rtc_server().reset_rtp_session(this->rtc_client_id);
     if(this->getType() == ClientType::CLIENT_TEASPEAK) {
         /* registering the broadcast again since rtp session reset resets the broadcasts as well */
@@ -934,18 +944,12 @@ inline command_result broadcast_start_result_to_command_result(rtc::BroadcastSta
 }
 
 command_result SpeakingClient::handleCommandBroadcastAudio(Command &command) {
-    CMD_REQ_SERVER;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-
     auto ssrc = command[0].has("ssrc") ? command["ssrc"].as<uint32_t>() : (uint32_t) 0;
     auto broadcast_result = this->server->rtc_server().start_broadcast_audio(this->rtc_client_id, ssrc);
     return broadcast_start_result_to_command_result(broadcast_result);
 }
 
 command_result SpeakingClient::handleCommandBroadcastVideo(Command &command) {
-    CMD_REQ_SERVER;
-    CMD_CHK_AND_INC_FLOOD_POINTS(15);
-
     auto ssrc = command[0].has("ssrc") ? command["ssrc"].as<uint32_t>() : (uint32_t) 0;
     auto type = (rtc::VideoBroadcastType) command["type"].as<uint8_t>();
 
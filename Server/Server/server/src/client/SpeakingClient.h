@@ -57,7 +57,8 @@ namespace ts::server {
             void updateChannelClientProperties(bool channel_lock, bool notify) override;
 
         protected:
-            command_result handleCommand(Command &command) override;
+            command_result handleCommand(Command &command, CommandId command_id) override;
+            command_result handleCommandView(const ts::command_parser &command, CommandId command_id) override;
 
         public:
             virtual void processJoin();
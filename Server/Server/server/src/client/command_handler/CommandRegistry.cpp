@@ -0,0 +1,340 @@
+#include "./CommandRegistry.h"
+#include <array>
+
+using namespace ts;
+using namespace ts::server;
+
+namespace {
+    constexpr uint8_t client_type_mask(ClientType type) { return 1U << (uint8_t) type; }
+
+    constexpr uint8_t kQueryClients{client_type_mask(ClientType::CLIENT_QUERY)};
+    constexpr uint8_t kVoiceClients{(uint8_t) (client_type_mask(ClientType::CLIENT_TEAMSPEAK) | client_type_mask(ClientType::CLIENT_TEASPEAK))};
+    constexpr uint8_t kWebClients{client_type_mask(ClientType::CLIENT_WEB)};
+    constexpr uint8_t kSpeakingClients{(uint8_t) (kVoiceClients | kWebClients)};
+
+    struct CommandBuilder {
+        CommandDescriptor descriptor{};
+
+        constexpr CommandBuilder clients(uint8_t client_types) const {
+            auto result = *this;
+            result.descriptor.client_types = client_types;
+            return result;
+        }
+
+        constexpr CommandBuilder requires_server() const {
+            auto result = *this;
+            result.descriptor.flags |= CommandDescriptor::kFlagRequiresServer;
+            return result;
+        }
+
+        constexpr CommandBuilder flood(uint16_t points) const {
+            auto result = *this;
+            result.descriptor.flags |= CommandDescriptor::kFlagFloodCheck;
+            result.descriptor.flood_points = points;
+            return result;
+        }
+
+        constexpr CommandBuilder permission(permission::PermissionType permission) const {
+            auto result = *this;
+            result.descriptor.permission = permission;
+            return result;
+        }
+
+        constexpr CommandBuilder lockless() const {
+            auto result = *this;
+            result.descriptor.flags |= CommandDescriptor::kFlagLockless;
+            return result;
+        }
+
+        constexpr CommandBuilder parser_view() const {
+            auto result = *this;
+            result.descriptor.flags |= CommandDescriptor::kFlagParserView;
+            return result;
+        }
+    };
+
+    constexpr CommandBuilder command(std::string_view name, CommandId id) {
+        return CommandBuilder{CommandDescriptor{name, id}};
+    }
+
+    template <typename... builder_t>
+    constexpr auto build_registry(const builder_t&... builders) {
+        return std::array<CommandDescriptor, sizeof...(builder_t)>{builders.descriptor...};
+    }
+
+    /* Flood points, permissions and the server requirement must match the checks the handlers previously did by themself */
+    constexpr auto kCommands = build_registry(
+            command("servergetvariables", CommandId::ServerGetVariables),
+            command("serverrequestconnectioninfo", CommandId::ServerRequestConnectionInfo).requires_server().permission(permission::b_virtualserver_connectioninfo_view),
+            command("getconnectioninfo", CommandId::GetConnectionInfo).requires_server().flood(5),
+            command("setconnectioninfo", CommandId::SetConnectionInfo),
+            command("clientgetvariables", CommandId::ClientGetVariables),
+            command("serveredit", CommandId::ServerEdit).flood(5),
+            command("clientedit", CommandId::ClientEdit).parser_view(),
+            command("channelgetdescription", CommandId::ChannelGetDescription).flood(0),
+            command("connectioninfoautoupdate", CommandId::ConnectionInfoAutoUpdate),
+            command("permissionlist", CommandId::PermissionList),
+            command("propertylist", CommandId::PropertyList).lockless(),
+            command("servergrouplist", CommandId::ServerGroupList).flood(5).permission(permission::b_virtualserver_servergroup_list),
+            command("servergroupadd", CommandId::ServerGroupAdd),
+            command("servergroupcopy", CommandId::ServerGroupCopy),
+            command("servergroupdel", CommandId::ServerGroupDel),
+            command("servergrouprename", CommandId::ServerGroupRename),
+            command("servergroupclientlist", CommandId::ServerGroupClientList).flood(5).permission(permission::b_virtualserver_servergroup_client_list),
+            command("servergroupaddclient", CommandId::ServerGroupAddClient).flood(25),
+            command("clientaddservergroup", CommandId::ServerGroupAddClient).flood(25),
+            command("servergroupdelclient", CommandId::ServerGroupDelClient).flood(25),
+            command("clientdelservergroup", CommandId::ServerGroupDelClient).flood(25),
+            command("servergrouppermlist", CommandId::ServerGroupPermList).flood(5).permission(permission::b_virtualserver_servergroup_permission_list),
+            command("servergroupaddperm", CommandId::ServerGroupAddPerm).flood(5),
+            command("servergroupdelperm", CommandId::ServerGroupDelPerm).flood(5),
+            command("setclientchannelgroup", CommandId::SetClientChannelGroup).requires_server().flood(25),
+            command("channelcreate", CommandId::ChannelCreate).flood(25),
+            command("channelmove", CommandId::ChannelMove).flood(25),
+            command("channeledit", CommandId::ChannelEdit).flood(25),
+            command("channeldelete", CommandId::ChannelDelete).flood(25),
+            command("channelfind", CommandId::ChannelFind).flood(5),
+            command("channelinfo", CommandId::ChannelInfo),
+            command("channelpermlist", CommandId::ChannelPermList).flood(5),
+            command("channeladdperm", CommandId::ChannelAddPerm).flood(5),
+            command("channeldelperm", CommandId::ChannelDelPerm),
+            command("channelgroupadd", CommandId::ChannelGroupAdd),
+            command("channelgroupcopy", CommandId::ChannelGroupCopy),
+            command("channelgrouprename", CommandId::ChannelGroupRename),
+            command("channelgroupdel", CommandId::ChannelGroupDel),
+            command("channelgrouplist", CommandId::ChannelGroupList).flood(5).permission(permission::b_virtualserver_channelgroup_list),
+            command("channelgroupclientlist", CommandId::ChannelGroupClientList).requires_server().flood(5),
+            command("channelgrouppermlist", CommandId::ChannelGroupPermList).flood(5).permission(permission::b_virtualserver_channelgroup_permission_list),
+            command("channelgroupaddperm", CommandId::ChannelGroupAddPerm).flood(5),
+            command("channelgroupdelperm", CommandId::ChannelGroupDelPerm).flood(5),
+            command("channelsubscribe", CommandId::ChannelSubscribe).parser_view(),
+            command("channelsubscribeall", CommandId::ChannelSubscribeAll).requires_server().flood(20),
+            command("channelunsubscribe", CommandId::ChannelUnsubscribe).requires_server().flood(5),
+            command("channelunsubscribeall", CommandId::ChannelUnsubscribeAll).requires_server().flood(25),
+            command("channelclientpermlist", CommandId::ChannelClientPermList).requires_server().flood(5),
+            command("channelclientaddperm", CommandId::ChannelClientAddPerm),
+            command("channelclientdelperm", CommandId::ChannelClientDelPerm),
+            command("clientupdate", CommandId::ClientUpdate).parser_view(),
+            command("clientmove", CommandId::ClientMove).requires_server().flood(10).parser_view(),
+            command("clientgetids", CommandId::ClientGetIds),
+            command("clientkick", CommandId::ClientKick).requires_server().flood(25),
+            command("clientpoke", CommandId::ClientPoke).requires_server().flood(25),
+            command("sendtextmessage", CommandId::SendTextMessage).requires_server().flood(5).parser_view(),
+            command("clientchatcomposing", CommandId::ClientChatComposing).requires_server().flood(0),
+            command("clientchatclosed", CommandId::ClientChatClosed).requires_server().flood(5),
+            command("clientfind", CommandId::ClientFind).requires_server().flood(5),
+            command("clientinfo", CommandId::ClientInfo),
+            command("clientaddperm", CommandId::ClientAddPerm).requires_server().flood(5),
+            command("clientdelperm", CommandId::ClientDelPerm).requires_server().flood(5),
+            command("clientpermlist", CommandId::ClientPermList).requires_server().flood(5).permission(permission::b_virtualserver_client_permission_list),
+            command("ftgetfilelist", CommandId::FTGetFileList),
+            command("ftcreatedir", CommandId::FTCreateDir),
+            command("ftdeletefile", CommandId::FTDeleteFile),
+            command("ftinitupload", CommandId::FTInitUpload),
+            command("ftinitdownload", CommandId::FTInitDownload),
+            command("ftgetfileinfo", CommandId::FTGetFileInfo),
+            command("ftrenamefile", CommandId::FTRenameFile).requires_server().flood(5),
+            command("ftlist", CommandId::FTList).requires_server().flood(25),
+            command("ftstop", CommandId::FTStop).requires_server().flood(25),
+            command("banlist", CommandId::BanList).flood(25),
+            command("banadd", CommandId::BanAdd).flood(25),
+            command("banedit", CommandId::BanEdit).flood(25),
+            command("banclient", CommandId::BanClient).requires_server().flood(25),
+            command("bandel", CommandId::BanDel).flood(5),
+            command("bandelall", CommandId::BanDelAll).requires_server().flood(25).permission(permission::b_client_ban_delete),
+            command("bantriggerlist", CommandId::BanTriggerList).requires_server().flood(25).permission(permission::b_client_ban_trigger_list),
+            command("tokenactionlist", CommandId::TokenActionList).requires_server().flood(5),
+            command("tokenlist", CommandId::TokenList).requires_server().flood(5),
+            command("privilegekeylist", CommandId::TokenList).requires_server().flood(5),
+            command("tokenadd", CommandId::TokenAdd).requires_server().flood(5),
+            command("privilegekeyadd", CommandId::TokenAdd).requires_server().flood(5),
+            command("tokenedit", CommandId::TokenEdit).requires_server().flood(15),
+            command("tokenuse", CommandId::TokenUse).requires_server().flood(5),
+            command("privilegekeyuse", CommandId::TokenUse).requires_server().flood(5),
+            command("tokendelete", CommandId::TokenDelete).requires_server().flood(5),
+            command("privilegekeydelete", CommandId::TokenDelete).requires_server().flood(5),
+            command("clientdblist", CommandId::ClientDbList).requires_server().flood(25).permission(permission::b_virtualserver_client_dblist),
+            command("clientdbinfo", CommandId::ClientDbInfo).requires_server().flood(5).permission(permission::b_virtualserver_client_dbinfo),
+            command("clientdbedit", CommandId::ClientDBEdit).requires_server().flood(5).permission(permission::b_client_modify_dbproperties),
+            command("clientdbfind", CommandId::ClientDBFind).requires_server().flood(5).permission(permission::b_virtualserver_client_dbsearch),
+            command("clientdbdelete", CommandId::ClientDBDelete).requires_server().flood(5).permission(permission::b_client_delete_dbproperties),
+            command("plugincmd", CommandId::PluginCmd).requires_server().flood(5),
+            command("clientmute", CommandId::ClientMute),
+            command("clientunmute", CommandId::ClientUnmute),
+            command("clientlist", CommandId::ClientList),
+            command("whoami", CommandId::WhoAmI),
+            command("servergroupsbyclientid", CommandId::ServerGroupsByClientId),
+            command("clientgetdbidfromuid", CommandId::ClientGetDBIDfromUID),
+            command("clientgetnamefromdbid", CommandId::ClientGetNameFromDBID),
+            command("clientgetnamefromuid", CommandId::ClientGetNameFromUid),
+            command("clientgetuidfromclid", CommandId::ClientGetUidFromClid),
+            command("complainadd", CommandId::ComplainAdd).requires_server().flood(25),
+            command("complainlist", CommandId::ComplainList).requires_server().flood(25).permission(permission::b_client_complain_list),
+            command("complaindel", CommandId::ComplainDel).requires_server().flood(5),
+            command("complaindelall", CommandId::ComplainDelAll).requires_server().flood(25).permission(permission::b_client_complain_delete),
+            command("version", CommandId::Version).lockless(),
+            command("verifyserverpassword", CommandId::VerifyServerPassword).requires_server().flood(5),
+            command("verifychannelpassword", CommandId::VerifyChannelPassword).requires_server().flood(5),
+            command("messagelist", CommandId::MessageList).requires_server().flood(5),
+            command("messageadd", CommandId::MessageAdd).requires_server().flood(25).permission(permission::b_client_offline_textmessage_send),
+            command("messageget", CommandId::MessageGet).requires_server().flood(10),
+            command("messagedel", CommandId::MessageDel).requires_server().flood(5),
+            command("messageupdateflag", CommandId::MessageUpdateFlag).requires_server().flood(5),
+            command("permget", CommandId::PermGet).permission(permission::b_client_permissionoverview_own),
+            command("permfind", CommandId::PermFind),
+            command("permidgetbyname", CommandId::PermIdGetByName).lockless(),
+            command("permoverview", CommandId::PermOverview).requires_server().flood(5),
+            command("permreset", CommandId::PermReset).requires_server().flood(50).permission(permission::b_virtualserver_permission_reset),
+            command("clientsetserverquerylogin", CommandId::ClientSetServerQueryLogin).permission(permission::b_client_create_modify_serverquery_login),
+            command("musicbotcreate", CommandId::MusicBotCreate),
+            command("musicbotdelete", CommandId::MusicBotDelete),
+            command("musicbotsetsubscription", CommandId::MusicBotSetSubscription),
+            command("musicbotplayerinfo", CommandId::MusicBotPlayerInfo),
+            command("musicbotplayeraction", CommandId::MusicBotPlayerAction),
+            command("musicbotqueuelist", CommandId::MusicBotQueueList),
+            command("musicbotqueueadd", CommandId::MusicBotQueueAdd),
+            command("musicbotqueueremove", CommandId::MusicBotQueueRemove),
+            command("musicbotqueuereorder", CommandId::MusicBotQueueReorder),
+            command("musicbotplaylistassign", CommandId::MusicBotPlaylistAssign),
+            command("help", CommandId::Help).flood(5).permission(permission::b_serverinstance_help_view),
+            command("logview", CommandId::LogView).flood(50),
+            command("logquery", CommandId::LogQuery).flood(50),
+            command("logadd", CommandId::LogAdd).flood(50),
+            command("servergroupautoaddperm", CommandId::ServerGroupAutoAddPerm).flood(25),
+            command("servergroupautodelperm", CommandId::ServerGroupAutoDelPerm).flood(25),
+            command("updatemytsid", CommandId::UpdateMyTsId),
+            command("updatemytsdata", CommandId::UpdateMyTsData),
+            command("querycreate", CommandId::QueryCreate),
+            command("querydelete", CommandId::QueryDelete),
+            command("querylist", CommandId::QueryList),
+            command("queryrename", CommandId::QueryRename),
+            command("querychangepassword", CommandId::QueryChangePassword),
+            command("playlistlist", CommandId::PlaylistList).requires_server().flood(25),
+            command("playlistcreate", CommandId::PlaylistCreate),
+            command("playlistdelete", CommandId::PlaylistDelete),
+            command("playlistsetsubscription", CommandId::PlaylistSetSubscription),
+            command("playlistpermlist", CommandId::PlaylistPermList),
+            command("playlistaddperm", CommandId::PlaylistAddPerm),
+            command("playlistdelperm", CommandId::PlaylistDelPerm),
+            command("playlistclientlist", CommandId::PlaylistClientList),
+            command("playlistclientpermlist", CommandId::PlaylistClientPermList),
+            command("playlistclientaddperm", CommandId::PlaylistClientAddPerm),
+            command("playlistclientdelperm", CommandId::PlaylistClientDelPerm),
+            command("playlistinfo", CommandId::PlaylistInfo),
+            command("playlistedit", CommandId::PlaylistEdit),
+            command("playlistsonglist", CommandId::PlaylistSongList),
+            command("playlistsongsetcurrent", CommandId::PlaylistSongSetCurrent),
+            command("playlistsongadd", CommandId::PlaylistSongAdd),
+            command("playlistsongreorder", CommandId::PlaylistSongReorder),
+            command("playlistsongmove", CommandId::PlaylistSongReorder),
+            command("playlistsongremove", CommandId::PlaylistSongRemove),
+            command("dummy_ipchange", CommandId::Dummy_IpChange),
+            command("conversationhistory", CommandId::ConversationHistory),
+            command("conversationfetch", CommandId::ConversationFetch),
+            command("conversationmessagedelete", CommandId::ConversationMessageDelete),
+            command("listfeaturesupport", CommandId::ListFeatureSupport).lockless(),
+            command("exit", CommandId::Exit).clients(kQueryClients),
+            command("quit", CommandId::Exit).clients(kQueryClients),
+            command("use", CommandId::ServerSelect).clients(kQueryClients),
+            command("serverselect", CommandId::ServerSelect).clients(kQueryClients),
+            command("serverinfo", CommandId::ServerInfo).clients(kQueryClients).permission(permission::b_virtualserver_info_view),
+            command("channellist", CommandId::ChannelList).clients(kQueryClients).permission(permission::b_virtualserver_channel_list),
+            command("login", CommandId::Login).clients(kQueryClients),
+            command("logout", CommandId::Logout).clients(kQueryClients),
+            command("globalmessage", CommandId::GlobalMessage).clients(kQueryClients).permission(permission::b_serverinstance_textmessage_send),
+            command("gm", CommandId::GlobalMessage).clients(kQueryClients).permission(permission::b_serverinstance_textmessage_send),
+            command("serverlist", CommandId::ServerList).clients(kQueryClients).permission(permission::b_serverinstance_virtualserver_list),
+            command("servercreate", CommandId::ServerCreate).clients(kQueryClients).permission(permission::b_virtualserver_create),
+            command("serverstart", CommandId::ServerStart).clients(kQueryClients),
+            command("serverstop", CommandId::ServerStop).clients(kQueryClients),
+            command("serverdelete", CommandId::ServerDelete).clients(kQueryClients).permission(permission::b_virtualserver_delete),
+            command("serveridgetbyport", CommandId::ServerIdGetByPort).clients(kQueryClients),
+            command("instanceinfo", CommandId::InstanceInfo).clients(kQueryClients).permission(permission::b_serverinstance_info_view),
+            command("instanceedit", CommandId::InstanceEdit).clients(kQueryClients).permission(permission::b_serverinstance_modify_settings),
+            command("hostinfo", CommandId::HostInfo).clients(kQueryClients).permission(permission::b_serverinstance_info_view),
+            command("bindinglist", CommandId::BindingList).clients(kQueryClients),
+            command("serversnapshotdeploy", CommandId::ServerSnapshotDeploy).clients(kQueryClients),
+            command("serversnapshotcreate", CommandId::ServerSnapshotCreate).clients(kQueryClients).permission(permission::b_virtualserver_snapshot_create),
+            command("serverprocessstop", CommandId::ServerProcessStop).clients(kQueryClients).permission(permission::b_serverinstance_stop),
+            command("servernotifyregister", CommandId::ServerNotifyRegister).clients(kQueryClients),
+            command("servernotifylist", CommandId::ServerNotifyList).clients(kQueryClients),
+            command("servernotifyunregister", CommandId::ServerNotifyUnregister).clients(kQueryClients),
+            command("handshakebegin", CommandId::HandshakeBegin).clients(kSpeakingClients),
+            command("handshakeindentityproof", CommandId::HandshakeIdentityProof).clients(kSpeakingClients),
+            command("rtcsessiondescribe", CommandId::RtcSessionDescribe).clients(kSpeakingClients),
+            command("rtcicecandidate", CommandId::RtcIceCandidate).clients(kSpeakingClients),
+            command("rtcsessionreset", CommandId::RtcSessionReset).clients(kSpeakingClients).requires_server().flood(15),
+            command("broadcastaudio", CommandId::BroadcastAudio).clients(kSpeakingClients).requires_server().flood(5),
+            command("broadcastvideo", CommandId::BroadcastVideo).clients(kSpeakingClients).requires_server().flood(15),
+            command("broadcastvideojoin", CommandId::BroadcastVideoJoin).clients(kSpeakingClients),
+            command("broadcastvideoleave", CommandId::BroadcastVideoLeave).clients(kSpeakingClients),
+            command("broadcastvideoconfig", CommandId::BroadcastVideoConfig).clients(kSpeakingClients),
+            command("broadcastvideoconfigure", CommandId::BroadcastVideoConfigure).clients(kSpeakingClients),
+            command("clientinit", CommandId::ClientInit).clients(kVoiceClients | kWebClients),
+            command("clientdisconnect", CommandId::ClientDisconnect).clients(kVoiceClients),
+            command("whispersessioninitialize", CommandId::WhisperSessionInitialize).clients(kWebClients),
+            command("whispersessionreset", CommandId::WhisperSessionReset).clients(kWebClients)
+    );
+
+    /* FNV-1a */
+    constexpr uint32_t command_hash(const std::string_view& name, uint32_t seed) {
+        uint32_t hash{2166136261U ^ seed};
+        for(auto character : name) {
+            hash ^= (uint8_t) character;
+            hash *= 16777619U;
+        }
+        return hash ^ (hash >> 15U);
+    }
+
+    constexpr size_t kTableBits{12};
+    constexpr size_t kTableSize{1U << kTableBits};
+    constexpr uint32_t kMaxSeed{100000};
+    static_assert(kCommands.size() < 0xFF, "command index does not fit into the lookup table");
+
+    /* Search for a seed which maps every command to a distinct slot */
+    constexpr uint32_t find_seed() {
+        for(uint32_t seed{0}; seed < kMaxSeed; seed++) {
+            std::array<uint64_t, kTableSize / 64> used_slots{};
+
+            bool collision{false};
+            for(const auto& command : kCommands) {
+                auto slot = command_hash(command.name, seed) & (kTableSize - 1);
+                if(used_slots[slot / 64] & (1ULL << (slot % 64))) {
+                    collision = true;
+                    break;
+                }
+                used_slots[slot / 64] |= 1ULL << (slot % 64);
+            }
+
+            if(!collision) {
+                return seed;
+            }
+        }
+
+        return kMaxSeed;
+    }
+
+    constexpr uint32_t kSeed{find_seed()};
+    static_assert(kSeed < kMaxSeed, "failed to find a perfect hash seed, increase the table size");
+
+    /* Slot => command index + 1 (zero marks an empty slot) */
+    constexpr auto kTable = []{
+        std::array<uint8_t, kTableSize> result{};
+        for(size_t index{0}; index < kCommands.size(); index++) {
+            result[command_hash(kCommands[index].name, kSeed) & (kTableSize - 1)] = (uint8_t) (index + 1);
+        }
+        return result;
+    }();
+}
+
+const CommandDescriptor command_registry::kUnknownCommand{};
+
+const CommandDescriptor& command_registry::find(const std::string_view &command) {
+    auto index = kTable[command_hash(command, kSeed) & (kTableSize - 1)];
+    if(index == 0) {
+        return kUnknownCommand;
+    }
+
+    const auto& descriptor = kCommands[index - 1];
+    return descriptor.name == command ? descriptor : kUnknownCommand;
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <Definitions.h>
+#include <PermissionManager.h>
+
+namespace ts::server {
+    /* Every command the server is able to handle. Aliases (e.g. "clientaddservergroup") share the id of their command. */
+    enum struct CommandId : uint8_t {
+            Unknown,
+            ServerGetVariables,
+            ServerRequestConnectionInfo,
+            GetConnectionInfo,
+            SetConnectionInfo,
+            ClientGetVariables,
+            ServerEdit,
+            ClientEdit,
+            ChannelGetDescription,
+            ConnectionInfoAutoUpdate,
+            PermissionList,
+            PropertyList,
+            ServerGroupList,
+            ServerGroupAdd,
+            ServerGroupCopy,
+            ServerGroupDel,
+            ServerGroupRename,
+            ServerGroupClientList,
+            ServerGroupAddClient,
+            ServerGroupDelClient,
+            ServerGroupPermList,
+            ServerGroupAddPerm,
+            ServerGroupDelPerm,
+            SetClientChannelGroup,
+            ChannelCreate,
+            ChannelMove,
+            ChannelEdit,
+            ChannelDelete,
+            ChannelFind,
+            ChannelInfo,
+            ChannelPermList,
+            ChannelAddPerm,
+            ChannelDelPerm,
+            ChannelGroupAdd,
+            ChannelGroupCopy,
+            ChannelGroupRename,
+            ChannelGroupDel,
+            ChannelGroupList,
+            ChannelGroupClientList,
+            ChannelGroupPermList,
+            ChannelGroupAddPerm,
+            ChannelGroupDelPerm,
+            ChannelSubscribe,
+            ChannelSubscribeAll,
+            ChannelUnsubscribe,
+            ChannelUnsubscribeAll,
+            ChannelClientPermList,
+            ChannelClientAddPerm,
+            ChannelClientDelPerm,
+            ClientUpdate,
+            ClientMove,
+            ClientGetIds,
+            ClientKick,
+            ClientPoke,
+            SendTextMessage,
+            ClientChatComposing,
+            ClientChatClosed,
+            ClientFind,
+            ClientInfo,
+            ClientAddPerm,
+            ClientDelPerm,
+            ClientPermList,
+            FTGetFileList,
+            FTCreateDir,
+            FTDeleteFile,
+            FTInitUpload,
+            FTInitDownload,
+            FTGetFileInfo,
+            FTRenameFile,
+            FTList,
+            FTStop,
+            BanList,
+            BanAdd,
+            BanEdit,
+            BanClient,
+            BanDel,
+            BanDelAll,
+            BanTriggerList,
+            TokenActionList,
+            TokenList,
+            TokenAdd,
+            TokenEdit,
+            TokenUse,
+            TokenDelete,
+            ClientDbList,
+            ClientDbInfo,
+            ClientDBEdit,
+            ClientDBFind,
+            ClientDBDelete,
+            PluginCmd,
+            ClientMute,
+            ClientUnmute,
+            ClientList,
+            WhoAmI,
+            ServerGroupsByClientId,
+            ClientGetDBIDfromUID,
+            ClientGetNameFromDBID,
+            ClientGetNameFromUid,
+            ClientGetUidFromClid,
+            ComplainAdd,
+            ComplainList,
+            ComplainDel,
+            ComplainDelAll,
+            Version,
+            VerifyServerPassword,
+            VerifyChannelPassword,
+            MessageList,
+            MessageAdd,
+            MessageGet,
+            MessageDel,
+            MessageUpdateFlag,
+            PermGet,
+            PermFind,
+            PermIdGetByName,
+            PermOverview,
+            PermReset,
+            ClientSetServerQueryLogin,
+            MusicBotCreate,
+            MusicBotDelete,
+            MusicBotSetSubscription,
+            MusicBotPlayerInfo,
+            MusicBotPlayerAction,
+            MusicBotQueueList,
+            MusicBotQueueAdd,
+            MusicBotQueueRemove,
+            MusicBotQueueReorder,
+            MusicBotPlaylistAssign,
+            Help,
+            LogView,
+            LogQuery,
+            LogAdd,
+            ServerGroupAutoAddPerm,
+            ServerGroupAutoDelPerm,
+            UpdateMyTsId,
+            UpdateMyTsData,
+            QueryCreate,
+            QueryDelete,
+            QueryList,
+            QueryRename,
+            QueryChangePassword,
+            PlaylistList,
+            PlaylistCreate,
+            PlaylistDelete,
+            PlaylistSetSubscription,
+            PlaylistPermList,
+            PlaylistAddPerm,
+            PlaylistDelPerm,
+            PlaylistClientList,
+            PlaylistClientPermList,
+            PlaylistClientAddPerm,
+            PlaylistClientDelPerm,
+            PlaylistInfo,
+            PlaylistEdit,
+            PlaylistSongList,
+            PlaylistSongSetCurrent,
+            PlaylistSongAdd,
+            PlaylistSongReorder,
+            PlaylistSongRemove,
+            Dummy_IpChange,
+            ConversationHistory,
+            ConversationFetch,
+            ConversationMessageDelete,
+            ListFeatureSupport,
+            Exit,
+            ServerSelect,
+            ServerInfo,
+            ChannelList,
+            Login,
+            Logout,
+            GlobalMessage,
+            ServerList,
+            ServerCreate,
+            ServerStart,
+            ServerStop,
+            ServerDelete,
+            ServerIdGetByPort,
+            InstanceInfo,
+            InstanceEdit,
+            HostInfo,
+            BindingList,
+            ServerSnapshotDeploy,
+            ServerSnapshotCreate,
+            ServerProcessStop,
+            ServerNotifyRegister,
+            ServerNotifyList,
+            ServerNotifyUnregister,
+            HandshakeBegin,
+            HandshakeIdentityProof,
+            RtcSessionDescribe,
+            RtcIceCandidate,
+            RtcSessionReset,
+            BroadcastAudio,
+            BroadcastVideo,
+            BroadcastVideoJoin,
+            BroadcastVideoLeave,
+            BroadcastVideoConfig,
+            BroadcastVideoConfigure,
+            ClientInit,
+            ClientDisconnect,
+            WhisperSessionInitialize,
+            WhisperSessionReset,
+    };
+
+    /**
+     * Registry entry of a command.
+     * The requirements will be tested (in the declared order) by ConnectedClient::handleCommandFull before the command gets dispatched.
+     */
+    struct CommandDescriptor {
+        constexpr static uint8_t kFlagRequiresServer{1U << 0U};
+        constexpr static uint8_t kFlagFloodCheck{1U << 1U};
+        /* The command does not touch any client state and could be executed without the command lock */
+        constexpr static uint8_t kFlagLockless{1U << 2U};
+        /* The handler consumes a ts::command_parser view of the raw command instead of the legacy ts::Command */
+        constexpr static uint8_t kFlagParserView{1U << 3U};
+
+        std::string_view name{};
+        CommandId id{CommandId::Unknown};
+        /* Bit mask of the ClientType values which are allowed to execute the command */
+        uint8_t client_types{0xFF};
+        uint8_t flags{0};
+        uint16_t flood_points{0};
+        /* Permission which must be granted on the server (or instance) level. unknown if not required */
+        permission::PermissionType permission{permission::unknown};
+
+        [[nodiscard]] constexpr bool client_allowed(ClientType type) const { return (this->client_types & (1U << (uint8_t) type)) != 0; }
+        [[nodiscard]] constexpr bool requires_server() const { return (this->flags & kFlagRequiresServer) != 0; }
+        [[nodiscard]] constexpr bool flood_check() const { return (this->flags & kFlagFloodCheck) != 0; }
+        [[nodiscard]] constexpr bool lockless() const { return (this->flags & kFlagLockless) != 0; }
+        [[nodiscard]] constexpr bool parser_view() const { return (this->flags & kFlagParserView) != 0; }
+    };
+
+    namespace command_registry {
+        /* Descriptor used for all commands which aren't registered */
+        extern const CommandDescriptor kUnknownCommand;
+
+        /**
+         * Lookup a command by its name.
+         * The lookup uses a perfect hash table generated at compile time and requires exactly one string compare.
+         * Returns kUnknownCommand if the command does not exists.
+         */
+        [[nodiscard]] extern const CommandDescriptor& find(const std::string_view& /* command */);
+    }
+}
@@ -33,7 +33,6 @@ using namespace ts;
 using namespace ts::server;
 
 command_result ConnectedClient::handleCommandChannelGetDescription(Command &cmd) {
-    CMD_CHK_AND_INC_FLOOD_POINTS(0);
     RESOLVE_CHANNEL_R(cmd["cid"], true);
     auto channel = dynamic_pointer_cast<BasicChannel>(l_channel->entry);
     assert(channel);
@@ -70,23 +69,23 @@ command_result ConnectedClient::handleCommandChannelGetDescription(Command &cmd)
     return command_result{error::ok};
 }
 
-command_result ConnectedClient::handleCommandChannelSubscribe(Command &cmd) {
+command_result ConnectedClient::handleCommandChannelSubscribe(const ts::command_parser &cmd) {
     CMD_REF_SERVER(ref_server);
     CMD_RESET_IDLE;
 
     bool flood_points{false};
     std::deque<std::shared_ptr<BasicChannel>> target_channels{};
-    //target_channels.reserve(cmd.bulkCount());
+    //target_channels.reserve(cmd.bulk_count());
 
     ts::command_result_bulk result{};
-    result.emplace_result_n(cmd.bulkCount(), error::ok);
+    result.emplace_result_n(cmd.bulk_count(), error::ok);
 
     {
         std::shared_lock server_channel_lock{this->server->channel_tree_mutex};
         std::lock_guard client_channel_lock{this->channel_tree_mutex};
 
-        for (int index{0}; index < cmd.bulkCount(); index++) {
-            auto target_channel_id = cmd[index]["cid"].as<ChannelId>();
+        for (size_t index{0}; index < cmd.bulk_count(); index++) {
+            auto target_channel_id = cmd[index].value_as<ChannelId>("cid");
             auto local_channel = this->channel_view()->find_channel(target_channel_id);
             if (!local_channel) {
                 result.set_result(index, ts::command_result{error::channel_invalid_id});
@@ -120,9 +119,6 @@ command_result ConnectedClient::handleCommandChannelSubscribe(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandChannelSubscribeAll(Command &cmd) {
-    CMD_REQ_SERVER;
-    CMD_CHK_AND_INC_FLOOD_POINTS(20);
-
     {
         std::shared_lock server_channel_lock{this->server->channel_tree_mutex};
         std::lock_guard client_channel_lock{this->channel_tree_mutex};
@@ -133,9 +129,6 @@ command_result ConnectedClient::handleCommandChannelSubscribeAll(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandChannelUnsubscribe(Command &cmd) {
-    CMD_REQ_SERVER;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-
     ts::command_result_bulk result{};
     result.emplace_result_n(cmd.bulkCount(), error::ok);
 
@@ -161,9 +154,6 @@ command_result ConnectedClient::handleCommandChannelUnsubscribe(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandChannelUnsubscribeAll(Command &cmd) {
-    CMD_REQ_SERVER;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
-
     {
         std::shared_lock server_channel_lock{this->server->channel_tree_mutex};
         std::lock_guard client_channel_lock{this->channel_tree_mutex};
@@ -192,8 +182,6 @@ command_result ConnectedClient::handleCommandChannelGroupDel(Command &cmd) {
 
 command_result ConnectedClient::handleCommandChannelGroupList(Command &) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_virtualserver_channelgroup_list, 1);
 
     std::optional<ts::command_builder> notify{};
     this->notifyChannelGroupList(notify, this->getType() != ClientType::CLIENT_QUERY);
@@ -203,9 +191,7 @@ command_result ConnectedClient::handleCommandChannelGroupList(Command &) {
 }
 
 command_result ConnectedClient::handleCommandChannelGroupClientList(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     auto target_channel_id = cmd[0].has("cid") ? cmd["cid"].as<ChannelId>() : 0;
     auto target_client_database_id = cmd[0].has("cldbid") ? cmd["cldbid"].as<ClientDbId>() : 0;
@@ -233,9 +219,6 @@ command_result ConnectedClient::handleCommandChannelGroupClientList(Command &cmd
 }
 
 command_result ConnectedClient::handleCommandChannelGroupPermList(Command &cmd) {
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_virtualserver_channelgroup_permission_list, 1);
-
     auto group_manager = this->server ? this->server->group_manager() : serverInstance->group_manager();
     auto channelGroup = group_manager->channel_groups()->find_group(groups::GroupCalculateMode::GLOBAL, cmd["cgid"].as<GroupId>());
     if (!channelGroup) {
@@ -254,8 +237,6 @@ command_result ConnectedClient::handleCommandChannelGroupPermList(Command &cmd)
 }
 
 command_result ConnectedClient::handleCommandChannelGroupAddPerm(Command &cmd) {
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-
     auto group_id = cmd["cgid"].as<GroupId>();
 
     std::shared_ptr<groups::ChannelGroupManager> owning_manager{};
@@ -273,8 +254,6 @@ command_result ConnectedClient::handleCommandChannelGroupAddPerm(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandChannelGroupDelPerm(Command &cmd) {
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-
     auto group_id = cmd["cgid"].as<GroupId>();
 
     std::shared_ptr<groups::ChannelGroupManager> owning_manager{};
@@ -294,7 +273,6 @@ command_result ConnectedClient::handleCommandChannelGroupDelPerm(Command &cmd) {
 //TODO: Test if parent or previous is deleted!
 command_result ConnectedClient::handleCommandChannelCreate(Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
     CMD_CHK_PARM_COUNT(1);
 
     auto target_tree = this->server ? this->server->channelTree : &*serverInstance->getChannelTree();
@@ -672,7 +650,6 @@ command_result ConnectedClient::handleCommandChannelCreate(Command &cmd) {
 
 command_result ConnectedClient::handleCommandChannelDelete(Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
 
     RESOLVE_CHANNEL_W(cmd["cid"], true);
     auto channel = dynamic_pointer_cast<ServerChannel>(l_channel->entry);
@@ -705,7 +682,6 @@ command_result ConnectedClient::handleCommandChannelDelete(Command &cmd) {
 
 command_result ConnectedClient::handleCommandChannelEdit(Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
 
     RESOLVE_CHANNEL_R(cmd["cid"], true);
     auto channel = dynamic_pointer_cast<ServerChannel>(l_channel->entry);
@@ -1640,7 +1616,6 @@ ts::command_result ConnectedClient::execute_channel_edit(ChannelId& channel_id,
 
 command_result ConnectedClient::handleCommandChannelMove(Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
     RESOLVE_CHANNEL_W(cmd["cid"], true);
     auto channel = dynamic_pointer_cast<ServerChannel>(l_channel->entry);
     assert(channel);
@@ -1782,8 +1757,6 @@ command_result ConnectedClient::handleCommandChannelMove(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandChannelPermList(Command &cmd) {
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-
     RESOLVE_CHANNEL_R(cmd["cid"], true);
     auto channel = dynamic_pointer_cast<BasicChannel>(l_channel->entry);
     assert(channel);
@@ -1843,7 +1816,6 @@ command_result ConnectedClient::handleCommandChannelPermList(Command &cmd) {
 //Desctiption has no extra parm
 command_result ConnectedClient::handleCommandChannelAddPerm(Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     RESOLVE_CHANNEL_R(cmd["cid"], true);
     auto channel = dynamic_pointer_cast<BasicChannel>(l_channel->entry);
@@ -1968,9 +1940,7 @@ command_result ConnectedClient::handleCommandChannelDelPerm(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandChannelClientPermList(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
     RESOLVE_CHANNEL_R(cmd["cid"], true);
     auto channel = dynamic_pointer_cast<ServerChannel>(l_channel->entry);
     if (!channel) return command_result{error::vs_critical};
@@ -2156,8 +2126,6 @@ command_result ConnectedClient::handleCommandChannelClientAddPerm(Command &cmd)
 
 
 command_result ConnectedClient::handleCommandChannelFind(Command &cmd) {
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-
     string pattern = cmd["pattern"];
     std::transform(pattern.begin(), pattern.end(), pattern.begin(), ::tolower);
 
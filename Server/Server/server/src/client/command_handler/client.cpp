@@ -58,9 +58,6 @@ command_result ConnectedClient::handleCommandClientGetVariables(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandClientKick(Command &cmd) {
-    CMD_REQ_SERVER;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
-
     command_result_bulk result{};
     result.reserve(cmd.bulkCount());
 
@@ -155,14 +152,12 @@ command_result ConnectedClient::handleCommandClientGetIds(Command &cmd) {
     return command_result{error::ok};
 }
 
-command_result ConnectedClient::handleCommandClientMove(Command &cmd) {
-    CMD_REQ_SERVER;
+command_result ConnectedClient::handleCommandClientMove(const ts::command_parser &cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(10);
 
     std::unique_lock server_channel_lock{this->server->channel_tree_mutex};
 
-    auto target_channel = this->server->channelTree->findChannel(cmd["cid"].as<ChannelId>());
+    auto target_channel = this->server->channelTree->findChannel(cmd[0].value_as<ChannelId>("cid"));
     if (!target_channel) {
         return command_result{error::channel_invalid_id};
     }
@@ -172,18 +167,15 @@ command_result ConnectedClient::handleCommandClientMove(Command &cmd) {
     if(whitelist_entry != channel_whitelist.end()) {
         debugMessage(this->getServerId(), "{} Allowing client to join channel {} because the token he used earlier explicitly allowed it.", this->getLoggingPrefix(), target_channel->channelId());
         if(whitelist_entry->second != "ignore") {
-            if (!target_channel->verify_password(cmd["cpw"].optional_string(), this->getType() != ClientType::CLIENT_QUERY)) {
+            if (!target_channel->verify_password(cmd[0].has_key("cpw") ? std::make_optional(cmd[0].value("cpw")) : std::nullopt, this->getType() != ClientType::CLIENT_QUERY)) {
                 if (!permission::v2::permission_granted(1, this->calculate_permission(permission::b_channel_join_ignore_password, target_channel->channelId()))) {
                     return command_result{error::channel_invalid_password};
                 }
             }
         }
     } else {
-        if(!cmd[0].has("cpw")) {
-            cmd["cpw"] = "";
-        }
-
-        if (!target_channel->verify_password(cmd["cpw"].optional_string(), this->getType() != ClientType::CLIENT_QUERY)) {
+        /* a missing password is treated like an empty one */
+        if (!target_channel->verify_password(std::make_optional(cmd[0].has_key("cpw") ? cmd[0].value("cpw") : std::string{}), this->getType() != ClientType::CLIENT_QUERY)) {
             if (!permission::v2::permission_granted(1, this->calculate_permission(permission::b_channel_join_ignore_password, target_channel->channelId()))) {
                 return command_result{error::channel_invalid_password};
             }
@@ -197,12 +189,12 @@ command_result ConnectedClient::handleCommandClientMove(Command &cmd) {
     channel_whitelist.clear();
 
     command_result_bulk result{};
-    result.reserve(cmd.bulkCount());
+    result.reserve(cmd.bulk_count());
 
     std::vector<ConnectedLockedClient<ConnectedClient>> target_clients{};
 
-    for(size_t index{0}; index < cmd.bulkCount(); index++) {
-        auto target_client_id = cmd[index]["clid"].as<ClientId>();
+    for(size_t index{0}; index < cmd.bulk_count(); index++) {
+        auto target_client_id = cmd[index].value_as<ClientId>("clid");
         ConnectedLockedClient target_client{target_client_id == 0 ? this->ref() : this->server->find_client_by_id(target_client_id)};
         if(!target_client) {
             result.emplace_result(error::client_invalid_id);
@@ -312,9 +304,7 @@ command_result ConnectedClient::handleCommandClientMove(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandClientPoke(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
 
     command_result_bulk result{};
     result.reserve(cmd.bulkCount());
@@ -366,9 +356,6 @@ command_result ConnectedClient::handleCommandClientPoke(Command &cmd) {
 
 
 command_result ConnectedClient::handleCommandClientChatComposing(Command &cmd) {
-    CMD_REQ_SERVER;
-    CMD_CHK_AND_INC_FLOOD_POINTS(0);
-
     ConnectedLockedClient client{this->server->find_client_by_id(cmd["clid"].as<ClientId>())};
     if (!client) return command_result{error::client_invalid_id};
 
@@ -377,9 +364,6 @@ command_result ConnectedClient::handleCommandClientChatComposing(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandClientChatClosed(Command &cmd) {
-    CMD_REQ_SERVER;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-
     ConnectedLockedClient<ConnectedClient> client{this->server->find_client_by_id(cmd["clid"].as<ClientId>())};
     if (!client) return command_result{error::client_invalid_id};
     {
@@ -399,10 +383,7 @@ command_result ConnectedClient::handleCommandClientChatClosed(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandClientDbList(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_virtualserver_client_dblist, 1);
 
     size_t offset = cmd[0].has("start") ? cmd["start"].as<size_t>() : 0;
     size_t limit = cmd[0].has("duration") ? cmd["duration"].as<int>() : 0;
@@ -454,10 +435,7 @@ command_result ConnectedClient::handleCommandClientDbList(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandClientDBEdit(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_client_modify_dbproperties, 1);
 
     if (!serverInstance->databaseHelper()->validClientDatabaseId(this->server, cmd["cldbid"])) return command_result{error::database_empty_result, "invalid cldbid"};
     auto props = serverInstance->databaseHelper()->loadClientProperties(this->server, cmd["cldbid"], ClientType::CLIENT_TEAMSPEAK);
@@ -480,15 +458,15 @@ command_result ConnectedClient::handleCommandClientDBEdit(Command &cmd) {
     return command_result{error::ok};
 }
 
-command_result ConnectedClient::handleCommandClientEdit(ts::Command &cmd) {
+command_result ConnectedClient::handleCommandClientEdit(const ts::command_parser &cmd) {
     CMD_REQ_SERVER;
 
-    ConnectedLockedClient client{this->server->find_client_by_id(cmd["clid"].as<ClientId>())};
+    ConnectedLockedClient client{this->server->find_client_by_id(cmd[0].value_as<ClientId>("clid"))};
     if (!client) return command_result{error::client_invalid_id};
     return this->handleCommandClientEdit(cmd, client.client);
 }
 
-command_result ConnectedClient::handleCommandClientEdit(Command &cmd, const std::shared_ptr<ConnectedClient>& client) {
+command_result ConnectedClient::handleCommandClientEdit(const ts::command_parser &cmd, const std::shared_ptr<ConnectedClient>& client) {
     assert(client);
     auto self = client == this;
     CMD_CHK_AND_INC_FLOOD_POINTS(self ? 15 : 25);
@@ -497,8 +475,19 @@ command_result ConnectedClient::handleCommandClientEdit(Command &cmd, const std:
 
     bool update_talk_rights = false;
     unique_ptr<lock_guard<std::recursive_mutex>> nickname_lock;
+    /* the properties which should be updated and their new value */
     std::deque<std::pair<const property::PropertyDescription*, std::string>> keys;
-    for(const auto& key : cmd[0].keys()) {
+
+    const auto& bulk = cmd[0];
+    size_t entry_index{0};
+    std::string_view key{};
+    std::string value{};
+    while(bulk.next_entry(entry_index, key, value)) {
+        if(key.empty() || key[0] == '-') {
+            /* switches can't be properties */
+            continue;
+        }
+
         if(key == "return_code") {
             continue;
         }
@@ -509,21 +498,21 @@ command_result ConnectedClient::handleCommandClientEdit(Command &cmd, const std:
 
         const auto &info = property::find<property::ClientProperties>(key);
         if(info == property::CLIENT_UNDEFINED) {
-            logError(this->getServerId(), R"([{}] Tried to change a not existing client property for {}. (Key: "{}", Value: "{}"))", CLIENT_STR_LOG_PREFIX, CLIENT_STR_LOG_PREFIX_(client), key, cmd[key].string());
+            logError(this->getServerId(), R"([{}] Tried to change a not existing client property for {}. (Key: "{}", Value: "{}"))", CLIENT_STR_LOG_PREFIX, CLIENT_STR_LOG_PREFIX_(client), key, value);
             continue;
         }
 
         if((info.flags & property::FLAG_USER_EDITABLE) == 0) {
-            logError(this->getServerId(), R"([{}] Tried to change a not user editable client property for {}. (Key: "{}", Value: "{}"))", CLIENT_STR_LOG_PREFIX, CLIENT_STR_LOG_PREFIX_(client), key, cmd[key].string());
+            logError(this->getServerId(), R"([{}] Tried to change a not user editable client property for {}. (Key: "{}", Value: "{}"))", CLIENT_STR_LOG_PREFIX, CLIENT_STR_LOG_PREFIX_(client), key, value);
             continue;
         }
 
-        if(!info.validate_input(cmd[key].as<string>())) {
-            logError(this->getServerId(), R"([{}] Tried to change a client property to an invalid value for {}. (Key: "{}", Value: "{}"))", CLIENT_STR_LOG_PREFIX, CLIENT_STR_LOG_PREFIX_(client), key, cmd[key].string());
+        if(!info.validate_input(value)) {
+            logError(this->getServerId(), R"([{}] Tried to change a client property to an invalid value for {}. (Key: "{}", Value: "{}"))", CLIENT_STR_LOG_PREFIX, CLIENT_STR_LOG_PREFIX_(client), key, value);
             continue;
         }
 
-        if(client->properties()[&info].as_unchecked<string>() == cmd[key].as<string>()) {
+        if(client->properties()[&info].as_unchecked<string>() == value) {
             continue;
         }
 
@@ -538,19 +527,16 @@ command_result ConnectedClient::handleCommandClientEdit(Command &cmd, const std:
                 ACTION_REQUIRES_PERMISSION(permission::b_client_modify_description, 1, client->getChannelId());
             }
 
-            string value = cmd["client_description"].string();
             auto value_length = utf8::count_characters(value);
             if (value_length < 0 || value_length > 200) {
                 return command_result{error::parameter_invalid, "Invalid description length. A maximum of 200 characters is allowed!"};
             }
         } else if (info == property::CLIENT_IS_TALKER) {
             ACTION_REQUIRES_PERMISSION(permission::b_client_set_flag_talker, 1, client->getChannelId());
-            cmd["client_is_talker"] = cmd["client_is_talker"].as<bool>();
-            cmd["client_talk_request"] = 0;
             update_talk_rights = true;
 
-            keys.emplace_back(&property::describe(property::CLIENT_IS_TALKER), "client_is_talker");
-            keys.emplace_back(&property::describe(property::CLIENT_TALK_REQUEST), "client_talk_request");
+            keys.emplace_back(&property::describe(property::CLIENT_IS_TALKER), bulk.value_as<bool>("client_is_talker") ? "1" : "0");
+            keys.emplace_back(&property::describe(property::CLIENT_TALK_REQUEST), "0");
             continue;
         } else if(info == property::CLIENT_NICKNAME) {
             if(!self) {
@@ -560,7 +546,7 @@ command_result ConnectedClient::handleCommandClientEdit(Command &cmd, const std:
                 }
             }
 
-            string name = cmd["client_nickname"].string();
+            const auto& name = value;
             auto name_length = utf8::count_characters(name);
             if (name_length < 3) {
                 return command_result{error::parameter_invalid, "Invalid name length. A minimum of 3 characters is required!"};
@@ -578,7 +564,7 @@ command_result ConnectedClient::handleCommandClientEdit(Command &cmd, const std:
                 nickname_lock = std::make_unique<lock_guard<recursive_mutex>>(this->server->client_nickname_lock);
                 bool self = false;
                 for (const auto &cl : this->server->getClients()) {
-                    if (cl->getDisplayName() == cmd["client_nickname"].string()) {
+                    if (cl->getDisplayName() == name) {
                         if(cl == this)
                             self = true;
                         else
@@ -598,8 +584,7 @@ command_result ConnectedClient::handleCommandClientEdit(Command &cmd, const std:
                 }
             }
 
-            string name = cmd["client_nickname_phonetic"].string();
-            auto name_length = utf8::count_characters(name);
+            auto name_length = utf8::count_characters(value);
             if (name_length < 0 || name_length > 30) {
                 return command_result{error::parameter_invalid, "Invalid name length. A maximum of 30 characters is allowed!"};
             }
@@ -611,13 +596,13 @@ command_result ConnectedClient::handleCommandClientEdit(Command &cmd, const std:
             auto bot = dynamic_pointer_cast<MusicClient>(client);
             assert(bot);
 
-            auto volume = cmd["player_volume"].as<float>();
+            auto volume = bulk.value_as<float>("player_volume");
 
             auto max_volume = this->calculate_permission(permission::i_client_music_create_modify_max_volume, client->getClientId());
             if(max_volume.has_value && !permission::v2::permission_granted(volume * 100, max_volume))
                 return command_result{permission::i_client_music_create_modify_max_volume};
 
-            bot->volume_modifier(cmd["player_volume"]);
+            bot->volume_modifier(volume);
         } else if(info == property::CLIENT_IS_CHANNEL_COMMANDER) {
             if(!self) {
                 if(client->getType() != ClientType::CLIENT_MUSIC) return command_result{error::client_invalid_type};
@@ -626,7 +611,7 @@ command_result ConnectedClient::handleCommandClientEdit(Command &cmd, const std:
                 }
             }
 
-            if(cmd["client_is_channel_commander"].as<bool>())
+            if(bulk.value_as<bool>("client_is_channel_commander"))
                 ACTION_REQUIRES_PERMISSION(permission::b_client_use_channel_commander, 1, client->getChannelId());
         } else if(info == property::CLIENT_IS_PRIORITY_SPEAKER) {
             //FIXME allow other to remove this thing
@@ -637,20 +622,17 @@ command_result ConnectedClient::handleCommandClientEdit(Command &cmd, const std:
                     ACTION_REQUIRES_PERMISSION(permission::i_client_music_modify_power, client->calculate_permission(permission::i_client_music_needed_modify_power, client->getClientId()), client->getClientId());
             }
 
-            if(cmd["client_is_priority_speaker"].as<bool>())
+            if(bulk.value_as<bool>("client_is_priority_speaker"))
                 ACTION_REQUIRES_PERMISSION(permission::b_client_use_priority_speaker, 1, client->getChannelId());
         } else if (self && key == "client_talk_request") {
             CMD_CHK_AND_INC_FLOOD_POINTS(20);
             ACTION_REQUIRES_PERMISSION(permission::b_client_request_talker, 1, client->getChannelId());
 
-            if (cmd["client_talk_request"].as<bool>())
-                cmd["client_talk_request"] = duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
-            else
-                cmd["client_talk_request"] = 0;
-            keys.emplace_back(&property::describe(property::CLIENT_TALK_REQUEST), "client_talk_request");
+            auto talk_request = bulk.value_as<bool>("client_talk_request") ? duration_cast<seconds>(system_clock::now().time_since_epoch()).count() : 0;
+            keys.emplace_back(&property::describe(property::CLIENT_TALK_REQUEST), std::to_string(talk_request));
             continue;
         } else if (self && key == "client_badges") {
-            std::string str = cmd[key];
+            const auto& str = value;
             size_t index = 0;
             int badgesTags = 0;
             do {
@@ -690,19 +672,19 @@ command_result ConnectedClient::handleCommandClientEdit(Command &cmd, const std:
                 ACTION_REQUIRES_PERMISSION(permission::i_client_music_modify_power, client->calculate_permission(permission::i_client_music_needed_modify_power, client->getChannelId()), client->getChannelId());
             }
 
-            if(cmd[key].as<MusicClient::UptimeMode::value>() == MusicClient::UptimeMode::TIME_SINCE_SERVER_START) {
-                cmd["client_lastconnected"] = duration_cast<seconds>(this->server->startTimestamp.time_since_epoch()).count();
+            std::string last_connected{};
+            if(bulk.value_as<MusicClient::UptimeMode::value>(key) == MusicClient::UptimeMode::TIME_SINCE_SERVER_START) {
+                last_connected = std::to_string(duration_cast<seconds>(this->server->startTimestamp.time_since_epoch()).count());
             } else {
-                string value = client->properties()[property::CLIENT_CREATED];
-                if(value.empty())
-                    value = "0";
-                cmd["client_lastconnected"] = value;
+                last_connected = client->properties()[property::CLIENT_CREATED].value();
+                if(last_connected.empty())
+                    last_connected = "0";
             }
 
-            keys.emplace_back(&property::describe(property::CLIENT_LASTCONNECTED), "client_lastconnected");
+            keys.emplace_back(&property::describe(property::CLIENT_LASTCONNECTED), std::move(last_connected));
         } else if(!self && info == property::CLIENT_BOT_TYPE) {
             ACTION_REQUIRES_PERMISSION(permission::i_client_music_modify_power, client->calculate_permission(permission::i_client_music_needed_modify_power, client->getChannelId()), client->getChannelId());
-            auto type = cmd["client_bot_type"].as<MusicClient::Type::value>();
+            auto type = bulk.value_as<MusicClient::Type::value>("client_bot_type");
             if(type == MusicClient::Type::TEMPORARY) {
                 ACTION_REQUIRES_PERMISSION(permission::b_client_music_modify_temporary, 1, client->getChannelId());
             } else if(type == MusicClient::Type::SEMI_PERMANENT) {
@@ -714,38 +696,37 @@ command_result ConnectedClient::handleCommandClientEdit(Command &cmd, const std:
         } else if(info == property::CLIENT_AWAY_MESSAGE) {
             if(!self) continue;
 
-            if(cmd["client_away_message"].string().length() > ts::config::server::limits::afk_message_length)
+            if(value.length() > ts::config::server::limits::afk_message_length)
                 return command_result{error::parameter_invalid};
         } else if(!self) { /* dont edit random properties of other clients. For us self its allowed to edit the rest without permissions */
             continue;
         } else if(info == property::CLIENT_TALK_REQUEST_MSG) {
-            if(cmd["client_talk_request_msg"].string().length() > ts::config::server::limits::talk_power_request_message_length)
+            if(value.length() > ts::config::server::limits::talk_power_request_message_length)
                 return command_result{error::parameter_invalid};
         }
 
-        keys.emplace_back(&info, key);
+        keys.emplace_back(&info, value);
     }
 
     deque<const property::PropertyDescription*> updates;
-    for(const auto& key : keys) {
-        if(*key.first == property::CLIENT_IS_PRIORITY_SPEAKER) {
-            client->clientPermissions->set_permission(permission::b_client_is_priority_speaker, {1, 0}, cmd["client_is_priority_speaker"].as<bool>() ? permission::v2::PermissionUpdateType::set_value : permission::v2::PermissionUpdateType::delete_value, permission::v2::PermissionUpdateType::do_nothing);
+    for(const auto& [property_info, new_value] : keys) {
+        if(*property_info == property::CLIENT_IS_PRIORITY_SPEAKER) {
+            client->clientPermissions->set_permission(permission::b_client_is_priority_speaker, {1, 0}, bulk.value_as<bool>("client_is_priority_speaker") ? permission::v2::PermissionUpdateType::set_value : permission::v2::PermissionUpdateType::delete_value, permission::v2::PermissionUpdateType::do_nothing);
         }
 
-        auto property = client->properties()[key.first];
+        auto property = client->properties()[property_info];
         auto old_value = property.value();
-        auto new_value = cmd[0][key.second].value();
         if(old_value == new_value)
             continue;
 
         property = new_value;
-        updates.push_back(key.first);
+        updates.push_back(property_info);
 
         serverInstance->action_logger()->client_edit_logger.log_client_edit(
                 this->getServerId(),
                 this->ref(),
                 client,
-                *key.first,
+                *property_info,
                 old_value,
                 new_value
         );
@@ -762,7 +743,7 @@ command_result ConnectedClient::handleCommandClientEdit(Command &cmd, const std:
     return command_result{error::ok};
 }
 
-command_result ConnectedClient::handleCommandClientUpdate(Command &cmd) {
+command_result ConnectedClient::handleCommandClientUpdate(const ts::command_parser &cmd) {
     return this->handleCommandClientEdit(cmd, this->ref());
 }
 
@@ -814,69 +795,63 @@ command_result ConnectedClient::handleCommandClientList(Command &cmd) {
     bool allow_ip = false;
     if (cmd.hasParm("ip"))
         allow_ip = permission::v2::permission_granted(1, this->calculate_permission(permission::b_client_remoteaddress_view, 0));
-    Command result("");
-
-    int index = 0;
+    command_arena_builder result{"", 8192};
     this->server->forEachClient([&](shared_ptr<ConnectedClient> client) {
         if (client->getType() == ClientType::CLIENT_INTERNAL) return;
 
-        result[index]["clid"] = client->getClientId();
-        if (client->getChannel())
-            result[index]["cid"] = client->getChannel()->channelId();
-        else result[index]["cid"] = 0;
-        result[index]["client_database_id"] = client->getClientDatabaseId();
-        result[index]["client_nickname"] = client->getDisplayName();
-        result[index]["client_type"] = client->getType();
+        auto channel = client->getChannel();
+        result.put("clid", client->getClientId());
+        result.put("cid", channel ? channel->channelId() : 0);
+        result.put("client_database_id", client->getClientDatabaseId());
+        result.put("client_nickname", client->getDisplayName());
+        result.put("client_type", client->getType());
 
         if (cmd.hasParm("uid"))
-            result[index]["client_unique_identifier"] = client->getUid();
+            result.put("client_unique_identifier", client->getUid());
         if (cmd.hasParm("away")) {
-            result[index]["client_away"] = client->properties()[property::CLIENT_AWAY].as_unchecked<string>();
-            result[index]["client_away_message"] = client->properties()[property::CLIENT_AWAY_MESSAGE].as_unchecked<string>();
+            result.put("client_away", client->properties()[property::CLIENT_AWAY].as_unchecked<string>());
+            result.put("client_away_message", client->properties()[property::CLIENT_AWAY_MESSAGE].as_unchecked<string>());
         }
         if (cmd.hasParm("groups")) {
-            result[index]["client_channel_group_id"] = client->properties()[property::CLIENT_CHANNEL_GROUP_ID].as_unchecked<string>();
-            result[index]["client_servergroups"] = client->properties()[property::CLIENT_SERVERGROUPS].as_unchecked<string>();
-            result[index]["client_channel_group_inherited_channel_id"] = client->properties()[property::CLIENT_CHANNEL_GROUP_INHERITED_CHANNEL_ID].as_unchecked<string>();
+            result.put("client_channel_group_id", client->properties()[property::CLIENT_CHANNEL_GROUP_ID].as_unchecked<string>());
+            result.put("client_servergroups", client->properties()[property::CLIENT_SERVERGROUPS].as_unchecked<string>());
+            result.put("client_channel_group_inherited_channel_id", client->properties()[property::CLIENT_CHANNEL_GROUP_INHERITED_CHANNEL_ID].as_unchecked<string>());
         }
         if (cmd.hasParm("times")) {
-            result[index]["client_idle_time"] = duration_cast<milliseconds>(system_clock::now() - client->idleTimestamp).count();
-            result[index]["client_total_online_time"] =
-                    client->properties()[property::CLIENT_TOTAL_ONLINE_TIME].as_unchecked<int64_t>() + duration_cast<seconds>(system_clock::now() - client->lastOnlineTimestamp).count();
-            result[index]["client_month_online_time"] =
-                    client->properties()[property::CLIENT_MONTH_ONLINE_TIME].as_unchecked<int64_t>() + duration_cast<seconds>(system_clock::now() - client->lastOnlineTimestamp).count();
-            result[index]["client_idle_time"] = duration_cast<milliseconds>(system_clock::now() - client->idleTimestamp).count();
-            result[index]["client_created"] = client->properties()[property::CLIENT_CREATED].as_unchecked<string>();
-            result[index]["client_lastconnected"] = client->properties()[property::CLIENT_LASTCONNECTED].as_unchecked<string>();
+            result.put("client_idle_time", duration_cast<milliseconds>(system_clock::now() - client->idleTimestamp).count());
+            result.put("client_total_online_time", client->properties()[property::CLIENT_TOTAL_ONLINE_TIME].as_unchecked<int64_t>() + duration_cast<seconds>(system_clock::now() - client->lastOnlineTimestamp).count());
+            result.put("client_month_online_time", client->properties()[property::CLIENT_MONTH_ONLINE_TIME].as_unchecked<int64_t>() + duration_cast<seconds>(system_clock::now() - client->lastOnlineTimestamp).count());
+            result.put("client_created", client->properties()[property::CLIENT_CREATED].as_unchecked<string>());
+            result.put("client_lastconnected", client->properties()[property::CLIENT_LASTCONNECTED].as_unchecked<string>());
         }
         if (cmd.hasParm("info")) {
-            result[index]["client_version"] = client->properties()[property::CLIENT_VERSION].as_unchecked<string>();
-            result[index]["client_platform"] = client->properties()[property::CLIENT_PLATFORM].as_unchecked<string>();
+            result.put("client_version", client->properties()[property::CLIENT_VERSION].as_unchecked<string>());
+            result.put("client_platform", client->properties()[property::CLIENT_PLATFORM].as_unchecked<string>());
         }
 
         if (cmd.hasParm("badges"))
-            result[index]["client_badges"] = client->properties()[property::CLIENT_BADGES].as_unchecked<string>();
+            result.put("client_badges", client->properties()[property::CLIENT_BADGES].as_unchecked<string>());
         if (cmd.hasParm("country"))
-            result[index]["client_country"] = client->properties()[property::CLIENT_COUNTRY].as_unchecked<string>();
+            result.put("client_country", client->properties()[property::CLIENT_COUNTRY].as_unchecked<string>());
         if (cmd.hasParm("ip"))
-            result[index]["connection_client_ip"] = allow_ip ? client->getPeerIp() : "hidden";
+            result.put("connection_client_ip", allow_ip ? client->getPeerIp() : "hidden");
         if (cmd.hasParm("icon"))
-            result[index]["client_icon_id"] = client->properties()[property::CLIENT_ICON_ID].as_unchecked<string>();
+            result.put("client_icon_id", client->properties()[property::CLIENT_ICON_ID].as_unchecked<string>());
 
         if (cmd.hasParm("voice")) {
-            result[index]["client_talk_power"] = client->properties()[property::CLIENT_TALK_POWER].as_unchecked<string>();
-            result[index]["client_flag_talking"] = client->properties()[property::CLIENT_FLAG_TALKING].as_unchecked<string>();
-            result[index]["client_input_muted"] = client->properties()[property::CLIENT_INPUT_MUTED].as_unchecked<string>();
-            result[index]["client_output_muted"] = client->properties()[property::CLIENT_OUTPUT_MUTED].as_unchecked<string>();
-            result[index]["client_input_hardware"] = client->properties()[property::CLIENT_INPUT_HARDWARE].as_unchecked<string>();
-            result[index]["client_output_hardware"] = client->properties()[property::CLIENT_OUTPUT_HARDWARE].as_unchecked<string>();
-            result[index]["client_is_talker"] = client->properties()[property::CLIENT_IS_TALKER].as_unchecked<string>();
-            result[index]["client_is_priority_speaker"] = client->properties()[property::CLIENT_IS_PRIORITY_SPEAKER].as_unchecked<string>();
-            result[index]["client_is_recording"] = client->properties()[property::CLIENT_IS_RECORDING].as_unchecked<string>();
-            result[index]["client_is_channel_commander"] = client->properties()[property::CLIENT_IS_CHANNEL_COMMANDER].as_unchecked<string>();
+            result.put("client_talk_power", client->properties()[property::CLIENT_TALK_POWER].as_unchecked<string>());
+            result.put("client_flag_talking", client->properties()[property::CLIENT_FLAG_TALKING].as_unchecked<string>());
+            result.put("client_input_muted", client->properties()[property::CLIENT_INPUT_MUTED].as_unchecked<string>());
+            result.put("client_output_muted", client->properties()[property::CLIENT_OUTPUT_MUTED].as_unchecked<string>());
+            result.put("client_input_hardware", client->properties()[property::CLIENT_INPUT_HARDWARE].as_unchecked<string>());
+            result.put("client_output_hardware", client->properties()[property::CLIENT_OUTPUT_HARDWARE].as_unchecked<string>());
+            result.put("client_is_talker", client->properties()[property::CLIENT_IS_TALKER].as_unchecked<string>());
+            result.put("client_is_priority_speaker", client->properties()[property::CLIENT_IS_PRIORITY_SPEAKER].as_unchecked<string>());
+            result.put("client_is_recording", client->properties()[property::CLIENT_IS_RECORDING].as_unchecked<string>());
+            result.put("client_is_channel_commander", client->properties()[property::CLIENT_IS_CHANNEL_COMMANDER].as_unchecked<string>());
 
         }
-        index++;
+        result.next_bulk();
     });
     this->sendCommand(result);
     return command_result{error::ok};
@@ -988,9 +963,7 @@ command_result ConnectedClient::handleCommandClientGetUidFromClid(Command &cmd)
 }
 
 command_result ConnectedClient::handleCommandClientAddPerm(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     auto cldbid = cmd["cldbid"].as<ClientDbId>();
     if(!serverInstance->databaseHelper()->validClientDatabaseId(this->server, cldbid))
@@ -1032,9 +1005,7 @@ command_result ConnectedClient::handleCommandClientAddPerm(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandClientDelPerm(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     auto cldbid = cmd["cldbid"].as<ClientDbId>();
     if(!serverInstance->databaseHelper()->validClientDatabaseId(this->server, cldbid))
@@ -1074,10 +1045,7 @@ command_result ConnectedClient::handleCommandClientDelPerm(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandClientPermList(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_virtualserver_client_permission_list, 1);
 
     if(!serverInstance->databaseHelper()->validClientDatabaseId(this->server, cmd["cldbid"])) return command_result{error::client_invalid_id};
     auto mgr = serverInstance->databaseHelper()->loadClientPermissionManager(this->getServerId(), cmd["cldbid"]);
@@ -1086,10 +1054,7 @@ command_result ConnectedClient::handleCommandClientPermList(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandClientDbInfo(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_virtualserver_client_dbinfo, 1);
 
     std::deque<ClientDbId> cldbids;
     for(int index = 0; index < cmd.bulkCount(); index++) {
@@ -1154,10 +1119,7 @@ command_result ConnectedClient::handleCommandClientDbInfo(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandClientDBDelete(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_client_delete_dbproperties, 1);
 
     ClientDbId id = cmd["cldbid"];
     if (!serverInstance->databaseHelper()->validClientDatabaseId(this->server, id)) return command_result{error::database_empty_result};
@@ -1167,10 +1129,7 @@ command_result ConnectedClient::handleCommandClientDBDelete(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandClientDBFind(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_virtualserver_client_dbsearch, 1);
 
     bool uid = cmd.hasParm("uid");
     string pattern = cmd["pattern"];
@@ -1333,9 +1292,6 @@ command_result ConnectedClient::handleCommandClientInfo(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandClientFind(Command &cmd) {
-    CMD_REQ_SERVER;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-
     string pattern = cmd["pattern"];
     std::transform(pattern.begin(), pattern.end(), pattern.begin(), ::tolower);
 
@@ -1357,8 +1313,6 @@ command_result ConnectedClient::handleCommandClientFind(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandClientSetServerQueryLogin(Command &cmd) {
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_client_create_modify_serverquery_login, 1);
-
     if(!cmd[0].has("client_login_password")) cmd["client_login_password"] = "";
 
     std::string password = cmd["client_login_password"];
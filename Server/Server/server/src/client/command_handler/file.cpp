@@ -913,8 +913,6 @@ command_result ConnectedClient::handleCommandFTInitDownload(ts::Command &cmd) {
  */
 command_result ConnectedClient::handleCommandFTRenameFile(ts::Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_REQ_SERVER;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     auto virtual_file_server = file::server()->find_virtual_server(this->getServerId());
     if(!virtual_file_server) return command_result{error::file_virtual_server_not_registered};
@@ -989,8 +987,6 @@ command_result ConnectedClient::handleCommandFTRenameFile(ts::Command &cmd) {
 // serverftfid=6 sender=0 status=1 current_speed=60872.8 average_speed runtime
 command_result ConnectedClient::handleCommandFTList(ts::Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_REQ_SERVER;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
     ACTION_REQUIRES_PERMISSION(permission::b_ft_transfer_list, 1, 0);
 
     auto virtual_file_server = file::server()->find_virtual_server(this->getServerId());
@@ -1052,8 +1048,6 @@ command_result ConnectedClient::handleCommandFTList(ts::Command &cmd) {
 //ftstop serverftfid='2' clientftfid='4096' delete='0'
 command_result ConnectedClient::handleCommandFTStop(ts::Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_REQ_SERVER;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
 
     auto virtual_file_server = file::server()->find_virtual_server(this->getServerId());
     if(!virtual_file_server) {
@@ -44,238 +44,392 @@ using namespace ts::server::token;
 
 #define QUERY_PASSWORD_LENGTH 12
 
-command_result ConnectedClient::handleCommand(Command &cmd) {
-    threads::MutexLock l2(this->command_lock);
-    auto command = cmd.command();
-    if (command == "servergetvariables") return this->handleCommandServerGetVariables(cmd);
-    else if (command == "serverrequestconnectioninfo") return this->handleCommandServerRequestConnectionInfo(cmd);
-    else if (command == "getconnectioninfo") return this->handleCommandGetConnectionInfo(cmd);
-    else if (command == "setconnectioninfo") return this->handleCommandSetConnectionInfo(cmd);
-    else if (command == "clientgetvariables") return this->handleCommandClientGetVariables(cmd);
-    else if (command == "serveredit") return this->handleCommandServerEdit(cmd);
-    else if (command == "clientedit") return this->handleCommandClientEdit(cmd);
-    else if (command == "channelgetdescription") return this->handleCommandChannelGetDescription(cmd);
-    else if (command == "connectioninfoautoupdate") return this->handleCommandConnectionInfoAutoUpdate(cmd);
-    else if (command == "permissionlist") return this->handleCommandPermissionList(cmd);
-    else if (command == "propertylist") return this->handleCommandPropertyList(cmd);
+command_result ConnectedClient::handleCommand(Command &cmd, CommandId command_id) {
+    switch (command_id) {
+        case CommandId::ServerGetVariables:
+            return this->handleCommandServerGetVariables(cmd);
+        case CommandId::ServerRequestConnectionInfo:
+            return this->handleCommandServerRequestConnectionInfo(cmd);
+        case CommandId::GetConnectionInfo:
+            return this->handleCommandGetConnectionInfo(cmd);
+        case CommandId::SetConnectionInfo:
+            return this->handleCommandSetConnectionInfo(cmd);
+        case CommandId::ClientGetVariables:
+            return this->handleCommandClientGetVariables(cmd);
+        case CommandId::ServerEdit:
+            return this->handleCommandServerEdit(cmd);
+        case CommandId::ChannelGetDescription:
+            return this->handleCommandChannelGetDescription(cmd);
+        case CommandId::ConnectionInfoAutoUpdate:
+            return this->handleCommandConnectionInfoAutoUpdate(cmd);
+        case CommandId::PermissionList:
+            return this->handleCommandPermissionList(cmd);
+        case CommandId::PropertyList:
+            return this->handleCommandPropertyList(cmd);
 
         //Server group
-    else if (command == "servergrouplist") return this->handleCommandServerGroupList(cmd);
-    else if (command == "servergroupadd") return this->handleCommandServerGroupAdd(cmd);
-    else if (command == "servergroupcopy") return this->handleCommandServerGroupCopy(cmd);
-    else if (command == "servergroupdel") return this->handleCommandServerGroupDel(cmd);
-    else if (command == "servergrouprename") return this->handleCommandServerGroupRename(cmd);
-    else if (command == "servergroupclientlist") return this->handleCommandServerGroupClientList(cmd);
-    else if (command == "servergroupaddclient" || command == "clientaddservergroup") return this->handleCommandServerGroupAddClient(cmd);
-    else if (command == "servergroupdelclient" || command == "clientdelservergroup") return this->handleCommandServerGroupDelClient(cmd);
-    else if (command == "servergrouppermlist") return this->handleCommandServerGroupPermList(cmd);
-    else if (command == "servergroupaddperm") return this->handleCommandServerGroupAddPerm(cmd);
-    else if (command == "servergroupdelperm") return this->handleCommandServerGroupDelPerm(cmd);
-
-    else if (command == "setclientchannelgroup") return this->handleCommandSetClientChannelGroup(cmd);
+        case CommandId::ServerGroupList:
+            return this->handleCommandServerGroupList(cmd);
+        case CommandId::ServerGroupAdd:
+            return this->handleCommandServerGroupAdd(cmd);
+        case CommandId::ServerGroupCopy:
+            return this->handleCommandServerGroupCopy(cmd);
+        case CommandId::ServerGroupDel:
+            return this->handleCommandServerGroupDel(cmd);
+        case CommandId::ServerGroupRename:
+            return this->handleCommandServerGroupRename(cmd);
+        case CommandId::ServerGroupClientList:
+            return this->handleCommandServerGroupClientList(cmd);
+        case CommandId::ServerGroupAddClient:
+            return this->handleCommandServerGroupAddClient(cmd);
+        case CommandId::ServerGroupDelClient:
+            return this->handleCommandServerGroupDelClient(cmd);
+        case CommandId::ServerGroupPermList:
+            return this->handleCommandServerGroupPermList(cmd);
+        case CommandId::ServerGroupAddPerm:
+            return this->handleCommandServerGroupAddPerm(cmd);
+        case CommandId::ServerGroupDelPerm:
+            return this->handleCommandServerGroupDelPerm(cmd);
+
+        case CommandId::SetClientChannelGroup:
+            return this->handleCommandSetClientChannelGroup(cmd);
 
         //Channel basic actions
-    else if (command == "channelcreate") return this->handleCommandChannelCreate(cmd);
-    else if (command == "channelmove") return this->handleCommandChannelMove(cmd);
-    else if (command == "channeledit") return this->handleCommandChannelEdit(cmd);
-    else if (command == "channeldelete") return this->handleCommandChannelDelete(cmd);
+        case CommandId::ChannelCreate:
+            return this->handleCommandChannelCreate(cmd);
+        case CommandId::ChannelMove:
+            return this->handleCommandChannelMove(cmd);
+        case CommandId::ChannelEdit:
+            return this->handleCommandChannelEdit(cmd);
+        case CommandId::ChannelDelete:
+            return this->handleCommandChannelDelete(cmd);
         //Find a channel and get informations
-    else if (command == "channelfind") return this->handleCommandChannelFind(cmd);
-    else if (command == "channelinfo") return this->handleCommandChannelInfo(cmd);
+        case CommandId::ChannelFind:
+            return this->handleCommandChannelFind(cmd);
+        case CommandId::ChannelInfo:
+            return this->handleCommandChannelInfo(cmd);
         //Channel perm actions
-    else if (command == "channelpermlist") return this->handleCommandChannelPermList(cmd);
-    else if (command == "channeladdperm") return this->handleCommandChannelAddPerm(cmd);
-    else if (command == "channeldelperm") return this->handleCommandChannelDelPerm(cmd);
+        case CommandId::ChannelPermList:
+            return this->handleCommandChannelPermList(cmd);
+        case CommandId::ChannelAddPerm:
+            return this->handleCommandChannelAddPerm(cmd);
+        case CommandId::ChannelDelPerm:
+            return this->handleCommandChannelDelPerm(cmd);
         //Channel group actions
-    else if (command == "channelgroupadd") return this->handleCommandChannelGroupAdd(cmd);
-    else if (command == "channelgroupcopy") return this->handleCommandChannelGroupCopy(cmd);
-    else if (command == "channelgrouprename") return this->handleCommandChannelGroupRename(cmd);
-    else if (command == "channelgroupdel") return this->handleCommandChannelGroupDel(cmd);
-    else if (command == "channelgrouplist") return this->handleCommandChannelGroupList(cmd);
-    else if (command == "channelgroupclientlist") return this->handleCommandChannelGroupClientList(cmd);
-    else if (command == "channelgrouppermlist") return this->handleCommandChannelGroupPermList(cmd);
-    else if (command == "channelgroupaddperm") return this->handleCommandChannelGroupAddPerm(cmd);
-    else if (command == "channelgroupdelperm") return this->handleCommandChannelGroupDelPerm(cmd);
+        case CommandId::ChannelGroupAdd:
+            return this->handleCommandChannelGroupAdd(cmd);
+        case CommandId::ChannelGroupCopy:
+            return this->handleCommandChannelGroupCopy(cmd);
+        case CommandId::ChannelGroupRename:
+            return this->handleCommandChannelGroupRename(cmd);
+        case CommandId::ChannelGroupDel:
+            return this->handleCommandChannelGroupDel(cmd);
+        case CommandId::ChannelGroupList:
+            return this->handleCommandChannelGroupList(cmd);
+        case CommandId::ChannelGroupClientList:
+            return this->handleCommandChannelGroupClientList(cmd);
+        case CommandId::ChannelGroupPermList:
+            return this->handleCommandChannelGroupPermList(cmd);
+        case CommandId::ChannelGroupAddPerm:
+            return this->handleCommandChannelGroupAddPerm(cmd);
+        case CommandId::ChannelGroupDelPerm:
+            return this->handleCommandChannelGroupDelPerm(cmd);
         //Channel sub/unsubscribe
-    else if (command == "channelsubscribe") return this->handleCommandChannelSubscribe(cmd);
-    else if (command == "channelsubscribeall") return this->handleCommandChannelSubscribeAll(cmd);
-    else if (command == "channelunsubscribe") return this->handleCommandChannelUnsubscribe(cmd);
-    else if (command == "channelunsubscribeall") return this->handleCommandChannelUnsubscribeAll(cmd);
+        case CommandId::ChannelSubscribeAll:
+            return this->handleCommandChannelSubscribeAll(cmd);
+        case CommandId::ChannelUnsubscribe:
+            return this->handleCommandChannelUnsubscribe(cmd);
+        case CommandId::ChannelUnsubscribeAll:
+            return this->handleCommandChannelUnsubscribeAll(cmd);
         //manager channel permissions
-    else if (command == "channelclientpermlist") return this->handleCommandChannelClientPermList(cmd);
-    else if (command == "channelclientaddperm") return this->handleCommandChannelClientAddPerm(cmd);
-    else if (command == "channelclientdelperm") return this->handleCommandChannelClientDelPerm(cmd);
+        case CommandId::ChannelClientPermList:
+            return this->handleCommandChannelClientPermList(cmd);
+        case CommandId::ChannelClientAddPerm:
+            return this->handleCommandChannelClientAddPerm(cmd);
+        case CommandId::ChannelClientDelPerm:
+            return this->handleCommandChannelClientDelPerm(cmd);
         //Client actions
-    else if (command == "clientupdate") return this->handleCommandClientUpdate(cmd);
-    else if (command == "clientmove") return this->handleCommandClientMove(cmd);
-    else if (command == "clientgetids") return this->handleCommandClientGetIds(cmd);
-    else if (command == "clientkick") return this->handleCommandClientKick(cmd);
-    else if (command == "clientpoke") return this->handleCommandClientPoke(cmd);
-    else if (command == "sendtextmessage") return this->handleCommandSendTextMessage(cmd);
-    else if (command == "clientchatcomposing") return this->handleCommandClientChatComposing(cmd);
-    else if (command == "clientchatclosed") return this->handleCommandClientChatClosed(cmd);
-
-    else if (command == "clientfind") return this->handleCommandClientFind(cmd);
-    else if (command == "clientinfo") return this->handleCommandClientInfo(cmd);
-
-    else if (command == "clientaddperm") return this->handleCommandClientAddPerm(cmd);
-    else if (command == "clientdelperm") return this->handleCommandClientDelPerm(cmd);
-    else if (command == "clientpermlist") return this->handleCommandClientPermList(cmd);
+        case CommandId::ClientGetIds:
+            return this->handleCommandClientGetIds(cmd);
+        case CommandId::ClientKick:
+            return this->handleCommandClientKick(cmd);
+        case CommandId::ClientPoke:
+            return this->handleCommandClientPoke(cmd);
+        case CommandId::ClientChatComposing:
+            return this->handleCommandClientChatComposing(cmd);
+        case CommandId::ClientChatClosed:
+            return this->handleCommandClientChatClosed(cmd);
+
+        case CommandId::ClientFind:
+            return this->handleCommandClientFind(cmd);
+        case CommandId::ClientInfo:
+            return this->handleCommandClientInfo(cmd);
+
+        case CommandId::ClientAddPerm:
+            return this->handleCommandClientAddPerm(cmd);
+        case CommandId::ClientDelPerm:
+            return this->handleCommandClientDelPerm(cmd);
+        case CommandId::ClientPermList:
+            return this->handleCommandClientPermList(cmd);
         //File transfare
-    else if (command == "ftgetfilelist") return this->handleCommandFTGetFileList(cmd);
-    else if (command == "ftcreatedir") return this->handleCommandFTCreateDir(cmd);
-    else if (command == "ftdeletefile") return this->handleCommandFTDeleteFile(cmd);
-    else if (command == "ftinitupload") {
-        auto result = this->handleCommandFTInitUpload(cmd);
-        if(result.has_error() && this->getType() == ClientType::CLIENT_TEAMSPEAK) {
-            ts::command_builder notify{"notifystatusfiletransfer"};
-            notify.put_unchecked(0, "clientftfid", cmd["clientftfid"].string());
-            notify.put(0, "size", 0);
-            this->writeCommandResult(notify, result, "status");
-            this->sendCommand(notify);
-            result.release_data();
+        case CommandId::FTGetFileList:
+            return this->handleCommandFTGetFileList(cmd);
+        case CommandId::FTCreateDir:
+            return this->handleCommandFTCreateDir(cmd);
+        case CommandId::FTDeleteFile:
+            return this->handleCommandFTDeleteFile(cmd);
+        case CommandId::FTInitUpload: {
+            auto result = this->handleCommandFTInitUpload(cmd);
+            if(result.has_error() && this->getType() == ClientType::CLIENT_TEAMSPEAK) {
+                ts::command_builder notify{"notifystatusfiletransfer"};
+                notify.put_unchecked(0, "clientftfid", cmd["clientftfid"].string());
+                notify.put(0, "size", 0);
+                this->writeCommandResult(notify, result, "status");
+                this->sendCommand(notify);
+                result.release_data();
 
-            return command_result{error::ok};
-        }
-        return result;
-    }
-    else if (command == "ftinitdownload") {
-        auto result = this->handleCommandFTInitDownload(cmd);
-        if(result.has_error() && this->getType() == ClientType::CLIENT_TEAMSPEAK) {
-            ts::command_builder notify{"notifystatusfiletransfer"};
-            notify.put_unchecked(0, "clientftfid", cmd["clientftfid"].string());
-            notify.put(0, "size", 0);
-            this->writeCommandResult(notify, result, "status");
-            this->sendCommand(notify);
-            result.release_data();
+                return command_result{error::ok};
+            }
+            return result;
+        }
+        case CommandId::FTInitDownload: {
+            auto result = this->handleCommandFTInitDownload(cmd);
+            if(result.has_error() && this->getType() == ClientType::CLIENT_TEAMSPEAK) {
+                ts::command_builder notify{"notifystatusfiletransfer"};
+                notify.put_unchecked(0, "clientftfid", cmd["clientftfid"].string());
+                notify.put(0, "size", 0);
+                this->writeCommandResult(notify, result, "status");
+                this->sendCommand(notify);
+                result.release_data();
 
-            return command_result{error::ok};
-        }
-        return result;
-    }
-    else if (command == "ftgetfileinfo") return this->handleCommandFTGetFileInfo(cmd);
-    else if (command == "ftrenamefile") return this->handleCommandFTRenameFile(cmd);
-    else if (command == "ftlist") return this->handleCommandFTList(cmd);
-    else if (command == "ftstop") return this->handleCommandFTStop(cmd);
+                return command_result{error::ok};
+            }
+            return result;
+        }
+        case CommandId::FTGetFileInfo:
+            return this->handleCommandFTGetFileInfo(cmd);
+        case CommandId::FTRenameFile:
+            return this->handleCommandFTRenameFile(cmd);
+        case CommandId::FTList:
+            return this->handleCommandFTList(cmd);
+        case CommandId::FTStop:
+            return this->handleCommandFTStop(cmd);
         //Banlist
-    else if (command == "banlist") return this->handleCommandBanList(cmd);
-    else if (command == "banadd") return this->handleCommandBanAdd(cmd);
-    else if (command == "banedit") return this->handleCommandBanEdit(cmd);
-    else if (command == "banclient") return this->handleCommandBanClient(cmd);
-    else if (command == "bandel") return this->handleCommandBanDel(cmd);
-    else if (command == "bandelall") return this->handleCommandBanDelAll(cmd);
-    else if (command == "bantriggerlist") return this->handleCommandBanTriggerList(cmd);
+        case CommandId::BanList:
+            return this->handleCommandBanList(cmd);
+        case CommandId::BanAdd:
+            return this->handleCommandBanAdd(cmd);
+        case CommandId::BanEdit:
+            return this->handleCommandBanEdit(cmd);
+        case CommandId::BanClient:
+            return this->handleCommandBanClient(cmd);
+        case CommandId::BanDel:
+            return this->handleCommandBanDel(cmd);
+        case CommandId::BanDelAll:
+            return this->handleCommandBanDelAll(cmd);
+        case CommandId::BanTriggerList:
+            return this->handleCommandBanTriggerList(cmd);
         //Tokens
-    else if (command == "tokenactionlist") return this->handleCommandTokenActionList(cmd);
-    else if (command == "tokenlist" || command == "privilegekeylist") return this->handleCommandTokenList(cmd);
-    else if (command == "tokenadd" || command == "privilegekeyadd") return this->handleCommandTokenAdd(cmd);
-    else if (command == "tokenedit") return this->handleCommandTokenEdit(cmd);
-    else if (command == "tokenuse" || command == "privilegekeyuse") return this->handleCommandTokenUse(cmd);
-    else if (command == "tokendelete" || command == "privilegekeydelete") return this->handleCommandTokenDelete(cmd);
+        case CommandId::TokenActionList:
+            return this->handleCommandTokenActionList(cmd);
+        case CommandId::TokenList:
+            return this->handleCommandTokenList(cmd);
+        case CommandId::TokenAdd:
+            return this->handleCommandTokenAdd(cmd);
+        case CommandId::TokenEdit:
+            return this->handleCommandTokenEdit(cmd);
+        case CommandId::TokenUse:
+            return this->handleCommandTokenUse(cmd);
+        case CommandId::TokenDelete:
+            return this->handleCommandTokenDelete(cmd);
 
         //DB stuff
-    else if (command == "clientdblist") return this->handleCommandClientDbList(cmd);
-    else if (command == "clientdbinfo") return this->handleCommandClientDbInfo(cmd);
-    else if (command == "clientdbedit") return this->handleCommandClientDBEdit(cmd);
-    else if (command == "clientdbfind") return this->handleCommandClientDBFind(cmd);
-    else if (command == "clientdbdelete") return this->handleCommandClientDBDelete(cmd);
-    else if (command == "plugincmd") return this->handleCommandPluginCmd(cmd);
-
-    else if (command == "clientmute") return this->handleCommandClientMute(cmd);
-    else if (command == "clientunmute") return this->handleCommandClientUnmute(cmd);
-
-    else if (command == "clientlist") return this->handleCommandClientList(cmd);
-    else if (command == "whoami") return this->handleCommandWhoAmI(cmd);
-    else if (command == "servergroupsbyclientid") return this->handleCommandServerGroupsByClientId(cmd);
-
-    else if (command == "clientgetdbidfromuid") return this->handleCommandClientGetDBIDfromUID(cmd);
-    else if (command == "clientgetnamefromdbid") return this->handleCommandClientGetNameFromDBID(cmd);
-    else if (command == "clientgetnamefromuid") return this->handleCommandClientGetNameFromUid(cmd);
-    else if (command == "clientgetuidfromclid") return this->handleCommandClientGetUidFromClid(cmd);
-
-
-    else if (command == "complainadd") return this->handleCommandComplainAdd(cmd);
-    else if (command == "complainlist") return this->handleCommandComplainList(cmd);
-    else if (command == "complaindel") return this->handleCommandComplainDel(cmd);
-    else if (command == "complaindelall") return this->handleCommandComplainDelAll(cmd);
-
-    else if (command == "version") return this->handleCommandVersion(cmd);
-
-    else if (command == "verifyserverpassword") return this->handleCommandVerifyServerPassword(cmd);
-    else if (command == "verifychannelpassword") return this->handleCommandVerifyChannelPassword(cmd);
-
-    else if (command == "messagelist") return this->handleCommandMessageList(cmd);
-    else if (command == "messageadd") return this->handleCommandMessageAdd(cmd);
-    else if (command == "messageget") return this->handleCommandMessageGet(cmd);
-    else if (command == "messagedel") return this->handleCommandMessageDel(cmd);
-    else if (command == "messageupdateflag") return this->handleCommandMessageUpdateFlag(cmd);
-
-    else if (command == "permget") return this->handleCommandPermGet(cmd);
-    else if (command == "permfind") return this->handleCommandPermFind(cmd);
-    else if (command == "permidgetbyname") return this->handleCommandPermIdGetByName(cmd);
-    else if (command == "permoverview") return this->handleCommandPermOverview(cmd);
-    else if (command == "permreset") return this->handleCommandPermReset(cmd);
-
-    else if (command == "clientsetserverquerylogin") return this->handleCommandClientSetServerQueryLogin(cmd);
+        case CommandId::ClientDbList:
+            return this->handleCommandClientDbList(cmd);
+        case CommandId::ClientDbInfo:
+            return this->handleCommandClientDbInfo(cmd);
+        case CommandId::ClientDBEdit:
+            return this->handleCommandClientDBEdit(cmd);
+        case CommandId::ClientDBFind:
+            return this->handleCommandClientDBFind(cmd);
+        case CommandId::ClientDBDelete:
+            return this->handleCommandClientDBDelete(cmd);
+        case CommandId::PluginCmd:
+            return this->handleCommandPluginCmd(cmd);
+
+        case CommandId::ClientMute:
+            return this->handleCommandClientMute(cmd);
+        case CommandId::ClientUnmute:
+            return this->handleCommandClientUnmute(cmd);
+
+        case CommandId::ClientList:
+            return this->handleCommandClientList(cmd);
+        case CommandId::WhoAmI:
+            return this->handleCommandWhoAmI(cmd);
+        case CommandId::ServerGroupsByClientId:
+            return this->handleCommandServerGroupsByClientId(cmd);
+
+        case CommandId::ClientGetDBIDfromUID:
+            return this->handleCommandClientGetDBIDfromUID(cmd);
+        case CommandId::ClientGetNameFromDBID:
+            return this->handleCommandClientGetNameFromDBID(cmd);
+        case CommandId::ClientGetNameFromUid:
+            return this->handleCommandClientGetNameFromUid(cmd);
+        case CommandId::ClientGetUidFromClid:
+            return this->handleCommandClientGetUidFromClid(cmd);
+
+        case CommandId::ComplainAdd:
+            return this->handleCommandComplainAdd(cmd);
+        case CommandId::ComplainList:
+            return this->handleCommandComplainList(cmd);
+        case CommandId::ComplainDel:
+            return this->handleCommandComplainDel(cmd);
+        case CommandId::ComplainDelAll:
+            return this->handleCommandComplainDelAll(cmd);
+
+        case CommandId::Version:
+            return this->handleCommandVersion(cmd);
+
+        case CommandId::VerifyServerPassword:
+            return this->handleCommandVerifyServerPassword(cmd);
+        case CommandId::VerifyChannelPassword:
+            return this->handleCommandVerifyChannelPassword(cmd);
+
+        case CommandId::MessageList:
+            return this->handleCommandMessageList(cmd);
+        case CommandId::MessageAdd:
+            return this->handleCommandMessageAdd(cmd);
+        case CommandId::MessageGet:
+            return this->handleCommandMessageGet(cmd);
+        case CommandId::MessageDel:
+            return this->handleCommandMessageDel(cmd);
+        case CommandId::MessageUpdateFlag:
+            return this->handleCommandMessageUpdateFlag(cmd);
+
+        case CommandId::PermGet:
+            return this->handleCommandPermGet(cmd);
+        case CommandId::PermFind:
+            return this->handleCommandPermFind(cmd);
+        case CommandId::PermIdGetByName:
+            return this->handleCommandPermIdGetByName(cmd);
+        case CommandId::PermOverview:
+            return this->handleCommandPermOverview(cmd);
+        case CommandId::PermReset:
+            return this->handleCommandPermReset(cmd);
+
+        case CommandId::ClientSetServerQueryLogin:
+            return this->handleCommandClientSetServerQueryLogin(cmd);
 
         //Music stuff
-    else if (command == "musicbotcreate") return this->handleCommandMusicBotCreate(cmd);
-    else if (command == "musicbotdelete") return this->handleCommandMusicBotDelete(cmd);
-    else if (command == "musicbotsetsubscription") return this->handleCommandMusicBotSetSubscription(cmd);
-    else if (command == "musicbotplayerinfo") return this->handleCommandMusicBotPlayerInfo(cmd);
-    else if (command == "musicbotplayeraction") return this->handleCommandMusicBotPlayerAction(cmd);
-    else if (command == "musicbotqueuelist") return this->handleCommandMusicBotQueueList(cmd);
-    else if (command == "musicbotqueueadd") return this->handleCommandMusicBotQueueAdd(cmd);
-    else if (command == "musicbotqueueremove") return this->handleCommandMusicBotQueueRemove(cmd);
-    else if (command == "musicbotqueuereorder") return this->handleCommandMusicBotQueueReorder(cmd);
-    else if (command == "musicbotplaylistassign") return this->handleCommandMusicBotPlaylistAssign(cmd);
-
-    else if (command == "help") return this->handleCommandHelp(cmd);
-
-    else if (command == "logview") return this->handleCommandLogView(cmd);
-    else if (command == "logquery") return this->handleCommandLogQuery(cmd);
-    else if (command == "logadd") return this->handleCommandLogAdd(cmd);
-
-    else if (command == "servergroupautoaddperm") return this->handleCommandServerGroupAutoAddPerm(cmd);
-    else if (command == "servergroupautodelperm") return this->handleCommandServerGroupAutoDelPerm(cmd);
-
-    else if (command == "updatemytsid") return this->handleCommandUpdateMyTsId(cmd);
-    else if (command == "updatemytsdata") return this->handleCommandUpdateMyTsData(cmd);
-
-    else if (command == "querycreate") return this->handleCommandQueryCreate(cmd);
-    else if (command == "querydelete") return this->handleCommandQueryDelete(cmd);
-    else if (command == "querylist") return this->handleCommandQueryList(cmd);
-    else if (command == "queryrename") return this->handleCommandQueryRename(cmd);
-    else if (command == "querychangepassword") return this->handleCommandQueryChangePassword(cmd);
-
-    else if (command == "playlistlist") return this->handleCommandPlaylistList(cmd);
-    else if (command == "playlistcreate") return this->handleCommandPlaylistCreate(cmd);
-    else if (command == "playlistdelete") return this->handleCommandPlaylistDelete(cmd);
-    else if (command == "playlistsetsubscription") return this->handleCommandPlaylistSetSubscription(cmd);
-
-    else if (command == "playlistpermlist") return this->handleCommandPlaylistPermList(cmd);
-    else if (command == "playlistaddperm") return this->handleCommandPlaylistAddPerm(cmd);
-    else if (command == "playlistdelperm") return this->handleCommandPlaylistDelPerm(cmd);
-    else if (command == "playlistclientlist") return this->handleCommandPlaylistClientList(cmd);
-    else if (command == "playlistclientpermlist") return this->handleCommandPlaylistClientPermList(cmd);
-    else if (command == "playlistclientaddperm") return this->handleCommandPlaylistClientAddPerm(cmd);
-    else if (command == "playlistclientdelperm") return this->handleCommandPlaylistClientDelPerm(cmd);
-    else if (command == "playlistinfo") return this->handleCommandPlaylistInfo(cmd);
-    else if (command == "playlistedit") return this->handleCommandPlaylistEdit(cmd);
-
-    else if (command == "playlistsonglist") return this->handleCommandPlaylistSongList(cmd);
-    else if (command == "playlistsongsetcurrent") return this->handleCommandPlaylistSongSetCurrent(cmd);
-    else if (command == "playlistsongadd") return this->handleCommandPlaylistSongAdd(cmd);
-    else if (command == "playlistsongreorder" || command == "playlistsongmove") return this->handleCommandPlaylistSongReorder(cmd);
-    else if (command == "playlistsongremove") return this->handleCommandPlaylistSongRemove(cmd);
-
-    else if (command == "dummy_ipchange") return this->handleCommandDummy_IpChange(cmd);
-    else if (command == "conversationhistory") return this->handleCommandConversationHistory(cmd);
-    else if (command == "conversationfetch") return this->handleCommandConversationFetch(cmd);
-    else if (command == "conversationmessagedelete") return this->handleCommandConversationMessageDelete(cmd);
-
-    else if (command == "listfeaturesupport") return this->handleCommandListFeatureSupport(cmd);
+        case CommandId::MusicBotCreate:
+            return this->handleCommandMusicBotCreate(cmd);
+        case CommandId::MusicBotDelete:
+            return this->handleCommandMusicBotDelete(cmd);
+        case CommandId::MusicBotSetSubscription:
+            return this->handleCommandMusicBotSetSubscription(cmd);
+        case CommandId::MusicBotPlayerInfo:
+            return this->handleCommandMusicBotPlayerInfo(cmd);
+        case CommandId::MusicBotPlayerAction:
+            return this->handleCommandMusicBotPlayerAction(cmd);
+        case CommandId::MusicBotQueueList:
+            return this->handleCommandMusicBotQueueList(cmd);
+        case CommandId::MusicBotQueueAdd:
+            return this->handleCommandMusicBotQueueAdd(cmd);
+        case CommandId::MusicBotQueueRemove:
+            return this->handleCommandMusicBotQueueRemove(cmd);
+        case CommandId::MusicBotQueueReorder:
+            return this->handleCommandMusicBotQueueReorder(cmd);
+        case CommandId::MusicBotPlaylistAssign:
+            return this->handleCommandMusicBotPlaylistAssign(cmd);
+
+        case CommandId::Help:
+            return this->handleCommandHelp(cmd);
+
+        case CommandId::LogView:
+            return this->handleCommandLogView(cmd);
+        case CommandId::LogQuery:
+            return this->handleCommandLogQuery(cmd);
+        case CommandId::LogAdd:
+            return this->handleCommandLogAdd(cmd);
+
+        case CommandId::ServerGroupAutoAddPerm:
+            return this->handleCommandServerGroupAutoAddPerm(cmd);
+        case CommandId::ServerGroupAutoDelPerm:
+            return this->handleCommandServerGroupAutoDelPerm(cmd);
+
+        case CommandId::UpdateMyTsId:
+            return this->handleCommandUpdateMyTsId(cmd);
+        case CommandId::UpdateMyTsData:
+            return this->handleCommandUpdateMyTsData(cmd);
+
+        case CommandId::QueryCreate:
+            return this->handleCommandQueryCreate(cmd);
+        case CommandId::QueryDelete:
+            return this->handleCommandQueryDelete(cmd);
+        case CommandId::QueryList:
+            return this->handleCommandQueryList(cmd);
+        case CommandId::QueryRename:
+            return this->handleCommandQueryRename(cmd);
+        case CommandId::QueryChangePassword:
+            return this->handleCommandQueryChangePassword(cmd);
+
+        case CommandId::PlaylistList:
+            return this->handleCommandPlaylistList(cmd);
+        case CommandId::PlaylistCreate:
+            return this->handleCommandPlaylistCreate(cmd);
+        case CommandId::PlaylistDelete:
+            return this->handleCommandPlaylistDelete(cmd);
+        case CommandId::PlaylistSetSubscription:
+            return this->handleCommandPlaylistSetSubscription(cmd);
+
+        case CommandId::PlaylistPermList:
+            return this->handleCommandPlaylistPermList(cmd);
+        case CommandId::PlaylistAddPerm:
+            return this->handleCommandPlaylistAddPerm(cmd);
+        case CommandId::PlaylistDelPerm:
+            return this->handleCommandPlaylistDelPerm(cmd);
+        case CommandId::PlaylistClientList:
+            return this->handleCommandPlaylistClientList(cmd);
+        case CommandId::PlaylistClientPermList:
+            return this->handleCommandPlaylistClientPermList(cmd);
+        case CommandId::PlaylistClientAddPerm:
+            return this->handleCommandPlaylistClientAddPerm(cmd);
+        case CommandId::PlaylistClientDelPerm:
+            return this->handleCommandPlaylistClientDelPerm(cmd);
+        case CommandId::PlaylistInfo:
+            return this->handleCommandPlaylistInfo(cmd);
+        case CommandId::PlaylistEdit:
+            return this->handleCommandPlaylistEdit(cmd);
+
+        case CommandId::PlaylistSongList:
+            return this->handleCommandPlaylistSongList(cmd);
+        case CommandId::PlaylistSongSetCurrent:
+            return this->handleCommandPlaylistSongSetCurrent(cmd);
+        case CommandId::PlaylistSongAdd:
+            return this->handleCommandPlaylistSongAdd(cmd);
+        case CommandId::PlaylistSongReorder:
+            return this->handleCommandPlaylistSongReorder(cmd);
+        case CommandId::PlaylistSongRemove:
+            return this->handleCommandPlaylistSongRemove(cmd);
+
+        case CommandId::Dummy_IpChange:
+            return this->handleCommandDummy_IpChange(cmd);
+        case CommandId::ConversationHistory:
+            return this->handleCommandConversationHistory(cmd);
+        case CommandId::ConversationFetch:
+            return this->handleCommandConversationFetch(cmd);
+        case CommandId::ConversationMessageDelete:
+            return this->handleCommandConversationMessageDelete(cmd);
+
+        case CommandId::ListFeatureSupport:
+            return this->handleCommandListFeatureSupport(cmd);
+
+        case CommandId::Unknown:
+        default:
+            break;
+    }
 
+    auto command = cmd.command();
     if (this->getType() == ClientType::CLIENT_QUERY)
         return command_result{error::command_not_found}; //Dont log query invalid commands
 
@@ -289,10 +443,27 @@ command_result ConnectedClient::handleCommand(Command &cmd) {
     return command_result{error::command_not_found};
 };
 
-command_result ConnectedClient::handleCommandGetConnectionInfo(Command &cmd) {
-    CMD_REQ_SERVER;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
+command_result ConnectedClient::handleCommandView(const ts::command_parser &cmd, CommandId command_id) {
+    switch (command_id) {
+        case CommandId::ClientEdit:
+            return this->handleCommandClientEdit(cmd);
+        case CommandId::ChannelSubscribe:
+            return this->handleCommandChannelSubscribe(cmd);
+        case CommandId::ClientUpdate:
+            return this->handleCommandClientUpdate(cmd);
+        case CommandId::ClientMove:
+            return this->handleCommandClientMove(cmd);
+        case CommandId::SendTextMessage:
+            return this->handleCommandSendTextMessage(cmd);
+        default:
+            break;
+    }
+
+    logError(this->getServerId(), "Missing parser view handler for command '{}'", cmd.identifier());
+    return command_result{error::command_not_found};
+}
 
+command_result ConnectedClient::handleCommandGetConnectionInfo(Command &cmd) {
     ConnectedLockedClient client{this->server->find_client_by_id(cmd["clid"].as<ClientId>())};
     if (!client) return command_result{error::client_invalid_id};
 
@@ -352,14 +523,16 @@ command_result ConnectedClient::handleCommandConnectionInfoAutoUpdate(Command &c
 command_result ConnectedClient::handleCommandPermissionList(Command &cmd) {
     CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
-    static std::string permission_list_string[ClientType::MAX];
-    static std::mutex permission_list_string_lock;
+    /* the response only depends on the client type and if the client expects a notify identifier */
+    static std::shared_ptr<ts::command_arena_builder> permission_lists[ClientType::MAX][2];
+    static std::mutex permission_lists_lock;
 
     static auto build_permission_list = [](const std::string& command, const ClientType& type) {
-        Command list_builder(command);
-        int index = 0;
-        for (auto group : permission::availableGroups)
-            list_builder[index++]["group_id_end"] = group;
+        auto list_builder = std::make_shared<ts::command_arena_builder>(command, permission::availablePermissions.size() * 128, permission::availablePermissions.size() + permission::availableGroups.size());
+        for (auto group : permission::availableGroups) {
+            list_builder->put("group_id_end", group);
+            list_builder->next_bulk();
+        }
 
         auto avPerms = permission::availablePermissions;
         std::sort(avPerms.begin(), avPerms.end(), [](const std::shared_ptr<permission::PermissionTypeEntry> &a, const std::shared_ptr<permission::PermissionTypeEntry> &b) {
@@ -370,28 +543,28 @@ command_result ConnectedClient::handleCommandPermissionList(Command &cmd) {
         for (const auto& permission : avPerms) {
             if (!permission->clientSupported) continue;
 
-            auto &blk = list_builder[index++];
-
-            blk["permname"] = permission->name;
-            blk["permname"] = mapper->permission_name(type, permission->type);
-            blk["permdesc"] = permission->description;
-            blk["permid"] = permission->type;
+            list_builder->put("permname", mapper->permission_name(type, permission->type));
+            list_builder->put("permdesc", permission->description);
+            list_builder->put("permid", permission->type);
+            list_builder->next_bulk();
         }
         return list_builder;
     };
 
     auto type = this->getType();
+    auto command = this->notify_response_command("notifypermissionlist");
     if(type == CLIENT_TEASPEAK || type == CLIENT_TEAMSPEAK || type == CLIENT_QUERY) {
-        Command response{this->notify_response_command("notifypermissionlist")};
+        std::shared_ptr<ts::command_arena_builder> response{};
         {
-            lock_guard lock(permission_list_string_lock);
-            if(permission_list_string[type].empty())
-                permission_list_string[type] = build_permission_list("", type).build();
-            response[0][""] = permission_list_string[type];
+            lock_guard lock(permission_lists_lock);
+            auto& permission_list = permission_lists[type][command.empty() ? 0 : 1];
+            if(!permission_list)
+                permission_list = build_permission_list(command, type);
+            response = permission_list;
         }
-        this->sendCommand(response);
+        this->sendCommand(*response);
     } else {
-        this->sendCommand(build_permission_list(this->notify_response_command("notifypermissionlist"), type));
+        this->sendCommand(*build_permission_list(command, type));
     }
     return command_result{error::ok};
 }
@@ -443,9 +616,7 @@ command_result ConnectedClient::handleCommandPropertyList(ts::Command& cmd) {
 }
 
 command_result ConnectedClient::handleCommandSetClientChannelGroup(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
 
     auto target_channel_group_id = cmd["cgid"].as<GroupId>();
     std::shared_ptr<groups::ChannelGroup> target_channel_group{}, default_channel_group{};
@@ -571,14 +742,14 @@ command_result ConnectedClient::handleCommandSetClientChannelGroup(Command &cmd)
 }
 
 //sendtextmessage targetmode=1 <1 = direct | 2 = channel | 3 = server> msg=asd target=1 <clid>
-command_result ConnectedClient::handleCommandSendTextMessage(Command &cmd) {
-    CMD_REQ_SERVER;
+command_result ConnectedClient::handleCommandSendTextMessage(const ts::command_parser &cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     auto timestamp = system_clock::now();
-    if (cmd["targetmode"].as<ChatMessageMode>() == ChatMessageMode::TEXTMODE_PRIVATE) {
-        ConnectedLockedClient target{this->server->find_client_by_id(cmd["target"].as<ClientId>())};
+    auto target_mode = cmd[0].value_as<ChatMessageMode>("targetmode");
+    auto message = cmd[0].value("msg");
+    if (target_mode == ChatMessageMode::TEXTMODE_PRIVATE) {
+        ConnectedLockedClient target{this->server->find_client_by_id(cmd[0].value_as<ClientId>("target"))};
         if (!target) return command_result{error::client_invalid_id};
 
         bool chat_open{false};
@@ -618,22 +789,27 @@ command_result ConnectedClient::handleCommandSendTextMessage(Command &cmd) {
             }
         }
 
-        if(this->handleTextMessage(ChatMessageMode::TEXTMODE_PRIVATE, cmd["msg"], target.client)) {
+        if(this->handleTextMessage(ChatMessageMode::TEXTMODE_PRIVATE, message, target.client)) {
             return command_result{error::ok};
         }
 
-        target->notifyTextMessage(ChatMessageMode::TEXTMODE_PRIVATE, this->ref(), target->getClientId(), 0, timestamp, cmd["msg"].string());
-        this->notifyTextMessage(ChatMessageMode::TEXTMODE_PRIVATE, this->ref(), target->getClientId(), 0, timestamp, cmd["msg"].string());
-    } else if (cmd["targetmode"] == ChatMessageMode::TEXTMODE_CHANNEL) {
-        if(cmd[0].has("cid")) {
-            cmd["target"] = cmd["cid"].string();
+        target->notifyTextMessage(ChatMessageMode::TEXTMODE_PRIVATE, this->ref(), target->getClientId(), 0, timestamp, message);
+        this->notifyTextMessage(ChatMessageMode::TEXTMODE_PRIVATE, this->ref(), target->getClientId(), 0, timestamp, message);
+    } else if (target_mode == ChatMessageMode::TEXTMODE_CHANNEL) {
+        ChannelId channel_id{0};
+        if(cmd[0].has_key("cid")) {
+            channel_id = cmd[0].value_as<ChannelId>("cid");
+        } else if(cmd[0].has_key("target")) {
+            channel_id = cmd[0].value_as<ChannelId>("target");
         }
 
-        if(!cmd[0].has("target")) {
-            cmd["target"] = 0;
+        auto channel_tree = this->server->channelTree;
+        std::shared_lock channel_tree_read_lock{this->server->channel_tree_mutex};
+        auto l_channel = channel_id ? channel_tree->findLinkedChannel(channel_id) : nullptr;
+        if (!l_channel && channel_id != 0) {
+            return command_result{error::channel_invalid_id, "Cant resolve channel"};
         }
 
-        RESOLVE_CHANNEL_R(cmd["target"], false);
         auto channel = l_channel ? dynamic_pointer_cast<BasicChannel>(l_channel->entry) : nullptr;
         if(!channel) {
             CMD_REQ_CHANNEL;
@@ -646,7 +822,7 @@ command_result ConnectedClient::handleCommandSendTextMessage(Command &cmd) {
 
         if(channel == this->currentChannel) {
             channel_tree_read_lock.unlock(); //Method may creates a music bot which modifies the channel tree
-            if(this->handleTextMessage(ChatMessageMode::TEXTMODE_CHANNEL, cmd["msg"], nullptr)) {
+            if(this->handleTextMessage(ChatMessageMode::TEXTMODE_CHANNEL, message, nullptr)) {
                 return command_result{error::ok};
             }
             channel_tree_read_lock.lock();
@@ -665,11 +841,12 @@ command_result ConnectedClient::handleCommandSendTextMessage(Command &cmd) {
             }
         }
 
-        this->server->send_text_message(channel, this->ref(), cmd["msg"].string());
-    } else if (cmd["targetmode"] == ChatMessageMode::TEXTMODE_SERVER) {
+        this->server->send_text_message(channel, this->ref(), message);
+    } else if (target_mode == ChatMessageMode::TEXTMODE_SERVER) {
         ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_client_server_textmessage_send, 1);
 
-        if(this->handleTextMessage(ChatMessageMode::TEXTMODE_SERVER, cmd["msg"], nullptr)) return command_result{error::ok};
+        if(this->handleTextMessage(ChatMessageMode::TEXTMODE_SERVER, message, nullptr)) return command_result{error::ok};
+        TextMessageBroadcast notify{ChatMessageMode::TEXTMODE_SERVER, this->ref(), this->getClientId(), 0, timestamp, message};
         for(const auto& client : this->server->getClients()) {
             if (client->connectionState() != ConnectionState::CONNECTED)
                 continue;
@@ -678,13 +855,13 @@ command_result ConnectedClient::handleCommandSendTextMessage(Command &cmd) {
             if (type == ClientType::CLIENT_INTERNAL || type == ClientType::CLIENT_MUSIC)
                 continue;
 
-            client->notifyTextMessage(ChatMessageMode::TEXTMODE_SERVER, this->ref(), this->getClientId(), 0, timestamp, cmd["msg"].string());
+            client->notifyTextMessage(notify);
         }
 
         {
             auto conversations = this->server->conversation_manager();
             auto conversation = conversations->get_or_create(0);
-            conversation->register_message(this->getClientDatabaseId(), this->getUid(), this->getDisplayName(), timestamp, cmd["msg"].string());
+            conversation->register_message(this->getClientDatabaseId(), this->getUid(), this->getDisplayName(), timestamp, message);
         }
     } else return command_result{error::parameter_invalid, "invalid target mode"};
 
@@ -694,7 +871,6 @@ command_result ConnectedClient::handleCommandSendTextMessage(Command &cmd) {
 //notifybanlist banid=3 ip name uid=zbex8X3bFRTIKLI7mzeyJGZsh64= lastnickname=Wolf\sC++\sXXXX created=1510357269 duration=3600 invokername=WolverinDEV invokercldbid=5 invokeruid=xxjnc14LmvTk+Lyrm8OOeo4tOqw= reason=Prefix\sFake\s\p\sName enforcements=3
 command_result ConnectedClient::handleCommandBanList(Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
 
     ServerId sid = this->getServerId();
     if (cmd[0].has("sid")) {
@@ -751,7 +927,6 @@ command_result ConnectedClient::handleCommandBanList(Command &cmd) {
 
 command_result ConnectedClient::handleCommandBanAdd(Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
 
     string ip = cmd[0].has("ip") ? cmd["ip"].string() : "";
     string name = cmd[0].has("name") ? cmd["name"].string() : "";
@@ -809,7 +984,6 @@ command_result ConnectedClient::handleCommandBanAdd(Command &cmd) {
 
 command_result ConnectedClient::handleCommandBanEdit(Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
 
     ServerId sid = this->getServerId();
     if (cmd[0].has("sid"))
@@ -872,9 +1046,7 @@ command_result ConnectedClient::handleCommandBanEdit(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandBanClient(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
 
     std::string target_unique_id{};
     ClientDbId target_database_id{0};
@@ -975,7 +1147,6 @@ command_result ConnectedClient::handleCommandBanClient(Command &cmd) {
 
 command_result ConnectedClient::handleCommandBanDel(Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     ServerId sid = this->getServerId();
     if (cmd[0].has("sid"))
@@ -1000,20 +1171,14 @@ command_result ConnectedClient::handleCommandBanDel(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandBanDelAll(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_client_ban_delete, 1);
 
     serverInstance->banManager()->deleteAllBans(server->getServerId());
     return command_result{error::ok};
 }
 
 command_result ConnectedClient::handleCommandBanTriggerList(ts::Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_client_ban_trigger_list, 1);
 
     CMD_REQ_PARM("banid");
 
@@ -1044,9 +1209,7 @@ command_result ConnectedClient::handleCommandBanTriggerList(ts::Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandTokenList(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     auto& token_manager = this->server->getTokenManager();
 
@@ -1108,9 +1271,7 @@ command_result ConnectedClient::handleCommandTokenList(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandTokenActionList(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     auto& token_manager = this->server->getTokenManager();
     std::shared_ptr<token::Token> token_info{};
@@ -1374,9 +1535,7 @@ void check_token_action_permissions(const std::shared_ptr<ConnectedClient>& clie
 }
 
 command_result ConnectedClient::handleCommandTokenAdd(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     auto client_tokens = this->server->tokenManager->client_token_count(this->getClientDatabaseId());
     auto token_limit = this->calculate_permission(permission::i_virtualserver_token_limit, 0);
@@ -1446,9 +1605,7 @@ command_result ConnectedClient::handleCommandTokenAdd(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandTokenEdit(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(15);
 
     std::shared_ptr<token::Token> token{};
     if(cmd[0].has("token_id")) {
@@ -1601,9 +1758,7 @@ command_result ConnectedClient::handleCommandTokenEdit(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandTokenUse(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
     //ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_virtualserver_token_use, 1);
 
     auto& token_manager = this->server->getTokenManager();
@@ -1629,9 +1784,7 @@ command_result ConnectedClient::handleCommandTokenUse(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandTokenDelete(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     std::shared_ptr<token::Token> token{};
     if(cmd[0].has("token_id")) {
@@ -1661,9 +1814,6 @@ command_result ConnectedClient::handleCommandTokenDelete(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandPluginCmd(Command &cmd) {
-    CMD_REQ_SERVER;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-
     auto mode = cmd["targetmode"].as<PluginTargetMode>();
 
     if (mode == PluginTargetMode::PLUGINCMD_CURRENT_CHANNEL) {
@@ -1767,9 +1917,7 @@ command_result ConnectedClient::handleCommandVersion(Command &) {
 
 //cid=%d password=%s
 command_result ConnectedClient::handleCommandVerifyChannelPassword(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     std::shared_ptr<BasicChannel> channel = (this->server ? this->server->channelTree : serverInstance->getChannelTree().get())->findChannel(cmd["cid"].as<ChannelId>());
     if (!channel) return command_result{error::channel_invalid_id, "Cant resolve channel"};
@@ -1779,9 +1927,7 @@ command_result ConnectedClient::handleCommandVerifyChannelPassword(Command &cmd)
 }
 
 command_result ConnectedClient::handleCommandVerifyServerPassword(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     std::string password = cmd["password"];
     if (!this->server->verifyServerPassword(password, false)) return command_result{error::server_invalid_password};
@@ -1791,9 +1937,7 @@ command_result ConnectedClient::handleCommandVerifyServerPassword(Command &cmd)
 //msgid=2 cluid=IkBXingb46\/z1Q3hhMvJEweb3lw= subject=The\sSubject timestamp=1512224138 flag_read=0
 //notifymessagelist msgid=2 cluid=IkBXingb46\/z1Q3hhMvJEweb3lw= subject=The\sSubject timestamp=1512224138 flag_read=0
 command_result ConnectedClient::handleCommandMessageList(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     auto msgList = this->server->letters->avariableLetters(this->getUid());
     if (msgList.empty()) return command_result{error::database_empty_result, "no letters available"};
@@ -1816,19 +1960,14 @@ command_result ConnectedClient::handleCommandMessageList(Command &cmd) {
 
 //messageadd cluid=ePHuXhcai9nk\/4Fd\/xkxrokvnNk= subject=Test message=Message
 command_result ConnectedClient::handleCommandMessageAdd(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_client_offline_textmessage_send, 1);
 
     this->server->letters->createLetter(this->getUid(), cmd["cluid"], cmd["subject"], cmd["message"]);
     return command_result{error::ok};
 }
 
 command_result ConnectedClient::handleCommandMessageGet(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(10);
 
     auto letter = this->server->letters->getFullLetter(cmd["msgid"]);
 
@@ -1845,9 +1984,7 @@ command_result ConnectedClient::handleCommandMessageGet(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandMessageUpdateFlag(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     this->server->letters->updateReadFlag(cmd["msgid"], cmd["flag"]);
 
@@ -1855,9 +1992,7 @@ command_result ConnectedClient::handleCommandMessageUpdateFlag(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandMessageDel(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     this->server->letters->deleteLetter(cmd["msgid"]);
 
@@ -1866,7 +2001,6 @@ command_result ConnectedClient::handleCommandMessageDel(Command &cmd) {
 
 command_result ConnectedClient::handleCommandPermGet(Command &cmd) {
     CMD_RESET_IDLE;
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_client_permissionoverview_own, 1);
 
     Command res("");
 
@@ -2197,9 +2331,7 @@ command_result ConnectedClient::handleCommandPermFind(Command &cmd) {
  * - Alle rechte des channels
  */
 command_result ConnectedClient::handleCommandPermOverview(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     auto client_dbid = cmd["cldbid"].as<ClientDbId>();
     if(!serverInstance->databaseHelper()->validClientDatabaseId(this->getServer(), client_dbid)) {
@@ -2383,9 +2515,7 @@ command_result ConnectedClient::handleCommandPermOverview(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandComplainAdd(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
 
     ClientDbId target = cmd["tcldbid"];
     std::string msg = cmd["message"];
@@ -2408,10 +2538,7 @@ command_result ConnectedClient::handleCommandComplainAdd(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandComplainList(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_client_complain_list, 1);
 
     ClientDbId id = cmd[0].has("tcldbid") ? cmd["tcldbid"].as<ClientDbId>() : 0;
     auto list = id == 0 ? this->server->complains->complains() : this->server->complains->findComplainsFromTarget(id);
@@ -2453,9 +2580,7 @@ command_result ConnectedClient::handleCommandComplainList(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandComplainDel(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
     ClientDbId tid = cmd["tcldbid"];
     ClientDbId fid = cmd["fcldbid"];
@@ -2479,10 +2604,7 @@ command_result ConnectedClient::handleCommandComplainDel(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandComplainDelAll(Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_client_complain_delete, 1);
 
     ClientDbId tid = cmd["tcldbid"];
     if (!this->server->complains->deleteComplainsFromTarget(tid)) return command_result{error::database_empty_result};
@@ -2491,8 +2613,6 @@ command_result ConnectedClient::handleCommandComplainDelAll(Command &cmd) {
 
 command_result ConnectedClient::handleCommandHelp(Command& cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_serverinstance_help_view, 1);
 
     string command = cmd[0].has("command") ? cmd["command"].as<string>() : "";
     if(command.empty())
@@ -2517,10 +2637,7 @@ command_result ConnectedClient::handleCommandHelp(Command& cmd) {
 }
 
 command_result ConnectedClient::handleCommandPermReset(ts::Command& cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(50);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_virtualserver_permission_reset, 1);
 
     string token;
     if(!this->server->resetPermissions(token))
@@ -2534,8 +2651,6 @@ command_result ConnectedClient::handleCommandPermReset(ts::Command& cmd) {
 }
 
 command_result ConnectedClient::handleCommandLogView(ts::Command& cmd) {
-    CMD_CHK_AND_INC_FLOOD_POINTS(50);
-
     ServerId target_server = cmd[0].has("instance") && cmd["instance"].as<bool>() ? (ServerId) 0 : this->getServerId();
     if(target_server == 0)
         ACTION_REQUIRES_INSTANCE_PERMISSION(permission::b_serverinstance_log_view, 1);
@@ -2715,8 +2830,6 @@ command_result ConnectedClient::handleCommandLogView(ts::Command& cmd) {
 }
 
 command_result ConnectedClient::handleCommandLogQuery(ts::Command &cmd) {
-    CMD_CHK_AND_INC_FLOOD_POINTS(50);
-
     uint64_t target_server = (cmd[0].has("instance") && cmd["instance"].as<bool>()) || cmd.hasParm("instance") ? (ServerId) 0 : this->getServerId();
     if(target_server == 0) {
         ACTION_REQUIRES_INSTANCE_PERMISSION(permission::b_serverinstance_log_view, 1);
@@ -2795,8 +2908,6 @@ command_result ConnectedClient::handleCommandLogQuery(ts::Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandLogAdd(ts::Command& cmd) {
-    CMD_CHK_AND_INC_FLOOD_POINTS(50);
-
     uint64_t target_server = cmd[0].has("instance") && cmd["instance"].as<bool>() ? (ServerId) 0 : this->getServerId();
     if(target_server == 0) {
         ACTION_REQUIRES_INSTANCE_PERMISSION(permission::b_serverinstance_log_add, 1);
@@ -294,9 +294,7 @@ command_result ConnectedClient::handleCommandMusicBotPlayerAction(Command& cmd)
 }
 
 command_result ConnectedClient::handleCommandPlaylistList(ts::Command &cmd) {
-    CMD_REQ_SERVER;
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
 
     auto self_ref = this->ref();
     auto playlists = this->server->music_manager_->playlists();
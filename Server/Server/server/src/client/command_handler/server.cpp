@@ -56,8 +56,6 @@ else if(key == name) { \
    if(!cmd[0][key].castable<type_a>() && !!cmd[0][key].castable<type_b>()) return command_result{error::parameter_invalid};
 
 command_result ConnectedClient::handleCommandServerEdit(Command &cmd) {
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-
     if (cmd[0].has("sid") && this->getServerId() != cmd["sid"].as<ServerId>()) {
         return command_result{error::server_invalid_id};
     }
@@ -255,9 +253,6 @@ command_result ConnectedClient::handleCommandServerEdit(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandServerRequestConnectionInfo(Command &) {
-    CMD_REQ_SERVER;
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_virtualserver_connectioninfo_view, 1);
-
     ts::command_builder result{"notifyserverconnectioninfo"};
     auto first_bulk = result.bulk(0);
 
@@ -316,8 +311,6 @@ command_result ConnectedClient::handleCommandServerGroupDel(Command &cmd) {
 
 command_result ConnectedClient::handleCommandServerGroupList(Command &) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_virtualserver_servergroup_list, 1);
 
     std::optional<ts::command_builder> generated_command{};
     this->notifyServerGroupList(generated_command, this->getType() != ClientType::CLIENT_QUERY);
@@ -329,9 +322,7 @@ command_result ConnectedClient::handleCommandServerGroupList(Command &) {
 //notifyservergroupclientlist sgid=6 cldbid=2 client_nickname=WolverinDEV client_unique_identifier=xxjnc14LmvTk+Lyrm8OOeo4tOqw=
 command_result ConnectedClient::handleCommandServerGroupClientList(Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
 
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_virtualserver_servergroup_client_list, 1);
 
     std::shared_ptr<VirtualServer> target_server{};
     if(cmd[0].has("sid")) {
@@ -379,7 +370,6 @@ command_result ConnectedClient::handleCommandServerGroupClientList(Command &cmd)
 
 command_result ConnectedClient::handleCommandServerGroupAddClient(Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
 
     std::shared_ptr<VirtualServer> target_server{};
     if(cmd[0].has("sid")) {
@@ -506,7 +496,6 @@ command_result ConnectedClient::handleCommandServerGroupAddClient(Command &cmd)
 
 command_result ConnectedClient::handleCommandServerGroupDelClient(Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
 
     std::shared_ptr<VirtualServer> target_server{};
     if(cmd[0].has("sid")) {
@@ -633,8 +622,6 @@ command_result ConnectedClient::handleCommandServerGroupDelClient(Command &cmd)
 
 command_result ConnectedClient::handleCommandServerGroupPermList(Command &cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_virtualserver_servergroup_permission_list, 1);
 
     auto group_manager = this->server ? this->server->group_manager() : serverInstance->group_manager();
     auto serverGroup = group_manager->server_groups()->find_group(groups::GroupCalculateMode::GLOBAL, cmd["sgid"].as<GroupId>());
@@ -654,8 +641,6 @@ command_result ConnectedClient::handleCommandServerGroupPermList(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandServerGroupAddPerm(Command &cmd) {
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-
     auto group_id = cmd["sgid"].as<GroupId>();
 
     std::shared_ptr<groups::ServerGroupManager> owning_manager{};
@@ -673,8 +658,6 @@ command_result ConnectedClient::handleCommandServerGroupAddPerm(Command &cmd) {
 }
 
 command_result ConnectedClient::handleCommandServerGroupDelPerm(Command &cmd) {
-    CMD_CHK_AND_INC_FLOOD_POINTS(5);
-
     auto group_id = cmd["sgid"].as<GroupId>();
 
     std::shared_ptr<groups::ServerGroupManager> owning_manager{};
@@ -693,7 +676,6 @@ command_result ConnectedClient::handleCommandServerGroupDelPerm(Command &cmd) {
 
 command_result ConnectedClient::handleCommandServerGroupAutoAddPerm(ts::Command& cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
 
     auto update_type = cmd["sgtype"].as<permission::PermissionValue>();
 
@@ -721,7 +703,6 @@ command_result ConnectedClient::handleCommandServerGroupAutoAddPerm(ts::Command&
 
 command_result ConnectedClient::handleCommandServerGroupAutoDelPerm(ts::Command& cmd) {
     CMD_RESET_IDLE;
-    CMD_CHK_AND_INC_FLOOD_POINTS(25);
 
     auto update_type = cmd["sgtype"].as<permission::PermissionValue>();
 
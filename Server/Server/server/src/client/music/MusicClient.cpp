@@ -81,6 +81,8 @@ MusicClient::~MusicClient() {
 
 void MusicClient::sendCommand(const ts::Command &command, bool low) { }
 void MusicClient::sendCommand(const ts::command_builder &command, bool low) { }
+void MusicClient::sendCommand(const ts::command_arena_builder &command, bool low) { }
+void MusicClient::sendCommand(BroadcastCommand &command, bool low) { }
 
 bool MusicClient::close_connection(const std::chrono::system_clock::time_point&) {
     logError(this->getServerId(), "Music manager is forced to disconnect!");
@@ -114,6 +116,12 @@ bool MusicClient::notifyClientMoved(
     return true;
 }
 
+bool MusicClient::notifyClientMoved(ClientMovedBroadcast &notify) {
+    if(&*notify.client() == this && notify.target_channel())
+        this->properties()[property::CLIENT_LAST_CHANNEL] = notify.target_channel()->channelId();
+    return true;
+}
+
 void MusicClient::initialize_bot() {
     this->_player_state = this->properties()[property::CLIENT_PLAYER_STATE];
     if(this->_player_state == ReplayState::LOADING)
@@ -45,6 +45,8 @@ namespace ts::server {
             //Basic TeaSpeak stuff
             void sendCommand(const ts::Command &command, bool low) override;
             void sendCommand(const ts::command_builder &command, bool low) override;
+            void sendCommand(const ts::command_arena_builder &command, bool low) override;
+            void sendCommand(BroadcastCommand &command, bool low) override;
 
             bool disconnect(const std::string &reason) override;
             bool close_connection(const std::chrono::system_clock::time_point& = std::chrono::system_clock::time_point()) override;
@@ -86,6 +88,7 @@ namespace ts::server {
                     std::shared_ptr<ConnectedClient> invoker,
                     bool lock_channel_tree
             ) override;
+            bool notifyClientMoved(ClientMovedBroadcast &notify) override;
         protected:
 
             void broadcast_text_message(const std::string &message);
@@ -157,15 +157,24 @@ void QueryClient::postInitialize() {
     this->task_update_needed_permissions.enqueue();
 }
 
-void QueryClient::send_message(const std::string_view& message) {
+void QueryClient::send_message(const std::string_view& message, const std::string_view& suffix) {
     if(this->state == ConnectionState::DISCONNECTED || !this->handle) {
         return;
     }
 
     if(this->connectionType == ConnectionType::PLAIN) {
-        this->enqueue_write_buffer(message);
+        this->enqueue_write_buffer(message, suffix);
     } else if(this->connectionType == ConnectionType::SSL_ENCRYPTED) {
-        this->ssl_handler.send(pipes::buffer_view{(void*) message.data(), message.length()});
+        if(suffix.empty()) {
+            this->ssl_handler.send(pipes::buffer_view{(void*) message.data(), message.length()});
+        } else {
+            /* every send call results in its own TLS record */
+            std::string payload{};
+            payload.reserve(message.length() + suffix.length());
+            payload.append(message);
+            payload.append(suffix);
+            this->ssl_handler.send(pipes::buffer_view{(void*) payload.data(), payload.length()});
+        }
     } else {
         logCritical(LOG_GENERAL, "Invalid query connection type to write to!");
     }
@@ -239,9 +248,10 @@ void QueryClient::execute_final_disconnect() {
     }
 }
 
-void QueryClient::enqueue_write_buffer(const std::string_view &message) {
-    auto buffer = NetworkBuffer::allocate(message.length());
+void QueryClient::enqueue_write_buffer(const std::string_view &message, const std::string_view &suffix) {
+    auto buffer = NetworkBuffer::allocate(message.length() + suffix.length());
     memcpy(buffer->data(), message.data(), message.length());
+    memcpy((char*) buffer->data() + message.length(), suffix.data(), suffix.length());
 
     {
         std::lock_guard buffer_lock{this->network_mutex};
@@ -592,6 +602,16 @@ void QueryClient::sendCommand(const ts::command_builder &command, bool) {
     logTrace(LOG_QUERY, "Send command {}", command.build());
 }
 
+void QueryClient::sendCommand(const ts::command_arena_builder &command, bool) {
+    send_message(command.view(), config::query::newlineCharacter);
+    logTrace(LOG_QUERY, "Send command {}", command.view());
+}
+
+void QueryClient::sendCommand(BroadcastCommand &command, bool) {
+    send_message(command.command(), config::query::newlineCharacter);
+    logTrace(LOG_QUERY, "Send command {}", command.command());
+}
+
 void QueryClient::tick_server(const std::chrono::system_clock::time_point &time) {
     ConnectedClient::tick_server(time);
 }
@@ -47,6 +47,8 @@ namespace ts::server {
 
             void sendCommand(const ts::Command &command, bool low = false) override;
             void sendCommand(const ts::command_builder &command, bool low) override;
+            void sendCommand(const ts::command_arena_builder &command, bool low) override;
+            void sendCommand(BroadcastCommand &command, bool low) override;
 
             bool disconnect(const std::string &reason) override;
             bool close_connection(const std::chrono::system_clock::time_point& flush_timeout) override;
@@ -80,8 +82,8 @@ namespace ts::server {
 
             /* Methods will be called within the io loop (single thread) */
             static void handle_event_write(int, short, void*);
-            void send_message(const std::string_view&);
-            void enqueue_write_buffer(const std::string_view& /* message */);
+            void send_message(const std::string_view& /* message */, const std::string_view& /* suffix */ = {});
+            void enqueue_write_buffer(const std::string_view& /* message */, const std::string_view& /* suffix */ = {});
         private:
             QueryServer* handle;
 
@@ -117,7 +119,7 @@ namespace ts::server {
 
             std::shared_ptr<QueryAccount> query_account;
         protected:
-            command_result handleCommand(Command &command) override;
+            command_result handleCommand(Command &command, CommandId command_id) override;
 
         public:
             //Silent events
@@ -129,11 +131,13 @@ namespace ts::server {
             bool notifyClientPoke(std::shared_ptr<ConnectedClient> invoker, std::string msg) override;
 
             bool notifyClientUpdated(const std::shared_ptr<ConnectedClient> &ptr, const std::deque<const property::PropertyDescription*> &deque, bool lock_channel_tree) override;
+            bool notifyClientUpdated(ClientUpdatedBroadcast &notify) override;
 
             bool notifyPluginCmd(std::string name, std::string msg,std::shared_ptr<ConnectedClient>) override;
             bool notifyClientChatComposing(const std::shared_ptr<ConnectedClient> &ptr) override;
             bool notifyClientChatClosed(const std::shared_ptr<ConnectedClient> &ptr) override;
             bool notifyTextMessage(ChatMessageMode mode, const std::shared_ptr<ConnectedClient> &sender, uint64_t targetId, ChannelId channel_id, const std::chrono::system_clock::time_point&, const std::string &textMessage) override;
+            bool notifyTextMessage(TextMessageBroadcast &notify) override;
 
             bool notifyServerGroupClientAdd(std::optional<ts::command_builder> &anOptional,
                                             const std::shared_ptr<ConnectedClient> &ptr,
@@ -35,27 +35,41 @@ bool QueryClientCommandHandler::handle_command(const std::string_view &command)
         return true;
     }
 
+    ts::command_parser command_view{command};
+    auto& descriptor = command_view.parse(true) ? command_registry::find(command_view.identifier()) : command_registry::kUnknownCommand;
+
     unique_ptr<Command> cmd;
     command_result error{};
-    try {
-        cmd = make_unique<Command>(Command::parse(command, true, !ts::config::server::strict_ut8_mode));
-    } catch(std::invalid_argument& ex) {
-        logTrace(LOG_QUERY, "[{}:{}] Failed to parse command (invalid argument): {}", client->getLoggingPeerIp(), client->getPeerPort(), command);
-        error.reset(command_result{error::parameter_convert});
-        goto handle_error;
-    } catch(std::exception& ex) {
-        logTrace(LOG_QUERY, "[{}:{}] Failed to parse command (exception: {}): {}", client->getLoggingPeerIp(), client->getPeerPort(), ex.what(), command);
-        error.reset(command_result{error::vs_critical, std::string{ex.what()}});
-        goto handle_error;
+    if(!descriptor.parser_view()) {
+        try {
+            cmd = make_unique<Command>(Command::parse(command, true, !ts::config::server::strict_ut8_mode));
+        } catch(std::invalid_argument& ex) {
+            logTrace(LOG_QUERY, "[{}:{}] Failed to parse command (invalid argument): {}", client->getLoggingPeerIp(), client->getPeerPort(), command);
+            error.reset(command_result{error::parameter_convert});
+            goto handle_error;
+        } catch(std::exception& ex) {
+            logTrace(LOG_QUERY, "[{}:{}] Failed to parse command (exception: {}): {}", client->getLoggingPeerIp(), client->getPeerPort(), ex.what(), command);
+            error.reset(command_result{error::vs_critical, std::string{ex.what()}});
+            goto handle_error;
+        }
     }
 
     try {
-        std::lock_guard execute_lock{client->command_lock};
+        /* lockless commands will not be serialized with the other commands of the client */
+        std::unique_lock execute_lock{client->command_lock, std::defer_lock};
+        if(!descriptor.lockless()) {
+            execute_lock.lock();
+        }
+
         if(client->state >= ConnectionState::DISCONNECTING) {
             return false;
         }
 
-        client->handleCommandFull(*cmd);
+        if(cmd) {
+            client->handleCommandFull(*cmd);
+        } else {
+            client->handleCommandFull(command_view, descriptor);
+        }
     } catch(std::exception& ex) {
         error.reset(command_result{error::vs_critical, std::string{ex.what()}});
         goto handle_error;
@@ -69,84 +83,43 @@ bool QueryClientCommandHandler::handle_command(const std::string_view &command)
     return true;
 }
 
-constexpr unsigned int string_hash(const char* str, unsigned int h = 0) {
-    return !str[h] ? 5381 : (string_hash(str, h + 1U) * 33U) ^ (unsigned int) str[h];
-}
-
-command_result QueryClient::handleCommand(Command& cmd) {
-    /*
-        if (cmd.command() == "exit" || cmd.command() == "quit") return this->handleCommandExit(cmd);
-        else if (cmd.command() == "use" || cmd.command() == "serverselect") return this->handleCommandServerSelect(cmd);
-        else if (cmd.command() == "serverinfo") return this->handleCommandServerInfo(cmd);
-        else if (cmd.command() == "channellist") return this->handleCommandChannelList(cmd);
-        else if (cmd.command() == "login") return this->handleCommandLogin(cmd);
-        else if (cmd.command() == "logout") return this->handleCommandLogout(cmd);
-        else if (cmd.command() == "join") return this->handleCommandJoin(cmd);
-        else if (cmd.command() == "left") return this->handleCommandLeft(cmd);
-        else if (cmd.command() == "globalmessage" || cmd.command() == "gm") return this->handleCommandGlobalMessage(cmd);
-
-        else if (cmd.command() == "serverlist") return this->handleCommandServerList(cmd);
-        else if (cmd.command() == "servercreate") return this->handleCommandServerCreate(cmd);
-        else if (cmd.command() == "serverstart") return this->handleCommandServerStart(cmd);
-        else if (cmd.command() == "serverstop") return this->handleCommandServerStop(cmd);
-        else if (cmd.command() == "serverdelete") return this->handleCommandServerDelete(cmd);
-        else if (cmd.command() == "serveridgetbyport") return this->handleCommandServerIdGetByPort(cmd);
-        else if (cmd.command() == "instanceinfo") return this->handleCommandInstanceInfo(cmd);
-        else if (cmd.command() == "instanceedit") return this->handleCommandInstanceEdit(cmd);
-        else if (cmd.command() == "hostinfo") return this->handleCommandHostInfo(cmd);
-
-        else if (cmd.command() == "bindinglist") return this->handleCommandBindingList(cmd);
-
-        else if (cmd.command() == "serversnapshotdeploy") return this->handleCommandServerSnapshotDeploy(cmd);
-        else if (cmd.command() == "serversnapshotcreate") return this->handleCommandServerSnapshotCreate(cmd);
-
-        else if (cmd.command() == "serverprocessstop") return this->handleCommandServerProcessStop(cmd);
-
-        else if (cmd.command() == "servernotifyregister") return this->handleCommandServerNotifyRegister(cmd);
-        else if (cmd.command() == "servernotifylist") return this->handleCommandServerNotifyList(cmd);
-        else if (cmd.command() == "servernotifyunregister") return this->handleCommandServerNotifyUnregister(cmd);
-     */
-    auto command = cmd.command();
-    auto command_hash = string_hash(command.c_str());
-    switch (command_hash) {
-        case string_hash("exit"):
-        case string_hash("quit"):
+command_result QueryClient::handleCommand(Command& cmd, CommandId command_id) {
+    switch (command_id) {
+        case CommandId::Exit:
             return this->handleCommandExit(cmd);
-        case string_hash("use"):
-        case string_hash("serverselect"):
+        case CommandId::ServerSelect:
             return this->handleCommandServerSelect(cmd);
-        case string_hash("serverinfo"):
+        case CommandId::ServerInfo:
             return this->handleCommandServerInfo(cmd);
-        case string_hash("channellist"):
+        case CommandId::ChannelList:
             return this->handleCommandChannelList(cmd);
-        case string_hash("login"):
+        case CommandId::Login:
             return this->handleCommandLogin(cmd);
-        case string_hash("logout"):
+        case CommandId::Logout:
             return this->handleCommandLogout(cmd);
-        case string_hash("globalmessage"):
-        case string_hash("gm"):
+        case CommandId::GlobalMessage:
             return this->handleCommandGlobalMessage(cmd);
-        case string_hash("serverlist"):
+        case CommandId::ServerList:
             return this->handleCommandServerList(cmd);
-        case string_hash("servercreate"):
+        case CommandId::ServerCreate:
             return this->handleCommandServerCreate(cmd);
-        case string_hash("serverstart"):
+        case CommandId::ServerStart:
             return this->handleCommandServerStart(cmd);
-        case string_hash("serverstop"):
+        case CommandId::ServerStop:
             return this->handleCommandServerStop(cmd);
-        case string_hash("serverdelete"):
+        case CommandId::ServerDelete:
             return this->handleCommandServerDelete(cmd);
-        case string_hash("serveridgetbyport"):
+        case CommandId::ServerIdGetByPort:
             return this->handleCommandServerIdGetByPort(cmd);
-        case string_hash("instanceinfo"):
+        case CommandId::InstanceInfo:
             return this->handleCommandInstanceInfo(cmd);
-        case string_hash("instanceedit"):
+        case CommandId::InstanceEdit:
             return this->handleCommandInstanceEdit(cmd);
-        case string_hash("hostinfo"):
+        case CommandId::HostInfo:
             return this->handleCommandHostInfo(cmd);
-        case string_hash("bindinglist"):
+        case CommandId::BindingList:
             return this->handleCommandBindingList(cmd);
-        case string_hash("serversnapshotdeploy"): {
+        case CommandId::ServerSnapshotDeploy: {
             auto cmd_str = cmd.build();
             ts::command_parser parser{cmd_str};
             if(!parser.parse(true)) {
@@ -155,21 +128,21 @@ command_result QueryClient::handleCommand(Command& cmd) {
 
             return this->handleCommandServerSnapshotDeployNew(parser);
         }
-        case string_hash("serversnapshotcreate"):
+        case CommandId::ServerSnapshotCreate:
             return this->handleCommandServerSnapshotCreate(cmd);
-        case string_hash("serverprocessstop"):
+        case CommandId::ServerProcessStop:
             return this->handleCommandServerProcessStop(cmd);
-        case string_hash("servernotifyregister"):
+        case CommandId::ServerNotifyRegister:
             return this->handleCommandServerNotifyRegister(cmd);
-        case string_hash("servernotifylist"):
+        case CommandId::ServerNotifyList:
             return this->handleCommandServerNotifyList(cmd);
-        case string_hash("servernotifyunregister"):
+        case CommandId::ServerNotifyUnregister:
             return this->handleCommandServerNotifyUnregister(cmd);
         default:
             break;
     }
 
-    return ConnectedClient::handleCommand(cmd);
+    return ConnectedClient::handleCommand(cmd, command_id);
 }
 
 command_result QueryClient::handleCommandExit(Command &) {
@@ -465,7 +438,6 @@ command_result QueryClient::handleCommandServerSelect(Command &cmd) {
 
 command_result QueryClient::handleCommandServerInfo(Command &) {
     CMD_RESET_IDLE;
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_virtualserver_info_view, 1);
 
     Command cmd("");
 
@@ -550,69 +522,67 @@ command_result QueryClient::handleCommandServerInfo(Command &) {
 
 command_result QueryClient::handleCommandChannelList(Command& cmd) {
     CMD_RESET_IDLE;
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_virtualserver_channel_list, 1);
 
-    int index = 0;
     shared_lock channel_lock(this->server ? this->server->channel_tree_mutex : serverInstance->getChannelTreeLock());
     auto entries = this->server ? this->channel_tree->channels() : serverInstance->getChannelTree()->channels();
     channel_lock.unlock();
 
-    command_builder result{"", 1024, entries.size()};
+    command_arena_builder result{"", entries.size() * 256, entries.size()};
     for(const auto& channel : entries){
         if(!channel) continue;
 
         const auto channel_clients = this->server ? this->server->getClientsByChannel(channel).size() : 0;
-        result.put_unchecked(index, "cid", channel->channelId());
-        result.put_unchecked(index, "pid", channel->properties()[property::CHANNEL_PID].as_unchecked<string>());
-        result.put_unchecked(index, "channel_name", channel->name());
-        result.put_unchecked(index, "channel_order", channel->channelOrder());
-        result.put_unchecked(index, "total_clients", channel_clients);
+        result.put("cid", channel->channelId());
+        result.put("pid", channel->properties()[property::CHANNEL_PID].as_unchecked<string>());
+        result.put("channel_name", channel->name());
+        result.put("channel_order", channel->channelOrder());
+        result.put("total_clients", channel_clients);
         /* result.put_unchecked(index, "channel_needed_subscribe_power", channel->permissions()->getPermissionValue(permission::i_channel_needed_subscribe_power, channel, 0)); */
 
         if(cmd.hasParm("flags")){
-            result.put_unchecked(index, "channel_flag_default",
-                                 channel->properties()[property::CHANNEL_FLAG_DEFAULT].as_unchecked<string>());
-            result.put_unchecked(index, "channel_flag_password",
-                                 channel->properties()[property::CHANNEL_FLAG_PASSWORD].as_unchecked<string>());
-            result.put_unchecked(index, "channel_flag_permanent",
-                                 channel->properties()[property::CHANNEL_FLAG_PERMANENT].as_unchecked<string>());
-            result.put_unchecked(index, "channel_flag_semi_permanent",
-                                 channel->properties()[property::CHANNEL_FLAG_SEMI_PERMANENT].as_unchecked<string>());
+            result.put("channel_flag_default",
+                       channel->properties()[property::CHANNEL_FLAG_DEFAULT].as_unchecked<string>());
+            result.put("channel_flag_password",
+                       channel->properties()[property::CHANNEL_FLAG_PASSWORD].as_unchecked<string>());
+            result.put("channel_flag_permanent",
+                       channel->properties()[property::CHANNEL_FLAG_PERMANENT].as_unchecked<string>());
+            result.put("channel_flag_semi_permanent",
+                       channel->properties()[property::CHANNEL_FLAG_SEMI_PERMANENT].as_unchecked<string>());
         }
         if(cmd.hasParm("voice")){
-            result.put_unchecked(index, "channel_codec",
-                                 channel->properties()[property::CHANNEL_CODEC].as_unchecked<string>());
-            result.put_unchecked(index, "channel_codec_quality",
-                                 channel->properties()[property::CHANNEL_CODEC_QUALITY].as_unchecked<string>());
-            result.put_unchecked(index, "channel_needed_talk_power",
-                                 channel->properties()[property::CHANNEL_NEEDED_TALK_POWER].as_unchecked<string>());
+            result.put("channel_codec",
+                       channel->properties()[property::CHANNEL_CODEC].as_unchecked<string>());
+            result.put("channel_codec_quality",
+                       channel->properties()[property::CHANNEL_CODEC_QUALITY].as_unchecked<string>());
+            result.put("channel_needed_talk_power",
+                       channel->properties()[property::CHANNEL_NEEDED_TALK_POWER].as_unchecked<string>());
         }
         if(cmd.hasParm("icon")){
-            result.put_unchecked(index, "channel_icon_id",
-                                 channel->properties()[property::CHANNEL_ICON_ID].as_unchecked<string>());
+            result.put("channel_icon_id",
+                       channel->properties()[property::CHANNEL_ICON_ID].as_unchecked<string>());
         }
         if(cmd.hasParm("limits")){
-            result.put_unchecked(index, "total_clients_family", this->server ? this->server->getClientsByChannelRoot(channel, false).size() : 0);
-            result.put_unchecked(index, "total_clients", this->server ? this->server->getClientsByChannel(channel).size() : 0);
+            result.put("total_clients_family", this->server ? this->server->getClientsByChannelRoot(channel, false).size() : 0);
+            result.put("total_clients", this->server ? this->server->getClientsByChannel(channel).size() : 0);
 
-            result.put_unchecked(index, "channel_maxclients",
-                                 channel->properties()[property::CHANNEL_MAXCLIENTS].as_unchecked<string>());
-            result.put_unchecked(index, "channel_maxfamilyclients",
-                                 channel->properties()[property::CHANNEL_MAXFAMILYCLIENTS].as_unchecked<string>());
+            result.put("channel_maxclients",
+                       channel->properties()[property::CHANNEL_MAXCLIENTS].as_unchecked<string>());
+            result.put("channel_maxfamilyclients",
+                       channel->properties()[property::CHANNEL_MAXFAMILYCLIENTS].as_unchecked<string>());
 
             {
                 auto needed_power = channel->permissions()->permission_value_flagged(permission::i_channel_subscribe_power);
-                result.put_unchecked(index, "channel_needed_subscribe_power", needed_power.has_value ? needed_power.value : 0);
+                result.put("channel_needed_subscribe_power", needed_power.has_value ? needed_power.value : 0);
             }
         }
         if(cmd.hasParm("topic")) {
-            result.put_unchecked(index, "channel_topic",
-                                 channel->properties()[property::CHANNEL_TOPIC].as_unchecked<string>());
+            result.put("channel_topic",
+                       channel->properties()[property::CHANNEL_TOPIC].as_unchecked<string>());
         }
         if(cmd.hasParm("times") || cmd.hasParm("secondsempty")){
-            result.put_unchecked(index, "seconds_empty", channel_clients == 0 ? channel->empty_seconds() : 0);
+            result.put("seconds_empty", channel_clients == 0 ? channel->empty_seconds() : 0);
         }
-        index++;
+        result.next_bulk();
     }
 
     this->sendCommand(result, false);
@@ -621,7 +591,6 @@ command_result QueryClient::handleCommandChannelList(Command& cmd) {
 
 command_result QueryClient::handleCommandServerList(Command& cmd) {
     CMD_RESET_IDLE;
-    ACTION_REQUIRES_INSTANCE_PERMISSION(permission::b_serverinstance_virtualserver_list, 1);
 
     auto servers = serverInstance->getVoiceServerManager()->serverInstances();
     command_builder result{"", 256, servers.size()};
@@ -667,7 +636,6 @@ command_result QueryClient::handleCommandServerList(Command& cmd) {
 
 command_result QueryClient::handleCommandServerCreate(Command& cmd) {
     CMD_RESET_IDLE;
-    ACTION_REQUIRES_INSTANCE_PERMISSION(permission::b_virtualserver_create, 1);
 
     if(serverInstance->getVoiceServerManager()->getState() != VirtualServerManager::STARTED) {
         return command_result{error::vs_critical, "Server manager isn't started yet or not finished starting"};
@@ -756,7 +724,6 @@ command_result QueryClient::handleCommandServerCreate(Command& cmd) {
 
 command_result QueryClient::handleCommandServerDelete(Command& cmd) {
     CMD_RESET_IDLE;
-    ACTION_REQUIRES_INSTANCE_PERMISSION(permission::b_virtualserver_delete, 1);
 
     if(serverInstance->getVoiceServerManager()->getState() != VirtualServerManager::STARTED)
         return command_result{error::vs_critical, "Server manager isn't started yet or not finished starting"};
@@ -829,8 +796,6 @@ command_result QueryClient::handleCommandServerStop(Command& cmd) {
 
 
 command_result QueryClient::handleCommandInstanceInfo(Command& cmd) {
-    ACTION_REQUIRES_INSTANCE_PERMISSION(permission::b_serverinstance_info_view, 1);
-
     Command res("");
     for(const auto& e : serverInstance->properties()->list_properties(property::FLAG_INSTANCE_VARIABLE, this->getType() == CLIENT_TEAMSPEAK ? property::FLAG_NEW : (uint16_t) 0)) {
         res[e.type().name] = e.value();
@@ -847,8 +812,6 @@ command_result QueryClient::handleCommandInstanceInfo(Command& cmd) {
 }
 
 command_result QueryClient::handleCommandInstanceEdit(Command& cmd) {
-    ACTION_REQUIRES_INSTANCE_PERMISSION(permission::b_serverinstance_modify_settings, 1);
-
     for(const auto &key : cmd[0].keys()){
         const auto* info = &property::find<property::InstanceProperties>(key);
         if(key == "serverinstance_serverquery_max_connections_per_ip")
@@ -873,8 +836,6 @@ command_result QueryClient::handleCommandInstanceEdit(Command& cmd) {
 }
 
 command_result QueryClient::handleCommandHostInfo(Command &) {
-    ACTION_REQUIRES_INSTANCE_PERMISSION(permission::b_serverinstance_info_view, 1);
-
     Command res("");
     res["instance_uptime"] = duration_cast<seconds>(system_clock::now() - serverInstance->getStartTimestamp()).count();
     res["host_timestamp_utc"] = duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
@@ -910,8 +871,6 @@ command_result QueryClient::handleCommandHostInfo(Command &) {
 }
 
 command_result QueryClient::handleCommandGlobalMessage(Command& cmd) {
-    ACTION_REQUIRES_INSTANCE_PERMISSION(permission::b_serverinstance_textmessage_send, 1);
-
     for(const auto &server : serverInstance->getVoiceServerManager()->serverInstances())
         if(server->running()) server->broadcastMessage(server->getServerRoot(), cmd["msg"]);
 
@@ -976,7 +935,6 @@ command_result QueryClient::handleCommandServerSnapshotDeployNew(const ts::comma
 }
 
 command_result QueryClient::handleCommandServerSnapshotCreate(Command& cmd) {
-    ACTION_REQUIRES_GLOBAL_PERMISSION(permission::b_virtualserver_snapshot_create, 1);
     CMD_RESET_IDLE;
     CMD_REQ_SERVER;
 
@@ -1029,8 +987,6 @@ command_result QueryClient::handleCommandServerSnapshotCreate(Command& cmd) {
 
 extern bool mainThreadActive;
 command_result QueryClient::handleCommandServerProcessStop(Command& cmd) {
-    ACTION_REQUIRES_INSTANCE_PERMISSION(permission::b_serverinstance_stop, 1);
-
     if(cmd[0].has("type")) {
         if(cmd["type"] == "cancel") {
             auto task = ts::server::scheduledShutdown();
@@ -48,6 +48,11 @@ bool QueryClient::notifyClientUpdated(const std::shared_ptr<ConnectedClient> &pt
     return ConnectedClient::notifyClientUpdated(ptr, deque, lock_channel_tree);
 }
 
+bool QueryClient::notifyClientUpdated(ClientUpdatedBroadcast &notify) {
+    CHK_EVENT(QEVENTGROUP_CLIENT_MISC, QEVENTSPECIFIER_CLIENT_MISC_UPDATE);
+    return ConnectedClient::notifyClientUpdated(notify);
+}
+
 bool QueryClient::notifyClientPoke(std::shared_ptr<ConnectedClient> invoker, std::string msg) {
     CHK_EVENT(QEVENTGROUP_CLIENT_MISC, QEVENTSPECIFIER_CLIENT_MISC_POKE);
     return ConnectedClient::notifyClientPoke(invoker, msg);
@@ -75,6 +80,13 @@ bool QueryClient::notifyTextMessage(ChatMessageMode mode, const shared_ptr<Conne
     return ConnectedClient::notifyTextMessage(mode, sender, targetId, channel_id, tp, textMessage);
 }
 
+bool QueryClient::notifyTextMessage(TextMessageBroadcast &notify) {
+    if(notify.mode() == ChatMessageMode::TEXTMODE_PRIVATE) CHK_EVENT(QEVENTGROUP_CHAT, QEVENTSPECIFIER_CHAT_MESSAGE_PRIVATE);
+    else if(notify.mode() == ChatMessageMode::TEXTMODE_CHANNEL) CHK_EVENT(QEVENTGROUP_CHAT, QEVENTSPECIFIER_CHAT_MESSAGE_CHANNEL);
+    else if(notify.mode() == ChatMessageMode::TEXTMODE_SERVER) CHK_EVENT(QEVENTGROUP_CHAT, QEVENTSPECIFIER_CHAT_MESSAGE_SERVER);
+    return ConnectedClient::notifyTextMessage(notify);
+}
+
 
 bool QueryClient::notifyServerGroupClientAdd(optional<ts::command_builder> &anOptional,
                                              const shared_ptr<ConnectedClient> &ptr,
@@ -58,6 +58,20 @@ namespace ts::server {
             return std::exchange(this->has_command_handling_scheduled, true);
         }
 
+        /**
+         * @param head The first command of a command chain linked via `next_command`.
+         *             Ownership of all commands will be taken.
+         * @param tail The next_command member of the last command within the chain.
+         * @returns `true` if command handling has already been schedules and `false` if not
+         */
+        bool enqueue_chain(ReassembledCommand *head, ReassembledCommand** tail){
+            std::lock_guard pc_lock{this->pending_commands_lock};
+            *this->pending_commands_tail = head;
+            this->pending_commands_tail = tail;
+
+            return std::exchange(this->has_command_handling_scheduled, true);
+        }
+
         ReassembledCommand* pop_command(bool& more_pending) {
             std::lock_guard pc_lock{this->pending_commands_lock};
             auto result = this->pending_commands_head;
@@ -80,6 +94,14 @@ namespace ts::server {
     };
 }
 
+namespace {
+    thread_local std::chrono::nanoseconds executing_queue_wait{0};
+}
+
+std::chrono::nanoseconds ServerCommandHandler::current_queue_wait() {
+    return executing_queue_wait;
+}
+
 bool ServerCommandHandler::execute_handling() {
     bool more_pending;
     std::unique_ptr<ReassembledCommand, void(*)(ReassembledCommand*)> pending_command{nullptr, ReassembledCommand::free};
@@ -89,10 +111,12 @@ bool ServerCommandHandler::execute_handling() {
             break;
         }
 
+        executing_queue_wait = std::chrono::steady_clock::now() - pending_command->enqueue_timestamp;
         try {
             auto result = this->handle_command(std::string_view{pending_command->command(), pending_command->length()});
             if(!result) {
                 /* flush all commands */
+                executing_queue_wait = std::chrono::nanoseconds{0};
                 this->inner->reset();
                 more_pending = false;
                 break;
@@ -100,6 +124,7 @@ bool ServerCommandHandler::execute_handling() {
         } catch (std::exception& ex) {
             logCritical(LOG_GENERAL, "Exception reached command execution root! {}",ex.what());
         }
+        executing_queue_wait = std::chrono::nanoseconds{0};
 
         break; /* Maybe handle more than one command? Maybe some kind of time limit? */
     }
@@ -129,6 +154,7 @@ void ServerCommandQueue::enqueue_command_string(const std::string_view &buffer)
 
 void ServerCommandQueue::enqueue_command_execution(ReassembledCommand *command) {
     assert(!command->next_command);
+    command->enqueue_timestamp = std::chrono::steady_clock::now();
 
     bool command_handling_scheduled = this->inner->enqueue(command);
     if(!command_handling_scheduled) {
@@ -136,6 +162,26 @@ void ServerCommandQueue::enqueue_command_execution(ReassembledCommand *command)
     }
 }
 
+void ServerCommandQueue::enqueue_command_executions(ReassembledCommand *head) {
+    if(!head) {
+        return;
+    }
+
+    /* find the tail outside of the lock */
+    auto timestamp = std::chrono::steady_clock::now();
+    head->enqueue_timestamp = timestamp;
+    auto tail = &head->next_command;
+    while(*tail) {
+        (*tail)->enqueue_timestamp = timestamp;
+        tail = &(*tail)->next_command;
+    }
+
+    bool command_handling_scheduled = this->inner->enqueue_chain(head, tail);
+    if(!command_handling_scheduled) {
+        this->executor->enqueue_handler(this->command_handler);
+    }
+}
+
 #if 0
 void ServerCommandQueue::execute_handle_command_packets(const std::chrono::system_clock::time_point& /* scheduled */) {
     if(!this->client->getServer() || this->client->connectionState() >= ConnectionState::DISCONNECTING) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <misc/spin_mutex.h>
 #include <pipes/buffer.h>
 #include <EventLoop.h>
@@ -25,6 +26,12 @@ namespace ts::server {
             ServerCommandHandler() = default;
             virtual ~ServerCommandHandler() = default;
 
+            /**
+             * The time the command, which is currently handled by the calling thread, has been waiting within the queue.
+             * Zero if the calling thread isn't handling a queued command.
+             */
+            [[nodiscard]] static std::chrono::nanoseconds current_queue_wait();
+
         protected:
             /**
              * Handle a command.
@@ -57,6 +64,8 @@ namespace ts::server {
             void enqueue_command_string(const std::string_view& /* payload */);
             /* Attention: The method will take ownership of the command */
             void enqueue_command_execution(command::ReassembledCommand*);
+            /* Attention: The method will take ownership of all commands linked via `next_command` */
+            void enqueue_command_executions(command::ReassembledCommand* /* head */);
         private:
             std::shared_ptr<ServerCommandExecutor> executor{};
             std::shared_ptr<ServerCommandHandler> command_handler{};
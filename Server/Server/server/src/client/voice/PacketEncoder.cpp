@@ -12,6 +12,106 @@
 using namespace ts;
 using namespace ts::server::server::udp;
 
+namespace {
+    /* Encrypt batches might be processed by multiple threads at once */
+    struct EncryptStageCounters {
+        std::atomic<uint64_t> batches{0};
+        std::atomic<uint64_t> packets{0};
+
+        std::array<std::atomic<uint64_t>, PacketEncoder::kEncryptHistogramBuckets> queue_depths{};
+        std::array<std::atomic<uint64_t>, PacketEncoder::kEncryptHistogramBuckets> encrypt_latencies{};
+    };
+
+    EncryptStageCounters encrypt_stage_counters{};
+
+    inline size_t histogram_bucket(size_t value) {
+        size_t bucket{0};
+        while(value >> (bucket + 1) && bucket + 1 < PacketEncoder::kEncryptHistogramBuckets) {
+            bucket++;
+        }
+
+        return bucket;
+    }
+}
+
+namespace {
+    constexpr static size_t kMaxCommandPacketPayloadLength{487};
+    constexpr static size_t kCommandCompressThreshold{100};
+
+    /* Reused by every command compressed within this thread */
+    thread_local std::vector<uint8_t> command_compress_buffer{};
+
+    /**
+     * Compress "long" commands. The payload will point to the compress buffer if the compressed command is shorter.
+     * Returns false if the command could not be compressed.
+     */
+    bool command_payload(const std::string_view& command, std::string_view& payload, bool& compressed) {
+        payload = command;
+        compressed = false;
+        if(command.size() <= kCommandCompressThreshold) {
+            return true;
+        }
+
+        auto& buffer = command_compress_buffer;
+        buffer.resize(compression::qlz_compressed_size(command.data(), command.length()));
+        size_t compressed_size{buffer.size()};
+        if(!compression::qlz_compress_payload(command.data(), command.length(), buffer.data(), &compressed_size)) {
+            return false;
+        }
+
+        /* we don't need to make the command longer than it is */
+        if(compressed_size < command.length()) {
+            payload = std::string_view{(const char*) buffer.data(), compressed_size};
+            compressed = true;
+        }
+        return true;
+    }
+
+    /* Split the payload into equally sized chunks fitting into one packet each */
+    template <typename callback_t>
+    void fragment_command_payload(std::string_view payload, callback_t&& callback) {
+        auto chunk_count = std::max((payload.length() + kMaxCommandPacketPayloadLength - 1) / kMaxCommandPacketPayloadLength, (size_t) 1);
+        auto chunk_size = (payload.length() + chunk_count - 1) / chunk_count;
+
+        for(size_t index{0}; index < chunk_count; index++) {
+            auto chunk = payload.substr(0, chunk_size);
+            payload.remove_prefix(chunk.length());
+            callback(chunk, chunk_count > 1 && (index == 0 || index + 1 == chunk_count));
+        }
+    }
+}
+
+std::shared_ptr<CommandFragments> CommandFragments::build(const std::string_view &command) {
+    std::shared_ptr<CommandFragments> result{new CommandFragments{}};
+
+    std::string_view payload{};
+    if(!command_payload(command, payload, result->compressed_)) {
+        return nullptr;
+    }
+
+    fragment_command_payload(payload, [&](const std::string_view& chunk, bool) {
+        auto fragment = protocol::allocate_shared_packet_payload(chunk.length());
+        memcpy(fragment->payload, chunk.data(), chunk.length());
+        result->payloads_.push_back(fragment);
+    });
+    return result;
+}
+
+CommandFragments::~CommandFragments() {
+    for(auto payload : this->payloads_) {
+        payload->unref();
+    }
+}
+
+struct PacketEncoder::EncryptStage {
+    /* Protects the encoder pointer. Will be reset to null as soon the encoder gets destroyed. */
+    std::mutex encoder_mutex{};
+    PacketEncoder* encoder{nullptr};
+
+    /* Ensures that the encrypt queue of one client is only processed by one worker at once */
+    multi_shot_task encrypt_task{};
+};
+
 PacketEncoder::PacketEncoder(ts::connection::CryptHandler *crypt_handler, protocol::PacketStatistics* pstats)
     : crypt_handler_{crypt_handler}, packet_statistics_{pstats} {
 
@@ -26,28 +126,100 @@ PacketEncoder::PacketEncoder(ts::connection::CryptHandler *crypt_handler, protoc
 }
 
 PacketEncoder::~PacketEncoder() {
+    if(this->encrypt_stage_) {
+        /* wait until the current encrypt batch has been finished */
+        std::lock_guard encoder_lock{this->encrypt_stage_->encoder_mutex};
+        this->encrypt_stage_->encoder = nullptr;
+    }
+
     this->reset();
 }
 
+void PacketEncoder::enable_encrypt_stage(const std::shared_ptr<task_executor> &executor) {
+    assert(!this->encrypt_stage_);
+
+    auto stage = std::make_shared<EncryptStage>();
+    stage->encoder = this;
+
+    std::weak_ptr weak_stage{stage};
+    stage->encrypt_task = multi_shot_task{executor, "voice client encrypt", [weak_stage]{
+        auto stage = weak_stage.lock();
+        if(!stage) {
+            return;
+        }
+
+        std::lock_guard encoder_lock{stage->encoder_mutex};
+        if(!stage->encoder) {
+            return;
+        }
+
+        stage->encoder->encrypt_pending_packets();
+    }};
+
+    this->encrypt_stage_ = std::move(stage);
+}
+
+PacketEncoder::EncryptStageStatistics PacketEncoder::encrypt_stage_statistics() {
+    EncryptStageStatistics result{};
+    result.batches = encrypt_stage_counters.batches.load(std::memory_order_relaxed);
+    result.packets = encrypt_stage_counters.packets.load(std::memory_order_relaxed);
+    for(size_t bucket{0}; bucket < kEncryptHistogramBuckets; bucket++) {
+        result.queue_depths[bucket] = encrypt_stage_counters.queue_depths[bucket].load(std::memory_order_relaxed);
+        result.encrypt_latencies[bucket] = encrypt_stage_counters.encrypt_latencies[bucket].load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+PacketEncoder::EgressClass PacketEncoder::egress_class(protocol::PacketType type) {
+    switch(type) {
+        case protocol::PacketType::ACK:
+        case protocol::PacketType::ACK_LOW:
+            return EgressClass::ACK;
+
+        case protocol::PacketType::VOICE:
+        case protocol::PacketType::VOICE_WHISPER:
+            return EgressClass::VOICE;
+
+        case protocol::PacketType::PING:
+        case protocol::PacketType::PONG:
+            return EgressClass::PING;
+
+        case protocol::PacketType::COMMAND_LOW:
+            return EgressClass::COMMAND_LOW;
+
+        case protocol::PacketType::COMMAND:
+        default:
+            return EgressClass::COMMAND;
+    }
+}
+
 void PacketEncoder::reset() {
     this->acknowledge_manager_.reset();
 
-    protocol::OutgoingServerPacket *write_head, *read_head;
+    protocol::OutgoingServerPacket *write_head;
+    std::array<protocol::OutgoingServerPacket*, kEgressClasses> read_heads{};
     {
         std::lock_guard wlock{this->write_queue_mutex};
         write_head = std::exchange(this->encrypt_queue_head, nullptr);
-        read_head = std::exchange(this->send_queue_head, nullptr);
-
         this->encrypt_queue_tail = &this->encrypt_queue_head;
-        this->send_queue_tail = &this->send_queue_head;
+        this->encrypt_queue_length = 0;
+
+        for(size_t index{0}; index < kEgressClasses; index++) {
+            auto& queue = this->send_queues[index];
+            read_heads[index] = std::exchange(queue.head, nullptr);
+            queue.tail = &queue.head;
+        }
+        this->command_deficits = {};
     }
 
     while(write_head) {
         std::exchange(write_head, write_head->next)->unref();
     }
 
-    while(read_head) {
-        std::exchange(read_head, read_head->next)->unref();
+    for(auto read_head : read_heads) {
+        while(read_head) {
+            std::exchange(read_head, read_head->next)->unref();
+        }
     }
 }
 
@@ -67,9 +239,18 @@ void PacketEncoder::send_packet(ts::protocol::OutgoingServerPacket *packet) {
         std::lock_guard qlock{this->write_queue_mutex};
         *this->encrypt_queue_tail = packet;
         this->encrypt_queue_tail = &packet->next;
+        this->encrypt_queue_length++;
     }
 
-    this->callback_request_write(this->callback_data);
+    this->notify_packets_enqueued();
+}
+
+void PacketEncoder::notify_packets_enqueued() {
+    if(this->encrypt_stage_) {
+        this->encrypt_stage_->encrypt_task.enqueue();
+    } else {
+        this->callback_request_write(this->callback_data);
+    }
 }
 
 void PacketEncoder::send_packet(protocol::PacketType type, const protocol::PacketFlags& flag, const void *payload, size_t payload_size) {
@@ -81,6 +262,13 @@ void PacketEncoder::send_packet(protocol::PacketType type, const protocol::Packe
     this->send_packet(packet);
 }
 
+void PacketEncoder::send_packet(protocol::PacketType type, const protocol::PacketFlags& flag, protocol::SharedPacketPayload *payload) {
+    auto packet = protocol::allocate_shared_outgoing_server_packet(payload);
+    packet->type_and_flags_ = (uint8_t) type | (uint8_t) flag;
+
+    this->send_packet(packet);
+}
+
 void PacketEncoder::send_packet_acknowledge(uint16_t pid, bool low) {
     char buffer[2];
     le2be16(pid, buffer);
@@ -90,76 +278,72 @@ void PacketEncoder::send_packet_acknowledge(uint16_t pid, bool low) {
 }
 
 
-#define MAX_COMMAND_PACKET_PAYLOAD_LENGTH (487)
 void PacketEncoder::send_command(const std::string_view &command, bool low, std::unique_ptr<std::function<void(bool)>> ack_listener) {
-    std::optional<void*> temp_data_buffer{};
-
-    const char* data_buffer{command.data()};
-    size_t data_length{command.length()};
-
-    uint8_t head_pflags{0};
     protocol::PacketType ptype{low ? protocol::PacketType::COMMAND_LOW : protocol::PacketType::COMMAND};
     protocol::OutgoingServerPacket *packets_head{nullptr};
     protocol::OutgoingServerPacket **packets_tail{&packets_head};
 
-    /* only compress "long" commands */
-    if(command.size() > 100) {
-        size_t max_compressed_payload_size = compression::qlz_compressed_size(command.data(), command.length());
-        auto compressed_buffer = ::malloc(max_compressed_payload_size);
+    uint8_t ptype_and_flags{(uint8_t) ((uint8_t) ptype | (uint8_t) protocol::PacketFlag::NewProtocol)};
 
-        size_t compressed_size{max_compressed_payload_size};
-        if(!compression::qlz_compress_payload(command.data(), command.length(), compressed_buffer, &compressed_size)) {
-            logCritical(0, "Failed to compress command packet. Dropping packet");
-            ::free(compressed_buffer);
-            return;
-        }
+    std::string_view payload{};
+    bool compressed;
+    if(!command_payload(command, payload, compressed)) {
+        logCritical(0, "Failed to compress command packet. Dropping packet");
+        return;
+    }
 
-        /* we don't need to make the command longer than it is */
-        if(compressed_size < command.length()) {
-            data_length = compressed_size;
-            data_buffer = (char*) compressed_buffer;
-            temp_data_buffer = std::make_optional(compressed_buffer);
-            head_pflags |= protocol::PacketFlag::Compressed;
-        } else {
-            ::free(compressed_buffer);
+    fragment_command_payload(payload, [&](const std::string_view& chunk, bool fragmented) {
+        auto packet = protocol::allocate_outgoing_server_packet(chunk.length());
+        packet->type_and_flags_ = ptype_and_flags;
+        if(fragmented) {
+            packet->type_and_flags_ |= protocol::PacketFlag::Fragmented;
         }
+        memcpy(packet->payload, chunk.data(), chunk.length());
+
+        *packets_tail = packet;
+        packets_tail = &packet->next;
+        assert(!packet->next);
+    });
+
+    uint8_t head_pflags{0};
+    if(compressed) {
+        head_pflags |= protocol::PacketFlag::Compressed;
     }
+    this->enqueue_command_packets(ptype, packets_head, packets_tail, head_pflags, std::move(ack_listener));
+}
+
+void PacketEncoder::send_command(const std::shared_ptr<CommandFragments> &fragments, bool low, std::unique_ptr<std::function<void(bool)>> ack_listener) {
+    protocol::PacketType ptype{low ? protocol::PacketType::COMMAND_LOW : protocol::PacketType::COMMAND};
+    protocol::OutgoingServerPacket *packets_head{nullptr};
+    protocol::OutgoingServerPacket **packets_tail{&packets_head};
 
     uint8_t ptype_and_flags{(uint8_t) ((uint8_t) ptype | (uint8_t) protocol::PacketFlag::NewProtocol)};
-    if(data_length > MAX_COMMAND_PACKET_PAYLOAD_LENGTH) {
-        auto chunk_count = (size_t) ceil((float) data_length / (float) MAX_COMMAND_PACKET_PAYLOAD_LENGTH);
-        auto chunk_size = (size_t) ceil((float) data_length / (float) chunk_count);
-
-        while(true) {
-            auto bytes = std::min(chunk_size, data_length);
-            auto packet = protocol::allocate_outgoing_server_packet(bytes);
-            packet->type_and_flags_ = ptype_and_flags;
-            memcpy(packet->payload, data_buffer, bytes);
-
-            *packets_tail = packet;
-            packets_tail = &packet->next;
-            assert(!packet->next);
-
-            data_length -= bytes;
-            if(data_length == 0) {
-                packet->type_and_flags_ |= protocol::PacketFlag::Fragmented;
-                break;
-            }
 
-            data_buffer += bytes;
-        }
-        packets_head->type_and_flags_ |= protocol::PacketFlag::Fragmented;
-    } else {
-        auto packet = protocol::allocate_outgoing_server_packet(data_length);
+    const auto& payloads = fragments->payloads();
+    for(size_t index{0}; index < payloads.size(); index++) {
+        /* the packet takes its own payload reference */
+        auto packet = protocol::allocate_shared_outgoing_server_packet(payloads[index]);
         packet->type_and_flags_ = ptype_and_flags;
+        if(payloads.size() > 1 && (index == 0 || index + 1 == payloads.size())) {
+            packet->type_and_flags_ |= protocol::PacketFlag::Fragmented;
+        }
 
-        memcpy(packet->payload, data_buffer, data_length);
-
-        packets_head = packet;
+        *packets_tail = packet;
         packets_tail = &packet->next;
         assert(!packet->next);
     }
 
+    uint8_t head_pflags{0};
+    if(fragments->compressed()) {
+        head_pflags |= protocol::PacketFlag::Compressed;
+    }
+    this->enqueue_command_packets(ptype, packets_head, packets_tail, head_pflags, std::move(ack_listener));
+}
+
+void PacketEncoder::enqueue_command_packets(protocol::PacketType ptype, protocol::OutgoingServerPacket *packets_head, protocol::OutgoingServerPacket **packets_tail,
+                                            uint8_t head_pflags, std::unique_ptr<std::function<void(bool)>> ack_listener) {
+    assert(packets_head);
+
     {
         std::lock_guard id_lock{this->packet_id_mutex};
 
@@ -180,9 +364,11 @@ void PacketEncoder::send_command(const std::string_view &command, bool low, std:
     packets_head->type_and_flags_ |= head_pflags;
 
     /* general stats */
+    size_t packet_count{0};
     {
         auto head = packets_head;
         while(head) {
+            packet_count++;
             this->callback_connection_stats(this->callback_data, StatisticsCategory::COMMAND, head->packet_length() + 96); /* 96 for the UDP overhead */
             head = head->next;
         }
@@ -212,37 +398,75 @@ void PacketEncoder::send_command(const std::string_view &command, bool low, std:
         std::lock_guard qlock{this->write_queue_mutex};
         *this->encrypt_queue_tail = packets_head;
         this->encrypt_queue_tail = packets_tail;
+        this->encrypt_queue_length += packet_count;
     }
-    this->callback_request_write(this->callback_data);
+    this->notify_packets_enqueued();
+    this->callback_request_resend(this->callback_data);
+}
 
-    if(temp_data_buffer.has_value()) {
-        ::free(*temp_data_buffer);
+void PacketEncoder::encrypt_pending_packets() {
+    std::lock_guard encrypt_lock{this->encrypt_mutex};
+    while(this->encrypt_pending_batch()) {
+        this->callback_request_write(this->callback_data);
     }
 }
 
-void PacketEncoder::encrypt_pending_packets() {
-    protocol::OutgoingServerPacket *packets_head, **packets_tail;
+bool PacketEncoder::encrypt_pending_batch() {
+    protocol::OutgoingServerPacket *packets_head, *packets_last;
+    size_t batch_size{1}, queue_depth;
     {
         std::lock_guard wlock{this->write_queue_mutex};
-        packets_head = std::exchange(this->encrypt_queue_head, nullptr);
-        packets_tail = std::exchange(this->encrypt_queue_tail, &this->encrypt_queue_head);
+        packets_head = this->encrypt_queue_head;
+        if(!packets_head) {
+            return false;
+        }
+
+        packets_last = packets_head;
+        while(packets_last->next && batch_size < kEncryptBatchSize) {
+            packets_last = packets_last->next;
+            batch_size++;
+        }
+
+        this->encrypt_queue_head = std::exchange(packets_last->next, nullptr);
+        if(!this->encrypt_queue_head) {
+            this->encrypt_queue_tail = &this->encrypt_queue_head;
+        }
+
+        queue_depth = std::exchange(this->encrypt_queue_length, this->encrypt_queue_length - batch_size);
+        this->encrypt_batch_tail = &packets_last->next;
     }
 
-    auto current_packet{packets_head};
-    while(current_packet) {
-        this->encrypt_outgoing_packet(current_packet);
-        current_packet = current_packet->next;
+    auto encrypt_begin = std::chrono::steady_clock::now();
+    for(auto packet{packets_head}; packet; packet = packet->next) {
+        this->encrypt_outgoing_packet(packet);
     }
+    auto encrypt_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - encrypt_begin).count();
 
     {
+        /* Distribute the encrypted packets to their egress classes */
         std::lock_guard wlock{this->write_queue_mutex};
-        *this->send_queue_tail = packets_head;
-        this->send_queue_tail = packets_tail;
+        for(auto packet{packets_head}; packet;) {
+            auto next_packet = std::exchange(packet->next, nullptr);
+
+            auto& queue = this->send_queue(PacketEncoder::egress_class(packet->packet_type()));
+            *queue.tail = packet;
+            queue.tail = &packet->next;
+
+            packet = next_packet;
+        }
+        this->encrypt_batch_tail = nullptr;
     }
+
+    encrypt_stage_counters.batches.fetch_add(1, std::memory_order_relaxed);
+    encrypt_stage_counters.packets.fetch_add(batch_size, std::memory_order_relaxed);
+    encrypt_stage_counters.queue_depths[histogram_bucket(queue_depth)].fetch_add(1, std::memory_order_relaxed);
+    encrypt_stage_counters.encrypt_latencies[histogram_bucket((size_t) encrypt_time)].fetch_add(1, std::memory_order_relaxed);
+    return true;
 }
 
 bool PacketEncoder::encrypt_outgoing_packet(ts::protocol::OutgoingServerPacket *packet) {
     if(packet->type_and_flags_ & protocol::PacketFlag::Unencrypted) {
+        packet->gather_shared_payload();
         this->crypt_handler_->write_default_mac(packet->mac);
     } else {
         connection::CryptHandler::key_t crypt_key{};
@@ -254,20 +478,27 @@ bool PacketEncoder::encrypt_outgoing_packet(ts::protocol::OutgoingServerPacket *
             crypt_nonce = connection::CryptHandler::kDefaultNonce;
         } else {
             if(!this->crypt_handler_->generate_key_nonce(false, (uint8_t) packet->packet_type(), packet->packet_id(), packet->generation, crypt_key, crypt_nonce)) {
+                packet->gather_shared_payload();
                 this->callback_crypt_error(this->callback_data, CryptError::KEY_GENERATION_FAILED, "");
                 return false;
             }
         }
 
+        /* Shared payloads will be encrypted directly into the packet, saving us the copy */
+        const void* plain_payload = packet->gather_payload ? packet->gather_payload->payload : packet->payload;
         auto crypt_result = this->crypt_handler_->encrypt(
                 (char*) packet->packet_data() + protocol::ServerPacketParser::kHeaderOffset,
                 protocol::ServerPacketParser::kHeaderLength,
-                packet->payload, packet->payload_size,
+                plain_payload, packet->payload, packet->payload_size,
                 packet->mac,
                 crypt_key, crypt_nonce,
                 error
         );
 
+        if(packet->gather_payload) {
+            std::exchange(packet->gather_payload, nullptr)->unref();
+        }
+
         if(!crypt_result) {
             this->callback_crypt_error(this->callback_data, CryptError::KEY_GENERATION_FAILED, error);
             return false;
@@ -277,62 +508,141 @@ bool PacketEncoder::encrypt_outgoing_packet(ts::protocol::OutgoingServerPacket *
     return true;
 }
 
+bool PacketEncoder::packet_enqueued(protocol::OutgoingServerPacket *packet) {
+    if(packet->next) {
+        return true;
+    }
+
+    if(&packet->next == this->encrypt_queue_tail || &packet->next == this->encrypt_batch_tail) {
+        return true;
+    }
+
+    for(const auto& queue : this->send_queues) {
+        if(&packet->next == queue.tail) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool PacketEncoder::send_queues_empty() const {
+    for(const auto& queue : this->send_queues) {
+        if(queue.head) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void PacketEncoder::begin_write_round() {
+    std::lock_guard wlock{this->write_queue_mutex};
+    for(size_t index{0}; index < kCommandClasses; index++) {
+        auto& deficit = this->command_deficits[index];
+        if(this->send_queues[(size_t) EgressClass::COMMAND + index].head) {
+            /* The deficit might not have been used if the write has been interrupted */
+            deficit = std::min(deficit + kCommandQuantum, 2 * kCommandQuantum);
+        } else {
+            deficit = 0;
+        }
+    }
+
+    this->command_class_index = (this->command_class_index + 1) % kCommandClasses;
+}
+
+protocol::OutgoingServerPacket* PacketEncoder::pop_command_packet() {
+    for(size_t attempt{0}; attempt < kCommandClasses; attempt++) {
+        auto index = (this->command_class_index + attempt) % kCommandClasses;
+        auto& queue = this->send_queues[(size_t) EgressClass::COMMAND + index];
+        auto& deficit = this->command_deficits[index];
+
+        if(!queue.head) {
+            deficit = 0;
+            continue;
+        }
+
+        auto packet_length = queue.head->packet_length();
+        if(packet_length > deficit) {
+            continue;
+        }
+
+        deficit -= packet_length;
+        this->command_class_index = index;
+
+        auto result = queue.head;
+        if(result->next) {
+            assert(queue.tail != &result->next);
+            queue.head = result->next;
+        } else {
+            assert(queue.tail == &result->next);
+            queue.head = nullptr;
+            queue.tail = &queue.head;
+        }
+        return result;
+    }
+
+    return nullptr;
+}
+
 bool PacketEncoder::pop_write_buffer(protocol::OutgoingServerPacket *&result) {
-    bool need_encrypt{false}, more_packets;
+    if(!this->encrypt_stage_) {
+        /*
+         * Without an encrypt stage all pending packets are encrypted here, so the scheduler is able to prioritize them.
+         * If somebody else is currently encrypting packets a write will be requested as soon the packets are ready.
+         */
+        std::unique_lock encrypt_lock{this->encrypt_mutex, std::try_to_lock};
+        if(encrypt_lock.owns_lock()) {
+            while(this->encrypt_pending_batch()) {}
+        }
+    }
 
-    {
-        std::lock_guard wlock{this->write_queue_mutex};
-        if(this->send_queue_head) {
-            result = this->send_queue_head;
-            if(result->next) {
-                assert(this->send_queue_tail != &result->next);
-                this->send_queue_head = result->next;
-            } else {
-                assert(this->send_queue_tail == &result->next);
-                this->send_queue_head = nullptr;
-                this->send_queue_tail = &this->send_queue_head;
-            }
-        } else if(this->encrypt_queue_head) {
-            result = this->encrypt_queue_head;
-            if(result->next) {
-                assert(this->encrypt_queue_tail != &result->next);
-                this->encrypt_queue_head = result->next;
-            } else {
-                assert(this->encrypt_queue_tail == &result->next);
-                this->encrypt_queue_head = nullptr;
-                this->encrypt_queue_tail = &this->encrypt_queue_head;
-            }
+    std::lock_guard wlock{this->write_queue_mutex};
+    result = nullptr;
+    for(auto egress_class : {EgressClass::ACK, EgressClass::VOICE, EgressClass::PING}) {
+        auto& queue = this->send_queue(egress_class);
+        if(!queue.head) {
+            continue;
+        }
 
-            need_encrypt = true;
+        result = queue.head;
+        if(result->next) {
+            assert(queue.tail != &result->next);
+            queue.head = result->next;
         } else {
-            result = nullptr;
-            return false;
+            assert(queue.tail == &result->next);
+            queue.head = nullptr;
+            queue.tail = &queue.head;
         }
+        break;
+    }
 
-        result->next = nullptr;
-        more_packets = this->send_queue_head != nullptr || this->encrypt_queue_head != nullptr;
+    if(!result) {
+        result = this->pop_command_packet();
     }
 
-    if(need_encrypt) {
-        this->encrypt_outgoing_packet(result);
+    if(result) {
+        result->next = nullptr;
     }
 
-    return more_packets;
+    return !this->send_queues_empty();
 }
 
 void PacketEncoder::reenqueue_failed_buffer(protocol::OutgoingServerPacket *packet) {
     std::lock_guard wlock{this->write_queue_mutex};
-    if(packet->next || &packet->next == this->send_queue_tail || &packet->next == this->encrypt_queue_tail) {
+    if(this->packet_enqueued(packet)) {
         /* packets seemed to gotten reenqueued already */
         return;
     }
 
-    if(!this->send_queue_head) {
-        this->send_queue_tail = &packet->next;
+    /* The packet has already been encrypted. Prepend it to its class so it will be send first again. */
+    auto& queue = this->send_queue(PacketEncoder::egress_class(packet->packet_type()));
+    if(!queue.head) {
+        queue.tail = &packet->next;
     }
 
-    packet->next = this->send_queue_head;
-    this->send_queue_head = packet;
+    packet->next = queue.head;
+    queue.head = packet;
 }
 
 void PacketEncoder::execute_resend(const std::chrono::system_clock::time_point &now, std::chrono::system_clock::time_point &next) {
@@ -345,21 +655,18 @@ void PacketEncoder::execute_resend(const std::chrono::system_clock::time_point &
         size_t send_count{0};
         {
             std::lock_guard wlock{this->write_queue_mutex};
+            auto& resend_queue = this->send_queue(EgressClass::RESEND);
             for(auto& buffer : buffers) {
                 auto packet = (protocol::OutgoingServerPacket*) buffer->packet_ptr;
 
                 /* Test if the packet is still in the write/enqueue queue */
-                if(packet->next) {
-                    continue;
-                }
-
-                if(&packet->next == this->encrypt_queue_tail || &packet->next == this->send_queue_tail) {
+                if(this->packet_enqueued(packet)) {
                     continue;
                 }
 
                 packet->ref(); /* for the write queue again */
-                *this->send_queue_tail = packet;
-                this->send_queue_tail = &packet->next;
+                *resend_queue.tail = packet;
+                resend_queue.tail = &packet->next;
 
                 send_count++;
                 buffer->resend_count++;
@@ -377,10 +684,10 @@ bool PacketEncoder::wait_empty_write_and_prepare_queue(std::chrono::time_point<s
     while(true) {
         {
             std::lock_guard wlock{this->write_queue_mutex};
-            if(this->encrypt_queue_head)
+            if(this->encrypt_queue_head || this->encrypt_batch_tail)
                 goto _wait;
 
-            if(this->send_queue_head)
+            if(!this->send_queues_empty())
                 goto _wait;
         }
         break;
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <misc/spin_mutex.h>
+#include <misc/task_executor.h>
 #include <mutex>
 #include <deque>
+#include <array>
+#include <vector>
+#include <memory>
 #include <protocol/Packet.h>
 #include <protocol/AcknowledgeManager.h>
 #include <protocol/PacketStatistics.h>
@@ -13,7 +17,32 @@ namespace ts::connection {
     class AcknowledgeManager;
 }
 
+namespace ts::server::udp {
+    /**
+     * A compressed and fragmented command which gets send to multiple clients.
+     * The fragment payloads are shared by the packets of all recipients and encrypted directly into them.
+     */
+    class CommandFragments {
+        public:
+            /* returns null if the command could not be compressed */
+            [[nodiscard]] static std::shared_ptr<CommandFragments> build(const std::string_view& /* command */);
+
+            CommandFragments(const CommandFragments&) = delete;
+            CommandFragments& operator=(const CommandFragments&) = delete;
+            ~CommandFragments();
+
+            [[nodiscard]] inline bool compressed() const { return this->compressed_; }
+            [[nodiscard]] inline const std::vector<protocol::SharedPacketPayload*>& payloads() const { return this->payloads_; }
+        private:
+            CommandFragments() = default;
+
+            bool compressed_{false};
+            std::vector<protocol::SharedPacketPayload*> payloads_{};
+    };
+}
+
 namespace ts::server::server::udp {
+    using CommandFragments = ts::server::udp::CommandFragments;
 
     class PacketEncoder {
             using AcknowledgeEntry = connection::AcknowledgeManager::Entry;
@@ -25,6 +54,7 @@ namespace ts::server::server::udp {
             };
 
             typedef void(*callback_request_write_t)(void* /* user data */);
+            typedef void(*callback_request_resend_t)(void* /* user data */);
             typedef void(*callback_crypt_error_t)(void* /* user data */, const CryptError& /* error */, const std::string& /* details */);
 
             typedef void(*callback_resend_stats_t)(void* /* user data */, size_t /* resend packets */);
@@ -32,25 +62,82 @@ namespace ts::server::server::udp {
 
             typedef void(*callback_connection_stats_t)(void* /* user data */, StatisticsCategory::value, size_t /* bytes */);
 
+            constexpr static size_t kEncryptBatchSize{64};
+
+            /*
+             * Encrypted packets are queued per egress class.
+             * Acknowledges, voice and pings are send with strict priority (in that order).
+             * The command classes share the remaining bandwidth via deficit round robin. Every class gets
+             * kCommandQuantum bytes per write round, so a large command burst can't delay the voice packets
+             * of this or any other client.
+             */
+            enum struct EgressClass : uint8_t {
+                ACK,
+                VOICE,
+                PING,
+                COMMAND,
+                COMMAND_LOW,
+                RESEND
+            };
+            constexpr static size_t kEgressClasses{6};
+            constexpr static size_t kCommandClasses{3};
+            constexpr static size_t kCommandQuantum{4096};
+
+            [[nodiscard]] static EgressClass egress_class(protocol::PacketType /* type */);
+            constexpr static size_t kEncryptHistogramBuckets{12};
+
+            struct EncryptStageStatistics {
+                uint64_t batches{0};
+                uint64_t packets{0};
+
+                /* bucket n counts batches taken while the encrypt queue contained between 2^n and 2^(n + 1) - 1 packets */
+                std::array<uint64_t, kEncryptHistogramBuckets> queue_depths{};
+                /* bucket n counts batches which took between 2^n and 2^(n + 1) - 1 microseconds to encrypt */
+                std::array<uint64_t, kEncryptHistogramBuckets> encrypt_latencies{};
+            };
+
+            /* Statistics of all encrypt batches since the server has been started */
+            [[nodiscard]] static EncryptStageStatistics encrypt_stage_statistics();
+
             explicit PacketEncoder(connection::CryptHandler* /* crypt handler */, protocol::PacketStatistics* /* packet stats */);
             ~PacketEncoder();
 
             void reset();
 
+            /**
+             * Encrypt all packets within the given executor instead of the network thread.
+             * The network thread will only send already encrypted packets.
+             * This must be called before sending any packet.
+             */
+            void enable_encrypt_stage(const std::shared_ptr<task_executor>& /* executor */);
+
             void send_packet(protocol::OutgoingServerPacket* /* packet */); /* will claim ownership */
             void send_packet(protocol::PacketType /* type */, const protocol::PacketFlags& /* flags */, const void* /* payload */, size_t /* payload length */);
+            /* Send a packet gathering its payload from a shared payload. The payload will be copied/encrypted while encoding. */
+            void send_packet(protocol::PacketType /* type */, const protocol::PacketFlags& /* flags */, protocol::SharedPacketPayload* /* payload */);
             void send_command(const std::string_view& /* build command command */, bool /* command low */, std::unique_ptr<std::function<void(bool)>> /* acknowledge listener */);
+            /* Send a command which has been compressed and fragmented once for all of its recipients */
+            void send_command(const std::shared_ptr<CommandFragments>& /* fragments */, bool /* command low */, std::unique_ptr<std::function<void(bool)>> /* acknowledge listener */);
 
             void send_packet_acknowledge(uint16_t /* packet id */, bool /* acknowledge low */);
 
             void execute_resend(const std::chrono::system_clock::time_point &now, std::chrono::system_clock::time_point &next);
+
+            /* Encrypt all packets within the encrypt queue and move them to the send queue */
             void encrypt_pending_packets();
 
             bool wait_empty_write_and_prepare_queue(std::chrono::time_point<std::chrono::system_clock> until = std::chrono::time_point<std::chrono::system_clock>());
 
             /**
-             * Returns true if there is more data to write and false otherwise
-             * @return
+             * Start a new write round. Grants every pending command class its quantum.
+             * Must be called every time the client has been taken from the write queue.
+             */
+            void begin_write_round();
+
+            /**
+             * Returns true if there is more data to write and false otherwise.
+             * The packet will be null while true is returned if the command quantum of the current write round
+             * has been used up. The client should be rescheduled in that case.
              */
             bool pop_write_buffer(protocol::OutgoingServerPacket*& /* packet */);
             void reenqueue_failed_buffer(protocol::OutgoingServerPacket* /* packet */);
@@ -61,6 +148,7 @@ namespace ts::server::server::udp {
             void* callback_data{nullptr};
 
             callback_request_write_t callback_request_write{[](auto){}};
+            callback_request_resend_t callback_request_resend{[](auto){}}; /* called after new packets are awaiting an acknowledge */
             callback_crypt_error_t callback_crypt_error{[](auto, auto, auto){}};
 
             callback_resend_stats_t callback_resend_stats{[](auto, auto){}};
@@ -72,12 +160,28 @@ namespace ts::server::server::udp {
             protocol::PacketStatistics* packet_statistics_{nullptr};
             connection::AcknowledgeManager acknowledge_manager_{};
 
+            struct SendQueue {
+                protocol::OutgoingServerPacket* head{nullptr};
+                protocol::OutgoingServerPacket** tail{&this->head};
+            };
+
             spin_mutex write_queue_mutex{};
-            protocol::OutgoingServerPacket* send_queue_head{nullptr};
-            protocol::OutgoingServerPacket** send_queue_tail{&send_queue_head};
+            std::array<SendQueue, kEgressClasses> send_queues{};
+
+            /* deficit round robin state of the command classes */
+            std::array<size_t, kCommandClasses> command_deficits{};
+            size_t command_class_index{0};
 
             protocol::OutgoingServerPacket* encrypt_queue_head{nullptr};
             protocol::OutgoingServerPacket** encrypt_queue_tail{&encrypt_queue_head};
+            size_t encrypt_queue_length{0};
+
+            /* Tail of the batch which is currently getting encrypted by encrypt_pending_packets */
+            protocol::OutgoingServerPacket** encrypt_batch_tail{nullptr};
+            std::mutex encrypt_mutex{};
+
+            struct EncryptStage;
+            std::shared_ptr<EncryptStage> encrypt_stage_{nullptr};
 
             protocol::PacketIdManager packet_id_manager;
             spin_mutex packet_id_mutex{};
@@ -85,5 +189,21 @@ namespace ts::server::server::udp {
 
             /* thread save function */
             bool encrypt_outgoing_packet(protocol::OutgoingServerPacket* /* packet */);
+
+            /* encrypt_mutex must be hold. Returns false if there was nothing to encrypt. */
+            bool encrypt_pending_batch();
+
+            /* write_queue_mutex must be hold */
+            [[nodiscard]] inline SendQueue& send_queue(EgressClass egress_class) { return this->send_queues[(size_t) egress_class]; }
+            [[nodiscard]] bool packet_enqueued(protocol::OutgoingServerPacket* /* packet */);
+            [[nodiscard]] bool send_queues_empty() const;
+            protocol::OutgoingServerPacket* pop_command_packet();
+
+            /* Assign the packet ids, register the acknowledges and enqueue the packets of a command */
+            void enqueue_command_packets(protocol::PacketType /* type */, protocol::OutgoingServerPacket* /* head */, protocol::OutgoingServerPacket** /* tail */,
+                                         uint8_t /* head packet flags */, std::unique_ptr<std::function<void(bool)>> /* acknowledge listener */);
+
+            /* Notify the encrypt stage (if enabled) or the network thread about new packets within the encrypt queue */
+            void notify_packets_enqueued();
     };
 }
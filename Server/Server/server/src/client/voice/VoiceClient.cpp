@@ -18,6 +18,62 @@ using namespace ts::protocol;
 constexpr static auto kMaxWhisperClientNameLength{30};
 constexpr static auto kWhisperClientUniqueIdLength{28}; /* base64 encoded SHA1 hash */
 
+namespace {
+    /*
+     * The rtc library invokes the audio callback for every recipient of a voice frame, one after another.
+     * The voice payload (including the voice header) is equal for all of them, so we're building it only once.
+     * Every recipient packet references the payload which gets encrypted directly into the packet.
+     * All recipients receive the frame from the same source buffer, so the frame is identified by its header
+     * and the source buffer instead of comparing the whole voice data for every recipient.
+     */
+    struct VoiceFanoutCache {
+        ts::protocol::SharedPacketPayload* payload{nullptr};
+
+        uint16_t source_client_id{0};
+        uint16_t seq_no{0};
+        uint8_t codec{0};
+        const void* voice_data{nullptr};
+        size_t voice_length{0};
+
+        ~VoiceFanoutCache() {
+            if(this->payload) {
+                this->payload->unref();
+            }
+        }
+
+        ts::protocol::SharedPacketPayload* voice_payload(uint16_t source_client_id, uint16_t seq_no, uint8_t codec, const void *voice_data, size_t voice_length) {
+            if(this->payload && this->source_client_id == source_client_id && this->seq_no == seq_no && this->codec == codec &&
+                    this->voice_data == voice_data && this->voice_length == voice_length) {
+                return this->payload;
+            }
+
+            /* Reuse the buffer if all packets referencing the last payload have been encoded */
+            if(!this->payload || this->payload->payload_size != voice_length + 5 || this->payload->ref_count != 1) {
+                if(this->payload) {
+                    this->payload->unref();
+                }
+                this->payload = ts::protocol::allocate_shared_packet_payload(voice_length + 5);
+            }
+
+            *((uint16_t*) this->payload->payload + 0) = htons(seq_no);
+            *((uint16_t*) this->payload->payload + 1) = htons(source_client_id);
+            this->payload->payload[4] = codec;
+            if(voice_length > 0) {
+                memcpy(this->payload->payload + 5, voice_data, voice_length);
+            }
+
+            this->source_client_id = source_client_id;
+            this->seq_no = seq_no;
+            this->codec = codec;
+            this->voice_data = voice_data;
+            this->voice_length = voice_length;
+            return this->payload;
+        }
+    };
+
+    thread_local VoiceFanoutCache voice_fanout_cache{};
+}
+
 VoiceClient::VoiceClient(const std::shared_ptr<VoiceServer>& server, const sockaddr_storage* address) :
     SpeakingClient{server->get_server()->sql, server->get_server()},
     voice_server(server) {
@@ -68,12 +124,22 @@ void VoiceClient::sendCommand0(const std::string_view& cmd, bool low, std::uniqu
 #endif
 }
 
+void VoiceClient::sendCommand(BroadcastCommand &command, bool low) {
+    auto& fragments = command.voice_fragments();
+    if(!fragments) {
+        logCritical(this->getServerId(), "{} Failed to compress broadcast command. Dropping command.", CLIENT_STR_LOG_PREFIX);
+        return;
+    }
+
+    this->connection->send_command(fragments, low, nullptr);
+}
+
 void VoiceClient::tick_server(const std::chrono::system_clock::time_point &time) {
     SpeakingClient::tick_server(time);
     {
         ALARM_TIMER(A1, "VoiceClient::tick", milliseconds(3));
         if(this->state == ConnectionState::CONNECTED) {
-            this->connection->ping_handler().tick(time);
+            /* The ping handler gets ticked by the client timer within the network event loop */
             this->connection->packet_statistics().tick();
         } else if(this->state == ConnectionState::INIT_LOW || this->state == ConnectionState::INIT_HIGH) {
             auto last_command = this->connection->crypt_setup_handler().last_handled_command();
@@ -360,21 +426,10 @@ void VoiceClient::send_voice_packet(const pipes::buffer_view &voice_buffer, cons
 
 void VoiceClient::send_voice(const std::shared_ptr<SpeakingClient> &source_client, uint16_t seq_no, uint8_t codec, const void *payload, size_t payload_length) {
     /* TODO: Somehow set the head (compressed) flag for beginning voice packets? */
-    auto packet = protocol::allocate_outgoing_server_packet(payload_length + 5);
-    packet->type_and_flags_ = protocol::PacketType::VOICE;
-
-    auto packet_payload = (uint8_t*) packet->payload;
-    *((uint16_t*) packet_payload + 0) = htons(seq_no);
-    *((uint16_t*) packet_payload + 1) = htons(source_client->getClientId());
-    packet_payload[4] = codec;
+    assert(payload || payload_length == 0);
 
-    if(payload) {
-        memcpy(packet->payload + 5, payload, payload_length);
-    } else {
-        assert(payload_length == 0);
-    }
-
-    this->getConnection()->send_packet(packet);
+    auto voice_payload = voice_fanout_cache.voice_payload(source_client->getClientId(), seq_no, codec, payload, payload_length);
+    this->getConnection()->send_packet(protocol::PacketType::VOICE, (uint8_t) protocol::PacketFlag::None, voice_payload);
 }
 
 void VoiceClient::send_voice_whisper(const std::shared_ptr<SpeakingClient> &source_client, uint16_t seq_no, uint8_t codec, const void *payload, size_t payload_length) {
@@ -46,6 +46,7 @@ namespace ts {
         class VoiceClient : public SpeakingClient {
                 friend class VirtualServer;
                 friend class VoiceServer;
+                friend class VoiceServerSocket;
                 friend class POWHandler;
                 friend class ts::connection::VoiceClientConnection;
                 friend class ConnectedClient;
@@ -67,6 +68,8 @@ namespace ts {
 
                 void sendCommand(const ts::Command &command, bool low = false) override { return this->sendCommand0(command.build(), low, nullptr); }
                 void sendCommand(const ts::command_builder &command, bool low) override { return this->sendCommand0(command.build(), low, nullptr); }
+                void sendCommand(const ts::command_arena_builder &command, bool low) override { return this->sendCommand0(command.view(), low, nullptr); }
+                void sendCommand(BroadcastCommand &command, bool low) override;
 
                 /* Note: Order is only guaranteed if progressDirectly is on! */
                 virtual void sendCommand0(const std::string_view& /* data */, bool low, std::unique_ptr<std::function<void(bool)>> listener);
@@ -101,7 +104,8 @@ namespace ts {
 
                 void processJoin() override;
             protected:
-                virtual command_result handleCommand(Command &command) override;
+                virtual command_result handleCommand(Command &command, CommandId command_id) override;
+                virtual command_result handleCommandView(const ts::command_parser &command, CommandId command_id) override;
 
             private:
                 /*
@@ -112,6 +116,25 @@ namespace ts {
                  */
                 std::weak_ptr<VoiceClient> ref_self_voice{};
 
+                /*
+                 * Write scheduling state, managed by the VoiceServerSocket.
+                 * The reference keeps the client alive while being enqueued.
+                 */
+                std::atomic<bool> write_scheduled{false};
+                VoiceClient* write_queue_next{nullptr};
+                std::shared_ptr<VoiceClient> write_queue_reference{};
+
+                /*
+                 * Timer scheduling state, managed by the VoiceServerSocket.
+                 * The timer events index is the network events owning the client timers. It gets assigned once by the VoiceServerSocket.
+                 * The timer slot is the index within the owning network events timer list and only accessed by its event loop.
+                 */
+                std::atomic<bool> timer_scheduled{false};
+                VoiceClient* timer_queue_next{nullptr};
+                std::shared_ptr<VoiceClient> timer_queue_reference{};
+                std::atomic<size_t> timer_events_index{~(size_t) 0};
+                size_t timer_slot{~(size_t) 0};
+
                 rtc::NativeAudioSourceSupplier rtc_audio_supplier{};
                 rtc::NativeAudioSourceSupplier rtc_audio_whisper_supplier{};
 
@@ -21,7 +21,13 @@ bool VoiceClientCommandHandler::handle_command(const std::string_view &command_s
         return false;
     }
 
-    std::lock_guard command_lock{client->command_lock};
+    /* lockless commands will not be serialized with the other commands of the client */
+    auto command_name = command_string.substr(0, command_string.find(' '));
+    std::unique_lock command_lock{client->command_lock, std::defer_lock};
+    if(!command_registry::find(command_name).lockless()) {
+        command_lock.lock();
+    }
+
     {
         std::lock_guard state_lock{client->state_lock};
         switch(client->state) {
@@ -47,6 +53,15 @@ bool VoiceClientCommandHandler::handle_command(const std::string_view &command_s
 }
 
 void VoiceClient::handlePacketCommand(const std::string_view& command_string) {
+    ts::command_parser command_view{command_string};
+    if(command_view.parse(true)) {
+        auto& descriptor = command_registry::find(command_view.identifier());
+        if(descriptor.parser_view()) {
+            this->handleCommandFull(command_view, descriptor, true);
+            return;
+        }
+    }
+
     std::unique_ptr<Command> command;
     command_result result{};
     try {
@@ -66,19 +81,25 @@ void VoiceClient::handlePacketCommand(const std::string_view& command_string) {
     result.release_data();
 }
 
-command_result VoiceClient::handleCommand(ts::Command &command) {
-    threads::MutexLock l2(this->command_lock);
+command_result VoiceClient::handleCommand(ts::Command &command, CommandId command_id) {
     if(this->state == ConnectionState::DISCONNECTED) return command_result{error::client_not_logged_in};
     if(!this->voice_server) return command_result{error::server_unbound};
 
     if(this->state == ConnectionState::INIT_HIGH && this->handshake.state == HandshakeState::SUCCEEDED) {
-        if(command.command() == "clientinit") {
+        if(command_id == CommandId::ClientInit) {
             return this->handleCommandClientInit(command);
         }
-    } else if(command.command() == "clientdisconnect") {
+    } else if(command_id == CommandId::ClientDisconnect) {
         return this->handleCommandClientDisconnect(command);
     }
-    return SpeakingClient::handleCommand(command);
+    return SpeakingClient::handleCommand(command, command_id);
+}
+
+command_result VoiceClient::handleCommandView(const ts::command_parser &command, CommandId command_id) {
+    if(this->state == ConnectionState::DISCONNECTED) return command_result{error::client_not_logged_in};
+    if(!this->voice_server) return command_result{error::server_unbound};
+
+    return SpeakingClient::handleCommandView(command, command_id);
 }
 
 inline bool calculate_security_level(int& result, ecc_key* pubKey, const std::string& offset) {
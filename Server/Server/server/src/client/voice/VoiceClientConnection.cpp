@@ -4,6 +4,7 @@
 #include <ThreadPool/Timer.h>
 
 #include "../../server/VoiceServer.h"
+#include "../../InstanceHandler.h"
 #include "./VoiceClientConnection.h"
 
 
@@ -37,14 +38,19 @@ VoiceClientConnection::VoiceClientConnection(VoiceClient* client)
     this->packet_decoder_.callback_argument = this;
     this->packet_decoder_.callback_decoded_packet = VoiceClientConnection::callback_packet_decoded;
     this->packet_decoder_.callback_decoded_command = VoiceClientConnection::callback_command_decoded;
+    this->packet_decoder_.callback_decoded_commands = VoiceClientConnection::callback_commands_decoded;
     this->packet_decoder_.callback_send_acknowledge = VoiceClientConnection::callback_send_acknowledge;
 
     this->packet_encoder_.callback_data = this;
     this->packet_encoder_.callback_request_write = VoiceClientConnection::callback_request_write;
+    this->packet_encoder_.callback_request_resend = VoiceClientConnection::callback_request_resend;
     this->packet_encoder_.callback_crypt_error = VoiceClientConnection::callback_encode_crypt_error;
     this->packet_encoder_.callback_resend_failed = VoiceClientConnection::callback_resend_failed;
     this->packet_encoder_.callback_resend_stats = VoiceClientConnection::callback_resend_statistics;
     this->packet_encoder_.callback_connection_stats = VoiceClientConnection::callback_outgoing_connection_statistics;
+    if(serverInstance->encrypt_task_executor()) {
+        this->packet_encoder_.enable_encrypt_stage(serverInstance->encrypt_task_executor());
+    }
 
     this->ping_handler_.callback_argument = this;
     this->ping_handler_.callback_send_ping = VoiceClientConnection::callback_ping_send;
@@ -69,16 +75,38 @@ std::string VoiceClientConnection::log_prefix() {
 }
 
 void VoiceClientConnection::handle_incoming_datagram(protocol::ClientPacketParser& packet_parser) {
+    auto packet = &packet_parser;
+    this->handle_incoming_datagrams(&packet, 1);
+}
+
+void VoiceClientConnection::handle_incoming_datagrams(protocol::ClientPacketParser** packets, size_t count) {
+    PacketDecoder::ProcessBatch batch{};
+    this->packet_decoder_.begin_batch(batch);
+
+    std::string error{};
+    for(size_t index{0}; index < count; index++) {
+        auto& packet_parser = *packets[index];
 #ifndef CONNECTION_NO_STATISTICS
-    if(this->current_client) {
-        auto stats = this->current_client->connectionStatistics;
-        stats->logIncomingPacket(stats::ConnectionStatistics::category::from_type(packet_parser.type()), packet_parser.buffer().length() + 96); /* 96 for the UDP packet overhead */
-    }
-    this->packet_statistics().received_packet((protocol::PacketType) packet_parser.type(), packet_parser.full_packet_id());
+        if(this->current_client) {
+            auto stats = this->current_client->connectionStatistics;
+            stats->logIncomingPacket(stats::ConnectionStatistics::category::from_type(packet_parser.type()), packet_parser.buffer().length() + 96); /* 96 for the UDP packet overhead */
+        }
+        this->packet_statistics().received_packet((protocol::PacketType) packet_parser.type(), packet_parser.full_packet_id());
 #endif
 
-    std::string error{};
-    auto result = this->packet_decoder_.process_incoming_data(packet_parser, error);
+        error.clear();
+        auto result = this->packet_decoder_.process_incoming_data(batch, packet_parser, error);
+        this->handle_process_result(result, error);
+
+        /* clientinitiv and clientek have to be handled before the following packets could be decrypted */
+        this->packet_decoder_.flush_crypt_setup_commands(batch);
+    }
+
+    /* All decoded commands will be handed over at once */
+    this->packet_decoder_.finish_batch(batch);
+}
+
+void VoiceClientConnection::handle_process_result(protocol::PacketProcessResult result, const std::string& error) {
     using PacketProcessResult = protocol::PacketProcessResult;
     switch (result) {
         case PacketProcessResult::SUCCESS:
@@ -184,6 +212,13 @@ void VoiceClientConnection::callback_command_decoded(void *ptr_this, Reassembled
     connection->handlePacketCommand(std::exchange(command, nullptr));
 }
 
+void VoiceClientConnection::callback_commands_decoded(void *ptr_this, ReassembledCommand *&commands) {
+    auto connection = reinterpret_cast<VoiceClientConnection*>(ptr_this);
+
+    /* we're exchanging the command chain so we're taking the ownership */
+    connection->handlePacketCommands(std::exchange(commands, nullptr));
+}
+
 bool VoiceClientConnection::verify_encryption(const protocol::ClientPacketParser& packet) {
     return this->packet_decoder_.verify_encryption_client_packet(packet);
 }
@@ -217,10 +252,18 @@ void VoiceClientConnection::send_packet(protocol::OutgoingServerPacket* packet)
     this->packet_encoder_.send_packet(packet);
 }
 
+void VoiceClientConnection::send_packet(protocol::PacketType type, const protocol::PacketFlags& flag, protocol::SharedPacketPayload *payload) {
+    this->packet_encoder_.send_packet(type, flag, payload);
+}
+
 void VoiceClientConnection::send_command(const std::string_view &cmd, bool b, std::unique_ptr<std::function<void(bool)>> cb) {
     this->packet_encoder_.send_command(cmd, b, std::move(cb));
 }
 
+void VoiceClientConnection::send_command(const std::shared_ptr<CommandFragments> &fragments, bool b, std::unique_ptr<std::function<void(bool)>> cb) {
+    this->packet_encoder_.send_command(fragments, b, std::move(cb));
+}
+
 void VoiceClientConnection::callback_encode_crypt_error(void *ptr_this,
                                                         const PacketEncoder::CryptError &error,
                                                         const std::string &detail) {
@@ -242,7 +285,12 @@ void VoiceClientConnection::callback_encode_crypt_error(void *ptr_this,
 
 void VoiceClientConnection::callback_request_write(void *ptr_this) {
     auto connection = reinterpret_cast<VoiceClientConnection*>(ptr_this);
-    connection->socket_->enqueue_client_write(connection->current_client->ref_self_voice);
+    connection->socket_->enqueue_client_write(connection->current_client);
+}
+
+void VoiceClientConnection::callback_request_resend(void *ptr_this) {
+    auto connection = reinterpret_cast<VoiceClientConnection*>(ptr_this);
+    connection->socket_->schedule_client_timer(connection->current_client);
 }
 
 void VoiceClientConnection::callback_resend_failed(void *ptr_this, const shared_ptr<AcknowledgeManager::Entry> &entry) {
@@ -272,6 +320,14 @@ void VoiceClientConnection::callback_resend_statistics(void *ptr_this, size_t se
     auto connection = reinterpret_cast<VoiceClientConnection*>(ptr_this);
 
     logTrace(connection->virtual_server_id_, "{} Resending {} packets.", connection->log_prefix(), send_count);
+
+    if(metrics::enabled()) {
+        auto client = connection->getCurrentClient();
+        auto server = client ? client->getServer() : nullptr;
+        if(server) {
+            server->metrics()->packets_resent.fetch_add(send_count, std::memory_order_relaxed);
+        }
+    }
 }
 
 void VoiceClientConnection::callback_outgoing_connection_statistics(void *ptr_this,
@@ -46,6 +46,7 @@ namespace ts {
 
                 using PacketDecoder = protocol::PacketDecoder;
                 using PacketEncoder = server::server::udp::PacketEncoder;
+                using CommandFragments = server::udp::CommandFragments;
                 using PingHandler = server::server::udp::PingHandler;
                 using CryptSetupHandler = server::server::udp::CryptSetupHandler;
                 using ReassembledCommand = command::ReassembledCommand;
@@ -57,7 +58,9 @@ namespace ts {
 
                 void send_packet(protocol::PacketType /* type */, const protocol::PacketFlags& /* flags */, const void* /* payload */, size_t /* payload length */);
                 void send_packet(protocol::OutgoingServerPacket* /* packet */); /* method takes ownership of the packet */
+                void send_packet(protocol::PacketType /* type */, const protocol::PacketFlags& /* flags */, protocol::SharedPacketPayload* /* payload */); /* payload will be referenced */
                 void send_command(const std::string_view& /* build command command */, bool /* command low */, std::unique_ptr<std::function<void(bool)>> /* acknowledge listener */);
+                void send_command(const std::shared_ptr<CommandFragments>& /* fragments */, bool /* command low */, std::unique_ptr<std::function<void(bool)>> /* acknowledge listener */);
 
                 CryptHandler* getCryptHandler(){ return &crypt_handler; }
 
@@ -83,6 +86,8 @@ namespace ts {
                 [[nodiscard]] inline auto& crypt_setup_handler() { return this->crypt_setup_handler_; }
 
                 void handle_incoming_datagram(protocol::ClientPacketParser& /* packet */);
+                /* Process multiple datagrams of this connection at once. The decoder will only be locked once. */
+                void handle_incoming_datagrams(protocol::ClientPacketParser** /* packets */, size_t /* count */);
                 bool verify_encryption(const protocol::ClientPacketParser& /* packet */);
             private:
                 ServerId virtual_server_id_;
@@ -103,8 +108,10 @@ namespace ts {
 
                 static void callback_packet_decoded(void*, const protocol::PacketParser&);
                 static void callback_command_decoded(void*, ReassembledCommand*&);
+                static void callback_commands_decoded(void*, ReassembledCommand*&);
                 static void callback_send_acknowledge(void*, uint16_t, bool);
                 static void callback_request_write(void*);
+                static void callback_request_resend(void*);
                 static void callback_encode_crypt_error(void*, const PacketEncoder::CryptError&, const std::string&);
                 static void callback_resend_failed(void*, const std::shared_ptr<AcknowledgeManager::Entry>&);
                 static void callback_resend_statistics(void*, size_t);
@@ -113,8 +120,11 @@ namespace ts {
                 static void callback_ping_send_recovery(void*);
                 static void callback_ping_timeout(void*);
 
+                void handle_process_result(protocol::PacketProcessResult /* result */, const std::string& /* error */);
+
                 /* Attention: All packet callbacks are called from the IO threads and are not thread save! */
                 void handlePacketCommand(ReassembledCommand* /* command */); /* The ownership will be transferred */
+                void handlePacketCommands(ReassembledCommand* /* commands linked via next_command */); /* The ownership will be transferred */
                 void handlePacketAck(const protocol::PacketParser&);
                 void handlePacketAckLow(const protocol::PacketParser&);
                 void handlePacketVoice(const protocol::PacketParser&);
@@ -88,33 +88,70 @@ void VoiceClientConnection::handlePacketAckLow(const ts::protocol::PacketParser
 }
 
 void VoiceClientConnection::handlePacketCommand(ReassembledCommand* command) {
-    {
-        using CommandHandleResult = CryptSetupHandler::CommandHandleResult;
+    assert(!command->next_command);
+    this->handlePacketCommands(command);
+}
+
+void VoiceClientConnection::handlePacketCommands(ReassembledCommand* commands) {
+    using CommandHandleResult = CryptSetupHandler::CommandHandleResult;
+
+    /* Commands passing the crypt setup handler will be enqueued at once */
+    ReassembledCommand* pending_head{nullptr};
+    ReassembledCommand** pending_tail{&pending_head};
+
+    auto enqueue_pending = [&]{
+        auto head = std::exchange(pending_head, nullptr);
+        pending_tail = &pending_head;
+        if(!head) {
+            return;
+        }
+
+        auto client = this->getCurrentClient();
+        if(!client) {
+            while(head) {
+                ReassembledCommand::free(std::exchange(head, head->next_command));
+            }
+            /* TODO! */
+            return;
+        }
+
+        client->server_command_queue()->enqueue_command_executions(head);
+    };
+
+    while(commands) {
+        auto command = std::exchange(commands, commands->next_command);
+        command->next_command = nullptr;
 
         auto result = this->crypt_setup_handler_.handle_command(command->command_view());
         switch (result) {
             case CommandHandleResult::PASS_THROUGH:
+                *pending_tail = command;
+                pending_tail = &command->next_command;
                 break;
 
             case CommandHandleResult::CONSUME_COMMAND:
                 ReassembledCommand::free(command);
-                return;
+                break;
 
-            case CommandHandleResult::CLOSE_CONNECTION:
+            case CommandHandleResult::CLOSE_CONNECTION: {
                 ReassembledCommand::free(command);
+
+                /* commands received before still need to be executed in order */
+                enqueue_pending();
+
                 auto client = this->getCurrentClient();
-                assert(client); /* FIXME! */
-                client->close_connection(std::chrono::system_clock::time_point{});
+                if(client) {
+                    client->close_connection(std::chrono::system_clock::time_point{});
+                }
+
+                /* the connection is gone, don't process or execute anything received afterwards */
+                while(commands) {
+                    ReassembledCommand::free(std::exchange(commands, commands->next_command));
+                }
                 return;
+            }
         }
     }
 
-    auto client = this->getCurrentClient();
-    if(!client) {
-        ReassembledCommand::free(command);
-        /* TODO! */
-        return;
-    }
-
-    client->server_command_queue()->enqueue_command_execution(command);
+    enqueue_pending();
 }
\ No newline at end of file
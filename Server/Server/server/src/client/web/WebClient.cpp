@@ -203,6 +203,30 @@ void WebClient::sendCommand(const ts::command_builder &command, bool low) {
     }
 }
 
+void WebClient::sendCommand(const ts::command_arena_builder &command, bool low) {
+    if(this->allow_raw_commands) {
+        Json::Value value{};
+        value["type"] = "command-raw";
+        value["payload"] = std::string{command.view()};
+        this->sendJson(value);
+    } else {
+        Command parsed_command = Command::parse(command.view(), true, false);
+        this->sendCommand(parsed_command, low);
+    }
+}
+
+void WebClient::sendCommand(BroadcastCommand &command, bool low) {
+    if(this->allow_raw_commands) {
+        Json::Value value{};
+        value["type"] = "command-raw";
+        value["payload"] = command.command();
+        this->sendJson(value);
+    } else {
+        Command parsed_command = Command::parse(command.command(), true, false);
+        this->sendCommand(parsed_command, low);
+    }
+}
+
 bool WebClient::close_connection(const std::chrono::system_clock::time_point& timeout) {
     bool flushing = timeout.time_since_epoch().count() > 0;
 
@@ -276,9 +300,9 @@ bool WebClient::close_connection(const std::chrono::system_clock::time_point& ti
     return true;
 }
 
-command_result WebClient::handleCommand(Command &command) {
+command_result WebClient::handleCommand(Command &command, CommandId command_id) {
     if(this->connectionState() == ConnectionState::INIT_HIGH && this->handshake.state == HandshakeState::SUCCEEDED){
-        if(command.command() == "clientinit") {
+        if(command_id == CommandId::ClientInit) {
             auto result = this->handleCommandClientInit(command);
             if(result.has_error()) {
                 this->close_connection(system_clock::now() + seconds(1));
@@ -287,12 +311,13 @@ command_result WebClient::handleCommand(Command &command) {
         }
     }
 
-    if(command.command() == "whispersessioninitialize") {
-        return this->handleCommandWhisperSessionInitialize(command);
-    } else if(command.command() == "whispersessionreset") {
-        return this->handleCommandWhisperSessionReset(command);
+    switch(command_id) {
+        case CommandId::WhisperSessionInitialize: return this->handleCommandWhisperSessionInitialize(command);
+        case CommandId::WhisperSessionReset: return this->handleCommandWhisperSessionReset(command);
+        default:
+            break;
     }
-    return SpeakingClient::handleCommand(command);
+    return SpeakingClient::handleCommand(command, command_id);
 }
 
 void WebClient::tick_server(const std::chrono::system_clock::time_point& point) {
@@ -27,6 +27,8 @@ namespace ts::server {
             void sendJson(const Json::Value&);
             void sendCommand(const ts::Command &command, bool low) override;
             void sendCommand(const ts::command_builder &command, bool low) override;
+            void sendCommand(const ts::command_arena_builder &command, bool low) override;
+            void sendCommand(BroadcastCommand &command, bool low) override;
 
             bool disconnect(const std::string &reason) override;
             bool close_connection(const std::chrono::system_clock::time_point& timeout = std::chrono::system_clock::time_point()) override;
@@ -103,7 +105,7 @@ namespace ts::server {
 
         protected:
 
-            command_result handleCommand(Command &command) override;
+            command_result handleCommand(Command &command, CommandId command_id) override;
             command_result handleCommandClientInit(Command &command) override;
 
             command_result handleCommandWhisperSessionInitialize(Command &command);
@@ -109,6 +109,16 @@ event* NetworkEventLoop::allocate_event(int fd, short events, event_callback_fn
     return event;
 }
 
+event* NetworkEventLoop::allocate_event_on(size_t loop_index, int fd, short events, event_callback_fn callback, void *callback_data) {
+    std::lock_guard lock{this->mutex};
+    if(this->event_loops.empty()) {
+        return nullptr;
+    }
+
+    auto event_loop = this->event_loops[loop_index % this->event_loops.size()];
+    return event_new(event_loop->event_base, fd, events, callback, callback_data);
+}
+
 void NetworkEventLoop::event_loop_dispatch(EventLoop *event_loop) {
     debugMessage(LOG_GENERAL, "Network event loop {} started.", event_loop->loop_id);
     auto result = event_base_loop(event_loop->event_base, EVLOOP_NO_EXIT_ON_EMPTY);
@@ -38,6 +38,19 @@ namespace ts::server {
                     NetworkEventLoopUseList** /* containing all loops the event has already been bound to */
             );
 
+            /**
+             * Allocate a new event on a specific network event loop.
+             * This is used to pin multiple events onto the same thread.
+             * @return `nullptr` if an error occurred and an even otherwise
+             */
+            [[nodiscard]] struct event* allocate_event_on(
+                    size_t /* loop index */,
+                    evutil_socket_t /* fd */,
+                    short /* events */,
+                    event_callback_fn /* callback */,
+                    void */* callback_arg */
+            );
+
             void free_use_list(NetworkEventLoopUseList* /* use list */);
         private:
             struct EventLoop {
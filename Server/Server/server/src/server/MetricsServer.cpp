@@ -0,0 +1,368 @@
+#include "MetricsServer.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <log/LogUtils.h>
+#include <protocol/Packet.h>
+#include "./GlobalNetworkEvents.h"
+#include "../InstanceHandler.h"
+#include "../VirtualServerManager.h"
+#include "../VirtualServer.h"
+
+using namespace ts;
+using namespace ts::server;
+
+namespace {
+    inline timeval to_timeval(const std::chrono::microseconds& duration) {
+        return timeval{
+                .tv_sec = (time_t) (duration.count() / 1'000'000),
+                .tv_usec = (suseconds_t) (duration.count() % 1'000'000)
+        };
+    }
+}
+
+MetricsServer::MetricsServer(NetworkEventLoop *event_loop) : event_loop{event_loop} {}
+MetricsServer::~MetricsServer() {
+    this->stop();
+}
+
+bool MetricsServer::start(const std::string &host, uint16_t port, std::string &error) {
+    if(this->active) {
+        error = "already started";
+        return false;
+    }
+
+    for(auto& [name, address, resolve_error] : net::resolve_bindings(host, port)) {
+        if(!resolve_error.empty()) {
+            logError(LOG_INSTANCE, "Failed to resolve metrics binding {}: {}", name, resolve_error);
+            continue;
+        }
+
+        auto binding = std::make_unique<Binding>();
+        binding->address = address;
+
+        binding->file_descriptor = socket(binding->address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if(binding->file_descriptor < 0) {
+            logError(LOG_INSTANCE, "Failed to bind metrics server to {}. (Failed to create socket: {} | {})", binding->as_string(), errno, strerror(errno));
+            continue;
+        }
+
+        int enable{1};
+        if(setsockopt(binding->file_descriptor, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) < 0) {
+            logWarning(LOG_INSTANCE, "Failed to activate SO_REUSEADDR for metrics binding {} ({} | {})", binding->as_string(), errno, strerror(errno));
+        }
+
+        if(binding->address.ss_family == AF_INET6) {
+            if(setsockopt(binding->file_descriptor, IPPROTO_IPV6, IPV6_V6ONLY, &enable, sizeof(enable)) < 0) {
+                logWarning(LOG_INSTANCE, "Failed to activate IPV6_V6ONLY for metrics binding {} ({} | {})", binding->as_string(), errno, strerror(errno));
+            }
+        }
+
+        if(bind(binding->file_descriptor, (struct sockaddr *) &binding->address, sizeof(binding->address)) < 0) {
+            logError(LOG_INSTANCE, "Failed to bind metrics server to {}. (Failed to bind socket: {} | {})", binding->as_string(), errno, strerror(errno));
+            close(binding->file_descriptor);
+            continue;
+        }
+
+        if(listen(binding->file_descriptor, SOMAXCONN) < 0) {
+            logError(LOG_INSTANCE, "Failed to bind metrics server to {}. (Failed to listen: {} | {})", binding->as_string(), errno, strerror(errno));
+            close(binding->file_descriptor);
+            continue;
+        }
+
+        binding->event_accept = this->event_loop->allocate_event(binding->file_descriptor, EV_READ | EV_PERSIST, MetricsServer::callback_accept, this, nullptr);
+        if(!binding->event_accept) {
+            logError(LOG_INSTANCE, "Failed to allocate accept event for metrics binding {}", binding->as_string());
+            close(binding->file_descriptor);
+            continue;
+        }
+
+        event_add(binding->event_accept, nullptr);
+        this->bindings.push_back(std::move(binding));
+    }
+
+    if(this->bindings.empty()) {
+        error = "failed to bind to any address";
+        return false;
+    }
+
+    for(size_t index{0}; index < this->event_loop->loop_count(); index++) {
+        auto probe = std::make_unique<LagProbe>();
+        probe->loop_index = index;
+        probe->event_timer = this->event_loop->allocate_event_on(index, -1, 0, MetricsServer::callback_lag_probe, &*probe);
+        if(!probe->event_timer) {
+            logWarning(LOG_INSTANCE, "Failed to allocate lag probe for network event loop {}", index);
+            continue;
+        }
+
+        auto timeout = to_timeval(kLagProbeInterval);
+        probe->scheduled = std::chrono::steady_clock::now() + kLagProbeInterval;
+        event_add(probe->event_timer, &timeout);
+        this->lag_probes.push_back(std::move(probe));
+    }
+
+    this->active = true;
+    return true;
+}
+
+void MetricsServer::stop() {
+    this->active = false;
+
+    for(auto& binding : this->bindings) {
+        if(binding->event_accept) {
+            event_del_block(binding->event_accept);
+            event_free(std::exchange(binding->event_accept, nullptr));
+        }
+
+        if(binding->file_descriptor >= 0) {
+            close(std::exchange(binding->file_descriptor, -1));
+        }
+    }
+    this->bindings.clear();
+
+    for(auto& probe : this->lag_probes) {
+        event_del_block(probe->event_timer);
+        event_free(std::exchange(probe->event_timer, nullptr));
+    }
+    this->lag_probes.clear();
+
+    /* The connection callbacks will not free connections which are not registered any more */
+    std::unique_lock connections_lock{this->connections_mutex};
+    auto connections_ = std::move(this->connections);
+    connections_lock.unlock();
+
+    for(auto& connection : connections_) {
+        event_del_block(connection->event_read);
+        event_del_block(connection->event_write);
+        event_free(connection->event_read);
+        event_free(connection->event_write);
+        close(connection->file_descriptor);
+    }
+}
+
+void MetricsServer::callback_accept(int file_descriptor, short, void *ptr_server) {
+    auto server = (MetricsServer*) ptr_server;
+
+    sockaddr_storage remote_address{};
+    socklen_t address_length{sizeof(remote_address)};
+    auto client_file_descriptor = accept4(file_descriptor, (struct sockaddr *) &remote_address, &address_length, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if(client_file_descriptor < 0) {
+        if(errno != EAGAIN && errno != EWOULDBLOCK) {
+            logWarning(LOG_INSTANCE, "Failed to accept metrics client ({} | {})", errno, strerror(errno));
+        }
+        return;
+    }
+
+    auto connection = std::make_unique<Connection>();
+    connection->handle = server;
+    connection->file_descriptor = client_file_descriptor;
+
+    std::lock_guard connections_lock{server->connections_mutex};
+    /* Both events must be hosted by the same loop since they're freeing each other */
+    auto loop_index = server->connection_loop_index++;
+    connection->event_read = server->event_loop->allocate_event_on(loop_index, client_file_descriptor, EV_READ | EV_PERSIST, MetricsServer::callback_read, &*connection);
+    connection->event_write = server->event_loop->allocate_event_on(loop_index, client_file_descriptor, EV_WRITE | EV_PERSIST, MetricsServer::callback_write, &*connection);
+    if(!connection->event_read || !connection->event_write) {
+        logError(LOG_INSTANCE, "Failed to allocate events for metrics client {}", net::to_string(remote_address, true));
+        if(connection->event_read) {
+            event_free(connection->event_read);
+        }
+        if(connection->event_write) {
+            event_free(connection->event_write);
+        }
+        close(client_file_descriptor);
+        return;
+    }
+
+    auto timeout = to_timeval(kRequestTimeout);
+    event_add(connection->event_read, &timeout);
+    server->connections.push_back(std::move(connection));
+}
+
+void MetricsServer::callback_read(int file_descriptor, short events, void *ptr_connection) {
+    auto connection = (Connection*) ptr_connection;
+    if(events & EV_TIMEOUT) {
+        connection->handle->close_connection(connection);
+        return;
+    }
+
+    char buffer[2048];
+    while(true) {
+        auto length = read(file_descriptor, buffer, sizeof(buffer));
+        if(length < 0) {
+            if(errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+
+            connection->handle->close_connection(connection);
+            return;
+        } else if(length == 0) {
+            connection->handle->close_connection(connection);
+            return;
+        }
+
+        connection->request.append(buffer, length);
+        if(connection->request.find("\r\n\r\n") != std::string::npos) {
+            event_del_noblock(connection->event_read);
+            connection->handle->handle_request(connection);
+            return;
+        }
+
+        if(connection->request.length() > kMaxRequestSize) {
+            event_del_noblock(connection->event_read);
+            connection->handle->send_response(connection, "431 Request Header Fields Too Large", "text/plain", "request too large\n");
+            return;
+        }
+    }
+}
+
+void MetricsServer::callback_write(int, short events, void *ptr_connection) {
+    auto connection = (Connection*) ptr_connection;
+    if(events & EV_TIMEOUT) {
+        connection->handle->close_connection(connection);
+        return;
+    }
+
+    connection->handle->flush_response(connection);
+}
+
+void MetricsServer::callback_lag_probe(int, short, void *ptr_probe) {
+    auto probe = (LagProbe*) ptr_probe;
+    auto now = std::chrono::steady_clock::now();
+    probe->lag.record(now - probe->scheduled);
+
+    auto timeout = to_timeval(kLagProbeInterval);
+    probe->scheduled = now + kLagProbeInterval;
+    event_add(probe->event_timer, &timeout);
+}
+
+void MetricsServer::handle_request(Connection *connection) {
+    std::string_view request{connection->request};
+    auto request_line = request.substr(0, request.find("\r\n"));
+
+    auto method_end = request_line.find(' ');
+    auto target_end = method_end == std::string_view::npos ? std::string_view::npos : request_line.find(' ', method_end + 1);
+    if(target_end == std::string_view::npos) {
+        this->send_response(connection, "400 Bad Request", "text/plain", "bad request\n");
+        return;
+    }
+
+    auto method = request_line.substr(0, method_end);
+    auto target = request_line.substr(method_end + 1, target_end - method_end - 1);
+    target = target.substr(0, target.find('?'));
+
+    if(method != "GET") {
+        this->send_response(connection, "405 Method Not Allowed", "text/plain", "method not allowed\n");
+        return;
+    }
+
+    if(target != "/metrics") {
+        this->send_response(connection, "404 Not Found", "text/plain", "not found\n");
+        return;
+    }
+
+    std::string body{};
+    body.reserve(64 * 1024);
+    metrics::registry().render(body);
+    this->render_metrics(body);
+    body += "# EOF\n";
+
+    this->send_response(connection, "200 OK", "application/openmetrics-text; version=1.0.0; charset=utf-8", body);
+}
+
+void MetricsServer::send_response(Connection *connection, const std::string_view &status, const std::string_view &content_type, const std::string &body) {
+    auto& response = connection->response;
+    response.reserve(body.length() + 256);
+    response.append("HTTP/1.1 ").append(status).append("\r\n");
+    response.append("Content-Type: ").append(content_type).append("\r\n");
+    response.append("Content-Length: ").append(std::to_string(body.length())).append("\r\n");
+    response.append("Connection: close\r\n\r\n");
+    response.append(body);
+
+    if(this->flush_response(connection)) {
+        auto timeout = to_timeval(kRequestTimeout);
+        event_add(connection->event_write, &timeout);
+    }
+}
+
+bool MetricsServer::flush_response(Connection *connection) {
+    while(connection->response_offset < connection->response.length()) {
+        auto written = send(connection->file_descriptor,
+                            connection->response.data() + connection->response_offset,
+                            connection->response.length() - connection->response_offset,
+                            MSG_NOSIGNAL);
+        if(written < 0) {
+            if(errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+
+            this->close_connection(connection);
+            return false;
+        }
+
+        connection->response_offset += written;
+    }
+
+    this->close_connection(connection);
+    return false;
+}
+
+void MetricsServer::close_connection(Connection *connection) {
+    std::unique_lock connections_lock{this->connections_mutex};
+    auto it = std::find_if(this->connections.begin(), this->connections.end(), [&](const auto& entry) { return &*entry == connection; });
+    if(it == this->connections.end()) {
+        /* we're getting stopped, stop() will cleanup the connection */
+        return;
+    }
+
+    auto connection_ = std::move(*it);
+    this->connections.erase(it);
+    connections_lock.unlock();
+
+    /* We're within the event loop of the connection, we can't block here */
+    event_del_noblock(connection_->event_read);
+    event_del_noblock(connection_->event_write);
+    event_free(connection_->event_read);
+    event_free(connection_->event_write);
+    close(connection_->file_descriptor);
+}
+
+void MetricsServer::render_metrics(std::string &output) {
+    metrics::write_family(output, "teaspeak_event_loop_lag_seconds", "histogram", "seconds", "Delay of a timer within the network event loops");
+    for(const auto& probe : this->lag_probes) {
+        metrics::write_histogram(output, "teaspeak_event_loop_lag_seconds", "loop=\"" + std::to_string(probe->loop_index) + "\"", probe->lag);
+    }
+
+    auto packet_cache = protocol::outgoing_server_packet_cache_statistics();
+    metrics::write_family(output, "teaspeak_packet_cache_allocations", "counter", "", "Outgoing packet allocations by the packet cache result");
+    metrics::write_value(output, "teaspeak_packet_cache_allocations_total", "result=\"hit\"", packet_cache.hits);
+    metrics::write_value(output, "teaspeak_packet_cache_allocations_total", "result=\"miss\"", packet_cache.misses);
+    metrics::write_value(output, "teaspeak_packet_cache_allocations_total", "result=\"oversized\"", packet_cache.oversized);
+
+    metrics::write_family(output, "teaspeak_packet_cache_depot_transfers", "counter", "", "Packet magazines exchanged with the global depot");
+    metrics::write_value(output, "teaspeak_packet_cache_depot_transfers_total", "", packet_cache.depot_transfers);
+
+    metrics::write_family(output, "teaspeak_packet_cache_depot_packets", "gauge", "", "Packets cached within the global depot");
+    metrics::write_value(output, "teaspeak_packet_cache_depot_packets", "", packet_cache.depot_packets);
+
+    metrics::write_family(output, "teaspeak_packet_cache_threads", "gauge", "", "Threads owning a packet cache");
+    metrics::write_value(output, "teaspeak_packet_cache_threads", "", packet_cache.threads);
+
+    metrics::write_family(output, "teaspeak_file_transfer_bytes", "counter", "bytes", "Bytes transferred by the file transfer");
+    if(auto server_manager = serverInstance->getVoiceServerManager(); server_manager) {
+        auto servers = server_manager->serverInstances();
+        std::sort(servers.begin(), servers.end(), [](const auto& a, const auto& b) { return a->getServerId() < b->getServerId(); });
+
+        for(const auto& server : servers) {
+            auto statistics = server->getServerStatistics();
+            if(!statistics) {
+                continue;
+            }
+
+            auto file_stats = statistics->file_stats();
+            auto server_label = "server_id=\"" + std::to_string(server->getServerId()) + "\"";
+            metrics::write_value(output, "teaspeak_file_transfer_bytes_total", server_label + ",direction=\"upload\"", file_stats.bytes_received);
+            metrics::write_value(output, "teaspeak_file_transfer_bytes_total", server_label + ",direction=\"download\"", file_stats.bytes_sent);
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <event.h>
+#include <misc/net.h>
+#include "../Metrics.h"
+
+namespace ts::server {
+    class NetworkEventLoop;
+
+    /**
+     * Minimal HTTP endpoint exporting the instance metrics (see Metrics.h) in the OpenMetrics text format.
+     * The endpoint is hosted on the network event loop and answers every request with "Connection: close".
+     * Additionally it measures the lag of every network event loop via a timer event.
+     */
+    class MetricsServer {
+        public:
+            constexpr static auto kRequestTimeout{std::chrono::seconds{10}};
+            constexpr static size_t kMaxRequestSize{8 * 1024};
+            constexpr static auto kLagProbeInterval{std::chrono::milliseconds{250}};
+
+            explicit MetricsServer(NetworkEventLoop* /* event loop */);
+            ~MetricsServer();
+
+            bool start(const std::string& /* host */, uint16_t /* port */, std::string& /* error */);
+            void stop();
+        private:
+            struct Binding {
+                sockaddr_storage address{};
+                int file_descriptor{-1};
+                ::event* event_accept{nullptr};
+
+                inline std::string as_string() { return net::to_string(address, true); }
+            };
+
+            struct Connection {
+                MetricsServer* handle{nullptr};
+                int file_descriptor{-1};
+                ::event* event_read{nullptr};
+                ::event* event_write{nullptr};
+
+                std::string request{};
+                std::string response{};
+                size_t response_offset{0};
+            };
+
+            struct LagProbe {
+                size_t loop_index{0};
+                ::event* event_timer{nullptr};
+                std::chrono::steady_clock::time_point scheduled{};
+                metrics::Histogram lag{};
+            };
+
+            NetworkEventLoop* event_loop;
+
+            bool active{false};
+            std::vector<std::unique_ptr<Binding>> bindings{};
+            std::vector<std::unique_ptr<LagProbe>> lag_probes{};
+
+            std::mutex connections_mutex{};
+            size_t connection_loop_index{0};
+            std::vector<std::unique_ptr<Connection>> connections{};
+
+            static void callback_accept(int, short, void*);
+            static void callback_read(int, short, void*);
+            static void callback_write(int, short, void*);
+            static void callback_lag_probe(int, short, void*);
+
+            void handle_request(Connection* /* connection */);
+            void send_response(Connection* /* connection */, const std::string_view& /* status */, const std::string_view& /* content type */, const std::string& /* body */);
+            /* Write the pending response. Returns false if the connection has been closed. */
+            bool flush_response(Connection* /* connection */);
+            void close_connection(Connection* /* connection */);
+
+            void render_metrics(std::string& /* output */);
+    };
+}
@@ -2,6 +2,8 @@
 #include "src/InstanceHandler.h"
 #include "src/client/voice/VoiceClient.h"
 #include <misc/endianness.h>
+#include <misc/digest.h>
+#include <random>
 #include <log/LogUtils.h>
 
 using namespace std;
@@ -12,56 +14,167 @@ using namespace ts::server;
 //#define POW_DEBUG
 //#define POW_ERROR
 
-POWHandler::POWHandler(ts::server::VoiceServer *server) : server(server) { }
+POWHandler::POWHandler(ts::server::VoiceServer *server) : server(server) {
+    std::random_device random_device{};
+    for(auto& byte : this->cookie_secret) {
+        byte = (uint8_t) random_device();
+    }
+}
+
+inline int64_t current_second(const system_clock::time_point& timestamp) {
+    return duration_cast<seconds>(timestamp.time_since_epoch()).count();
+}
 
 void POWHandler::execute_tick() {
-    auto now = system_clock::now();
+    const auto timeout_second = current_second(system_clock::now()) - kClientTimeout.count();
 
     lock_guard lock(this->pending_clients_lock);
-    this->pending_clients.erase(remove_if(this->pending_clients.begin(), this->pending_clients.end(), [&, now](const shared_ptr<Client>& client) {
-        if(now - client->last_packet > std::chrono::seconds{5}) {
-            #ifdef POW_ERROR
-            if(client->state != LowHandshakeState::COMPLETED) { /* handshake succeeded */
-                debugMessage(this->get_server_id(), "[POW] Dropping connection from {} (Timeout)", net::to_string(client->address));
+    if(this->expiry_swept_second >= timeout_second) {
+        return;
+    }
+
+    /* every bucket needs to be visited once at most */
+    auto second = std::max(this->expiry_swept_second + 1, timeout_second - (int64_t) kExpiryBuckets + 1);
+    for(; second <= timeout_second; second++) {
+        auto& bucket = this->expiry_buckets[(size_t) second % kExpiryBuckets];
+        bucket.erase(remove_if(bucket.begin(), bucket.end(), [&](const ExpiryEntry& entry) {
+            if(entry.second > timeout_second) {
+                return false;
+            }
+
+            auto it = this->pending_clients.find(entry.address_key);
+            if(it != this->pending_clients.end() && it->second->expiry_second == entry.second) {
+                /* the client hasn't sent any packet since then */
+                #ifdef POW_ERROR
+                if(it->second->state != LowHandshakeState::COMPLETED) { /* handshake succeeded */
+                    debugMessage(this->get_server_id(), "[POW] Dropping connection from {} (Timeout)", net::to_string(it->second->address));
+                }
+                #endif
+                this->pending_clients.erase(it);
             }
-            #endif
             return true;
-        }
-        return false;
-    }), this->pending_clients.end());
+        }), bucket.end());
+    }
+    this->expiry_swept_second = timeout_second;
+}
+
+void POWHandler::touch_client(Client &client, int64_t second) {
+    if(client.expiry_second == second) {
+        return;
+    }
+
+    client.expiry_second = second;
+    this->expiry_buckets[(size_t) second % kExpiryBuckets].push_back({client.address_key, second});
 }
 
 void POWHandler::delete_client(const std::shared_ptr<ts::server::POWHandler::Client> &client) {
     lock_guard lock(this->pending_clients_lock);
-    auto it = find(this->pending_clients.begin(), this->pending_clients.end(), client);
-    if(it != this->pending_clients.end())
+    auto it = this->pending_clients.find(client->address_key);
+    if(it != this->pending_clients.end() && it->second == client)
         this->pending_clients.erase(it);
 }
 
+void POWHandler::generate_cookie(const AddressKey &address, uint32_t timestamp, uint8_t *cookie) {
+    /* secret prefixed SHA-256 of a fixed size message, so length extension isn't an issue */
+    uint8_t message[32 + 4 + 8 + 8 + 4];
+    memcpy(message, this->cookie_secret.data(), 32);
+    memcpy(&message[32], &address.family_port, 4);
+    memcpy(&message[36], &address.address_high, 8);
+    memcpy(&message[44], &address.address_low, 8);
+    le2be32(timestamp, &message[52]);
+
+    uint8_t mac[SHA256_DIGEST_LENGTH];
+    digest::sha256((const char*) message, sizeof(message), mac);
+
+    le2be32(timestamp, cookie);
+    memcpy(&cookie[4], mac, kCookieLength - 4);
+}
+
+bool POWHandler::verify_cookie(const AddressKey &address, const uint8_t *cookie) {
+    auto timestamp = be2le32(cookie);
+    auto age = (uint32_t) current_second(system_clock::now()) - timestamp;
+    if(age > kCookieLifetime.count()) {
+        return false;
+    }
+
+    uint8_t expected[kCookieLength];
+    this->generate_cookie(address, timestamp, expected);
+
+    uint8_t difference{0};
+    for(size_t index{0}; index < kCookieLength; index++) {
+        difference |= (uint8_t) (expected[index] ^ cookie[index]);
+    }
+    return difference == 0;
+}
+
 void POWHandler::handle_datagram(const std::shared_ptr<VoiceServerSocket>& socket, const sockaddr_storage &address,msghdr &info, const pipes::buffer_view &buffer) {
     if(buffer.length() < MAC_SIZE + CLIENT_HEADER_SIZE + 5) {
         return; /* too short packet! */
     }
 
+    AddressKey address_key{};
+    if(!AddressKey::from_address(address, address_key)) {
+        return;
+    }
+
+    /* buffer is in client packet format, but we dont need to parse because we dont need the header */
+    auto data = buffer.view(MAC_SIZE + CLIENT_HEADER_SIZE);
+    //this->crypto.client_time = be2le32((char*) packet->data().data_ptr(), 0); /* client timestamp */
+    auto packet_state = static_cast<LowHandshakeState>(data[4]);
+    #ifdef POW_DEBUG
+    debugMessage(this->get_server_id(), "[POW][{}] Received packet with state {}. length: {}", net::to_string(address), packet_state, data.length());
+    #endif
+
+    /*
+     * We don't allocate any state until the client requests a puzzle. If the cookie handshake is enforced the request must
+     * carry a valid server cookie, so spoofed puzzle requests can't allocate pending clients.
+     */
+    bool allocate_client{false};
+    if(packet_state == LowHandshakeState::PUZZLE_GET) {
+        allocate_client = !config::voice::enforce_coocie_handshake || (data.length() == 25 && this->verify_cookie(address_key, &data[5]));
+    }
+
+    const auto now = system_clock::now();
     std::shared_ptr<Client> client;
     {
         lock_guard lock(this->pending_clients_lock);
-        for(const auto& pending_client : this->pending_clients) {
-            if(pending_client->socket == socket && memcmp(&address, &pending_client->address, sizeof(sockaddr_storage)) == 0) {
-                client = pending_client;
-                break;
-            }
-        }
-
-        if(!client) {
+        auto it = this->pending_clients.find(address_key);
+        if(it != this->pending_clients.end() && it->second->socket == socket) {
+            client = it->second;
+        } else if(allocate_client) {
             #ifdef POW_DEBUG
             debugMessage(this->get_server_id(), "[POW] Got a new connection from {}", net::to_string(address));
             #endif
-            //We've got a new client
             client = make_shared<Client>();
-            client->state = LowHandshakeState::UNSET;
-            this->pending_clients.push_back(client);
+            client->socket = socket;
+            client->client_version = be2le32(&buffer[MAC_SIZE + CLIENT_HEADER_SIZE]);
+            memcpy(&client->address, &address, sizeof(client->address));
+            udp::DatagramPacket::extract_info(info, client->address_info);
+            client->address_key = address_key;
+            client->state = LowHandshakeState::PUZZLE_GET;
+
+            this->pending_clients[address_key] = client;
+        }
+
+        if(client) {
+            this->touch_client(*client, current_second(now));
+        }
+    }
+
+    if(!client) {
+        udp::pktinfo_storage address_info{};
+        udp::DatagramPacket::extract_info(info, address_info);
+
+        if(packet_state == LowHandshakeState::COOKIE_GET) {
+            this->handle_cookie_get(socket, address, address_info, data);
+        } else {
+            #ifdef POW_ERROR
+            debugMessage(this->get_server_id(), "[POW][{}] Received packet an unexpected state. Expected: {}, Received: {}. Resetting client", net::to_string(address), LowHandshakeState::COOKIE_GET, packet_state);
+            #endif
+            uint8_t reset_buffer[2] = {COMMAND_RESET, 0};
+            this->send_data(socket, address, address_info, pipes::buffer_view{reset_buffer, 2});
         }
+        return;
     }
 
     unique_lock lock(client->handle_lock, defer_lock_t{});
@@ -69,24 +182,7 @@ void POWHandler::handle_datagram(const std::shared_ptr<VoiceServerSocket>& socke
         //Failed to acquire handle lock
         return;
     }
-
-    if(client->state == LowHandshakeState::UNSET) { /* initialize client */
-        client->socket = socket;
-        client->client_version = be2le32(&buffer[MAC_SIZE + CLIENT_HEADER_SIZE]);
-        memcpy(&client->address, &address, sizeof(client->address));
-        udp::DatagramPacket::extract_info(info, client->address_info);
-
-        client->state = LowHandshakeState::COOKIE_GET;
-    }
-    client->last_packet = system_clock::now();
-
-    /* buffer is in client packet format, but we dont need to parse because we dont need the header */
-    auto data = buffer.view(MAC_SIZE + CLIENT_HEADER_SIZE);
-    //this->crypto.client_time = be2le32((char*) packet->data().data_ptr(), 0); /* client timestamp */
-    auto packet_state = static_cast<LowHandshakeState>(data[4]);
-    #ifdef POW_DEBUG
-    debugMessage(this->get_server_id(), "[POW][{}] Received packet with state {}. length: {}", net::to_string(address), packet_state, data.length());
-    #endif
+    client->last_packet = now;
 
     if(packet_state < client->state) {
         #ifdef POW_ERROR
@@ -95,14 +191,9 @@ void POWHandler::handle_datagram(const std::shared_ptr<VoiceServerSocket>& socke
         client->state = packet_state;
     } else if(packet_state != client->state) {
         if(packet_state == LowHandshakeState::PUZZLE_GET && client->state == LowHandshakeState::COOKIE_GET) {
-            if(!config::voice::enforce_coocie_handshake) {
-                #ifdef POW_DEBUG
-                debugMessage(this->get_server_id(), "[POW][{}] Client wants a puzzle, but we expected a cookie. Ignoring it and jump ahead to the puzzle.", net::to_string(address));
-                #endif
-                client->state = LowHandshakeState::PUZZLE_GET;
-                client->server_control_data[0] = 0; /* disable cookie check */
-                goto handle_packet;
-            }
+            /* the cookie (if required) will be verified by handle_puzzle_get */
+            client->state = LowHandshakeState::PUZZLE_GET;
+            goto handle_packet;
         }
         #ifdef POW_ERROR
         debugMessage(this->get_server_id(), "[POW][{}] Received packet an unexpected state. Expected: {}, Received: {}. Resetting client", net::to_string(address), client->state, packet_state);
@@ -112,9 +203,10 @@ void POWHandler::handle_datagram(const std::shared_ptr<VoiceServerSocket>& socke
     }
 
     handle_packet:
-    if(packet_state == LowHandshakeState::COOKIE_GET)
-        this->handle_cookie_get(client, data);
-    else if(packet_state == LowHandshakeState::PUZZLE_GET)
+    if(packet_state == LowHandshakeState::COOKIE_GET) {
+        if(this->handle_cookie_get(client->socket, client->address, client->address_info, data))
+            client->state = LowHandshakeState::PUZZLE_GET;
+    } else if(packet_state == LowHandshakeState::PUZZLE_GET)
         this->handle_puzzle_get(client, data);
     else if(packet_state == LowHandshakeState::PUZZLE_SOLVE)
         this->handle_puzzle_solve(client, data);
@@ -128,7 +220,11 @@ void POWHandler::handle_datagram(const std::shared_ptr<VoiceServerSocket>& socke
 }
 
 void POWHandler::send_data(const std::shared_ptr<ts::server::POWHandler::Client> &client, const pipes::buffer_view &buffer) {
-    auto datagram = udp::DatagramPacket::create(client->address, client->address_info, buffer.length() + MAC_SIZE + SERVER_HEADER_SIZE, nullptr);
+    this->send_data(client->socket, client->address, client->address_info, buffer);
+}
+
+void POWHandler::send_data(const std::shared_ptr<VoiceServerSocket> &socket, const sockaddr_storage &address, const udp::pktinfo_storage &address_info, const pipes::buffer_view &buffer) {
+    auto datagram = udp::DatagramPacket::create(address, address_info, buffer.length() + MAC_SIZE + SERVER_HEADER_SIZE, nullptr);
     if(!datagram) return; //Should never happen
 
     /* first 8 bytes mac */
@@ -141,7 +237,7 @@ void POWHandler::send_data(const std::shared_ptr<ts::server::POWHandler::Client>
     datagram->data[10] = (uint8_t) (0x08U | 0x80U);
 
     memcpy(&datagram->data[11], buffer.data_ptr(), buffer.length());
-    client->socket->send_datagram(datagram);
+    socket->send_datagram(datagram);
 }
 
 void POWHandler::reset_client(const std::shared_ptr<ts::server::POWHandler::Client> &client) {
@@ -150,39 +246,29 @@ void POWHandler::reset_client(const std::shared_ptr<ts::server::POWHandler::Clie
     client->state = LowHandshakeState::COOKIE_GET;
 }
 
-inline void generate_random(uint8_t *destination, size_t length) {
-    while(length-- > 0)
-        *(destination++) = (uint8_t) rand();
-}
-
-void POWHandler::handle_cookie_get(const std::shared_ptr<ts::server::POWHandler::Client> &client, const pipes::buffer_view &buffer) {
+bool POWHandler::handle_cookie_get(const std::shared_ptr<VoiceServerSocket> &socket, const sockaddr_storage &address, const udp::pktinfo_storage &address_info, const pipes::buffer_view &buffer) {
     if(buffer.length() != 21) {
         #ifdef POW_ERROR
-        debugMessage(this->get_server_id(), "[POW][{}][Cookie] Received an invalid packet with an invalid length. Expected {} bytes, but got {} bytes", net::to_string(client->address), 21, buffer.length());
+        debugMessage(this->get_server_id(), "[POW][{}][Cookie] Received an invalid packet with an invalid length. Expected {} bytes, but got {} bytes", net::to_string(address), 21, buffer.length());
         #endif
-        return;
+        return false;
     }
 
-    /* initialize data */
-    if(client->server_control_data[0] == 0) {
-        generate_random(client->server_control_data, 16);
-        client->server_control_data[0] |= 1U;
+    AddressKey address_key{};
+    if(!AddressKey::from_address(address, address_key)) {
+        return false;
     }
 
-    /* parse values */
-    memcpy(client->client_control_data, &buffer[9], 4);
-
     /* send response */
     {
         uint8_t response_buffer[21];
         response_buffer[0] = LowHandshakeState::COOKIE_SET;
-        memcpy(&response_buffer[1], client->server_control_data, 16);
-        *(uint32_t*) &response_buffer[17] = htonl(*(uint32_t*) &client->client_control_data);
+        this->generate_cookie(address_key, (uint32_t) current_second(system_clock::now()), &response_buffer[1]);
+        *(uint32_t*) &response_buffer[17] = htonl(*(uint32_t*) &buffer[9]);
 
-        this->send_data(client, pipes::buffer_view{response_buffer, 21});
+        this->send_data(socket, address, address_info, pipes::buffer_view{response_buffer, 21});
     }
-
-    client->state = LowHandshakeState::PUZZLE_GET;
+    return true;
 }
 
 void POWHandler::handle_puzzle_get(const std::shared_ptr<ts::server::POWHandler::Client> &client, const pipes::buffer_view &buffer) {
@@ -193,12 +279,13 @@ void POWHandler::handle_puzzle_get(const std::shared_ptr<ts::server::POWHandler:
         return;
     }
 
-    /* verify the server cookie */
-    if(client->server_control_data[0] != 0) {
-        if(memcmp(client->server_control_data, &buffer[5], 16) != 0) {
+    /* verify the server cookie. Clients are allowed to skip the cookie step if the handshake isn't enforced. */
+    if(!this->verify_cookie(client->address_key, &buffer[5])) {
+        if(config::voice::enforce_coocie_handshake) {
             #ifdef POW_ERROR
             debugMessage(this->get_server_id(), "[POW][{}][Puzzle] Received an invalid puzzle request. Returned server cookie dosnt match! Resetting client", net::to_string(client->address));
             #endif
+            this->delete_client(client);
             this->reset_client(client);
             return;
         }
@@ -284,68 +371,59 @@ void POWHandler::handle_puzzle_solve(const std::shared_ptr<ts::server::POWHandle
 }
 
 shared_ptr<VoiceClient> POWHandler::register_verified_client(const std::shared_ptr <ts::server::POWHandler::Client> &client) {
-    std::shared_ptr<VoiceClient> voice_client;
-    {
-        lock_guard lock(this->server->connectionLock);
-        for(const auto& connection : this->server->activeConnections) {
-            if(memcmp(&connection->remote_address, &client->address, sizeof(client->address)) != 0) {
-                continue;
-            }
+    /* The connection index contains the newest connection for the address */
+    std::shared_ptr<VoiceClient> voice_client{};
+    if(auto connection = this->server->findClient(&client->address); connection) {
+        switch(connection->connectionState()) {
+            case ConnectionState::DISCONNECTING:
+            case ConnectionState::DISCONNECTED:
+                /* Connection already disconnecting/disconnected. Don't use this connection. */
+                break;
+
+            case ConnectionState::INIT_LOW:
+            case ConnectionState::INIT_HIGH:
+                /* It seems like a clientinitiv command resend. Process it. */
+                voice_client = connection;
+                break;
 
-            switch(connection->connectionState()) {
-                case ConnectionState::DISCONNECTING:
-                case ConnectionState::DISCONNECTED:
-                    /* Connection already disconnecting/disconnected. Don't use this connection. */
-                    continue;
-
-                case ConnectionState::INIT_LOW:
-                case ConnectionState::INIT_HIGH:
-                    /* It seems like a clientinitiv command resend. Process it. */
-                    break;
-
-                case ConnectionState::CONNECTED: {
-                    auto timestamp_now = std::chrono::system_clock::now();
-                    auto last_client_alive_signal = std::max(connection->connection->ping_handler().last_ping_response(), connection->connection->ping_handler().last_command_acknowledged());
-                    if(timestamp_now - last_client_alive_signal < std::chrono::seconds(5)) {
-                        logMessage(connection->connection->virtual_server_id(), "{} Client initialized session reconnect, but last alive signal is not older then 5 seconds ({}). Ignoring attempt.",
-                                   connection->connection->log_prefix(),
-                                   duration_cast<std::chrono::milliseconds>(timestamp_now - last_client_alive_signal).count()
-                        );
-
-                        /* FIXME: Somehow send an error? */
-                        return nullptr;
-                    } else if(!config::voice::allow_session_reinitialize) {
-                        logMessage(connection->connection->virtual_server_id(), "{} Client initialized session reconnect and last ping response is older then 5 seconds ({}). Dropping attempt because its not allowed due to config settings",
-                                   connection->connection->log_prefix(),
-                                   duration_cast<std::chrono::milliseconds>(timestamp_now - last_client_alive_signal).count()
-                        );
-
-                        /* FIXME: Somehow send an error? */
-                        return nullptr;
-                    }
-
-                    logMessage(connection->connection->virtual_server_id(), "{} Client initialized reconnect and last ping response is older then 5 seconds ({}). Allowing attempt and dropping old connection.",
+            case ConnectionState::CONNECTED: {
+                auto timestamp_now = std::chrono::system_clock::now();
+                auto last_client_alive_signal = std::max(connection->connection->ping_handler().last_ping_response(), connection->connection->ping_handler().last_command_acknowledged());
+                if(timestamp_now - last_client_alive_signal < std::chrono::seconds(5)) {
+                    logMessage(connection->connection->virtual_server_id(), "{} Client initialized session reconnect, but last alive signal is not older then 5 seconds ({}). Ignoring attempt.",
                                connection->connection->log_prefix(),
                                duration_cast<std::chrono::milliseconds>(timestamp_now - last_client_alive_signal).count()
                     );
 
-                    connection->close_connection(std::chrono::system_clock::time_point{});
-                    {
-                        std::lock_guard flush_lock{connection->flush_mutex};
-                        connection->disconnect_acknowledged = std::make_optional(true);
-                    }
+                    /* FIXME: Somehow send an error? */
+                    return nullptr;
+                } else if(!config::voice::allow_session_reinitialize) {
+                    logMessage(connection->connection->virtual_server_id(), "{} Client initialized session reconnect and last ping response is older then 5 seconds ({}). Dropping attempt because its not allowed due to config settings",
+                               connection->connection->log_prefix(),
+                               duration_cast<std::chrono::milliseconds>(timestamp_now - last_client_alive_signal).count()
+                    );
 
-                    continue;
+                    /* FIXME: Somehow send an error? */
+                    return nullptr;
                 }
 
-                case ConnectionState::UNKNWON:
-                default:
-                    assert(false);
-                    continue;
+                logMessage(connection->connection->virtual_server_id(), "{} Client initialized reconnect and last ping response is older then 5 seconds ({}). Allowing attempt and dropping old connection.",
+                           connection->connection->log_prefix(),
+                           duration_cast<std::chrono::milliseconds>(timestamp_now - last_client_alive_signal).count()
+                );
+
+                connection->close_connection(std::chrono::system_clock::time_point{});
+                {
+                    std::lock_guard flush_lock{connection->flush_mutex};
+                    connection->disconnect_acknowledged = std::make_optional(true);
+                }
+                break;
             }
 
-            voice_client = connection;
-            break;
+            case ConnectionState::UNKNWON:
+            default:
+                assert(false);
+                break;
         }
     }
 
@@ -355,12 +433,15 @@ shared_ptr<VoiceClient> POWHandler::register_verified_client(const std::shared_p
         voice_client->initialize();
 
         voice_client->connection->socket_ = client->socket;
+        /* With socket sharding all datagrams of the client are received by the same event loop */
+        voice_client->connection->packet_decoder().set_single_owner(client->socket->sharded());
         voice_client->state = ConnectionState::INIT_LOW;
         memcpy(&voice_client->connection->remote_address_info_, &client->address_info, sizeof(client->address_info));
 
         {
             std::lock_guard lock{this->server->connectionLock};
             this->server->activeConnections.push_back(voice_client);
+            this->server->connection_index.insert(voice_client);
         }
 
         debugMessage(this->get_server_id(), "Having new voice client. Remote address: {}:{}", voice_client->getLoggingPeerIp(), voice_client->getPeerPort());
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <mutex>
+#include <array>
+#include <vector>
+#include <unordered_map>
 #include <netinet/in.h>
 #include <pipes/buffer.h>
 #include <src/server/PrecomputedPuzzles.h>
@@ -25,6 +28,13 @@ namespace ts::server {
                 UNSET = 0xFB
             };
 
+            /* Maximal age of a server cookie returned within a puzzle request */
+            constexpr static std::chrono::seconds kCookieLifetime{10};
+            constexpr static std::chrono::seconds kClientTimeout{5};
+            constexpr static size_t kCookieLength{16};
+            constexpr static size_t kExpiryBuckets{8};
+            static_assert(kExpiryBuckets > kClientTimeout.count() + 1);
+
             struct Client {
                 std::shared_ptr<VoiceServerSocket> socket;
                 sockaddr_storage address;
@@ -34,8 +44,10 @@ namespace ts::server {
                 std::chrono::system_clock::time_point last_packet;
                 LowHandshakeState state = LowHandshakeState::COOKIE_GET;
 
-                uint8_t client_control_data[4]{0};
-                uint8_t server_control_data[16]{0};
+                /* locked by pending_clients_lock */
+                AddressKey address_key{};
+                int64_t expiry_second{0};
+
                 uint8_t server_data[100];
 
                 uint32_t client_version;
@@ -53,17 +65,43 @@ namespace ts::server {
             }
             VoiceServer* server;
 
+            /* Key of the server cookies. Cookies don't need to be valid across restarts. */
+            std::array<uint8_t, 32> cookie_secret{};
+
+            struct ExpiryEntry {
+                AddressKey address_key;
+                int64_t second;
+            };
+
+            /*
+             * State is only allocated once a client requests a puzzle.
+             * Every client is referenced within the expiry bucket of the second it has sent its last packet in,
+             * so the tick only needs to visit the clients which might have been timed out.
+             */
             std::mutex pending_clients_lock;
-            std::deque<std::shared_ptr<Client>> pending_clients;
+            std::unordered_map<AddressKey, std::shared_ptr<Client>, AddressKeyHash> pending_clients{};
+            std::array<std::vector<ExpiryEntry>, kExpiryBuckets> expiry_buckets{};
+            int64_t expiry_swept_second{0};
 
+            /* Attention: pending_clients_lock must be locked */
+            void touch_client(Client& /* client */, int64_t /* second */);
             void delete_client(const std::shared_ptr<Client>& /* client */);
 
-            void handle_cookie_get(const std::shared_ptr<Client>& /* client */, const pipes::buffer_view& /* buffer */);
+            /**
+             * Generate a server cookie for the remote address.
+             * The cookie contains the timestamp and a MAC of the address and the timestamp, so we don't need to store it.
+             */
+            void generate_cookie(const AddressKey& /* address */, uint32_t /* timestamp */, uint8_t* /* cookie */);
+            [[nodiscard]] bool verify_cookie(const AddressKey& /* address */, const uint8_t* /* cookie */);
+
+            /* Stateless. Returns false if the request is invalid. */
+            bool handle_cookie_get(const std::shared_ptr<VoiceServerSocket>& /* socket */, const sockaddr_storage& /* address */, const udp::pktinfo_storage& /* address info */, const pipes::buffer_view& /* buffer */);
             void handle_puzzle_get(const std::shared_ptr<Client>& /* client */, const pipes::buffer_view& /* buffer */);
             void handle_puzzle_solve(const std::shared_ptr<Client>& /* client */, const pipes::buffer_view& /* buffer */);
             std::shared_ptr<VoiceClient> register_verified_client(const std::shared_ptr<Client>& /* client */);
 
             void send_data(const std::shared_ptr<Client> &client /* client */, const pipes::buffer_view &buffer /* buffer */);
+            void send_data(const std::shared_ptr<VoiceServerSocket>& /* socket */, const sockaddr_storage& /* address */, const udp::pktinfo_storage& /* address info */, const pipes::buffer_view& /* buffer */);
             void reset_client(const std::shared_ptr<Client> &client /* client */);
     };
 }
\ No newline at end of file
@@ -0,0 +1,285 @@
+#include "VoiceConnectionIndex.h"
+#include "../client/voice/VoiceClient.h"
+#include <unordered_map>
+#include <vector>
+#include <array>
+#include <cstring>
+
+using namespace ts::server;
+
+namespace {
+    /*
+     * Epoch based reclamation of the replaced tables.
+     * Every reading thread owns a slot containing the epoch it started to read in (zero if not reading).
+     * A table replaced in epoch N can be freed as soon as no slot contains an epoch lower than N.
+     * Threads which could not get a slot (more than kReaderSlots concurrent threads) are counted instead.
+     */
+    constexpr size_t kReaderSlots{256};
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<bool> used{false};
+        std::atomic<uint64_t> epoch{0};
+    };
+
+    std::array<ReaderSlot, kReaderSlots> reader_slots{};
+    std::atomic<uint64_t> global_epoch{1};
+    std::atomic<size_t> unslotted_readers{0};
+
+    struct ThreadReaderSlot {
+        ReaderSlot* slot{nullptr};
+
+        ThreadReaderSlot() {
+            for(auto& reader_slot : reader_slots) {
+                bool expected{false};
+                if(reader_slot.used.compare_exchange_strong(expected, true)) {
+                    this->slot = &reader_slot;
+                    break;
+                }
+            }
+        }
+
+        ~ThreadReaderSlot() {
+            if(this->slot) {
+                this->slot->epoch.store(0);
+                this->slot->used.store(false);
+            }
+        }
+    };
+
+    thread_local ThreadReaderSlot thread_reader_slot{};
+
+    struct ReadGuard {
+        ReaderSlot* slot;
+
+        ReadGuard() : slot{thread_reader_slot.slot} {
+            if(this->slot) {
+                this->slot->epoch.store(global_epoch.load());
+            } else {
+                unslotted_readers++;
+            }
+        }
+
+        ~ReadGuard() {
+            if(this->slot) {
+                this->slot->epoch.store(0, std::memory_order_release);
+            } else {
+                unslotted_readers--;
+            }
+        }
+    };
+}
+
+namespace {
+    constexpr size_t kAddressShards{64};
+    constexpr size_t kClientIdChunkSize{64};
+
+    struct AddressShard {
+        std::unordered_map<AddressKey, std::shared_ptr<VoiceClient>, AddressKeyHash> clients{};
+    };
+
+    struct ClientIdChunk {
+        std::array<std::shared_ptr<VoiceClient>, kClientIdChunkSize> clients{};
+    };
+
+    inline size_t address_shard(const AddressKey& key) {
+        return AddressKeyHash{}(key) % kAddressShards;
+    }
+}
+
+/* Shards and chunks are shared between tables. Empty shards and chunks might be null. */
+struct VoiceConnectionIndex::Table {
+    std::array<std::shared_ptr<const AddressShard>, kAddressShards> address_shards{};
+    std::vector<std::shared_ptr<const ClientIdChunk>> client_id_chunks{};
+};
+
+VoiceConnectionIndex::VoiceConnectionIndex() : table_{new Table{}} { }
+
+VoiceConnectionIndex::~VoiceConnectionIndex() {
+    /* No readers left since the owning voice server is getting destroyed */
+    delete this->table_.exchange(nullptr);
+
+    std::lock_guard retired_lock{this->retired_mutex};
+    for(const auto& retired : this->retired_tables) {
+        delete retired.table;
+    }
+    this->retired_tables.clear();
+}
+
+void VoiceConnectionIndex::set_address(Table &table, const AddressKey &key, const std::shared_ptr<VoiceClient> &connection) {
+    auto& shard = table.address_shards[address_shard(key)];
+    auto new_shard = shard ? std::make_shared<AddressShard>(*shard) : std::make_shared<AddressShard>();
+    if(connection) {
+        new_shard->clients[key] = connection;
+    } else {
+        new_shard->clients.erase(key);
+    }
+    shard = std::move(new_shard);
+}
+
+void VoiceConnectionIndex::set_client_id(Table &table, ClientId client_id, const std::shared_ptr<VoiceClient> &connection) {
+    auto chunk_index = client_id / kClientIdChunkSize;
+    if(table.client_id_chunks.size() <= chunk_index) {
+        if(!connection) {
+            return;
+        }
+        table.client_id_chunks.resize(chunk_index + 1);
+    }
+
+    auto& chunk = table.client_id_chunks[chunk_index];
+    auto new_chunk = chunk ? std::make_shared<ClientIdChunk>(*chunk) : std::make_shared<ClientIdChunk>();
+    new_chunk->clients[client_id % kClientIdChunkSize] = connection;
+    chunk = std::move(new_chunk);
+}
+
+std::shared_ptr<VoiceClient> VoiceConnectionIndex::lookup(const Table &table, const AddressKey &key) {
+    auto& shard = table.address_shards[address_shard(key)];
+    if(!shard) {
+        return nullptr;
+    }
+
+    auto it = shard->clients.find(key);
+    return it == shard->clients.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<VoiceClient> VoiceConnectionIndex::lookup(const Table &table, ClientId client_id) {
+    auto chunk_index = client_id / kClientIdChunkSize;
+    if(chunk_index >= table.client_id_chunks.size() || !table.client_id_chunks[chunk_index]) {
+        return nullptr;
+    }
+
+    return table.client_id_chunks[chunk_index]->clients[client_id % kClientIdChunkSize];
+}
+
+void VoiceConnectionIndex::insert(const std::shared_ptr<VoiceClient> &connection) {
+    auto table = new Table{*this->table_.load()};
+
+    AddressKey key{};
+    if(AddressKey::from_address(connection->get_remote_address(), key)) {
+        /* The newest connection instance for an address wins */
+        set_address(*table, key, connection);
+    }
+
+    auto client_id = connection->getClientId();
+    if(client_id > 0) {
+        set_client_id(*table, client_id, connection);
+    }
+
+    this->publish(table);
+}
+
+void VoiceConnectionIndex::erase(const std::shared_ptr<VoiceClient> &connection) {
+    auto current_table = this->table_.load();
+    auto table = new Table{*current_table};
+
+    AddressKey key{};
+    if(AddressKey::from_address(connection->get_remote_address(), key) && lookup(*current_table, key) == connection) {
+        set_address(*table, key, nullptr);
+    }
+
+    auto client_id = connection->getClientId();
+    if(client_id > 0 && lookup(*current_table, client_id) == connection) {
+        set_client_id(*table, client_id, nullptr);
+    }
+
+    this->publish(table);
+}
+
+void VoiceConnectionIndex::update_address(const std::shared_ptr<VoiceClient> &connection, const sockaddr_storage &old_address) {
+    auto current_table = this->table_.load();
+    auto table = new Table{*current_table};
+
+    AddressKey key{};
+    if(AddressKey::from_address(old_address, key) && lookup(*current_table, key) == connection) {
+        set_address(*table, key, nullptr);
+    }
+
+    if(AddressKey::from_address(connection->get_remote_address(), key)) {
+        set_address(*table, key, connection);
+    }
+
+    this->publish(table);
+}
+
+void VoiceConnectionIndex::update_client_id(const std::shared_ptr<VoiceClient> &connection, ClientId old_client_id) {
+    auto current_table = this->table_.load();
+    auto table = new Table{*current_table};
+
+    if(old_client_id > 0 && lookup(*current_table, old_client_id) == connection) {
+        set_client_id(*table, old_client_id, nullptr);
+    }
+
+    auto client_id = connection->getClientId();
+    if(client_id > 0) {
+        set_client_id(*table, client_id, connection);
+    }
+
+    this->publish(table);
+}
+
+void VoiceConnectionIndex::clear() {
+    this->publish(new Table{});
+}
+
+void VoiceConnectionIndex::publish(Table *table) {
+    auto old_table = this->table_.exchange(table);
+    auto retire_epoch = ++global_epoch;
+    {
+        std::lock_guard retired_lock{this->retired_mutex};
+        this->retired_tables.push_back({ retire_epoch, old_table });
+    }
+
+    this->reclaim();
+}
+
+void VoiceConnectionIndex::reclaim() {
+    std::deque<Table*> free_tables{};
+    {
+        std::lock_guard retired_lock{this->retired_mutex};
+        if(this->retired_tables.empty() || unslotted_readers.load() > 0) {
+            return;
+        }
+
+        uint64_t oldest_reader_epoch{UINT64_MAX};
+        for(const auto& slot : reader_slots) {
+            auto epoch = slot.epoch.load();
+            if(epoch > 0 && epoch < oldest_reader_epoch) {
+                oldest_reader_epoch = epoch;
+            }
+        }
+
+        while(!this->retired_tables.empty() && this->retired_tables.front().epoch <= oldest_reader_epoch) {
+            free_tables.push_back(this->retired_tables.front().table);
+            this->retired_tables.pop_front();
+        }
+    }
+
+    /* This might release the last reference of a voice client, so don't hold the mutex */
+    for(const auto& table : free_tables) {
+        delete table;
+    }
+}
+
+std::shared_ptr<VoiceClient> VoiceConnectionIndex::find(ClientId client_id) const {
+    ReadGuard read_guard{};
+    auto table = this->table_.load();
+    if(!table) {
+        return nullptr;
+    }
+
+    return lookup(*table, client_id);
+}
+
+std::shared_ptr<VoiceClient> VoiceConnectionIndex::find(const sockaddr_storage &address) const {
+    AddressKey key{};
+    if(!AddressKey::from_address(address, key)) {
+        return nullptr;
+    }
+
+    ReadGuard read_guard{};
+    auto table = this->table_.load();
+    if(!table) {
+        return nullptr;
+    }
+
+    return lookup(*table, key);
+}
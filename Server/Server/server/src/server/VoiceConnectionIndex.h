@@ -0,0 +1,125 @@
+#pragma once
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <cstring>
+#include "Definitions.h"
+
+namespace ts::server {
+    class VoiceClient;
+
+    /**
+     * Compact and hashable representation of an IPv4 or IPv6 remote address including its port.
+     */
+    struct AddressKey {
+        uint64_t address_high{0};
+        uint64_t address_low{0};
+        uint32_t family_port{0};
+
+        [[nodiscard]] inline bool operator==(const AddressKey& other) const {
+            return this->address_high == other.address_high && this->address_low == other.address_low && this->family_port == other.family_port;
+        }
+
+        [[nodiscard]] static inline bool from_address(const sockaddr_storage& address, AddressKey& result) {
+            switch(address.ss_family) {
+                case AF_INET: {
+                    auto address_v4 = (const sockaddr_in*) &address;
+                    result.address_low = address_v4->sin_addr.s_addr;
+                    result.family_port = ((uint32_t) AF_INET << 16U) | address_v4->sin_port;
+                    return true;
+                }
+
+                case AF_INET6: {
+                    auto address_v6 = (const sockaddr_in6*) &address;
+                    memcpy(&result.address_high, address_v6->sin6_addr.s6_addr, 8);
+                    memcpy(&result.address_low, address_v6->sin6_addr.s6_addr + 8, 8);
+                    result.family_port = ((uint32_t) AF_INET6 << 16U) | address_v6->sin6_port;
+                    return true;
+                }
+
+                default:
+                    return false;
+            }
+        }
+    };
+
+    struct AddressKeyHash {
+        [[nodiscard]] inline size_t operator()(const AddressKey& key) const {
+            /* The port is the most random part of the remote address, so mix it into all bits */
+            auto hash = key.address_low ^ (key.address_high * 0x9E3779B97F4A7C15ULL) ^ ((uint64_t) key.family_port << 32U);
+            hash ^= hash >> 33U;
+            hash *= 0xFF51AFD7ED558CCDULL;
+            hash ^= hash >> 33U;
+            return (size_t) hash;
+        }
+    };
+
+    /**
+     * Lookup tables for all voice connections of a voice server, keyed by the remote address and the client id.
+     *
+     * The tables itself are immutable. The address table is split into shards and the client id table into chunks.
+     * A connection change copies the shard and chunk pointers, clones only the affected shard or chunk and
+     * publishes the new tables. Lookups never take a lock. Replaced tables are freed as soon as no reader
+     * could still access them (epoch based reclamation, see VoiceConnectionIndex.cpp).
+     *
+     * The caller must ensure that all modifications are serialized.
+     */
+    class VoiceConnectionIndex {
+        public:
+            VoiceConnectionIndex();
+            ~VoiceConnectionIndex();
+
+            /**
+             * Index a new connection by its remote address and client id.
+             * A connection which has been indexed for the same remote address before will be replaced.
+             */
+            void insert(const std::shared_ptr<VoiceClient>& /* connection */);
+
+            /**
+             * Remove the connection by its current remote address and client id.
+             * Entries which have been taken over by another connection are kept.
+             */
+            void erase(const std::shared_ptr<VoiceClient>& /* connection */);
+
+            /* Must be called after the remote address of the connection has been changed */
+            void update_address(const std::shared_ptr<VoiceClient>& /* connection */, const sockaddr_storage& /* old address */);
+
+            /* Must be called after the client id of the connection has been changed */
+            void update_client_id(const std::shared_ptr<VoiceClient>& /* connection */, ClientId /* old client id */);
+
+            void clear();
+
+            [[nodiscard]] std::shared_ptr<VoiceClient> find(ClientId /* client id */) const;
+            [[nodiscard]] std::shared_ptr<VoiceClient> find(const sockaddr_storage& /* remote address */) const;
+
+            /**
+             * Free all replaced tables which can't be accessed by any reader anymore.
+             */
+            void reclaim();
+        private:
+            struct Table;
+            struct RetiredTable {
+                uint64_t epoch;
+                Table* table;
+            };
+
+            std::atomic<Table*> table_;
+
+            std::mutex retired_mutex{};
+            std::deque<RetiredTable> retired_tables{};
+
+            /* Set (or clear if the connection is null) an entry of the new table */
+            static void set_address(Table& /* table */, const AddressKey& /* key */, const std::shared_ptr<VoiceClient>& /* connection */);
+            static void set_client_id(Table& /* table */, ClientId /* client id */, const std::shared_ptr<VoiceClient>& /* connection */);
+
+            [[nodiscard]] static std::shared_ptr<VoiceClient> lookup(const Table& /* table */, const AddressKey& /* key */);
+            [[nodiscard]] static std::shared_ptr<VoiceClient> lookup(const Table& /* table */, ClientId /* client id */);
+
+            /* Publish the new table and retire the current one */
+            void publish(Table* /* table */);
+    };
+}
@@ -0,0 +1,83 @@
+#include "VoiceFloodFilter.h"
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+using namespace ts::server;
+
+VoiceFloodFilter::VoiceFloodFilter(const Limits &limits) : limits{limits} {
+    std::random_device random_device{};
+    this->seed = ((uint64_t) random_device() << 32U) | random_device();
+
+    this->source_buckets = std::make_unique<std::array<Bucket, kSourceSlots>>();
+    this->prefix_buckets = std::make_unique<std::array<Bucket, kPrefixSlots>>();
+    this->update_clock();
+}
+
+void VoiceFloodFilter::update_clock() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    this->now_ms = (uint32_t) std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+}
+
+uint64_t VoiceFloodFilter::hash(AddressKey key) const {
+    key.address_low ^= this->seed;
+    key.address_high ^= this->seed * 0x9E3779B97F4A7C15ULL;
+
+    /* never zero since zero marks an unused bucket */
+    return (uint64_t) AddressKeyHash{}(key) | 1U;
+}
+
+bool VoiceFloodFilter::consume(Bucket &bucket, uint64_t tag, uint32_t rate, uint32_t burst) const {
+    const auto capacity = (uint64_t) burst * 1000;
+
+    if(bucket.tag != tag) {
+        bucket.tag = tag;
+        bucket.tokens = (uint32_t) capacity;
+    } else {
+        /* rate is given in packets per second, so the elapsed milliseconds times the rate are 1/1000 packets */
+        auto elapsed = (uint64_t) (uint32_t) (this->now_ms - bucket.last_update);
+        bucket.tokens = (uint32_t) std::min(capacity, bucket.tokens + elapsed * rate);
+    }
+    bucket.last_update = this->now_ms;
+
+    if(bucket.tokens < 1000) {
+        return false;
+    }
+
+    bucket.tokens -= 1000;
+    return true;
+}
+
+VoiceFloodFilter::Result VoiceFloodFilter::check(const sockaddr_storage &address) {
+    AddressKey source_key{};
+    if(!AddressKey::from_address(address, source_key)) {
+        return Result::ACCEPT;
+    }
+
+    auto source_hash = this->hash(source_key);
+    auto& source_bucket = (*this->source_buckets)[(source_hash >> 32U) % kSourceSlots];
+    if(!this->consume(source_bucket, source_hash, this->limits.source_rate, this->limits.source_burst)) {
+        return Result::DROP_SOURCE;
+    }
+
+    if(this->limits.prefix_rate == 0) {
+        return Result::ACCEPT;
+    }
+
+    /* /24 for IPv4 and /64 for IPv6. The port is not part of the prefix. */
+    AddressKey prefix_key{};
+    if(address.ss_family == AF_INET) {
+        prefix_key.address_low = source_key.address_low & htonl(0xFFFFFF00U);
+    } else {
+        prefix_key.address_high = source_key.address_high;
+    }
+    prefix_key.family_port = source_key.family_port & 0xFFFF0000U;
+
+    auto prefix_hash = this->hash(prefix_key);
+    auto& prefix_bucket = (*this->prefix_buckets)[(prefix_hash >> 32U) % kPrefixSlots];
+    if(!this->consume(prefix_bucket, prefix_hash, this->limits.prefix_rate, this->limits.prefix_burst)) {
+        return Result::DROP_PREFIX;
+    }
+
+    return Result::ACCEPT;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <array>
+#include <memory>
+#include <cstdint>
+#include "./VoiceConnectionIndex.h"
+
+namespace ts::server {
+    /**
+     * Rate limiter for incoming datagrams which is applied before the target client gets resolved.
+     *
+     * Every remote address has its own token bucket and shares a second one with all addresses of its
+     * /24 (IPv4) or /64 (IPv6) prefix. The buckets are stored within fixed size direct mapped tables.
+     * Colliding addresses replace each other and start with a full bucket, so a collision can only
+     * make the filter more permissive. Buckets are refilled based on the time elapsed since their last use.
+     *
+     * Attention: The filter is not thread save. Every network event owns its own filter.
+     */
+    class VoiceFloodFilter {
+        public:
+            constexpr static size_t kSourceSlots{4096};
+            constexpr static size_t kPrefixSlots{1024};
+
+            enum struct Result {
+                ACCEPT,
+                DROP_SOURCE,
+                DROP_PREFIX
+            };
+
+            struct Limits {
+                /* packets per second and max burst size in packets */
+                uint32_t source_rate{0};
+                uint32_t source_burst{0};
+                uint32_t prefix_rate{0};
+                uint32_t prefix_burst{0};
+            };
+
+            explicit VoiceFloodFilter(const Limits& /* limits */);
+
+            /**
+             * Update the filter clock.
+             * Should be called once per receive call and not for every datagram.
+             */
+            void update_clock();
+
+            [[nodiscard]] Result check(const sockaddr_storage& /* remote address */);
+
+        private:
+            struct Bucket {
+                uint64_t tag{0}; /* zero if unused */
+                uint32_t tokens{0}; /* 1/1000 packets */
+                uint32_t last_update{0};
+            };
+
+            Limits limits;
+
+            /* random seed to prevent targeted collisions */
+            uint64_t seed;
+            uint32_t now_ms{0};
+
+            std::unique_ptr<std::array<Bucket, kSourceSlots>> source_buckets;
+            std::unique_ptr<std::array<Bucket, kPrefixSlots>> prefix_buckets;
+
+            [[nodiscard]] uint64_t hash(AddressKey /* key */) const;
+            [[nodiscard]] bool consume(Bucket& /* bucket */, uint64_t /* tag */, uint32_t /* rate */, uint32_t /* burst */) const;
+    };
+}
@@ -83,6 +83,7 @@ bool VoiceServer::start(const std::deque<sockaddr_storage>& address_list, std::s
 
 void VoiceServer::tickHandshakingClients() {
     this->pow_handler->execute_tick();
+    this->connection_index.reclaim();
 
     decltype(this->activeConnections) connections;
     {
@@ -97,20 +98,6 @@ void VoiceServer::tickHandshakingClients() {
     }
 }
 
-void VoiceServer::execute_resend(const std::chrono::system_clock::time_point &now, std::chrono::system_clock::time_point &next) {
-    decltype(this->activeConnections) connections;
-    {
-        lock_guard lock(this->connectionLock);
-        connections = this->activeConnections;
-    }
-    string error;
-    for(const auto& client : connections) {
-        auto connection = client->getConnection();
-        sassert(connection); /* its not possible that a client hasn't a connection! */
-        connection->packet_encoder().execute_resend(now, next);
-    }
-}
-
 bool VoiceServer::stop(const std::chrono::milliseconds& flushTimeout) {
     if(!this->running) {
         return false;
@@ -129,10 +116,14 @@ bool VoiceServer::stop(const std::chrono::milliseconds& flushTimeout) {
         threads::self::sleep_for(milliseconds(10));
     }
 
-    for(const auto& connection : this->activeConnections) {
-        connection->voice_server = nullptr;
+    {
+        lock_guard lock(this->connectionLock);
+        for(const auto& connection : this->activeConnections) {
+            connection->voice_server = nullptr;
+        }
+        this->activeConnections.clear();
+        this->connection_index.clear();
     }
-    this->activeConnections.clear();
 
     auto tick_task_future = serverInstance->general_task_executor()->cancel_task_joinable(this->handshake_tick_task);
     if(tick_task_future.wait_for(std::chrono::seconds{5}) != std::future_status::ready) {
@@ -147,60 +138,35 @@ bool VoiceServer::stop(const std::chrono::milliseconds& flushTimeout) {
 }
 
 std::shared_ptr<VoiceClient> VoiceServer::findClient(ts::ClientId client) {
-    lock_guard lock(this->connectionLock);
-
-    for(const auto& elm : this->activeConnections) {
-        if(elm->getClientId() == client)
-            return elm;
-    }
-    return nullptr;
+    return this->connection_index.find(client);
 }
 
 std::shared_ptr<VoiceClient> VoiceServer::findClient(sockaddr_in *addr, bool) {
-    lock_guard lock(this->connectionLock);
-
-    /* Use a reverse iterator so we're getting the "last"/"newest" connection instance */
-    for(auto it{this->activeConnections.rbegin()}; it != this->activeConnections.rend(); it++) {
-        auto& elm = *it;
-        if(elm->isAddressV4()) {
-            if(elm->getAddressV4()->sin_addr.s_addr == addr->sin_addr.s_addr) {
-                if(elm->getAddressV4()->sin_port == addr->sin_port) {
-                    return elm;
-                }
-            }
-        }
-    }
-    return nullptr;
+    return this->connection_index.find(*(sockaddr_storage*) addr);
 }
 
 std::shared_ptr<VoiceClient> VoiceServer::findClient(sockaddr_in6 *addr, bool) {
-    lock_guard lock(this->connectionLock);
-
-    /* Use a reverse iterator so we're getting the "last"/"newest" connection instance */
-    for(auto it{this->activeConnections.rbegin()}; it != this->activeConnections.rend(); it++) {
-        auto& elm = *it;
-        if(elm->isAddressV6()) {
-            if(memcmp(elm->getAddressV6()->sin6_addr.__in6_u.__u6_addr8, addr->sin6_addr.__in6_u.__u6_addr8, 16) == 0) {
-                if(elm->getAddressV6()->sin6_port == addr->sin6_port) {
-                    return elm;
-                }
-            }
-        }
-    }
-
-    return nullptr;
+    return this->connection_index.find(*(sockaddr_storage*) addr);
 }
 
 bool VoiceServer::unregisterConnection(std::shared_ptr<VoiceClient> connection) {
     lock_guard lock(this->connectionLock);
 
     auto found = std::find(this->activeConnections.begin(), this->activeConnections.end(), connection);
-    if(found != activeConnections.end())
+    if(found != activeConnections.end()) {
         this->activeConnections.erase(found);
-    else logError(LOG_GENERAL, "unregisterConnection(...) -> could not find client");
+        this->connection_index.erase(connection);
+    } else {
+        logError(LOG_GENERAL, "unregisterConnection(...) -> could not find client");
+    }
     return true;
 }
 
+void VoiceServer::update_connection_client_id(const std::shared_ptr<VoiceClient> &connection, ClientId old_client_id) {
+    lock_guard lock(this->connectionLock);
+    this->connection_index.update_client_id(connection, old_client_id);
+}
+
 void VoiceServer::handleClientAddressChange(const std::shared_ptr<VoiceClient> &client,
                                             const sockaddr_storage &remote_address,
                                             const udp::pktinfo_storage &remote_address_info) {
@@ -209,6 +175,11 @@ void VoiceServer::handleClientAddressChange(const std::shared_ptr<VoiceClient> &
 
     auto command = "dummy_ipchange old_ip=" + old_address + " new_ip=" + new_address;
     client->server_command_queue()->enqueue_command_string(command);
-    memcpy(&client->remote_address, &remote_address, sizeof(remote_address));
-    memcpy(&client->connection->remote_address_info_, &remote_address_info, sizeof(remote_address_info));
+    {
+        lock_guard lock(this->connectionLock);
+        auto previous_address = client->get_remote_address();
+        memcpy(&client->remote_address, &remote_address, sizeof(remote_address));
+        memcpy(&client->connection->remote_address_info_, &remote_address_info, sizeof(remote_address_info));
+        this->connection_index.update_address(client, previous_address);
+    }
 }
\ No newline at end of file
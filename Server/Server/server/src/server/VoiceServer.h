@@ -1,19 +1,33 @@
 #pragma once
 
 #include <netinet/in.h>
+#include <sys/socket.h>
 #include <deque>
 #include <ThreadPool/Thread.h>
 #include <ThreadPool/Mutex.h>
 #include <event.h>
+#include <pipes/buffer.h>
 #include <condition_variable>
 #include <misc/net.h>
 #include <protocol/ringbuffer.h>
+#include <protocol/Packet.h>
 #include <misc/task_executor.h>
 #include "./voice/DatagramPacket.h"
+#include "./VoiceConnectionIndex.h"
+#include "./VoiceFloodFilter.h"
+#include "../LockProfiler.h"
 #include "Definitions.h"
 #include <shared_mutex>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <optional>
 
 namespace ts {
+    namespace protocol {
+        struct OutgoingServerPacket;
+    }
+
     namespace server {
         class VirtualServer;
         class VoiceServer;
@@ -22,16 +36,283 @@ namespace ts {
 
         class VoiceServerSocket : public std::enable_shared_from_this<VoiceServerSocket> {
             public:
+                constexpr static auto kReceiveBufferSize{1600}; //IPv6 MTU: 1500 | IPv4 MTU: 576
+                constexpr static auto kReceiveControlSize{0x100};
+                constexpr static auto kReceiveBatchBuckets{8};
+                constexpr static auto kTimerLagBuckets{12};
+
+                /* Upper bound for the time between two timer runs of a client (ping requests and timeouts) */
+                constexpr static std::chrono::milliseconds kClientTimerInterval{500};
+
+                /**
+                 * Preallocated receive slab used for `recvmmsg`.
+                 * Every network event owns its own batch since a read event will only be executed by one thread at a time.
+                 */
+                struct ReceiveBatch {
+                    struct Slot {
+                        sockaddr_storage address;
+                        iovec vector;
+                        char control[kReceiveControlSize];
+                        uint8_t buffer[kReceiveBufferSize];
+                    };
+
+                    const size_t capacity;
+                    std::unique_ptr<mmsghdr[]> headers;
+                    std::unique_ptr<Slot[]> slots;
+
+                    /*
+                     * Datagrams which have been resolved to a client.
+                     * They're processed grouped by their client so every connection only needs to be locked once per batch.
+                     */
+                    std::unique_ptr<std::optional<protocol::ClientPacketParser>[]> parsers;
+                    std::unique_ptr<std::shared_ptr<VoiceClient>[]> clients;
+                    std::unique_ptr<size_t[]> resolved;
+                    std::unique_ptr<protocol::ClientPacketParser*[]> client_packets;
+
+                    explicit ReceiveBatch(size_t /* capacity */);
+
+                    /* Resets the message headers after they've been modified by the kernel */
+                    void prepare();
+                };
+
+                /**
+                 * Receive statistics of one network event.
+                 * They're only written by the event loop owning the network event.
+                 */
+                struct ReceiveStatistics {
+                    std::atomic<uint64_t> receive_calls{0};
+                    std::atomic<uint64_t> datagrams_received{0};
+
+                    /* datagrams dropped by the flood filter */
+                    std::atomic<uint64_t> dropped_source{0};
+                    std::atomic<uint64_t> dropped_prefix{0};
+
+                    /* bucket n counts receive calls which returned between 2^n and 2^(n + 1) - 1 datagrams */
+                    std::array<std::atomic<uint64_t>, kReceiveBatchBuckets> batch_sizes{};
+
+                    inline void register_receive(size_t datagrams) {
+                        size_t bucket{0};
+                        while(datagrams >> (bucket + 1) && bucket + 1 < kReceiveBatchBuckets) {
+                            bucket++;
+                        }
+
+                        this->receive_calls.store(this->receive_calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                        this->datagrams_received.store(this->datagrams_received.load(std::memory_order_relaxed) + datagrams, std::memory_order_relaxed);
+                        this->batch_sizes[bucket].store(this->batch_sizes[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    }
+
+                    inline void register_drop(VoiceFloodFilter::Result result) {
+                        auto& counter = result == VoiceFloodFilter::Result::DROP_PREFIX ? this->dropped_prefix : this->dropped_source;
+                        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    }
+                };
+
+                constexpr static auto kSendControlSize{CMSG_SPACE(sizeof(in6_pktinfo)) + CMSG_SPACE(sizeof(uint16_t))};
+                constexpr static auto kGsoMaxSegments{64}; /* UDP_MAX_SEGMENTS */
+                constexpr static auto kGsoMaxPayload{0xFFFF - 0x100}; /* max UDP payload minus some space for the IP headers */
+
+                /**
+                 * Preallocated send slab used for `sendmmsg`.
+                 * Packets are collected per message. With GSO enabled a message may contain multiple
+                 * equally sized packets for the same client (only the last one may be shorter).
+                 */
+                struct SendBatch {
+                    struct Message {
+                        size_t client_index;
+                        size_t packet_offset;
+                        size_t packet_count;
+
+                        size_t segment_size;
+                        size_t payload_size;
+                        bool segments_closed;
+
+                        char control[kSendControlSize];
+                    };
+
+                    const size_t capacity;
+                    std::unique_ptr<mmsghdr[]> headers;
+                    std::unique_ptr<iovec[]> vectors;
+                    std::unique_ptr<Message[]> messages;
+
+                    std::unique_ptr<protocol::OutgoingServerPacket*[]> packets;
+                    std::unique_ptr<size_t[]> packet_client_index;
+
+                    /* holding a reference to all clients we've enqueued packets for */
+                    std::vector<std::shared_ptr<VoiceClient>> clients{};
+
+                    size_t packet_count{0};
+                    size_t message_count{0};
+
+                    explicit SendBatch(size_t /* capacity */);
+
+                    [[nodiscard]] inline bool full() const { return this->packet_count >= this->capacity; }
+                    [[nodiscard]] inline bool empty() const { return this->packet_count == 0; }
+
+                    /**
+                     * Append a packet for the last registered client.
+                     * The batch takes the ownership of the packet.
+                     */
+                    void append(protocol::OutgoingServerPacket* /* packet */, bool /* allow gso */);
+
+                    /* Write the control headers (pktinfo and gso segment size) of all messages */
+                    void finalize();
+
+                    /* Drop all client references, the packets must be handled already */
+                    void clear();
+                };
+
+                struct SendStatistics {
+                    std::atomic<uint64_t> send_calls{0};
+                    std::atomic<uint64_t> datagrams_sent{0};
+                    std::atomic<uint64_t> gso_messages{0};
+                    std::atomic<uint64_t> gso_segments{0};
+
+                    inline void register_send(size_t datagrams) {
+                        this->send_calls.store(this->send_calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                        this->datagrams_sent.store(this->datagrams_sent.load(std::memory_order_relaxed) + datagrams, std::memory_order_relaxed);
+                    }
+
+                    inline void register_gso(size_t segments) {
+                        this->gso_messages.store(this->gso_messages.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                        this->gso_segments.store(this->gso_segments.load(std::memory_order_relaxed) + segments, std::memory_order_relaxed);
+                    }
+                };
+
+                /**
+                 * Statistics of the client timers (command resends and pings) of one network event.
+                 * They're only written by the event loop owning the network event.
+                 */
+                struct TimerStatistics {
+                    std::atomic<uint64_t> timer_runs{0};
+                    std::atomic<uint64_t> clients_processed{0};
+                    std::atomic<uint64_t> registered_clients{0};
+
+                    /* bucket 0 counts lags below 1ms, bucket n lags between 2^(n - 1) and 2^n - 1 milliseconds */
+                    std::array<std::atomic<uint64_t>, kTimerLagBuckets> lags{};
+                    std::atomic<uint64_t> lag_max{0};
+
+                    inline void register_run(size_t clients_processed_, size_t registered_clients_) {
+                        this->timer_runs.store(this->timer_runs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                        this->clients_processed.store(this->clients_processed.load(std::memory_order_relaxed) + clients_processed_, std::memory_order_relaxed);
+                        this->registered_clients.store(registered_clients_, std::memory_order_relaxed);
+                    }
+
+                    inline void register_lag(const std::chrono::system_clock::duration& lag) {
+                        auto milliseconds = (uint64_t) std::max(std::chrono::duration_cast<std::chrono::milliseconds>(lag).count(), (int64_t) 0);
+
+                        size_t bucket{0};
+                        while(milliseconds >> bucket && bucket + 1 < kTimerLagBuckets) {
+                            bucket++;
+                        }
+
+                        this->lags[bucket].store(this->lags[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                        if(milliseconds > this->lag_max.load(std::memory_order_relaxed)) {
+                            this->lag_max.store(milliseconds, std::memory_order_relaxed);
+                        }
+                    }
+                };
+
+                struct StatisticsSnapshot {
+                    struct Shard {
+                        uint64_t datagrams_received{0};
+                        uint64_t datagrams_sent{0};
+
+                        uint64_t timer_clients{0};
+                        uint64_t timer_runs{0};
+                        uint64_t timer_clients_processed{0};
+                        uint64_t timer_lag_max{0};
+                        std::array<uint64_t, kTimerLagBuckets> timer_lags{};
+                    };
+
+                    /* zero if all network events share the same socket */
+                    size_t socket_shards{0};
+
+                    /* number of network events using the io_uring backend */
+                    size_t io_uring_events{0};
+
+                    /* contains one entry per network event */
+                    std::vector<Shard> shards{};
+
+                    size_t receive_batch_size{0};
+                    uint64_t receive_calls{0};
+                    uint64_t datagrams_received{0};
+                    std::array<uint64_t, kReceiveBatchBuckets> batch_sizes{};
+
+                    bool flood_filter{false};
+                    uint64_t dropped_source{0};
+                    uint64_t dropped_prefix{0};
+
+                    size_t send_batch_size{0};
+                    bool gso_enabled{false};
+                    uint64_t send_calls{0};
+                    uint64_t datagrams_sent{0};
+                    uint64_t gso_messages{0};
+                    uint64_t gso_segments{0};
+                };
+
+                /**
+                 * State of the io_uring network backend.
+                 * Defined in VoiceServerSocketIOUring.h since it's only available if compiled with HAVE_IO_URING.
+                 */
+                struct IOUringContext;
+
                 /**
-                 * Note: Only access event_read or event_write when the socket mutex is acquired or
-                 *       or within the event loop!
+                 * Note: Only access event_read or event_write when the socket mutex is acquired,
+                 *       within the event loop or as registered write producer!
                  */
                 struct NetworkEvents {
                     VoiceServerSocket* socket;
                     struct event* event_read{nullptr};
                     struct event* event_write{nullptr};
 
-                    NetworkEvents(VoiceServerSocket* socket) : socket{socket} {};
+                    /* The file descriptor used by the events. With socket sharding every network event has its own socket. */
+                    int file_descriptor{0};
+
+                    /*
+                     * Lock free MPSC write queues.
+                     * Producers push onto the head (LIFO). The event loop takes all pushed entries at once
+                     * and keeps them in FIFO order within the local list which is only accessed by the event loop.
+                     */
+                    std::atomic<udp::DatagramPacket*> write_datagram_head{nullptr};
+                    udp::DatagramPacket* write_datagram_local{nullptr};
+
+                    std::atomic<VoiceClient*> write_client_head{nullptr};
+                    VoiceClient* write_client_local{nullptr};
+
+                    /*
+                     * Client timers (command resends, pings and connection timeouts) of all clients owned by this network event.
+                     * New clients are registered via the lock free timer queue and processed immediately.
+                     * The client list is only accessed by the event loop.
+                     */
+                    struct TimerClient {
+                        std::shared_ptr<VoiceClient> client;
+                        std::chrono::system_clock::time_point deadline;
+                        bool woken;
+                    };
+
+                    struct event* event_timer{nullptr};
+                    std::atomic<VoiceClient*> timer_client_head{nullptr};
+                    std::vector<TimerClient> timer_clients{};
+                    TimerStatistics timer_statistics{};
+
+                    /* will be null if we're not using batched reads */
+                    std::unique_ptr<ReceiveBatch> receive_batch{nullptr};
+                    ReceiveStatistics receive_statistics{};
+
+                    /* will be null if the flood filter has been disabled */
+                    std::unique_ptr<VoiceFloodFilter> flood_filter{nullptr};
+
+                    /* will be null if we're not using batched writes */
+                    std::unique_ptr<SendBatch> send_batch{nullptr};
+                    SendStatistics send_statistics{};
+
+                    /*
+                     * Will be null if we're using the libevent backend.
+                     * Else event_read watches the completion event fd of the ring and not the socket.
+                     */
+                    std::unique_ptr<IOUringContext> io_uring{nullptr};
+
+                    explicit NetworkEvents(VoiceServerSocket* socket);
                     NetworkEvents(const NetworkEvents&) = delete;
                     NetworkEvents(NetworkEvents&&) = delete;
                     ~NetworkEvents();
@@ -54,30 +335,45 @@ namespace ts {
                  */
                 void deactivate();
 
-                inline void send_datagram(udp::DatagramPacket* datagram) {
-                    assert(!datagram->next_packet);
-                    datagram->next_packet = nullptr;
+                /**
+                 * Accumulate the receive and send statistics of all network events.
+                 */
+                [[nodiscard]] StatisticsSnapshot statistics();
 
-                    std::lock_guard lock{this->mutex};
-                    if(!this->file_descriptor) {
-                        udp::DatagramPacket::destroy(datagram);
-                        return;
-                    }
+                /**
+                 * Enqueue a raw datagram (e.g. a handshake response) for sending.
+                 * The socket takes the ownership of the datagram.
+                 */
+                void send_datagram(udp::DatagramPacket* /* datagram */);
 
-                    *this->write_datagram_tail = datagram;
-                    this->write_datagram_tail = &datagram->next_packet;
-                    this->enqueue_network_write();
-                }
+                /**
+                 * Schedule a write for the target client.
+                 * A client will be enqueued at most once until the event loop starts to flush it.
+                 * The remote address is used to select the socket shard the client belongs to.
+                 * This method is lock free.
+                 */
+                void enqueue_client_write(VoiceClient* /* client */);
 
-                inline void enqueue_client_write(std::weak_ptr<VoiceClient> client) {
-                    std::lock_guard lock{this->mutex};
-                    if(!this->file_descriptor) {
-                        return;
-                    }
+                /**
+                 * Wake up the client timer on the network event loop owning the client.
+                 * The client will stay registered until it has been disconnected. It will be visited at least every
+                 * kClientTimerInterval and whenever one of its command packets is due for a resend.
+                 * Must be called after new command packets are awaiting an acknowledge.
+                 * This method is lock free.
+                 */
+                void schedule_client_timer(VoiceClient* /* client */);
 
-                    this->write_client_queue.push_back(std::move(client));
-                    this->enqueue_network_write();
-                }
+                /**
+                 * Calculate the socket shard for a remote address.
+                 * This must match the classic BPF steering program attached to the reuse port group.
+                 */
+                [[nodiscard]] static size_t calculate_shard(const sockaddr_storage& /* address */, size_t /* shard count */);
+
+                /**
+                 * Returns true if every network event owns its own socket shard.
+                 * All datagrams of one remote address will then be received by the same event loop.
+                 */
+                [[nodiscard]] inline bool sharded() const { return this->socket_shards > 0; }
 
             private:
                 ServerId server_id;
@@ -86,62 +382,116 @@ namespace ts {
 
                 std::mutex mutex{};
                 int file_descriptor{0};
+
+                /* zero if all network events share the same socket */
+                size_t socket_shards{0};
+
+                /* UDP generic segmentation offload. Will be disabled if the kernel or the NIC does not support it. */
+                std::atomic<bool> gso_enabled{false};
                 std::vector<std::unique_ptr<NetworkEvents>> network_events{};
-                size_t network_write_index{0};
+                std::atomic<size_t> network_write_index{0};
 
-                udp::DatagramPacket* write_datagram_head{nullptr};
-                udp::DatagramPacket** write_datagram_tail{&this->write_datagram_head};
-                std::deque<std::weak_ptr<VoiceClient>> write_client_queue;
+                /*
+                 * Producers of the write queues are only allowed to access network_events while writes are accepted.
+                 * deactivate() waits until all producers left before it clears network_events.
+                 */
+                std::atomic<bool> writes_accepted{false};
+                std::atomic<size_t> write_producers{0};
 
-                inline udp::DatagramPacket* pop_dg_write_queue() {
-                    std::lock_guard lock{this->mutex};
-                    if(!this->write_datagram_head) {
-                        return nullptr;
-                    }
+                /* Attention: Must only be called from within the event loop of the network events! */
+                udp::DatagramPacket* pop_dg_write_queue(NetworkEvents* /* events */);
+                bool pop_voice_write_queue(NetworkEvents* /* events */, std::shared_ptr<VoiceClient>& /* result */);
 
-                    auto packet = std::exchange(this->write_datagram_head, this->write_datagram_head->next_packet);
-                    if(!this->write_datagram_head) {
-                        assert(this->write_datagram_tail == &packet->next_packet);
-                        this->write_datagram_tail = &this->write_datagram_head;
+                /**
+                 * Select the network events which should write to the target address.
+                 * With socket sharding this will be the shard the remote address is pinned to.
+                 * Attention: Writes must be accepted and the caller must be registered as write producer!
+                 */
+                inline NetworkEvents* select_write_events(const sockaddr_storage& remote_address) {
+                    assert(!this->network_events.empty());
+                    if(this->socket_shards > 0) {
+                        return &*this->network_events[VoiceServerSocket::calculate_shard(remote_address, this->network_events.size())];
                     }
 
-                    return packet;
+                    return &*this->network_events[this->network_write_index.fetch_add(1, std::memory_order_relaxed) % this->network_events.size()];
                 }
 
-                inline bool pop_voice_write_queue(std::shared_ptr<VoiceClient>& result) {
-                    std::lock_guard lock{this->mutex};
+                /**
+                 * Select the network events owning the client timers.
+                 * The owner is picked by the remote address when the client gets scheduled the first time and kept afterwards,
+                 * so an address change never lets two event loops process the timers of the same client.
+                 * Attention: Writes must be accepted and the caller must be registered as write producer!
+                 */
+                NetworkEvents* select_timer_events(VoiceClient* /* client */);
 
-                    auto it_begin = this->write_client_queue.begin();
-                    auto it_end = this->write_client_queue.end();
-                    auto it = it_begin;
+                /**
+                 * Allocate, configure and bind a new UDP socket.
+                 * @return the file descriptor or zero on failure
+                 */
+                [[nodiscard]] int create_socket(bool /* reuse port */, std::string& /* error */);
 
-                    while(it != it_end) {
-                        result = it->lock();
-                        if(result) {
-                            this->write_client_queue.erase(it_begin, ++it);
-                            return it != it_end;
-                        }
-                        it++;
-                    }
+                /**
+                 * Attach the classic BPF program steering remote addresses to the socket shards.
+                 */
+                [[nodiscard]] bool attach_shard_steering(std::string& /* error */);
 
-                    if(it_begin != it_end) {
-                        this->write_client_queue.erase(it_begin, it_end);
-                    }
-                    return false;
-                }
+                /**
+                 * Dispatch a received datagram to the POW handler or the target client.
+                 * Attention: Must only be called from within the event loop!
+                 */
+                void handle_datagram(NetworkEvents* /* events */, sockaddr_storage& /* remote address */, msghdr& /* message */, const pipes::buffer_view& /* buffer */);
 
                 /**
-                 * Enqueue a write event.
-                 * Attention: The socket mutex must be locked!
+                 * Resolve the target client of a received datagram.
+                 * Datagrams exceeding the flood filter limits will be dropped before anything else.
+                 * INIT datagrams will be passed to the POW handler.
+                 * @returns the target client or an empty pointer if the datagram has been consumed or should be dropped
+                 * Attention: Must only be called from within the event loop!
                  */
-                inline void enqueue_network_write() {
-                    assert(!this->network_events.empty());
-                    auto write_event = this->network_events[this->network_write_index++ % this->network_events.size()]->event_write;
-                    event_add(write_event, nullptr);
-                }
+                [[nodiscard]] std::shared_ptr<VoiceClient> resolve_datagram(NetworkEvents* /* events */, sockaddr_storage& /* remote address */, msghdr& /* message */, protocol::ClientPacketParser& /* packet */);
+
+                void log_truncated_datagram(const sockaddr_storage& /* remote address */);
+
+                void read_datagrams(NetworkEvents* /* events */);
+                void read_datagrams_batched(NetworkEvents* /* events */);
+
+                /**
+                 * Write the pending client packets.
+                 * Returns false if the socket would block.
+                 */
+                [[nodiscard]] bool write_client_packets(NetworkEvents* /* events */, bool& /* more clients */);
+                [[nodiscard]] bool write_client_packets_batched(NetworkEvents* /* events */, bool& /* more clients */);
+
+                /**
+                 * Flush the send batch with `sendmmsg`.
+                 * Returns false if the socket would block. All unsent packets have been reenqueued in that case.
+                 */
+                [[nodiscard]] bool flush_send_batch(NetworkEvents* /* events */);
+
+                /**
+                 * Setup the io_uring backend for the network events.
+                 * This will arm the multishot receive on the events socket.
+                 * Returns false if io_uring isn't supported by the kernel or the server has been compiled without it.
+                 */
+                [[nodiscard]] bool initialize_io_uring(NetworkEvents* /* events */, std::string& /* error */);
+
+                /**
+                 * Submit sends for the pending client packets.
+                 * Returns false if all send slots are in use. The send completions will rearm the write event.
+                 */
+                [[nodiscard]] bool write_client_packets_io_uring(NetworkEvents* /* events */, bool& /* more clients */);
+                void process_io_uring_completions(NetworkEvents* /* events */);
+
+                /**
+                 * Execute the resends and ping ticks of all due clients and rearm the timer.
+                 * Attention: Must only be called from within the event loop!
+                 */
+                void process_client_timers(NetworkEvents* /* events */);
 
                 static void network_event_read(int, short, void *);
                 static void network_event_write(int, short, void *);
+                static void network_event_io_uring(int, short, void *);
+                static void network_event_timer(int, short, void *);
         };
 
         class VoiceServer {
@@ -154,6 +504,7 @@ namespace ts {
                 bool start(const std::deque<sockaddr_storage>&, std::string&);
                 bool stop(const std::chrono::milliseconds& flushTimeout = std::chrono::milliseconds{1000});
 
+                /* All client lookups are lock free and served by the connection index */
                 [[nodiscard]] std::shared_ptr<VoiceClient> findClient(ClientId);
                 [[nodiscard]] std::shared_ptr<VoiceClient> findClient(sockaddr_in* addr, bool lock);
                 [[nodiscard]] std::shared_ptr<VoiceClient> findClient(sockaddr_in6* addr, bool lock);
@@ -178,8 +529,13 @@ namespace ts {
                 [[nodiscard]] inline std::shared_ptr<VirtualServer> get_server() { return this->server; }
 
                 void tickHandshakingClients();
-                void execute_resend(const std::chrono::system_clock::time_point& /* now */, std::chrono::system_clock::time_point& /* next resend */);
                 bool unregisterConnection(std::shared_ptr<VoiceClient>);
+
+                /**
+                 * Update the connection index.
+                 * Must be called after the client id of a connection has changed.
+                 */
+                void update_connection_client_id(const std::shared_ptr<VoiceClient>& /* connection */, ClientId /* old client id */);
             private:
                 std::unique_ptr<POWHandler> pow_handler;
                 std::shared_ptr<VirtualServer> server{nullptr};
@@ -191,8 +547,9 @@ namespace ts {
 
                 task_id handshake_tick_task{0};
 
-                std::recursive_mutex connectionLock;
+                lock_profiler::profiled_mutex_t<std::recursive_mutex, "VoiceServer::connectionLock"> connectionLock{};
                 std::deque<std::shared_ptr<VoiceClient>> activeConnections;
+                VoiceConnectionIndex connection_index{};
 
                 void handleClientAddressChange(
                         const std::shared_ptr<VoiceClient>& /* voice client */,
@@ -7,12 +7,15 @@
 #include <algorithm>
 #include <unistd.h>
 #include <fcntl.h>
+#include <netinet/udp.h>
+#include <linux/filter.h>
 #include "../client/voice/VoiceClient.h"
 #include <log/LogUtils.h>
 #include <misc/endianness.h>
 #include "src/VirtualServerManager.h"
 #include "../InstanceHandler.h"
 #include "./GlobalNetworkEvents.h"
+#include "./VoiceServerSocketIOUring.h"
 
 using namespace std;
 using namespace std::chrono;
@@ -20,9 +23,12 @@ using namespace ts::server;
 using namespace ts::buffer;
 using namespace ts;
 
+VoiceServerSocket::NetworkEvents::NetworkEvents(VoiceServerSocket *socket) : socket{socket} { }
+
 VoiceServerSocket::NetworkEvents::~NetworkEvents() {
     auto event_read_ = std::exchange(this->event_read, nullptr);
     auto event_write_ = std::exchange(this->event_write, nullptr);
+    auto event_timer_ = std::exchange(this->event_timer, nullptr);
 
     if(event_read_) {
         event_free(event_read_);
@@ -31,6 +37,159 @@ VoiceServerSocket::NetworkEvents::~NetworkEvents() {
     if(event_write_) {
         event_free(event_write_);
     }
+
+    if(event_timer_) {
+        event_free(event_timer_);
+    }
+}
+
+VoiceServerSocket::ReceiveBatch::ReceiveBatch(size_t capacity) : capacity{capacity} {
+    this->headers = std::make_unique<mmsghdr[]>(capacity);
+    this->slots = std::make_unique<Slot[]>(capacity);
+    this->parsers = std::make_unique<std::optional<protocol::ClientPacketParser>[]>(capacity);
+    this->clients = std::make_unique<std::shared_ptr<VoiceClient>[]>(capacity);
+    this->resolved = std::make_unique<size_t[]>(capacity);
+    this->client_packets = std::make_unique<protocol::ClientPacketParser*[]>(capacity);
+
+    for(size_t index{0}; index < capacity; index++) {
+        auto& slot = this->slots[index];
+        slot.vector.iov_base = slot.buffer;
+        slot.vector.iov_len = kReceiveBufferSize;
+
+        auto& header = this->headers[index].msg_hdr;
+        header.msg_name = &slot.address;
+        header.msg_iov = &slot.vector;
+        header.msg_iovlen = 1;
+        header.msg_control = slot.control;
+    }
+
+    this->prepare();
+}
+
+void VoiceServerSocket::ReceiveBatch::prepare() {
+    for(size_t index{0}; index < this->capacity; index++) {
+        auto& header = this->headers[index];
+        header.msg_len = 0;
+        header.msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        header.msg_hdr.msg_controllen = kReceiveControlSize;
+        header.msg_hdr.msg_flags = 0;
+    }
+}
+
+VoiceServerSocket::SendBatch::SendBatch(size_t capacity) : capacity{capacity} {
+    this->headers = std::make_unique<mmsghdr[]>(capacity);
+    this->vectors = std::make_unique<iovec[]>(capacity);
+    this->messages = std::make_unique<Message[]>(capacity);
+    this->packets = std::make_unique<protocol::OutgoingServerPacket*[]>(capacity);
+    this->packet_client_index = std::make_unique<size_t[]>(capacity);
+}
+
+void VoiceServerSocket::SendBatch::append(protocol::OutgoingServerPacket *packet, bool allow_gso) {
+    assert(!this->full());
+    assert(!this->clients.empty());
+
+    const auto client_index = this->clients.size() - 1;
+    const auto packet_length = packet->packet_length();
+
+    auto packet_index = this->packet_count++;
+    this->packets[packet_index] = packet;
+    this->packet_client_index[packet_index] = client_index;
+
+    auto& vector = this->vectors[packet_index];
+    vector.iov_base = (void*) packet->packet_data();
+    vector.iov_len = packet_length;
+
+    if(allow_gso && this->message_count > 0) {
+        auto& message = this->messages[this->message_count - 1];
+        auto& header = this->headers[this->message_count - 1].msg_hdr;
+
+        /*
+         * All segments of a GSO message must have the same size, only the last segment might be shorter.
+         * Since the vectors of the last message are always the tailing vectors we can just extend the message.
+         */
+        if(message.client_index == client_index && !message.segments_closed &&
+                packet_length <= message.segment_size &&
+                message.packet_count < kGsoMaxSegments &&
+                message.payload_size + packet_length <= kGsoMaxPayload) {
+            message.packet_count++;
+            message.payload_size += packet_length;
+            message.segments_closed = packet_length < message.segment_size;
+            header.msg_iovlen = message.packet_count;
+            return;
+        }
+    }
+
+    auto& message = this->messages[this->message_count];
+    message.client_index = client_index;
+    message.packet_offset = packet_index;
+    message.packet_count = 1;
+    message.segment_size = packet_length;
+    message.payload_size = packet_length;
+    message.segments_closed = false;
+
+    auto& client = this->clients[client_index];
+    auto& header = this->headers[this->message_count].msg_hdr;
+    header.msg_name = (void*) &client->get_remote_address();
+    header.msg_namelen = client->get_remote_address().ss_family == AF_INET ? sizeof(sockaddr_in) : sizeof(sockaddr_in6);
+    header.msg_iov = &vector;
+    header.msg_iovlen = 1;
+    header.msg_flags = 0;
+
+    this->message_count++;
+}
+
+void VoiceServerSocket::SendBatch::finalize() {
+    for(size_t index{0}; index < this->message_count; index++) {
+        auto& message = this->messages[index];
+        auto& header = this->headers[index].msg_hdr;
+        auto& client = this->clients[message.client_index];
+        const auto& address = client->get_remote_address();
+        const auto& address_info = client->getConnection()->remote_address_info();
+
+        header.msg_control = message.control;
+        header.msg_controllen = sizeof(message.control);
+
+        size_t control_length{0};
+        auto cmsg = CMSG_FIRSTHDR(&header);
+        if(address.ss_family == AF_INET) {
+            cmsg->cmsg_level = IPPROTO_IP;
+            cmsg->cmsg_type = IP_PKTINFO;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(in_pktinfo));
+            memcpy(CMSG_DATA(cmsg), &address_info, sizeof(in_pktinfo));
+
+            control_length += CMSG_SPACE(sizeof(in_pktinfo));
+            cmsg = CMSG_NXTHDR(&header, cmsg);
+        } else if(address.ss_family == AF_INET6) {
+            cmsg->cmsg_level = IPPROTO_IPV6;
+            cmsg->cmsg_type = IPV6_PKTINFO;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(in6_pktinfo));
+            memcpy(CMSG_DATA(cmsg), &address_info, sizeof(in6_pktinfo));
+
+            control_length += CMSG_SPACE(sizeof(in6_pktinfo));
+            cmsg = CMSG_NXTHDR(&header, cmsg);
+        }
+
+        if(message.packet_count > 1) {
+            assert(cmsg);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            *(uint16_t*) CMSG_DATA(cmsg) = (uint16_t) message.segment_size;
+
+            control_length += CMSG_SPACE(sizeof(uint16_t));
+        }
+
+        header.msg_controllen = control_length;
+        if(!control_length) {
+            header.msg_control = nullptr;
+        }
+    }
+}
+
+void VoiceServerSocket::SendBatch::clear() {
+    this->packet_count = 0;
+    this->message_count = 0;
+    this->clients.clear();
 }
 
 VoiceServerSocket::VoiceServerSocket(VoiceServer *server, sockaddr_storage address) : server{server}, server_id{server->get_server()->getServerId()}, address_{address} { }
@@ -40,69 +199,256 @@ VoiceServerSocket::~VoiceServerSocket() {
     this->deactivate();
 }
 
-bool VoiceServerSocket::activate(std::string &error) {
-    this->file_descriptor = socket(this->address_.ss_family, SOCK_DGRAM, 0);
-    if(this->file_descriptor <= 0) {
-        this->file_descriptor = 0;
+int VoiceServerSocket::create_socket(bool reuse_port, std::string &error) {
+    auto file_descriptor = socket(this->address_.ss_family, SOCK_DGRAM, 0);
+    if(file_descriptor <= 0) {
         error = "failed to allocate new socket";
-        return false;
+        return 0;
     }
 
     int enable = 1, disable = 0;
-    if(setsockopt(this->file_descriptor, SOL_SOCKET, SO_REUSEADDR, &disable, sizeof(int)) < 0) {
+    if(setsockopt(file_descriptor, SOL_SOCKET, SO_REUSEADDR, &disable, sizeof(int)) < 0) {
         logError(server_id, "Could not disable flag reuse address for bind {}!", net::to_string(this->address_));
     }
 
-    /*
-    if(setsockopt(this->file_descriptor, SOL_SOCKET, SO_REUSEPORT, &disable, sizeof(int)) < 0) {
-        logError(server_id, "Could not disable flag reuse port for bind {}!", net::to_string(this->address_));
+    if(reuse_port) {
+        /* Required for socket sharding. All shards are bound to the same address. */
+        if(setsockopt(file_descriptor, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(int)) < 0) {
+            error = "failed to enable SO_REUSEPORT";
+            goto create_failed;
+        }
     }
-    */
 
     /* We're never sending over MTU size packets! */
-    int pmtu{IP_PMTUDISC_DO};
-    setsockopt(this->file_descriptor, IPPROTO_IP, IP_MTU_DISCOVER, &pmtu, sizeof(pmtu));
+    {
+        int pmtu{IP_PMTUDISC_DO};
+        setsockopt(file_descriptor, IPPROTO_IP, IP_MTU_DISCOVER, &pmtu, sizeof(pmtu));
+    }
 
-    if(fcntl(this->file_descriptor, F_SETFD, FD_CLOEXEC) < 0) {
+    if(fcntl(file_descriptor, F_SETFD, FD_CLOEXEC) < 0) {
         error = "failed to enable FD_CLOEXEC";
-        goto bind_failed;
+        goto create_failed;
     }
 
     if(this->address_.ss_family == AF_INET6) {
-        if(setsockopt(this->file_descriptor, IPPROTO_IPV6, IPV6_RECVPKTINFO, &enable, sizeof(enable)) < 0) {
+        if(setsockopt(file_descriptor, IPPROTO_IPV6, IPV6_RECVPKTINFO, &enable, sizeof(enable)) < 0) {
             error = "failed to enable IPV6_RECVPKTINFO";
-            goto bind_failed;
+            goto create_failed;
         }
 
-        if(setsockopt(this->file_descriptor, IPPROTO_IPV6, IPV6_V6ONLY, &enable, sizeof(enable)) < 0) {
+        if(setsockopt(file_descriptor, IPPROTO_IPV6, IPV6_V6ONLY, &enable, sizeof(enable)) < 0) {
             error = "failed to enable IPV6_V6ONLY";
-            goto bind_failed;
+            goto create_failed;
         }
     } else {
-        if(setsockopt(this->file_descriptor, IPPROTO_IP, IP_PKTINFO, &enable, sizeof(enable)) < 0) {
+        if(setsockopt(file_descriptor, IPPROTO_IP, IP_PKTINFO, &enable, sizeof(enable)) < 0) {
             error = "failed to enable IP_PKTINFO";
-            goto bind_failed;
+            goto create_failed;
         }
     }
 
-    if(::bind(this->file_descriptor, (const sockaddr*) &this->address_, net::address_size(this->address_)) < 0) {
+    if(::bind(file_descriptor, (const sockaddr*) &this->address_, net::address_size(this->address_)) < 0) {
         error = "bind failed: " + std::string{strerror(errno)} + " (" + std::to_string(errno) + ")";
-        goto bind_failed;
+        goto create_failed;
     }
 
-    fcntl(this->file_descriptor, F_SETFL, fcntl(this->file_descriptor, F_GETFL, 0) | O_NONBLOCK);
+    fcntl(file_descriptor, F_SETFL, fcntl(file_descriptor, F_GETFL, 0) | O_NONBLOCK);
+    return file_descriptor;
 
-    {
-        const auto& network_loop = serverInstance->network_event_loop();
-        const auto network_event_count = std::min(network_loop->loop_count(), ts::config::threads::voice::events_per_server);
+    create_failed:
+    ::close(file_descriptor);
+    return 0;
+}
 
+size_t VoiceServerSocket::calculate_shard(const sockaddr_storage &address, size_t shard_count) {
+    uint32_t hash;
+    if(address.ss_family == AF_INET) {
+        hash = ntohl(((const sockaddr_in*) &address)->sin_addr.s_addr);
+    } else if(address.ss_family == AF_INET6) {
+        auto address_words = (const uint32_t*) ((const sockaddr_in6*) &address)->sin6_addr.s6_addr;
+        hash = ntohl(address_words[0]) ^ ntohl(address_words[1]) ^ ntohl(address_words[2]) ^ ntohl(address_words[3]);
+    } else {
+        return 0;
+    }
+
+    hash ^= hash >> 16U;
+    return hash % shard_count;
+}
+
+bool VoiceServerSocket::attach_shard_steering(std::string &error) {
+    /*
+     * The program gets executed with the UDP payload at offset zero.
+     * We're reading the source address from the network header and calculate the same hash as calculate_shard(...).
+     * The return value is the index of the socket within the reuse port group which equals the shard index since
+     * we're binding the shards in order.
+     */
+    std::vector<sock_filter> program{};
+    if(this->address_.ss_family == AF_INET) {
+        program.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, (uint32_t) (SKF_NET_OFF + 12)));
+    } else {
+        program.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, (uint32_t) (SKF_NET_OFF + 8)));
+        for(uint32_t offset : { 12, 16, 20 }) {
+            program.push_back(BPF_STMT(BPF_MISC | BPF_TAX, 0));
+            program.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, (uint32_t) (SKF_NET_OFF + offset)));
+            program.push_back(BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0));
+        }
+    }
+
+    program.push_back(BPF_STMT(BPF_MISC | BPF_TAX, 0));
+    program.push_back(BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 16));
+    program.push_back(BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0));
+    program.push_back(BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, (uint32_t) this->network_events.size()));
+    program.push_back(BPF_STMT(BPF_RET | BPF_A, 0));
+
+    sock_fprog program_header{};
+    program_header.len = (unsigned short) program.size();
+    program_header.filter = program.data();
+
+    if(setsockopt(this->file_descriptor, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program_header, sizeof(program_header)) < 0) {
+        error = "failed to attach reuse port steering program: " + std::string{strerror(errno)};
+        return false;
+    }
+
+    return true;
+}
+
+bool VoiceServerSocket::activate(std::string &error) {
+    const auto& network_loop = serverInstance->network_event_loop();
+    const auto socket_shards = std::min(network_loop->loop_count(), ts::config::voice::socket_shards);
+    const auto sharded = socket_shards > 1;
+    const auto network_event_count = sharded ? socket_shards : std::min(network_loop->loop_count(), ts::config::threads::voice::events_per_server);
+
+    const auto receive_batch_size = ts::config::voice::receive_batch_size;
+    const auto send_batch_size = ts::config::voice::send_batch_size;
+    const auto use_io_uring = ts::config::voice::io_backend == "io_uring";
+
+    VoiceFloodFilter::Limits flood_limits{};
+    flood_limits.source_rate = (uint32_t) ts::config::voice::flood_source_rate;
+    flood_limits.source_burst = (uint32_t) ts::config::voice::flood_source_burst;
+    flood_limits.prefix_rate = (uint32_t) ts::config::voice::flood_prefix_rate;
+    flood_limits.prefix_burst = (uint32_t) ts::config::voice::flood_prefix_burst;
+
+    this->file_descriptor = this->create_socket(sharded, error);
+    if(!this->file_descriptor) {
+        return false;
+    }
+
+    if(send_batch_size > 1 && ts::config::voice::send_gso) {
+        /* The kernel supports UDP GSO (Linux 4.18+) if we could query the segment size */
+        int segment_size{0};
+        socklen_t segment_size_length{sizeof(segment_size)};
+        if(getsockopt(this->file_descriptor, SOL_UDP, UDP_SEGMENT, &segment_size, &segment_size_length) == 0) {
+            this->gso_enabled = true;
+        } else {
+            logWarning(server_id, "Kernel does not support UDP GSO for bind {}. Using plain batched writes.", net::to_string(this->address_));
+        }
+    }
+
+    {
         std::lock_guard write_lock{this->mutex};
+        this->socket_shards = sharded ? socket_shards : 0;
+
+        /*
+         * Create all network events (and their shard sockets) first.
+         * The io_uring backend is all or nothing: If one ring can't be set up we're using libevent for every event,
+         * else the clients of one binding would be served by two different backends.
+         */
+        std::vector<std::unique_ptr<NetworkEvents>> pending_events{};
+        pending_events.reserve(network_event_count);
+        for(size_t index{0}; index < network_event_count; index++) {
+            auto& events = pending_events.emplace_back(std::make_unique<NetworkEvents>(this));
+            if(receive_batch_size > 1) {
+                events->receive_batch = std::make_unique<ReceiveBatch>(receive_batch_size);
+            }
+
+            if(send_batch_size > 1) {
+                events->send_batch = std::make_unique<SendBatch>(send_batch_size);
+            }
+
+            if(flood_limits.source_rate > 0) {
+                events->flood_filter = std::make_unique<VoiceFloodFilter>(flood_limits);
+            }
+
+            if(!sharded) {
+                events->file_descriptor = this->file_descriptor;
+                continue;
+            }
+
+            /* We can't tolerate any missing shard since the steering program expects all of them. */
+            events->file_descriptor = index == 0 ? this->file_descriptor : this->create_socket(true, error);
+            if(!events->file_descriptor) {
+                error = "failed to create socket shard " + std::to_string(index) + ": " + error;
+                for(auto& pending : pending_events) {
+                    this->network_events.emplace_back(std::move(pending));
+                }
+                goto bind_failed;
+            }
+        }
+
+        if(use_io_uring) {
+            for(auto& events : pending_events) {
+                std::string io_uring_error{};
+                if(this->initialize_io_uring(&*events, io_uring_error)) {
+                    continue;
+                }
+
+                logWarning(server_id, "Failed to initialize io_uring for voice server binding {} ({}). Falling back to libevent.", net::to_string(this->address_), io_uring_error);
+                for(auto& initialized_events : pending_events) {
+                    initialized_events->io_uring = nullptr;
+                }
+                break;
+            }
+        }
+
         NetworkEventLoopUseList* read_use_list{nullptr};
         NetworkEventLoopUseList* write_use_list{nullptr};
         for(size_t index{0}; index < network_event_count; index++) {
-            auto events = std::make_unique<NetworkEvents>(this);
-            events->event_read = network_loop->allocate_event(this->file_descriptor, EV_READ | EV_PERSIST, VoiceServerSocket::network_event_read, &*events, &read_use_list);
-            events->event_write = network_loop->allocate_event(this->file_descriptor, EV_WRITE, VoiceServerSocket::network_event_write, &*events, &write_use_list);
+            auto events = std::move(pending_events[index]);
+            if(sharded) {
+                /*
+                 * Every shard has its own socket and both events are pinned to the same event loop.
+                 * This way receive, decode and send of a client will stay on the same thread.
+                 */
+                if(events->io_uring) {
+                    events->event_read = network_loop->allocate_event_on(index, events->io_uring->event_fd, EV_READ | EV_PERSIST, VoiceServerSocket::network_event_io_uring, &*events);
+                } else {
+                    events->event_read = network_loop->allocate_event_on(index, events->file_descriptor, EV_READ | EV_PERSIST, VoiceServerSocket::network_event_read, &*events);
+                }
+                events->event_write = network_loop->allocate_event_on(index, events->file_descriptor, EV_WRITE, VoiceServerSocket::network_event_write, &*events);
+                events->event_timer = network_loop->allocate_event_on(index, -1, 0, VoiceServerSocket::network_event_timer, &*events);
+
+                auto& events_ref = *events;
+                this->network_events.emplace_back(std::move(events));
+                if(!events_ref.event_read || !events_ref.event_write || !events_ref.event_timer) {
+                    error = "failed to allocate network events for socket shard " + std::to_string(index);
+
+                    /* the remaining shard sockets have to be closed as well */
+                    for(auto& pending : pending_events) {
+                        if(pending) {
+                            this->network_events.emplace_back(std::move(pending));
+                        }
+                    }
+
+                    network_loop->free_use_list(read_use_list);
+                    network_loop->free_use_list(write_use_list);
+                    goto bind_failed;
+                }
+
+                event_add(events_ref.event_read, nullptr);
+                continue;
+            }
+
+            if(events->io_uring) {
+                /* The completions and the sends of one ring must be processed by the same thread */
+                events->event_read = network_loop->allocate_event_on(index, events->io_uring->event_fd, EV_READ | EV_PERSIST, VoiceServerSocket::network_event_io_uring, &*events);
+                events->event_write = network_loop->allocate_event_on(index, this->file_descriptor, EV_WRITE, VoiceServerSocket::network_event_write, &*events);
+            } else {
+                events->event_read = network_loop->allocate_event(this->file_descriptor, EV_READ | EV_PERSIST, VoiceServerSocket::network_event_read, &*events, &read_use_list);
+                events->event_write = network_loop->allocate_event(this->file_descriptor, EV_WRITE, VoiceServerSocket::network_event_write, &*events, &write_use_list);
+            }
+
+            /* The client timers are spread across the event loops like the sharded events */
+            events->event_timer = network_loop->allocate_event_on(index, -1, 0, VoiceServerSocket::network_event_timer, &*events);
 
             if(!events->event_read) {
                 logError(server_id, "Failed to allocate network read event for voice server binding {}", net::to_string(this->address_));
@@ -114,6 +460,11 @@ bool VoiceServerSocket::activate(std::string &error) {
                 continue;
             }
 
+            if(!events->event_timer) {
+                logError(server_id, "Failed to allocate network timer event for voice server binding {}", net::to_string(this->address_));
+                continue;
+            }
+
             event_add(events->event_read, nullptr);
             this->network_events.emplace_back(std::move(events));
         }
@@ -124,8 +475,17 @@ bool VoiceServerSocket::activate(std::string &error) {
             error = "failed to register any network events";
             goto bind_failed;
         }
+
+        if(sharded && !this->attach_shard_steering(error)) {
+            goto bind_failed;
+        }
+
+        this->writes_accepted = true;
     }
 
+    if(sharded) {
+        debugMessage(server_id, "Voice server binding {} uses {} socket shards.", net::to_string(this->address_), socket_shards);
+    }
     return true;
 
     bind_failed:
@@ -135,15 +495,16 @@ bool VoiceServerSocket::activate(std::string &error) {
 
 void VoiceServerSocket::deactivate() {
     std::unique_lock write_lock{this->mutex};
-    auto network_events_ = std::move(this->network_events);
-    auto file_descriptor_ = std::exchange(this->file_descriptor, 0);
 
-    this->write_client_queue.clear();
-    while(this->write_datagram_head) {
-        auto datagram = std::exchange(this->write_datagram_head, this->write_datagram_head->next_packet);
-        udp::DatagramPacket::destroy(datagram);
+    /* Wait until all write queue producers have left since they're accessing the network events */
+    this->writes_accepted = false;
+    while(this->write_producers > 0) {
+        std::this_thread::yield();
     }
-    this->write_datagram_tail = &this->write_datagram_head;
+
+    auto network_events_ = std::move(this->network_events);
+    auto file_descriptor_ = std::exchange(this->file_descriptor, 0);
+    this->socket_shards = 0;
     write_lock.unlock();
 
     /*
@@ -158,17 +519,255 @@ void VoiceServerSocket::deactivate() {
         if(binding->event_write) {
             event_del_block(binding->event_write);
         }
+
+        if(binding->event_timer) {
+            event_del_block(binding->event_timer);
+        }
+    }
+
+    /* The event loops don't access the write queues anymore. Drop all pending writes. */
+    for(const auto& events : network_events_) {
+        std::shared_ptr<VoiceClient> client{};
+        do {
+            this->pop_voice_write_queue(&*events, client);
+        } while(client);
+
+        while(auto datagram = this->pop_dg_write_queue(&*events)) {
+            udp::DatagramPacket::destroy(datagram);
+        }
+
+        auto timer_client = events->timer_client_head.exchange(nullptr);
+        while(timer_client) {
+            auto next = std::exchange(timer_client->timer_queue_next, nullptr);
+            auto reference = std::move(timer_client->timer_queue_reference);
+            timer_client->timer_scheduled = false;
+            timer_client = next;
+        }
+
+        for(auto& entry : events->timer_clients) {
+            entry.client->timer_slot = ~(size_t) 0;
+        }
+        events->timer_clients.clear();
     }
 
     /* Will free all events. */
+    std::vector<int> shard_file_descriptors{};
+    for(const auto& events : network_events_) {
+        if(events->file_descriptor > 0 && events->file_descriptor != file_descriptor_) {
+            shard_file_descriptors.push_back(events->file_descriptor);
+        }
+    }
     network_events_.clear();
 
-    /* Close the file descriptor after all network events have been finished*/
+    /* Close the file descriptors after all network events have been finished*/
+    for(const auto& shard_file_descriptor : shard_file_descriptors) {
+        ::close(shard_file_descriptor);
+    }
+
     if(file_descriptor_ > 0) {
         ::close(file_descriptor_);
     }
 }
 
+VoiceServerSocket::StatisticsSnapshot VoiceServerSocket::statistics() {
+    StatisticsSnapshot result{};
+    result.gso_enabled = this->gso_enabled;
+
+    std::lock_guard lock{this->mutex};
+    result.socket_shards = this->socket_shards;
+    for(const auto& events : this->network_events) {
+        const auto& receive_statistics = events->receive_statistics;
+        result.receive_batch_size = std::max(result.receive_batch_size, events->receive_batch ? events->receive_batch->capacity : 1);
+        result.receive_calls += receive_statistics.receive_calls.load(std::memory_order_relaxed);
+        result.datagrams_received += receive_statistics.datagrams_received.load(std::memory_order_relaxed);
+        for(size_t bucket{0}; bucket < kReceiveBatchBuckets; bucket++) {
+            result.batch_sizes[bucket] += receive_statistics.batch_sizes[bucket].load(std::memory_order_relaxed);
+        }
+        result.flood_filter |= events->flood_filter != nullptr;
+        result.dropped_source += receive_statistics.dropped_source.load(std::memory_order_relaxed);
+        result.dropped_prefix += receive_statistics.dropped_prefix.load(std::memory_order_relaxed);
+
+        const auto& send_statistics = events->send_statistics;
+        result.send_batch_size = std::max(result.send_batch_size, events->send_batch ? events->send_batch->capacity : 1);
+        result.send_calls += send_statistics.send_calls.load(std::memory_order_relaxed);
+        result.datagrams_sent += send_statistics.datagrams_sent.load(std::memory_order_relaxed);
+        result.gso_messages += send_statistics.gso_messages.load(std::memory_order_relaxed);
+        result.gso_segments += send_statistics.gso_segments.load(std::memory_order_relaxed);
+
+        result.io_uring_events += events->io_uring ? 1 : 0;
+
+        auto& shard = result.shards.emplace_back();
+        shard.datagrams_received = receive_statistics.datagrams_received.load(std::memory_order_relaxed);
+        shard.datagrams_sent = send_statistics.datagrams_sent.load(std::memory_order_relaxed);
+
+        const auto& timer_statistics = events->timer_statistics;
+        shard.timer_clients = timer_statistics.registered_clients.load(std::memory_order_relaxed);
+        shard.timer_runs = timer_statistics.timer_runs.load(std::memory_order_relaxed);
+        shard.timer_clients_processed = timer_statistics.clients_processed.load(std::memory_order_relaxed);
+        shard.timer_lag_max = timer_statistics.lag_max.load(std::memory_order_relaxed);
+        for(size_t bucket{0}; bucket < kTimerLagBuckets; bucket++) {
+            shard.timer_lags[bucket] = timer_statistics.lags[bucket].load(std::memory_order_relaxed);
+        }
+    }
+
+    return result;
+}
+
+
+void VoiceServerSocket::send_datagram(udp::DatagramPacket *datagram) {
+    assert(!datagram->next_packet);
+
+    this->write_producers++;
+    if(!this->writes_accepted) {
+        this->write_producers--;
+        udp::DatagramPacket::destroy(datagram);
+        return;
+    }
+
+    auto events = this->select_write_events(datagram->address);
+    auto head = events->write_datagram_head.load(std::memory_order_relaxed);
+    do {
+        datagram->next_packet = head;
+    } while(!events->write_datagram_head.compare_exchange_weak(head, datagram, std::memory_order_release, std::memory_order_relaxed));
+
+    if(!head) {
+        /* The queue has been empty. Else the write event has already been scheduled. */
+        event_add(events->event_write, nullptr);
+    }
+    this->write_producers--;
+}
+
+void VoiceServerSocket::enqueue_client_write(VoiceClient *client) {
+    if(client->write_scheduled.exchange(true)) {
+        /* The client is already enqueued and hasn't been flushed yet */
+        return;
+    }
+
+    auto reference = client->ref_self_voice.lock();
+    if(!reference) {
+        /* client is getting destroyed */
+        client->write_scheduled = false;
+        return;
+    }
+
+    this->write_producers++;
+    if(!this->writes_accepted) {
+        this->write_producers--;
+        client->write_scheduled = false;
+        return;
+    }
+
+    client->write_queue_reference = std::move(reference);
+
+    auto events = this->select_write_events(client->get_remote_address());
+    auto head = events->write_client_head.load(std::memory_order_relaxed);
+    do {
+        client->write_queue_next = head;
+    } while(!events->write_client_head.compare_exchange_weak(head, client, std::memory_order_release, std::memory_order_relaxed));
+
+    if(!head) {
+        /* The queue has been empty. Else the write event has already been scheduled. */
+        event_add(events->event_write, nullptr);
+    }
+    this->write_producers--;
+}
+
+void VoiceServerSocket::schedule_client_timer(VoiceClient *client) {
+    if(client->timer_scheduled.exchange(true)) {
+        /* The client is already enqueued and the event loop hasn't picked it up yet */
+        return;
+    }
+
+    auto reference = client->ref_self_voice.lock();
+    if(!reference) {
+        /* client is getting destroyed */
+        client->timer_scheduled = false;
+        return;
+    }
+
+    this->write_producers++;
+    if(!this->writes_accepted) {
+        this->write_producers--;
+        client->timer_scheduled = false;
+        return;
+    }
+
+    client->timer_queue_reference = std::move(reference);
+
+    auto events = this->select_timer_events(client);
+    auto head = events->timer_client_head.load(std::memory_order_relaxed);
+    do {
+        client->timer_queue_next = head;
+    } while(!events->timer_client_head.compare_exchange_weak(head, client, std::memory_order_release, std::memory_order_relaxed));
+
+    if(!head) {
+        /* The queue has been empty. Else the timer has already been activated. */
+        event_active(events->event_timer, EV_TIMEOUT, 1);
+    }
+    this->write_producers--;
+}
+
+VoiceServerSocket::NetworkEvents* VoiceServerSocket::select_timer_events(VoiceClient *client) {
+    assert(!this->network_events.empty());
+
+    auto index = client->timer_events_index.load(std::memory_order_relaxed);
+    if(index == ~(size_t) 0) {
+        auto expected = index;
+        index = VoiceServerSocket::calculate_shard(client->get_remote_address(), this->network_events.size());
+        if(!client->timer_events_index.compare_exchange_strong(expected, index, std::memory_order_relaxed)) {
+            /* Another thread has been faster */
+            index = expected;
+        }
+    }
+
+    /* The socket might have been reactivated with less network events. All timer lists have been cleared in that case. */
+    return &*this->network_events[index % this->network_events.size()];
+}
+
+udp::DatagramPacket* VoiceServerSocket::pop_dg_write_queue(NetworkEvents *events) {
+    if(!events->write_datagram_local) {
+        /* Take all pushed datagrams and restore their order */
+        auto datagram = events->write_datagram_head.exchange(nullptr, std::memory_order_acquire);
+        while(datagram) {
+            auto next = std::exchange(datagram->next_packet, events->write_datagram_local);
+            events->write_datagram_local = datagram;
+            datagram = next;
+        }
+
+        if(!events->write_datagram_local) {
+            return nullptr;
+        }
+    }
+
+    auto datagram = events->write_datagram_local;
+    events->write_datagram_local = std::exchange(datagram->next_packet, nullptr);
+    return datagram;
+}
+
+bool VoiceServerSocket::pop_voice_write_queue(NetworkEvents *events, std::shared_ptr<VoiceClient> &result) {
+    if(!events->write_client_local) {
+        /* Take all pushed clients and restore their order */
+        auto client = events->write_client_head.exchange(nullptr, std::memory_order_acquire);
+        while(client) {
+            auto next = std::exchange(client->write_queue_next, events->write_client_local);
+            events->write_client_local = client;
+            client = next;
+        }
+
+        if(!events->write_client_local) {
+            result = nullptr;
+            return false;
+        }
+    }
+
+    auto client = events->write_client_local;
+    events->write_client_local = std::exchange(client->write_queue_next, nullptr);
+    result = std::move(client->write_queue_reference);
+
+    /* From now on new writes will enqueue the client again */
+    client->write_scheduled = false;
+    return events->write_client_local || events->write_client_head.load(std::memory_order_relaxed);
+}
 
 template <int MHS>
 struct IOData {
@@ -244,108 +843,293 @@ inline ssize_t write_datagram(IOData<MHS>& io, const sockaddr_storage& address,
     return status;
 }
 
-void VoiceServerSocket::network_event_write(int, short, void *ptr_network_events) {
-    auto network_events = (NetworkEvents*) ptr_network_events;
-    auto socket = network_events->socket;
-    bool add_write_event{false};
-
+bool VoiceServerSocket::write_client_packets(NetworkEvents* network_events, bool& more_clients) {
     IOData<0x100> io{};
-    io.file_descriptor = socket->file_descriptor;
+    io.file_descriptor = network_events->file_descriptor;
 
-    { /* write and process clients */
-        std::shared_ptr<VoiceClient> client;
-        protocol::OutgoingServerPacket* packet{nullptr};
-        bool more_clients{true};
+    std::shared_ptr<VoiceClient> client;
+    protocol::OutgoingServerPacket* packet{nullptr};
+    more_clients = true;
 
-        auto write_timeout = system_clock::now() + microseconds(2500); /* read 2.5ms long at a time or 'till nothing more is there */
-        while(system_clock::now() <= write_timeout) {
-            more_clients = socket->pop_voice_write_queue(client);
-            if(!client) {
-                /* No pending client writes */
+    auto write_timeout = system_clock::now() + microseconds(2500); /* read 2.5ms long at a time or 'till nothing more is there */
+    while(system_clock::now() <= write_timeout) {
+        more_clients = this->pop_voice_write_queue(network_events, client);
+        if(!client) {
+            /* No pending client writes */
+            break;
+        }
+
+        client->getConnection()->packet_encoder().begin_write_round();
+
+        bool client_data_pending{true};
+        while(client_data_pending && std::chrono::system_clock::now() <= write_timeout) {
+            auto& client_packet_encoder = client->getConnection()->packet_encoder();
+
+            assert(!packet);
+            client_data_pending = client_packet_encoder.pop_write_buffer(packet);
+            if(!packet) {
+                /* Nothing to write or the command quantum has been used up. In the second case the client will be rescheduled. */
+                break;
+            }
+
+            ssize_t res = write_datagram(io, client->get_remote_address(), &client->getConnection()->remote_address_info(), packet->packet_length(), packet->packet_data());
+            if(res <= 0) {
+                if(errno == EAGAIN) {
+                    client_packet_encoder.reenqueue_failed_buffer(packet);
+                    this->enqueue_client_write(&*client);
+                    logTrace(this->server_id, "Failed to write datagram packet for client {} (EAGAIN). Rescheduling packet.", client->getLoggingPeerIp() + ":" + to_string(client->getPeerPort()));
+                    return false;
+                } else if(errno == EINVAL || res == -0xFEB) {
+                    /* needs more debug */
+                    auto voice_client = dynamic_pointer_cast<VoiceClient>(client);
+                    logCritical(
+                            this->server_id,
+                            "Failed to write datagram packet ({} @ {}) for client {} ({}) {}. Dropping packet! Extra data: [fd: {}, client family: {}, socket family: {}]",
+                            packet->packet_length(), packet->packet_data(),
+                            client->getLoggingPeerIp() + ":" + to_string(client->getPeerPort()),
+                            strerror(errno),
+                            res,
+                            network_events->file_descriptor,
+                            voice_client->isAddressV4() ? "v4" : voice_client->isAddressV6() ? "v6" : "v?",
+                            this->address_.ss_family == AF_INET ? "v4" : "v6"
+                    );
+                } else {
+                    logCritical(
+                            this->server_id,
+                            "Failed to write datagram packet for client {} (errno: {} message: {}). Dropping packet!",
+                            client->getLoggingPeerIp() + ":" + to_string(client->getPeerPort()),
+                            errno,
+                            strerror(errno)
+                    );
+                }
+                std::exchange(packet, nullptr)->unref();
                 break;
+            } else if(res != packet->packet_length()) {
+                logWarning(this->server_id, "Datagram write result didn't matches the datagrams size. Expected {}, Received {}", packet->packet_length(), res);
             }
 
-            bool client_data_pending{true};
-            while(client_data_pending && std::chrono::system_clock::now() <= write_timeout) {
-                auto& client_packet_encoder = client->getConnection()->packet_encoder();
+            network_events->send_statistics.register_send(1);
+            packet->unref();
+            packet = nullptr;
+        }
+
+        if(client_data_pending) {
+            /* we exceeded the max write time or the command quantum, rescheduling write */
+            this->enqueue_client_write(&*client);
+            more_clients = true;
+        }
 
-                assert(!packet);
-                client_data_pending = client_packet_encoder.pop_write_buffer(packet);
-                if(!packet) {
-                    assert(!client_data_pending);
-                    break;
+        client = nullptr;
+    }
+    return true;
+}
+
+bool VoiceServerSocket::write_client_packets_batched(NetworkEvents* network_events, bool& more_clients) {
+    auto& batch = *network_events->send_batch;
+    assert(batch.empty());
+
+    const auto allow_gso = this->gso_enabled.load(std::memory_order_relaxed);
+    std::shared_ptr<VoiceClient> client{};
+    protocol::OutgoingServerPacket* packet{nullptr};
+    more_clients = true;
+
+    /* The time budget will be checked after every flush and after every client */
+    auto write_timeout = system_clock::now() + microseconds(2500); /* read 2.5ms long at a time or 'till nothing more is there */
+    bool timeout_exceeded{false};
+    while(!timeout_exceeded) {
+        more_clients = this->pop_voice_write_queue(network_events, client);
+        if(!client) {
+            /* No pending client writes */
+            break;
+        }
+
+        auto& client_packet_encoder = client->getConnection()->packet_encoder();
+        client_packet_encoder.begin_write_round();
+        batch.clients.push_back(client);
+
+        bool client_data_pending{true};
+        while(client_data_pending) {
+            if(batch.full()) {
+                if(!this->flush_send_batch(network_events)) {
+                    return false;
                 }
 
-                ssize_t res = write_datagram(io, client->get_remote_address(), &client->getConnection()->remote_address_info(), packet->packet_length(), packet->packet_data());
-                if(res <= 0) {
-                    if(errno == EAGAIN) {
-                        client_packet_encoder.reenqueue_failed_buffer(packet);
-                        logTrace(socket->server_id, "Failed to write datagram packet for client {} (EAGAIN). Rescheduling packet.", client->getLoggingPeerIp() + ":" + to_string(client->getPeerPort()));
-                        return;
-                    } else if(errno == EINVAL || res == -0xFEB) {
-                        /* needs more debug */
-                        auto voice_client = dynamic_pointer_cast<VoiceClient>(client);
-                        logCritical(
-                                socket->server_id,
-                                "Failed to write datagram packet ({} @ {}) for client {} ({}) {}. Dropping packet! Extra data: [fd: {}, client family: {}, socket family: {}]",
-                                packet->packet_length(), packet->packet_data(),
-                                client->getLoggingPeerIp() + ":" + to_string(client->getPeerPort()),
-                                strerror(errno),
-                                res,
-                                socket->file_descriptor,
-                                voice_client->isAddressV4() ? "v4" : voice_client->isAddressV6() ? "v6" : "v?",
-                                socket->address_.ss_family == AF_INET ? "v4" : "v6"
-                        );
-                    } else {
-                        logCritical(
-                                socket->server_id,
-                                "Failed to write datagram packet for client {} (errno: {} message: {}). Dropping packet!",
-                                client->getLoggingPeerIp() + ":" + to_string(client->getPeerPort()),
-                                errno,
-                                strerror(errno)
-                        );
-                    }
-                    packet->unref();
+                if(system_clock::now() > write_timeout) {
+                    timeout_exceeded = true;
                     break;
-                } else if(res != packet->packet_length()) {
-                    logWarning(socket->server_id, "Datagram write result didn't matches the datagrams size. Expected {}, Received {}", packet->packet_length(), res);
                 }
 
-                packet->unref();
-                packet = nullptr;
+                /* the batch has been cleared, register the client again */
+                batch.clients.push_back(client);
+            }
+
+            assert(!packet);
+            client_data_pending = client_packet_encoder.pop_write_buffer(packet);
+            if(!packet) {
+                /* Nothing to write or the command quantum has been used up. In the second case the client will be rescheduled. */
+                break;
+            }
+
+            if(client->get_remote_address().ss_family == 0) {
+                /* address is unset (testing ip loss i guess) */
+                std::exchange(packet, nullptr)->unref();
+                continue;
+            }
+
+            batch.append(std::exchange(packet, nullptr), allow_gso);
+        }
+
+        if(client_data_pending) {
+            /* we exceeded the max write time or the command quantum, rescheduling write */
+            this->enqueue_client_write(&*client);
+            more_clients = true;
+        }
+
+        client = nullptr;
+
+        /* clients with only a few pending packets may never fill the batch */
+        timeout_exceeded |= system_clock::now() > write_timeout;
+    }
+
+    return this->flush_send_batch(network_events);
+}
+
+bool VoiceServerSocket::flush_send_batch(NetworkEvents* network_events) {
+    auto& batch = *network_events->send_batch;
+    if(batch.empty()) {
+        batch.clear();
+        return true;
+    }
+
+    batch.finalize();
+
+    size_t message_index{0};
+    while(message_index < batch.message_count) {
+        auto result = sendmmsg(network_events->file_descriptor, &batch.headers[message_index], batch.message_count - message_index, 0);
+        if(result <= 0) {
+            auto& message = batch.messages[message_index];
+            auto& client = batch.clients[message.client_index];
+
+            if(errno == EAGAIN || errno == EWOULDBLOCK) {
+                /* Reenqueue all packets we've not send yet. We've to do it in reverse order since the packets are getting prepended. */
+                for(auto packet_index = batch.packet_count; packet_index-- > message.packet_offset;) {
+                    auto& packet_client = batch.clients[batch.packet_client_index[packet_index]];
+                    packet_client->getConnection()->packet_encoder().reenqueue_failed_buffer(batch.packets[packet_index]);
+                }
+
+                for(auto client_index{message.client_index}; client_index < batch.clients.size(); client_index++) {
+                    this->enqueue_client_write(&*batch.clients[client_index]);
+                }
+
+                logTrace(this->server_id, "Failed to write {} datagram packets (EAGAIN). Rescheduling packets.", batch.packet_count - message.packet_offset);
+                batch.clear();
+                return false;
             }
 
-            if(client_data_pending) {
-                /* we exceeded the max write time, rescheduling write */
-                socket->enqueue_client_write(client);
-                more_clients = true;
+            if(message.packet_count > 1 && (errno == EIO || errno == EINVAL)) {
+                /* The NIC can't do checksum offloading or the kernel rejected the segment size */
+                if(this->gso_enabled.exchange(false)) {
+                    logWarning(this->server_id, "Failed to write segmented datagram for bind {} ({}). Disabling UDP GSO.", net::to_string(this->address_), strerror(errno));
+                }
+            } else {
+                logCritical(
+                        this->server_id,
+                        "Failed to write {} datagram packet(s) for client {} (errno: {} message: {}). Dropping packet!",
+                        message.packet_count,
+                        client->getLoggingPeerIp() + ":" + to_string(client->getPeerPort()),
+                        errno,
+                        strerror(errno)
+                );
+            }
+
+            for(size_t packet_index{0}; packet_index < message.packet_count; packet_index++) {
+                batch.packets[message.packet_offset + packet_index]->unref();
+            }
+
+            message_index++;
+            continue;
+        }
+
+        size_t datagrams_sent{0};
+        for(size_t index{0}; index < result; index++) {
+            auto& message = batch.messages[message_index + index];
+            for(size_t packet_index{0}; packet_index < message.packet_count; packet_index++) {
+                batch.packets[message.packet_offset + packet_index]->unref();
             }
 
-            client = nullptr;
+            if(message.packet_count > 1) {
+                network_events->send_statistics.register_gso(message.packet_count);
+            }
+            datagrams_sent += message.packet_count;
+        }
+
+        network_events->send_statistics.register_send(datagrams_sent);
+        message_index += result;
+    }
+
+    batch.clear();
+    return true;
+}
+
+void VoiceServerSocket::network_event_write(int, short, void *ptr_network_events) {
+    auto network_events = (NetworkEvents*) ptr_network_events;
+    auto socket = network_events->socket;
+    bool add_write_event{false};
+
+    { /* write and process clients */
+        bool more_clients{false};
+        bool socket_writable;
+        if(network_events->io_uring) {
+            socket_writable = socket->write_client_packets_io_uring(network_events, more_clients);
+        } else if(network_events->send_batch) {
+            socket_writable = socket->write_client_packets_batched(network_events, more_clients);
+        } else {
+            socket_writable = socket->write_client_packets(network_events, more_clients);
+        }
+
+        if(!socket_writable) {
+            if(!network_events->io_uring) {
+                /*
+                 * The write queues only schedule the write event if they've been empty.
+                 * Wait until the socket becomes writable again.
+                 * With io_uring the send completions will reschedule the write event.
+                 */
+                event_add(network_events->event_write, nullptr);
+            }
+            return;
         }
 
         add_write_event |= more_clients;
     }
 
+    IOData<0x100> io{};
+    io.file_descriptor = network_events->file_descriptor;
+
     /* write all manually specified datagram packets */
     {
         auto write_timeout = system_clock::now() + std::chrono::microseconds{2500}; /* read 2.5ms long at a time or 'till nothing more is there */
         udp::DatagramPacket* packet;
 
-        while(system_clock::now() <= write_timeout && (packet = socket->pop_dg_write_queue())) {
+        while(system_clock::now() <= write_timeout && (packet = socket->pop_dg_write_queue(network_events))) {
             ssize_t res = write_datagram(io, packet->address, &packet->pktinfo, packet->data_length, packet->data);
             if(res != packet->data_length) {
-                if(errno == EAGAIN) {
-                    /* Just resend it */
-                    socket->send_datagram(packet);
-                } else {
-                    udp::DatagramPacket::destroy(packet);
+                auto error = errno;
+                if(error == EAGAIN) {
+                    /*
+                     * Put the datagram back in front of the remaining local datagrams so the output order is kept.
+                     * The write queue only schedules the write event if it has been empty, so wait for the socket to become writable again.
+                     */
+                    packet->next_packet = network_events->write_datagram_local;
+                    network_events->write_datagram_local = packet;
+                    event_add(network_events->event_write, nullptr);
+                    return;
                 }
 
-                logError(socket->server_id, "Failed to send datagram. Wrote {} out of {}. {}/{}", res, packet->data_length, errno, strerror(errno));
-                add_write_event = false;
-                break;
+                logError(socket->server_id, "Failed to send datagram. Wrote {} out of {}. {}/{}", res, packet->data_length, error, strerror(error));
+                udp::DatagramPacket::destroy(packet);
+                continue;
             }
+            network_events->send_statistics.register_send(1);
             udp::DatagramPacket::destroy(packet);
         }
 
@@ -363,22 +1147,120 @@ static union {
     uint64_t integral;
 } TS3INIT;
 
-constexpr static auto kRecvBufferSize{1600}; //IPv6 MTU: 1500 | IPv4 MTU: 576
+void VoiceServerSocket::network_event_timer(int, short, void *ptr_network_events) {
+    auto network_events = (NetworkEvents*) ptr_network_events;
+    network_events->socket->process_client_timers(network_events);
+}
+
+void VoiceServerSocket::process_client_timers(NetworkEvents *network_events) {
+    auto now = system_clock::now();
+    auto& timer_clients = network_events->timer_clients;
+
+    /* Take all newly scheduled clients. They'll be processed within this run. */
+    {
+        auto client = network_events->timer_client_head.exchange(nullptr, std::memory_order_acquire);
+        while(client) {
+            auto next = std::exchange(client->timer_queue_next, nullptr);
+            auto reference = std::move(client->timer_queue_reference);
+
+            /* From now on new command packets will schedule the client again */
+            client->timer_scheduled = false;
+
+            if(client->timer_slot < timer_clients.size() && timer_clients[client->timer_slot].client == reference) {
+                auto& entry = timer_clients[client->timer_slot];
+                entry.deadline = now;
+                entry.woken = true;
+            } else {
+                client->timer_slot = timer_clients.size();
+                timer_clients.push_back(NetworkEvents::TimerClient{std::move(reference), now, true});
+            }
+
+            client = next;
+        }
+    }
+
+    size_t clients_processed{0};
+    auto next_deadline = now + kClientTimerInterval;
+    for(size_t index{0}; index < timer_clients.size();) {
+        auto& entry = timer_clients[index];
+        auto& client = entry.client;
+
+        if(client->state == ConnectionState::DISCONNECTED) {
+            client->timer_slot = ~(size_t) 0;
+            if(index + 1 < timer_clients.size()) {
+                entry = std::move(timer_clients.back());
+                entry.client->timer_slot = index;
+            }
+            timer_clients.pop_back();
+            continue;
+        }
+
+        if(entry.deadline <= now) {
+            if(!entry.woken) {
+                network_events->timer_statistics.register_lag(now - entry.deadline);
+            }
+
+            auto client_deadline = now + kClientTimerInterval;
+            auto connection = client->getConnection();
+            connection->packet_encoder().execute_resend(now, client_deadline);
+            if(client->state == ConnectionState::CONNECTED) {
+                connection->ping_handler().tick(now);
+            }
+
+            entry.deadline = client_deadline;
+            entry.woken = false;
+            clients_processed++;
+        }
+
+        next_deadline = std::min(next_deadline, entry.deadline);
+        index++;
+    }
+
+    network_events->timer_statistics.register_run(clients_processed, timer_clients.size());
+    if(timer_clients.empty()) {
+        /* Nothing to do until a client gets scheduled again */
+        return;
+    }
+
+    auto timeout = std::max(duration_cast<microseconds>(next_deadline - system_clock::now()), microseconds{0});
+    struct timeval timeout_value{};
+    timeout_value.tv_sec = (time_t) (timeout.count() / 1000000);
+    timeout_value.tv_usec = (suseconds_t) (timeout.count() % 1000000);
+    event_add(network_events->event_timer, &timeout_value);
+}
+
+void VoiceServerSocket::log_truncated_datagram(const sockaddr_storage& address) {
+    static std::chrono::system_clock::time_point last_error_message{};
+    auto now = system_clock::now();
+    if(last_error_message + std::chrono::seconds{5} < now) {
+        logError(this->server_id, "Received truncated message from {}", net::to_string(address));
+        last_error_message = now;
+    }
+}
+
 void VoiceServerSocket::network_event_read(int, short, void *ptr_network_events) {
     auto network_events = (NetworkEvents*) ptr_network_events;
     auto socket = network_events->socket;
 
-    uint8_t raw_read_buffer[kRecvBufferSize]; //Allocate on stack, so we dont need heap here
+    if(network_events->receive_batch) {
+        socket->read_datagrams_batched(network_events);
+    } else {
+        socket->read_datagrams(network_events);
+    }
+}
+
+void VoiceServerSocket::read_datagrams(NetworkEvents* network_events) {
+    uint8_t raw_read_buffer[kReceiveBufferSize]; //Allocate on stack, so we dont need heap here
 
     ssize_t bytes_read;
-    pipes::buffer_view read_buffer{raw_read_buffer, kRecvBufferSize}; /* will not allocate anything, just sets its mode to ptr and that's it :) */
+    pipes::buffer_view read_buffer{raw_read_buffer, kReceiveBufferSize}; /* will not allocate anything, just sets its mode to ptr and that's it :) */
 
     sockaddr_storage remote_address{};
     iovec io_vector{};
     io_vector.iov_base = (void*) raw_read_buffer;
-    io_vector.iov_len = kRecvBufferSize;
+    io_vector.iov_len = kReceiveBufferSize;
 
-    char message_headers[0x100];
+    char message_headers[kReceiveControlSize];
 
     msghdr message{};
     message.msg_name = &remote_address;
@@ -386,20 +1268,17 @@ void VoiceServerSocket::network_event_read(int, short, void *ptr_network_events)
     message.msg_iov = &io_vector;
     message.msg_iovlen = 1;
     message.msg_control = message_headers;
-    message.msg_controllen = 0x100;
+    message.msg_controllen = kReceiveControlSize;
 
     auto read_timeout = system_clock::now() + microseconds{2500}; /* read 2.5ms long at a time or 'till nothing more is there */
     while(system_clock::now() <= read_timeout) {
         message.msg_flags = 0;
-        bytes_read = recvmsg(socket->file_descriptor, &message, 0);
+        message.msg_namelen = sizeof(remote_address);
+        message.msg_controllen = kReceiveControlSize;
+        bytes_read = recvmsg(network_events->file_descriptor, &message, 0);
 
         if((message.msg_flags & MSG_TRUNC) > 0) {
-            static std::chrono::system_clock::time_point last_error_message{};
-            auto now = system_clock::now();
-            if(last_error_message + std::chrono::seconds{5} < now) {
-                logError(socket->server_id, "Received truncated message from {}", net::to_string(remote_address));
-                last_error_message = now;
-            }
+            this->log_truncated_datagram(remote_address);
             continue;
         }
 
@@ -409,61 +1288,173 @@ void VoiceServerSocket::network_event_read(int, short, void *ptr_network_events)
             }
 
             //Nothing more to read
-            logCritical(socket->server_id, "Could not receive datagram packet! Code: {} Reason: {}", errno, strerror(errno));
+            logCritical(this->server_id, "Could not receive datagram packet! Code: {} Reason: {}", errno, strerror(errno));
             break;
         } else if(bytes_read == 0){
             /* We received a dara gram with zero length? Well, how the hell sends us such? */
             break;
         }
 
-        if(bytes_read < 8) {
-            /* every packet must be at least 8 bytes long... */
-            continue;
+        network_events->receive_statistics.register_receive(1);
+        if(network_events->flood_filter) {
+            network_events->flood_filter->update_clock();
         }
+        this->handle_datagram(network_events, remote_address, message, read_buffer.view(0, bytes_read));
+    }
+}
 
-        if(*(uint64_t*) raw_read_buffer == TS3INIT.integral) {
-            //Handle ddos protection...
-            /* TODO: Don't pass the raw buffer instead pass the protocol::ClientPacketParser and ClientPacketParser mus allow the INIT packet */
-            socket->server->pow_handler->handle_datagram(socket->shared_from_this(), remote_address, message, read_buffer.view(0, bytes_read));
-            continue;
+void VoiceServerSocket::read_datagrams_batched(NetworkEvents* network_events) {
+    auto& batch = *network_events->receive_batch;
+
+    /*
+     * We're only checking the timeout once per batch.
+     * Querying the clock for every datagram costs more than the datagram processing itself.
+     */
+    auto read_timeout = system_clock::now() + microseconds{2500}; /* read 2.5ms long at a time or 'till nothing more is there */
+    while(true) {
+        batch.prepare();
+        auto datagrams = recvmmsg(network_events->file_descriptor, batch.headers.get(), batch.capacity, MSG_DONTWAIT, nullptr);
+        if(datagrams < 0) {
+            if(errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+
+            logCritical(this->server_id, "Could not receive datagram packets! Code: {} Reason: {}", errno, strerror(errno));
+            break;
+        } else if(datagrams == 0) {
+            break;
         }
 
-        protocol::ClientPacketParser packet_parser{read_buffer.view(0, bytes_read)};
-        if(!packet_parser.valid()) {
-            return;
+        network_events->receive_statistics.register_receive(datagrams);
+        if(network_events->flood_filter) {
+            network_events->flood_filter->update_clock();
         }
 
-        std::shared_ptr<VoiceClient> client{};
-        {
-            auto client_id = packet_parser.client_id();
-            if(client_id > 0) {
-                client = dynamic_pointer_cast<VoiceClient>(socket->server->server->find_client_by_id(client_id));
-            } else {
-                client = socket->server->findClient(&remote_address, true);
+        size_t resolved_count{0};
+        for(size_t index{0}; index < datagrams; index++) {
+            auto& header = batch.headers[index];
+            auto& slot = batch.slots[index];
+
+            if((header.msg_hdr.msg_flags & MSG_TRUNC) > 0) {
+                this->log_truncated_datagram(slot.address);
+                continue;
             }
-        }
 
-        if(!client) {
-            continue;
+            auto& packet_parser = batch.parsers[index].emplace(pipes::buffer_view{slot.buffer, header.msg_len});
+            auto client = this->resolve_datagram(network_events, slot.address, header.msg_hdr, packet_parser);
+            if(!client) {
+                continue;
+            }
+
+            batch.clients[index] = std::move(client);
+            batch.resolved[resolved_count++] = index;
         }
 
-        auto client_connection = client->getConnection();
-        if(memcmp(&client->get_remote_address(), &remote_address, sizeof(sockaddr_storage)) != 0) { /* verify the remote address */
-            /* only encrypted packets are allowed */
-            if(!packet_parser.has_flag(protocol::PacketFlag::Unencrypted) && client->connectionState() == ConnectionState::CONNECTED) {
-                /* the ip had changed */
-                if(client_connection->verify_encryption(packet_parser)) {
-                    udp::pktinfo_storage remote_address_info;
-                    udp::DatagramPacket::extract_info(message, remote_address_info);
-                    socket->server->handleClientAddressChange(client, remote_address, remote_address_info);
-                }
-            } else {
-                continue;
+        /* Group the datagrams by their client. The stable sort keeps the receive order of every client. */
+        std::stable_sort(&batch.resolved[0], &batch.resolved[resolved_count], [&](size_t a, size_t b) {
+            return batch.clients[a].get() < batch.clients[b].get();
+        });
+
+        for(size_t offset{0}; offset < resolved_count;) {
+            auto& client = batch.clients[batch.resolved[offset]];
+
+            size_t packet_count{0};
+            while(offset + packet_count < resolved_count && batch.clients[batch.resolved[offset + packet_count]] == client) {
+                batch.client_packets[packet_count] = &*batch.parsers[batch.resolved[offset + packet_count]];
+                packet_count++;
             }
+
+            /* The client might have been disconnected by one of the previous datagrams */
+            if(client->connectionState() != ConnectionState::DISCONNECTED) {
+                client->getConnection()->handle_incoming_datagrams(batch.client_packets.get(), packet_count);
+            }
+            offset += packet_count;
+        }
+
+        for(size_t index{0}; index < resolved_count; index++) {
+            batch.clients[batch.resolved[index]].reset();
+        }
+        for(size_t index{0}; index < datagrams; index++) {
+            batch.parsers[index].reset();
+        }
+
+        if(datagrams < batch.capacity) {
+            /* The socket has been drained */
+            break;
         }
 
-        if(client->connectionState() != ConnectionState::DISCONNECTED) {
-            client_connection->handle_incoming_datagram(packet_parser);
+        if(system_clock::now() > read_timeout) {
+            break;
         }
     }
-}
\ No newline at end of file
+}
+
+void VoiceServerSocket::handle_datagram(NetworkEvents* network_events, sockaddr_storage &remote_address, msghdr &message, const pipes::buffer_view &buffer) {
+    protocol::ClientPacketParser packet_parser{buffer};
+    auto client = this->resolve_datagram(network_events, remote_address, message, packet_parser);
+    if(client) {
+        client->getConnection()->handle_incoming_datagram(packet_parser);
+    }
+}
+
+std::shared_ptr<VoiceClient> VoiceServerSocket::resolve_datagram(NetworkEvents* network_events, sockaddr_storage &remote_address, msghdr &message, protocol::ClientPacketParser &packet_parser) {
+    if(network_events->flood_filter) {
+        auto filter_result = network_events->flood_filter->check(remote_address);
+        if(filter_result != VoiceFloodFilter::Result::ACCEPT) {
+            network_events->receive_statistics.register_drop(filter_result);
+            return nullptr;
+        }
+    }
+
+    const auto buffer = packet_parser.buffer();
+    if(buffer.length() < 8) {
+        /* every packet must be at least 8 bytes long... */
+        return nullptr;
+    }
+
+    if(*(uint64_t*) buffer.data_ptr() == TS3INIT.integral) {
+        //Handle ddos protection...
+        /* TODO: Don't pass the raw buffer instead pass the protocol::ClientPacketParser and ClientPacketParser mus allow the INIT packet */
+        this->server->pow_handler->handle_datagram(this->shared_from_this(), remote_address, message, buffer);
+        return nullptr;
+    }
+
+    if(!packet_parser.valid()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<VoiceClient> client{};
+    {
+        auto client_id = packet_parser.client_id();
+        if(client_id > 0) {
+            client = this->server->findClient(client_id);
+        } else {
+            client = this->server->findClient(&remote_address, true);
+        }
+    }
+
+    if(!client) {
+        return nullptr;
+    }
+
+    auto client_connection = client->getConnection();
+    if(memcmp(&client->get_remote_address(), &remote_address, sizeof(sockaddr_storage)) != 0) { /* verify the remote address */
+        /* only encrypted packets are allowed */
+        if(!packet_parser.has_flag(protocol::PacketFlag::Unencrypted) && client->connectionState() == ConnectionState::CONNECTED) {
+            /* the ip had changed */
+            if(client_connection->verify_encryption(packet_parser)) {
+                udp::pktinfo_storage remote_address_info;
+                udp::DatagramPacket::extract_info(message, remote_address_info);
+                this->server->handleClientAddressChange(client, remote_address, remote_address_info);
+            }
+        } else {
+            return nullptr;
+        }
+    }
+
+    if(client->connectionState() == ConnectionState::DISCONNECTED) {
+        return nullptr;
+    }
+
+    return client;
+}
@@ -0,0 +1,405 @@
+#include "./VoiceServerSocketIOUring.h"
+#include <log/LogUtils.h>
+
+#ifdef HAVE_IO_URING
+#include <sys/eventfd.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <cstring>
+#include <protocol/Packet.h>
+#include "../client/voice/VoiceClient.h"
+#include "../Configuration.h"
+#endif
+
+using namespace std::chrono;
+using namespace ts::server;
+using namespace ts;
+
+#ifndef HAVE_IO_URING
+bool VoiceServerSocket::initialize_io_uring(NetworkEvents *, std::string &error) {
+    error = "the server has been compiled without io_uring support";
+    return false;
+}
+
+bool VoiceServerSocket::write_client_packets_io_uring(NetworkEvents *, bool &more_clients) {
+    more_clients = false;
+    return true;
+}
+
+void VoiceServerSocket::process_io_uring_completions(NetworkEvents *) { }
+void VoiceServerSocket::network_event_io_uring(int, short, void *) { }
+#else
+
+/* Multishot recvmsg has been added with Linux 6.0, provided buffer rings with 5.19 */
+inline bool kernel_supports_multishot_receive() {
+    utsname name{};
+    if(uname(&name) != 0) {
+        return false;
+    }
+
+    int major{0};
+    if(sscanf(name.release, "%d.", &major) != 1) {
+        return false;
+    }
+
+    return major >= 6;
+}
+
+VoiceServerSocket::IOUringContext::~IOUringContext() {
+    if(this->ring_initialized) {
+        /*
+         * The kernel might still access our receive buffers and the send slots.
+         * Cancel everything and wait until all operations have been completed before we free them.
+         */
+        auto sqe = io_uring_get_sqe(&this->ring);
+        if(sqe) {
+            io_uring_prep_cancel64(sqe, 0, IORING_ASYNC_CANCEL_ANY);
+            io_uring_sqe_set_data64(sqe, kUserDataCancel);
+        }
+        io_uring_submit(&this->ring);
+
+        auto timeout = steady_clock::now() + seconds{1};
+        while((this->receive_armed || this->sends_in_flight > 0) && steady_clock::now() < timeout) {
+            __kernel_timespec wait_timeout{0, 50 * 1000 * 1000};
+            io_uring_cqe* cqe;
+            if(io_uring_wait_cqe_timeout(&this->ring, &cqe, &wait_timeout) != 0) {
+                continue;
+            }
+
+            auto user_data = io_uring_cqe_get_data64(cqe);
+            if(user_data == kUserDataReceive) {
+                this->receive_armed &= (cqe->flags & IORING_CQE_F_MORE) > 0;
+            } else if(user_data != kUserDataCancel) {
+                auto& slot = this->send_slots[user_data];
+                std::exchange(slot.packet, nullptr)->unref();
+                this->sends_in_flight--;
+            }
+            io_uring_cqe_seen(&this->ring, cqe);
+        }
+
+        if(this->receive_armed || this->sends_in_flight > 0) {
+            /* Leaking the buffers is better than the kernel writing into freed memory */
+            logCritical(LOG_GENERAL, "Failed to cancel all pending io_uring operations. Leaking their buffers.");
+            this->receive_buffers.release();
+            this->send_slots.release();
+        }
+
+        if(this->buffer_ring) {
+            io_uring_free_buf_ring(&this->ring, this->buffer_ring, this->buffer_count, kBufferGroup);
+        }
+
+        io_uring_queue_exit(&this->ring);
+    }
+
+    if(this->event_fd >= 0) {
+        ::close(this->event_fd);
+    }
+}
+
+bool VoiceServerSocket::IOUringContext::arm_receive(int file_descriptor) {
+    auto sqe = io_uring_get_sqe(&this->ring);
+    if(!sqe) {
+        return false;
+    }
+
+    io_uring_prep_recvmsg_multishot(sqe, file_descriptor, &this->receive_message, MSG_TRUNC);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    io_uring_sqe_set_data64(sqe, kUserDataReceive);
+
+    this->receive_armed = true;
+    return true;
+}
+
+bool VoiceServerSocket::initialize_io_uring(NetworkEvents *events, std::string &error) {
+    if(!kernel_supports_multishot_receive()) {
+        error = "io_uring multishot receive requires Linux 6.0 or newer";
+        return false;
+    }
+
+    size_t queue_depth{1};
+    while(queue_depth < ts::config::voice::io_uring_queue_depth) {
+        queue_depth <<= 1U;
+    }
+
+    auto context = std::make_unique<IOUringContext>();
+    {
+        io_uring_params params{};
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = queue_depth * 4; /* every send and every received datagram generates a completion */
+
+        auto result = io_uring_queue_init_params(queue_depth, &context->ring, &params);
+        if(result < 0) {
+            error = "failed to setup io_uring: " + std::string{strerror(-result)};
+            return false;
+        }
+        context->ring_initialized = true;
+    }
+
+    context->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(context->event_fd < 0) {
+        error = "failed to allocate completion event fd: " + std::string{strerror(errno)};
+        return false;
+    }
+
+    if(auto result = io_uring_register_eventfd(&context->ring, context->event_fd); result < 0) {
+        error = "failed to register completion event fd: " + std::string{strerror(-result)};
+        return false;
+    }
+
+    {
+        int result{0};
+        context->buffer_count = queue_depth;
+        context->buffer_ring = io_uring_setup_buf_ring(&context->ring, context->buffer_count, IOUringContext::kBufferGroup, 0, &result);
+        if(!context->buffer_ring) {
+            error = "failed to setup provided buffer ring: " + std::string{strerror(-result)};
+            return false;
+        }
+
+        context->receive_buffers = std::make_unique<uint8_t[]>(context->buffer_count * IOUringContext::kReceiveBufferSize);
+
+        auto buffer_mask = io_uring_buf_ring_mask(context->buffer_count);
+        for(size_t buffer_id{0}; buffer_id < context->buffer_count; buffer_id++) {
+            io_uring_buf_ring_add(context->buffer_ring, context->receive_buffer(buffer_id), IOUringContext::kReceiveBufferSize, buffer_id, buffer_mask, buffer_id);
+        }
+        io_uring_buf_ring_advance(context->buffer_ring, context->buffer_count);
+
+        context->receive_message.msg_namelen = sizeof(sockaddr_storage);
+        context->receive_message.msg_controllen = kReceiveControlSize;
+    }
+
+    context->send_slots = std::make_unique<IOUringContext::SendSlot[]>(queue_depth);
+    context->free_send_slots.reserve(queue_depth);
+    for(size_t slot_index{queue_depth}; slot_index-- > 0;) {
+        auto& slot = context->send_slots[slot_index];
+        slot.message.msg_name = &slot.address;
+        slot.message.msg_iov = &slot.vector;
+        slot.message.msg_iovlen = 1;
+        context->free_send_slots.push_back(slot_index);
+    }
+
+    if(!context->arm_receive(events->file_descriptor)) {
+        error = "failed to queue multishot receive";
+        return false;
+    }
+
+    if(auto result = io_uring_submit(&context->ring); result < 0) {
+        error = "failed to submit multishot receive: " + std::string{strerror(-result)};
+        return false;
+    }
+
+    events->io_uring = std::move(context);
+    return true;
+}
+
+inline void prepare_send_slot(VoiceServerSocket::IOUringContext::SendSlot& slot, const sockaddr_storage& address, const udp::pktinfo_storage& info, protocol::OutgoingServerPacket* packet) {
+    slot.packet = packet;
+    slot.vector.iov_base = (void*) packet->packet_data();
+    slot.vector.iov_len = packet->packet_length();
+
+    memcpy(&slot.address, &address, sizeof(address));
+    slot.message.msg_namelen = address.ss_family == AF_INET ? sizeof(sockaddr_in) : sizeof(sockaddr_in6);
+    slot.message.msg_control = slot.control;
+    slot.message.msg_controllen = sizeof(slot.control);
+    slot.message.msg_flags = 0;
+
+    auto cmsg = CMSG_FIRSTHDR(&slot.message);
+    if(address.ss_family == AF_INET) {
+        cmsg->cmsg_level = IPPROTO_IP;
+        cmsg->cmsg_type = IP_PKTINFO;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(in_pktinfo));
+        memcpy(CMSG_DATA(cmsg), &info, sizeof(in_pktinfo));
+        slot.message.msg_controllen = CMSG_SPACE(sizeof(in_pktinfo));
+    } else if(address.ss_family == AF_INET6) {
+        cmsg->cmsg_level = IPPROTO_IPV6;
+        cmsg->cmsg_type = IPV6_PKTINFO;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(in6_pktinfo));
+        memcpy(CMSG_DATA(cmsg), &info, sizeof(in6_pktinfo));
+        slot.message.msg_controllen = CMSG_SPACE(sizeof(in6_pktinfo));
+    } else {
+        slot.message.msg_control = nullptr;
+        slot.message.msg_controllen = 0;
+    }
+}
+
+bool VoiceServerSocket::write_client_packets_io_uring(NetworkEvents *events, bool &more_clients) {
+    auto& context = *events->io_uring;
+    more_clients = true;
+
+    std::shared_ptr<VoiceClient> client;
+    size_t packets_queued{0};
+    while(!context.free_send_slots.empty()) {
+        more_clients = this->pop_voice_write_queue(events, client);
+        if(!client) {
+            /* No pending client writes */
+            break;
+        }
+
+        auto& client_packet_encoder = client->getConnection()->packet_encoder();
+        client_packet_encoder.begin_write_round();
+
+        bool client_data_pending{true};
+        while(client_data_pending && !context.free_send_slots.empty()) {
+            protocol::OutgoingServerPacket* packet{nullptr};
+            client_data_pending = client_packet_encoder.pop_write_buffer(packet);
+            if(!packet) {
+                /* Nothing to write or the command quantum has been used up. In the second case the client will be rescheduled. */
+                break;
+            }
+
+            auto sqe = io_uring_get_sqe(&context.ring);
+            if(!sqe) {
+                /* submission queue is full, flush it and try again */
+                io_uring_submit(&context.ring);
+                events->send_statistics.register_send(std::exchange(packets_queued, 0));
+
+                sqe = io_uring_get_sqe(&context.ring);
+                if(!sqe) {
+                    client_packet_encoder.reenqueue_failed_buffer(packet);
+                    client_data_pending = true;
+                    break;
+                }
+            }
+
+            auto slot_index = context.free_send_slots.back();
+            context.free_send_slots.pop_back();
+
+            auto& slot = context.send_slots[slot_index];
+            prepare_send_slot(slot, client->get_remote_address(), client->getConnection()->remote_address_info(), packet);
+
+            io_uring_prep_sendmsg(sqe, events->file_descriptor, &slot.message, 0);
+            io_uring_sqe_set_data64(sqe, slot_index);
+
+            context.sends_in_flight++;
+            packets_queued++;
+        }
+
+        if(client_data_pending) {
+            /* we ran out of send slots or the command quantum, rescheduling write */
+            this->enqueue_client_write(&*client);
+            more_clients = true;
+        }
+
+        client = nullptr;
+    }
+
+    if(packets_queued > 0) {
+        io_uring_submit(&context.ring);
+        events->send_statistics.register_send(packets_queued);
+    }
+
+    if(context.free_send_slots.empty()) {
+        context.write_blocked = true;
+        more_clients = false;
+        return false;
+    }
+
+    return true;
+}
+
+void VoiceServerSocket::network_event_io_uring(int, short, void *ptr_network_events) {
+    auto network_events = (NetworkEvents*) ptr_network_events;
+
+    /* reset the event fd counter */
+    uint64_t counter;
+    (void) ::read(network_events->io_uring->event_fd, &counter, sizeof(counter));
+
+    network_events->socket->process_io_uring_completions(network_events);
+}
+
+void VoiceServerSocket::process_io_uring_completions(NetworkEvents *events) {
+    auto& context = *events->io_uring;
+    const auto buffer_mask = io_uring_buf_ring_mask(context.buffer_count);
+
+    size_t datagrams_received{0};
+    size_t buffers_returned{0};
+    bool sends_completed{false};
+
+    if(events->flood_filter) {
+        events->flood_filter->update_clock();
+    }
+
+    unsigned head;
+    unsigned completions{0};
+    io_uring_cqe* cqe;
+    io_uring_for_each_cqe(&context.ring, head, cqe) {
+        completions++;
+
+        auto user_data = io_uring_cqe_get_data64(cqe);
+        if(user_data == IOUringContext::kUserDataReceive) {
+            if((cqe->flags & IORING_CQE_F_MORE) == 0) {
+                context.receive_armed = false;
+            }
+
+            if(cqe->res < 0) {
+                if(cqe->res != -ENOBUFS && cqe->res != -ECANCELED) {
+                    logCritical(this->server_id, "Could not receive datagram packets! Code: {} Reason: {}", -cqe->res, strerror(-cqe->res));
+                }
+                continue;
+            }
+
+            if((cqe->flags & IORING_CQE_F_BUFFER) == 0) {
+                continue;
+            }
+
+            auto buffer_id = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+            auto buffer = context.receive_buffer(buffer_id);
+
+            auto message_out = io_uring_recvmsg_validate(buffer, cqe->res, &context.receive_message);
+            if(message_out) {
+                sockaddr_storage remote_address{};
+                memcpy(&remote_address, io_uring_recvmsg_name(message_out), std::min((size_t) message_out->namelen, sizeof(remote_address)));
+
+                if((message_out->flags & MSG_TRUNC) > 0) {
+                    this->log_truncated_datagram(remote_address);
+                } else {
+                    /* handle_datagram only needs the control messages to extract the packet info */
+                    msghdr message{};
+                    message.msg_control = (uint8_t*) io_uring_recvmsg_name(message_out) + context.receive_message.msg_namelen;
+                    message.msg_controllen = message_out->controllen;
+
+                    auto payload = io_uring_recvmsg_payload(message_out, &context.receive_message);
+                    auto payload_length = io_uring_recvmsg_payload_length(message_out, cqe->res, &context.receive_message);
+                    this->handle_datagram(events, remote_address, message, pipes::buffer_view{payload, payload_length});
+                    datagrams_received++;
+                }
+            }
+
+            io_uring_buf_ring_add(context.buffer_ring, buffer, IOUringContext::kReceiveBufferSize, buffer_id, buffer_mask, buffers_returned++);
+        } else if(user_data == IOUringContext::kUserDataCancel) {
+            continue;
+        } else {
+            auto& slot = context.send_slots[user_data];
+            if(cqe->res < 0) {
+                logTrace(this->server_id, "Failed to write datagram packet to {} (errno: {} message: {}). Dropping packet!", net::to_string(slot.address), -cqe->res, strerror(-cqe->res));
+            }
+
+            std::exchange(slot.packet, nullptr)->unref();
+            context.free_send_slots.push_back(user_data);
+            context.sends_in_flight--;
+            sends_completed = true;
+        }
+    }
+    io_uring_cq_advance(&context.ring, completions);
+
+    if(buffers_returned > 0) {
+        io_uring_buf_ring_advance(context.buffer_ring, buffers_returned);
+    }
+
+    if(datagrams_received > 0) {
+        events->receive_statistics.register_receive(datagrams_received);
+    }
+
+    if(!context.receive_armed) {
+        /* The multishot receive terminates if we've run out of buffers or an error occurred */
+        if(context.arm_receive(events->file_descriptor)) {
+            io_uring_submit(&context.ring);
+        }
+    }
+
+    if(sends_completed && context.write_blocked) {
+        context.write_blocked = false;
+        event_add(events->event_write, nullptr);
+    }
+}
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "./VoiceServer.h"
+
+#ifdef HAVE_IO_URING
+#include <liburing.h>
+#endif
+
+namespace ts::server {
+#ifdef HAVE_IO_URING
+    struct VoiceServerSocket::IOUringContext {
+        constexpr static auto kBufferGroup{0x7E};
+        constexpr static auto kReceiveBufferSize{2048}; /* io_uring_recvmsg_out + address + control + payload */
+        static_assert(kReceiveBufferSize >= sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_storage) + VoiceServerSocket::kReceiveControlSize + VoiceServerSocket::kReceiveBufferSize);
+
+        constexpr static uint64_t kUserDataReceive{~0ULL};
+        constexpr static uint64_t kUserDataCancel{~0ULL - 1};
+
+        struct SendSlot {
+            msghdr message{};
+            iovec vector{};
+            sockaddr_storage address{};
+            char control[CMSG_SPACE(sizeof(in6_pktinfo))]{};
+            protocol::OutgoingServerPacket* packet{nullptr};
+        };
+
+        io_uring ring{};
+        bool ring_initialized{false};
+        int event_fd{-1};
+
+        /* Provided buffers for the multishot receive. */
+        io_uring_buf_ring* buffer_ring{nullptr};
+        size_t buffer_count{0};
+        std::unique_ptr<uint8_t[]> receive_buffers{nullptr};
+
+        /* Template used by the kernel to lay out every received datagram within the provided buffer */
+        msghdr receive_message{};
+        bool receive_armed{false};
+
+        std::unique_ptr<SendSlot[]> send_slots{nullptr};
+        std::vector<uint32_t> free_send_slots{};
+        size_t sends_in_flight{0};
+
+        /* Set if we've run out of send slots. The next send completion will rearm the write event. */
+        bool write_blocked{false};
+
+        IOUringContext() = default;
+        IOUringContext(const IOUringContext&) = delete;
+        IOUringContext(IOUringContext&&) = delete;
+        ~IOUringContext();
+
+        [[nodiscard]] inline uint8_t* receive_buffer(size_t buffer_id) {
+            return &this->receive_buffers[buffer_id * kReceiveBufferSize];
+        }
+
+        /**
+         * Queue the multishot receive.
+         * Returns false if the submission queue is full.
+         */
+        [[nodiscard]] bool arm_receive(int /* file descriptor */);
+    };
+#else
+    struct VoiceServerSocket::IOUringContext {
+        int event_fd{-1};
+    };
+#endif
+}
@@ -7,13 +7,19 @@
 #include <sql/sqlite/SqliteSQL.h>
 #include <sys/resource.h>
 #include <protocol/buffers.h>
+#include <protocol/Packet.h>
+#include <protocol/CryptEAX.h>
 
 #include "../SignalHandler.h"
 #include "../client/ConnectedClient.h"
 #include "../InstanceHandler.h"
 #include "../ShutdownHelper.h"
 #include "../server/QueryServer.h"
+#include "../server/VoiceServer.h"
+#include "../client/voice/PacketEncoder.h"
 #include "../groups/GroupManager.h"
+#include "../Metrics.h"
+#include "../LockProfiler.h"
 
 #ifdef HAVE_JEMALLOC
     #include <jemalloc/jemalloc.h>
@@ -83,6 +89,12 @@ namespace terminal::chandler {
             return handleCommandReload(command, cmd);
         else if(cmd.lcommand == "taskinfo")
             return handleCommandTaskInfo(command, cmd);
+        else if(cmd.lcommand == "netstats")
+            return handleCommandNetStats(command, cmd);
+        else if(cmd.lcommand == "commandstats")
+            return handleCommandCommandStats(command, cmd);
+        else if(cmd.lcommand == "lockstats")
+            return handleCommandLockStats(command, cmd);
         else {
             logWarning(LOG_INSTANCE, "Missing terminal command {} ({})", cmd.command, cmd.line);
             command.response.emplace_back("unknown command");
@@ -118,6 +130,9 @@ namespace terminal::chandler {
         handle.response.emplace_back("  - dummy_crash");
         handle.response.emplace_back("  - memflush");
         handle.response.emplace_back("  - meminfo");
+        handle.response.emplace_back("  - netstats [server id]");
+        handle.response.emplace_back("  - commandstats [limit] [server id]");
+        handle.response.emplace_back("  - lockstats [call sites]");
         return true;
     }
 
@@ -393,7 +408,7 @@ namespace terminal::chandler {
 
     //meminfo track
     bool handleCommandMemInfo(CommandHandle& /* handle */, TerminalCommand& cmd){
-        bool flag_base = false, flag_malloc = false, flag_track = false, flag_buffer = false;
+        bool flag_base = false, flag_malloc = false, flag_track = false, flag_buffer = false, flag_packets = false;
 
         if(cmd.arguments.size() > 0) {
             if(cmd.larguments[0] == "basic")
@@ -404,8 +419,10 @@ namespace terminal::chandler {
                 flag_track = true;
             else if(cmd.larguments[0] == "buffers")
                 flag_buffer = true;
+            else if(cmd.larguments[0] == "packets")
+                flag_packets = true;
         } else {
-            flag_base = flag_malloc = flag_track = flag_buffer = true;
+            flag_base = flag_malloc = flag_track = flag_buffer = flag_packets = true;
         }
 
         if(flag_base) {
@@ -434,6 +451,16 @@ namespace terminal::chandler {
             logMessage("  Buffers : {}kb", ceil((info.bytes_buffer) / 1024));
             logMessage("  Buffers Used: {}kb", ceil((info.bytes_buffer_used) / 1024));
         }
+        if(flag_packets) {
+            auto info = protocol::outgoing_server_packet_cache_statistics();
+            auto allocations = info.hits + info.misses + info.oversized;
+            logMessage("Outgoing packet cache:");
+            logMessage("  Allocations    : {} ({} cached, {} new, {} oversized)", allocations, info.hits, info.misses, info.oversized);
+            logMessage("  Hit rate       : {:.2f}%", allocations > 0 ? info.hits * 100.0 / allocations : 0.0);
+            logMessage("  Depot transfers: {}", info.depot_transfers);
+            logMessage("  Depot packets  : {}", info.depot_packets);
+            logMessage("  Thread caches  : {}", info.threads);
+        }
         return true;
     }
 
@@ -540,4 +567,307 @@ namespace terminal::chandler {
         }, cmd.arguments.size() >= 1 && cmd.larguments[0] == "full");
         return true;
     }
-}
\ No newline at end of file
+
+    bool handleCommandNetStats(CommandHandle& handle, TerminalCommand& cmd) {
+        ServerId target_server_id{0};
+        if(!cmd.arguments.empty()) {
+            if(cmd.larguments[0].find_first_not_of("0123456789") != std::string::npos) {
+                handle.response.emplace_back("Invalid server id! (Given number isn't numeric!)");
+                return false;
+            }
+
+            target_server_id = cmd.arguments[0];
+        }
+
+        {
+            using PacketEncoder = ts::server::server::udp::PacketEncoder;
+            auto statistics = PacketEncoder::encrypt_stage_statistics();
+            auto average = statistics.batches > 0 ? (double) statistics.packets / (double) statistics.batches : 0;
+
+            handle.response.emplace_back("Packet encryption:");
+            handle.response.emplace_back("  Cipher backend  : " + std::string{connection::eax::backend_name(connection::eax::active_backend())});
+            handle.response.emplace_back("  Encrypt workers : " + (config::threads::voice::encrypt > 0 ? std::to_string(config::threads::voice::encrypt) : std::string{"none (network event loops)"}));
+            handle.response.emplace_back("  Encrypt batches : " + std::to_string(statistics.batches) + " (" + std::to_string(average) + " packets per batch)");
+            for(size_t bucket{0}; bucket < PacketEncoder::kEncryptHistogramBuckets; bucket++) {
+                if(!statistics.queue_depths[bucket]) {
+                    continue;
+                }
+
+                auto bucket_begin = 1ULL << bucket;
+                auto bucket_range = bucket + 1 < PacketEncoder::kEncryptHistogramBuckets ?
+                        std::to_string(bucket_begin) + "-" + std::to_string((bucket_begin << 1U) - 1) :
+                        std::to_string(bucket_begin) + "+";
+
+                handle.response.emplace_back("    Queue depth " + bucket_range + " packets: " + std::to_string(statistics.queue_depths[bucket]));
+            }
+            for(size_t bucket{0}; bucket < PacketEncoder::kEncryptHistogramBuckets; bucket++) {
+                if(!statistics.encrypt_latencies[bucket]) {
+                    continue;
+                }
+
+                auto bucket_begin = bucket == 0 ? 0ULL : 1ULL << bucket;
+                auto bucket_range = bucket + 1 < PacketEncoder::kEncryptHistogramBuckets ?
+                        std::to_string(bucket_begin) + "-" + std::to_string((2ULL << bucket) - 1) :
+                        std::to_string(bucket_begin) + "+";
+
+                handle.response.emplace_back("    Batch latency " + bucket_range + "us: " + std::to_string(statistics.encrypt_latencies[bucket]));
+            }
+        }
+
+        for(const auto& server : serverInstance->getVoiceServerManager()->serverInstances()) {
+            if(target_server_id > 0 && server->getServerId() != target_server_id) {
+                continue;
+            }
+
+            auto voice_server = server->getVoiceServer();
+            if(!voice_server) {
+                continue;
+            }
+
+            handle.response.emplace_back("Server " + std::to_string(server->getServerId()) + ":");
+            uint64_t server_dropped_source{0}, server_dropped_prefix{0};
+            for(const auto& socket : voice_server->getSockets()) {
+                if(!socket->is_active()) {
+                    continue;
+                }
+
+                auto statistics = socket->statistics();
+                auto average = statistics.receive_calls > 0 ? (double) statistics.datagrams_received / (double) statistics.receive_calls : 0;
+
+                handle.response.emplace_back("  " + net::to_string(socket->address()) + ":");
+                std::string io_backend{"libevent"};
+                if(statistics.io_uring_events > 0) {
+                    io_backend = "io_uring (" + std::to_string(statistics.io_uring_events) + " of " + std::to_string(statistics.shards.size()) + " network events)";
+                }
+                handle.response.emplace_back("    I/O backend       : " + io_backend);
+                handle.response.emplace_back("    Receive batch size: " + std::to_string(statistics.receive_batch_size));
+                handle.response.emplace_back("    Receive calls     : " + std::to_string(statistics.receive_calls));
+                handle.response.emplace_back("    Datagrams received: " + std::to_string(statistics.datagrams_received) + " (" + std::to_string(average) + " per call)");
+                for(size_t bucket{0}; bucket < statistics.batch_sizes.size(); bucket++) {
+                    if(!statistics.batch_sizes[bucket]) {
+                        continue;
+                    }
+
+                    auto bucket_begin = 1ULL << bucket;
+                    auto bucket_range = bucket + 1 < statistics.batch_sizes.size() ?
+                            std::to_string(bucket_begin) + "-" + std::to_string((bucket_begin << 1U) - 1) :
+                            std::to_string(bucket_begin) + "+";
+
+                    handle.response.emplace_back("      Batches with " + bucket_range + " datagrams: " + std::to_string(statistics.batch_sizes[bucket]));
+                }
+
+                if(statistics.flood_filter) {
+                    handle.response.emplace_back("    Flood filter drops: " + std::to_string(statistics.dropped_source) + " by address, " + std::to_string(statistics.dropped_prefix) + " by network");
+                    server_dropped_source += statistics.dropped_source;
+                    server_dropped_prefix += statistics.dropped_prefix;
+                } else {
+                    handle.response.emplace_back("    Flood filter      : disabled");
+                }
+
+                auto send_average = statistics.send_calls > 0 ? (double) statistics.datagrams_sent / (double) statistics.send_calls : 0;
+                handle.response.emplace_back("    Send batch size   : " + std::to_string(statistics.send_batch_size) + (statistics.gso_enabled ? " (GSO enabled)" : ""));
+                handle.response.emplace_back("    Send calls        : " + std::to_string(statistics.send_calls));
+                handle.response.emplace_back("    Datagrams sent    : " + std::to_string(statistics.datagrams_sent) + " (" + std::to_string(send_average) + " per call)");
+                handle.response.emplace_back("    GSO messages      : " + std::to_string(statistics.gso_messages) + " (" + std::to_string(statistics.gso_segments) + " segments)");
+
+                if(statistics.socket_shards > 0) {
+                    handle.response.emplace_back("    Socket shards     : " + std::to_string(statistics.socket_shards));
+                    for(size_t shard{0}; shard < statistics.shards.size(); shard++) {
+                        handle.response.emplace_back("      Shard " + std::to_string(shard) + ": " +
+                                std::to_string(statistics.shards[shard].datagrams_received) + " received, " +
+                                std::to_string(statistics.shards[shard].datagrams_sent) + " sent");
+                    }
+                }
+
+                std::array<uint64_t, VoiceServerSocket::kTimerLagBuckets> timer_lags{};
+                handle.response.emplace_back("    Client timers     :");
+                for(size_t shard{0}; shard < statistics.shards.size(); shard++) {
+                    const auto& shard_statistics = statistics.shards[shard];
+                    handle.response.emplace_back("      Network event " + std::to_string(shard) + ": " +
+                            std::to_string(shard_statistics.timer_clients) + " clients, " +
+                            std::to_string(shard_statistics.timer_runs) + " runs, " +
+                            std::to_string(shard_statistics.timer_clients_processed) + " clients processed, " +
+                            std::to_string(shard_statistics.timer_lag_max) + "ms max lag");
+
+                    for(size_t bucket{0}; bucket < timer_lags.size(); bucket++) {
+                        timer_lags[bucket] += shard_statistics.timer_lags[bucket];
+                    }
+                }
+                for(size_t bucket{0}; bucket < timer_lags.size(); bucket++) {
+                    if(!timer_lags[bucket]) {
+                        continue;
+                    }
+
+                    auto bucket_begin = bucket == 0 ? 0ULL : 1ULL << (bucket - 1);
+                    auto bucket_range = bucket + 1 < timer_lags.size() ?
+                            std::to_string(bucket_begin) + "-" + std::to_string(bucket == 0 ? 0ULL : (1ULL << bucket) - 1) :
+                            std::to_string(bucket_begin) + "+";
+
+                    handle.response.emplace_back("      Timer lag " + bucket_range + "ms: " + std::to_string(timer_lags[bucket]));
+                }
+            }
+            handle.response.emplace_back("  Flood filter drops: " + std::to_string(server_dropped_source) + " by address, " + std::to_string(server_dropped_prefix) + " by network");
+        }
+
+        return true;
+    }
+
+    bool handleCommandCommandStats(CommandHandle& handle, TerminalCommand& cmd) {
+        size_t limit{20};
+        ServerId target_server_id{0};
+        bool filter_server{false};
+        for(size_t index{0}; index < cmd.arguments.size() && index < 2; index++) {
+            if(cmd.larguments[index].empty() || cmd.larguments[index].find_first_not_of("0123456789") != std::string::npos) {
+                handle.response.emplace_back("Invalid argument " + cmd.arguments[index].string() + "! (Given number isn't numeric!)");
+                return false;
+            }
+
+            if(index == 0) {
+                limit = cmd.arguments[index].as<size_t>();
+            } else {
+                target_server_id = cmd.arguments[index];
+                filter_server = true;
+            }
+        }
+
+        struct CommandEntry {
+            ServerId server_id;
+            std::string command;
+            metrics::Histogram::Snapshot execution;
+            metrics::Histogram::Snapshot queue_wait;
+            uint64_t max_execution;
+        };
+
+        std::vector<CommandEntry> entries{};
+        for(const auto& server_metrics : metrics::registry().server_metrics()) {
+            if(filter_server && server_metrics->server_id != target_server_id) {
+                continue;
+            }
+
+            server_metrics->for_each_command([&](const std::string& command, const metrics::CommandMetrics& command_metrics) {
+                entries.push_back(CommandEntry{
+                        server_metrics->server_id,
+                        command,
+                        command_metrics.execution.snapshot(),
+                        command_metrics.queue_wait.snapshot(),
+                        command_metrics.max_execution.load(std::memory_order_relaxed)
+                });
+            });
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.execution.sum > b.execution.sum; });
+        if(entries.size() > limit) {
+            entries.resize(limit);
+        }
+
+        auto format_ms = [](uint64_t nanoseconds) {
+            auto result = std::to_string((double) nanoseconds / 1'000'000.0);
+            return result.substr(0, result.find('.') + 4) + "ms";
+        };
+
+        handle.response.emplace_back("Most expensive commands (by total execution time):");
+        if(entries.empty()) {
+            handle.response.emplace_back("  none");
+        }
+
+        size_t position{1};
+        for(const auto& entry : entries) {
+            auto count = std::max(entry.execution.count, (uint64_t) 1);
+            handle.response.emplace_back("  " + std::to_string(position++) + ". " + entry.command + " (" + (entry.server_id > 0 ? "server " + std::to_string(entry.server_id) : std::string{"instance"}) + "): " +
+                    std::to_string(entry.execution.count) + " calls, " +
+                    format_ms(entry.execution.sum) + " total, " +
+                    format_ms(entry.execution.sum / count) + " avg, " +
+                    format_ms(entry.execution.quantile(.99)) + " p99, " +
+                    format_ms(entry.max_execution) + " max, " +
+                    format_ms(entry.queue_wait.sum / count) + " avg queue wait");
+        }
+        return true;
+    }
+
+    bool handleCommandLockStats(CommandHandle& handle, TerminalCommand& cmd) {
+        if(!lock_profiler::kEnabled) {
+            handle.response.emplace_back("The lock profiler isn't available. Compile the server with COMPILE_LOCK_PROFILER enabled.");
+            return false;
+        }
+
+        size_t call_site_limit{3};
+        if(!cmd.arguments.empty()) {
+            if(cmd.larguments[0].empty() || cmd.larguments[0].find_first_not_of("0123456789") != std::string::npos) {
+                handle.response.emplace_back("Invalid argument " + cmd.arguments[0].string() + "! (Given number isn't numeric!)");
+                return false;
+            }
+
+            call_site_limit = cmd.arguments[0].as<size_t>();
+        }
+
+        auto format_us = [](uint64_t nanoseconds) {
+            auto result = std::to_string((double) nanoseconds / 1'000.0);
+            return result.substr(0, result.find('.') + 3) + "us";
+        };
+
+        auto format_histogram = [&](const metrics::Histogram::Snapshot& snapshot) {
+            return format_us(snapshot.sum / std::max(snapshot.count, (uint64_t) 1)) + " avg, " +
+                    format_us(snapshot.quantile(.99)) + " p99, " +
+                    format_us(snapshot.sum) + " total";
+        };
+
+        auto locks = lock_profiler::registered_locks();
+        std::sort(locks.begin(), locks.end(), [](const auto& a, const auto& b) {
+            return a->wait_exclusive.snapshot().sum + a->wait_shared.snapshot().sum > b->wait_exclusive.snapshot().sum + b->wait_shared.snapshot().sum;
+        });
+
+        handle.response.emplace_back("Lock contention (by total wait time):");
+        if(locks.empty()) {
+            handle.response.emplace_back("  none");
+        }
+
+        for(const auto& lock : locks) {
+            handle.response.emplace_back("  " + lock->name + ":");
+
+            for(const auto shared : {false, true}) {
+                auto wait = (shared ? lock->wait_shared : lock->wait_exclusive).snapshot();
+                auto hold = (shared ? lock->hold_shared : lock->hold_exclusive).snapshot();
+                if(wait.count == 0) {
+                    continue;
+                }
+
+                auto contended = (shared ? lock->contended_shared : lock->contended_exclusive).load(std::memory_order_relaxed);
+                handle.response.emplace_back(std::string{"    "} + (shared ? "shared" : "exclusive") + ": " +
+                        std::to_string(wait.count) + " acquisitions, " +
+                        std::to_string(contended) + " contended (" + std::to_string(contended * 100 / wait.count) + "%)");
+                handle.response.emplace_back("      wait: " + format_histogram(wait));
+                handle.response.emplace_back("      hold: " + format_histogram(hold));
+            }
+
+            auto call_sites = lock->call_sites();
+            if(call_sites.size() > call_site_limit) {
+                call_sites.resize(call_site_limit);
+            }
+
+            size_t position{1};
+            for(const auto& call_site : call_sites) {
+                /* show the first two frames outside of the profiler and the std lock wrappers */
+                std::string location{};
+                size_t frame_count{0};
+                for(auto frame : call_site.frames) {
+                    if(!frame || lock_profiler::internal_frame(frame)) {
+                        continue;
+                    }
+
+                    location += (frame_count > 0 ? " <- " : "") + lock_profiler::describe_frame(frame);
+                    if(++frame_count >= 2) {
+                        break;
+                    }
+                }
+
+                handle.response.emplace_back("    " + std::to_string(position++) + ". " + std::to_string(call_site.contentions) + " contentions, " +
+                        format_us(call_site.wait_sum) + " total wait: " + location);
+            }
+
+            if(auto untracked = lock->untracked_contentions(); untracked > 0) {
+                handle.response.emplace_back("    " + std::to_string(untracked) + " contentions from untracked call sites");
+            }
+        }
+        return true;
+    }
+}
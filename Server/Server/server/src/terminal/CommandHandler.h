@@ -41,4 +41,7 @@ namespace terminal::chandler {
 
     extern bool handleCommandReload(CommandHandle& /* handle */, TerminalCommand&);
     extern bool handleCommandTaskInfo(CommandHandle& /* handle */, TerminalCommand&);
+    extern bool handleCommandNetStats(CommandHandle& /* handle */, TerminalCommand&);
+    extern bool handleCommandCommandStats(CommandHandle& /* handle */, TerminalCommand&);
+    extern bool handleCommandLockStats(CommandHandle& /* handle */, TerminalCommand&);
 }
\ No newline at end of file
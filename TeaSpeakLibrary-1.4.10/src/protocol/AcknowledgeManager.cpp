@@ -1,5 +1,6 @@
 #include "AcknowledgeManager.h"
 #include <cmath>
+#include <cassert>
 #include <algorithm>
 
 using namespace ts;
@@ -8,7 +9,15 @@ using namespace ts::protocol;
 using namespace std;
 using namespace std::chrono;
 
-AcknowledgeManager::AcknowledgeManager() = default;
+namespace {
+    inline size_t window_index(uint8_t packet_type) {
+        return packet_type == protocol::COMMAND_LOW ? 1 : 0;
+    }
+}
+
+AcknowledgeManager::AcknowledgeManager() {
+    this->timer_wheel.current_tick = AcknowledgeManager::wheel_tick(system_clock::now(), false);
+}
 
 AcknowledgeManager::~AcknowledgeManager() {
     this->reset();
@@ -19,7 +28,27 @@ void AcknowledgeManager::reset() {
 
     {
         std::unique_lock lock{this->entry_lock};
-        auto pending_entries = std::move(this->entries);
+        std::deque<std::shared_ptr<Entry>> pending_entries{std::move(this->window_overflow)};
+        this->window_overflow.clear();
+
+        for(auto& window : this->window) {
+            for(auto& entry : window) {
+                if(entry) {
+                    pending_entries.push_back(std::move(entry));
+                }
+            }
+        }
+
+        for(auto& entry : pending_entries) {
+            entry->wheel_slot = nullptr;
+            entry->wheel_previous = nullptr;
+            entry->wheel_next = nullptr;
+        }
+
+        auto current_tick = this->timer_wheel.current_tick;
+        this->timer_wheel = TimerWheel{};
+        this->timer_wheel.current_tick = current_tick;
+        this->entry_count = 0;
         lock.unlock();
 
         /* save because entries are not accessible anymore */
@@ -33,7 +62,7 @@ void AcknowledgeManager::reset() {
 
 size_t AcknowledgeManager::awaiting_acknowledge() {
     std::lock_guard lock(this->entry_lock);
-    return this->entries.size();
+    return this->entry_count;
 }
 
 void AcknowledgeManager::process_packet(uint8_t type, uint32_t id, void *ptr, std::unique_ptr<std::function<void(bool)>> ack) {
@@ -56,7 +85,16 @@ void AcknowledgeManager::process_packet(uint8_t type, uint32_t id, void *ptr, st
     entry->send_count = 1;
     {
         std::lock_guard lock(this->entry_lock);
-        this->entries.push_front(std::move(entry));
+        this->wheel_schedule(&*entry, entry->next_resend);
+
+        auto& slot = this->window[window_index(type)][id & (kWindowSize - 1)];
+        if(!slot) {
+            slot = std::move(entry);
+        } else {
+            /* more than kWindowSize packets are in flight */
+            this->window_overflow.push_back(std::move(entry));
+        }
+        this->entry_count++;
     }
 }
 
@@ -67,20 +105,22 @@ bool AcknowledgeManager::process_acknowledge(uint8_t packet_type, uint16_t targe
     std::unique_ptr<std::function<void(bool)>> ack_listener;
     {
         std::lock_guard lock{this->entry_lock};
-        for(auto it = this->entries.begin(); it != this->entries.end(); it++) {
-            if((*it)->packet_type == target_type && (*it)->packet_full_id == target_id) {
-                entry = *it;
-                ack_listener = std::move(entry->acknowledge_listener); /* move it out so nobody else could call it as well */
-
-                entry->send_count--;
-                if(entry->send_count == 0) {
-                    this->entries.erase(it);
-                    if(entry->resend_count == 0) {
-                        auto difference = std::chrono::system_clock::now() - entry->first_send;
-                        this->rto_calculator_.update((float) std::chrono::duration_cast<std::chrono::milliseconds>(difference).count());
-                    }
+        auto location = this->find_entry(target_type, target_id);
+        if(location) {
+            entry = *location;
+            ack_listener = std::move(entry->acknowledge_listener); /* move it out so nobody else could call it as well */
+            entry->acknowledged = true;
+
+            entry->send_count--;
+            if(entry->send_count == 0) {
+                if(entry->resend_count == 0) {
+                    auto difference = std::chrono::system_clock::now() - entry->first_send;
+                    this->rto_calculator_.update((float) std::chrono::duration_cast<std::chrono::milliseconds>(difference).count());
                 }
-                break;
+                (void) this->remove_entry(&*entry);
+            } else {
+                /* Some resends are lost. So we just drop it after time */
+                this->wheel_schedule(&*entry, entry->next_resend + std::chrono::milliseconds{(int64_t) ceil(this->rto_calculator_.current_rto() * 4)});
             }
         }
     }
@@ -89,7 +129,6 @@ bool AcknowledgeManager::process_acknowledge(uint8_t packet_type, uint16_t targe
         return false;
     }
 
-    entry->acknowledged = true;
     if(ack_listener) {
         (*ack_listener)(true);
     }
@@ -102,34 +141,240 @@ void AcknowledgeManager::execute_resend(const system_clock::time_point& now , st
     {
         std::lock_guard lock{this->entry_lock};
 
-        this->entries.erase(std::remove_if(this->entries.begin(), this->entries.end(), [&](std::shared_ptr<Entry>& entry) {
+        std::vector<Entry*> expired{};
+        this->wheel_advance(AcknowledgeManager::wheel_tick(now, false), expired);
+
+        for(auto entry : expired) {
             if(entry->acknowledged) {
-                if (entry->next_resend + std::chrono::milliseconds{(int64_t) ceil(this->rto_calculator_.current_rto() * 4)} <= now) {
-                    /* Some resends are lost. So we just drop it after time */
-                    return true;
-                }
+                /* the drop timeout for acknowledged packets has been reached */
+                (void) this->remove_entry(entry);
+            } else if(entry->resend_count > 15 && entry->first_send + seconds(15) < now) {
+                /* packet resend seems to have failed */
+                resend_failed.push_back(this->remove_entry(entry));
             } else {
-                if (entry->next_resend <= now) {
-                    if (entry->resend_count > 15 && entry->first_send + seconds(15) < now) {
-                        /* packet resend seems to have failed */
-                        resend_failed.push_back(std::move(entry));
-                        return true;
-                    } else {
-                        entry->next_resend = now + std::chrono::milliseconds{(int64_t) std::min(ceil(this->rto_calculator_.current_rto()), 1500.f)};
-                        buffers.push_back(entry);
-                        //entry->resend_count++; /* this MUST be incremented by the result handler (resend may fails) */
-                        entry->send_count++;
-                    }
-                }
-                if (next_resend > entry->next_resend) {
-                    next_resend = entry->next_resend;
-                }
+                entry->next_resend = now + std::chrono::milliseconds{(int64_t) std::min(ceil(this->rto_calculator_.current_rto()), 1500.f)};
+                this->wheel_schedule(entry, entry->next_resend);
+
+                buffers.push_back(*this->locate_entry(entry));
+                //entry->resend_count++; /* this MUST be incremented by the result handler (resend may fails) */
+                entry->send_count++;
             }
-            return false;
-        }), this->entries.end());
+        }
+
+        auto wheel_next = this->wheel_next_deadline();
+        if(next_resend > wheel_next) {
+            next_resend = wheel_next;
+        }
     }
 
     for(const auto& failed : resend_failed) {
         this->callback_resend_failed(this->callback_data, failed);
     }
-}
\ No newline at end of file
+}
+
+std::shared_ptr<AcknowledgeManager::Entry>* AcknowledgeManager::find_entry(uint8_t packet_type, uint16_t packet_id) {
+    auto& slot = this->window[window_index(packet_type)][packet_id & (kWindowSize - 1)];
+    if(slot && slot->packet_type == packet_type && (uint16_t) slot->packet_full_id == packet_id) {
+        return &slot;
+    }
+
+    for(auto& entry : this->window_overflow) {
+        if(entry->packet_type == packet_type && (uint16_t) entry->packet_full_id == packet_id) {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
+
+std::shared_ptr<AcknowledgeManager::Entry>* AcknowledgeManager::locate_entry(const Entry* entry) {
+    auto& slot = this->window[window_index(entry->packet_type)][entry->packet_full_id & (kWindowSize - 1)];
+    if(slot.get() == entry) {
+        return &slot;
+    }
+
+    for(auto& overflow_entry : this->window_overflow) {
+        if(overflow_entry.get() == entry) {
+            return &overflow_entry;
+        }
+    }
+
+    return nullptr;
+}
+
+std::shared_ptr<AcknowledgeManager::Entry> AcknowledgeManager::remove_entry(Entry* entry) {
+    this->wheel_unschedule(entry);
+
+    auto& slot = this->window[window_index(entry->packet_type)][entry->packet_full_id & (kWindowSize - 1)];
+    std::shared_ptr<Entry> result{};
+    if(slot.get() == entry) {
+        result = std::move(slot);
+    } else {
+        auto it = std::find_if(this->window_overflow.begin(), this->window_overflow.end(), [&](const auto& overflow_entry) {
+            return overflow_entry.get() == entry;
+        });
+        assert(it != this->window_overflow.end());
+
+        result = std::move(*it);
+        this->window_overflow.erase(it);
+    }
+
+    assert(this->entry_count > 0);
+    this->entry_count--;
+    return result;
+}
+
+int64_t AcknowledgeManager::wheel_tick(const std::chrono::system_clock::time_point &timestamp, bool round_up) {
+    auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()).count();
+    if(round_up) {
+        milliseconds += kWheelTickMilliseconds - 1;
+    }
+    return milliseconds / kWheelTickMilliseconds;
+}
+
+void AcknowledgeManager::wheel_schedule(Entry *entry, const std::chrono::system_clock::time_point &deadline) {
+    if(entry->wheel_slot) {
+        this->wheel_unschedule(entry);
+    }
+
+    entry->wheel_deadline = deadline;
+    this->wheel_insert(entry);
+    this->timer_wheel.entry_count++;
+}
+
+void AcknowledgeManager::wheel_unschedule(Entry *entry) {
+    if(!entry->wheel_slot) {
+        return;
+    }
+
+    if(entry->wheel_previous) {
+        entry->wheel_previous->wheel_next = entry->wheel_next;
+    } else {
+        assert(*entry->wheel_slot == entry);
+        *entry->wheel_slot = entry->wheel_next;
+    }
+
+    if(entry->wheel_next) {
+        entry->wheel_next->wheel_previous = entry->wheel_previous;
+    }
+
+    entry->wheel_slot = nullptr;
+    entry->wheel_previous = nullptr;
+    entry->wheel_next = nullptr;
+
+    assert(this->timer_wheel.entry_count > 0);
+    this->timer_wheel.entry_count--;
+}
+
+void AcknowledgeManager::wheel_insert(Entry *entry) {
+    auto& wheel = this->timer_wheel;
+
+    /* deadlines which have already been passed will expire with the next tick */
+    auto tick = std::max(AcknowledgeManager::wheel_tick(entry->wheel_deadline, true), wheel.current_tick + 1);
+
+    Entry** slot;
+    if(tick - wheel.current_tick < (int64_t) kWheelLevel0Slots) {
+        slot = &wheel.level0[tick & (kWheelLevel0Slots - 1)];
+    } else if((tick >> kWheelLevel0Bits) - (wheel.current_tick >> kWheelLevel0Bits) < (int64_t) kWheelLevel1Slots) {
+        slot = &wheel.level1[(tick >> kWheelLevel0Bits) & (kWheelLevel1Slots - 1)];
+    } else {
+        slot = &wheel.far;
+    }
+
+    entry->wheel_slot = slot;
+    entry->wheel_previous = nullptr;
+    entry->wheel_next = *slot;
+    if(*slot) {
+        (*slot)->wheel_previous = entry;
+    }
+    *slot = entry;
+}
+
+void AcknowledgeManager::wheel_cascade(Entry *&slot) {
+    auto head = slot;
+    slot = nullptr;
+
+    while(head) {
+        auto next = head->wheel_next;
+        this->wheel_insert(head);
+        head = next;
+    }
+}
+
+void AcknowledgeManager::wheel_advance(int64_t target_tick, std::vector<Entry *> &expired) {
+    auto& wheel = this->timer_wheel;
+
+    if(target_tick - wheel.current_tick > (int64_t) (kWheelLevel0Slots * kWheelLevel1Slots)) {
+        /* We haven't been called for ages (or the system clock jumped). Reinsert everything relative to the new time. */
+        wheel.current_tick = target_tick - 1;
+
+        this->wheel_cascade(wheel.far);
+        for(auto& slot : wheel.level1) {
+            this->wheel_cascade(slot);
+        }
+        for(auto& slot : wheel.level0) {
+            this->wheel_cascade(slot);
+        }
+    }
+
+    while(wheel.current_tick < target_tick) {
+        if(!wheel.entry_count) {
+            wheel.current_tick = target_tick;
+            break;
+        }
+
+        auto tick = ++wheel.current_tick;
+        if((tick & (kWheelLevel0Slots - 1)) == 0) {
+            auto level1_index = (tick >> kWheelLevel0Bits) & (kWheelLevel1Slots - 1);
+            if(level1_index == 0) {
+                this->wheel_cascade(wheel.far);
+            }
+
+            this->wheel_cascade(wheel.level1[level1_index]);
+        }
+
+        auto& slot = wheel.level0[tick & (kWheelLevel0Slots - 1)];
+        while(slot) {
+            auto entry = slot;
+            this->wheel_unschedule(entry);
+            expired.push_back(entry);
+        }
+    }
+}
+
+std::chrono::system_clock::time_point AcknowledgeManager::wheel_next_deadline() const {
+    const auto& wheel = this->timer_wheel;
+    if(!wheel.entry_count) {
+        return std::chrono::system_clock::time_point::max();
+    }
+
+    auto list_minimum = [](const Entry* head) {
+        auto result = std::chrono::system_clock::time_point::max();
+        while(head) {
+            result = std::min(result, head->wheel_deadline);
+            head = head->wheel_next;
+        }
+        return result;
+    };
+
+    auto result = std::chrono::system_clock::time_point::max();
+    for(size_t offset{1}; offset < kWheelLevel0Slots; offset++) {
+        auto head = wheel.level0[(wheel.current_tick + offset) & (kWheelLevel0Slots - 1)];
+        if(head) {
+            result = list_minimum(head);
+            break;
+        }
+    }
+
+    /* level 0 reaches into the next level 1 slot so we've to check the first level 1 slot as well */
+    for(size_t offset{1}; offset < kWheelLevel1Slots; offset++) {
+        auto head = wheel.level1[((wheel.current_tick >> kWheelLevel0Bits) + offset) & (kWheelLevel1Slots - 1)];
+        if(head) {
+            result = std::min(result, list_minimum(head));
+            break;
+        }
+    }
+
+    /* entries in the far list have been inserted relative to an older tick and may expire before any level 1 entry */
+    return std::min(result, list_minimum(wheel.far));
+}
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <array>
+#include <deque>
 #include <memory>
 #include <chrono>
 #include <functional>
 #include <mutex>
+#include <vector>
 #include "./Packet.h"
 #include "./RtoCalculator.h"
 
@@ -23,6 +26,12 @@ namespace ts::connection {
                 std::unique_ptr<std::function<void(bool)>> acknowledge_listener;
 
                 void* packet_ptr;
+
+                /* Timer wheel linkage. Only accessed by the AcknowledgeManager while holding the entry lock. */
+                std::chrono::system_clock::time_point wheel_deadline{};
+                Entry* wheel_previous{nullptr};
+                Entry* wheel_next{nullptr};
+                Entry** wheel_slot{nullptr};
             };
 
             typedef void(*callback_resend_failed_t)(void* /* user data */, const std::shared_ptr<Entry>& /* entry */);
@@ -36,6 +45,10 @@ namespace ts::connection {
             void process_packet(uint8_t /* packet type */, uint32_t /* full packet id */, void* /* packet ptr */, std::unique_ptr<std::function<void(bool)>> /* ack listener */);
             bool process_acknowledge(uint8_t /* packet type */, uint16_t /* packet id */, std::string& /* error */);
 
+            /**
+             * Collect all packets which are due for a resend.
+             * Only the timer wheel slots which have been expired since the last call will be visited.
+             */
             void execute_resend(
                     const std::chrono::system_clock::time_point& /* now */,
                     std::chrono::system_clock::time_point& /* next resend */,
@@ -49,8 +62,53 @@ namespace ts::connection {
             void* callback_data{nullptr};
             callback_resend_failed_t callback_resend_failed{[](auto, auto){}}; /* must be valid all the time */
         private:
+            /*
+             * Entries are stored within a window indexed by their packet id (one window for Command and one for CommandLow).
+             * If more than kWindowSize packets are in flight the colliding entries will be kept within the overflow list.
+             */
+            constexpr static size_t kWindowSize{256};
+            constexpr static size_t kWindowTypes{2};
+
+            /*
+             * Hierarchical timer wheel holding the resend (or for acknowledged packets the drop) deadline of every entry.
+             * Level 0 covers ~1s with a resolution of 4ms, level 1 covers ~65s with a resolution of ~1s.
+             * Deadlines even further away are kept within the far list and cascaded every ~65s.
+             */
+            constexpr static int64_t kWheelTickMilliseconds{4};
+            constexpr static size_t kWheelLevel0Bits{8};
+            constexpr static size_t kWheelLevel1Bits{6};
+            constexpr static size_t kWheelLevel0Slots{1U << kWheelLevel0Bits};
+            constexpr static size_t kWheelLevel1Slots{1U << kWheelLevel1Bits};
+
+            struct TimerWheel {
+                int64_t current_tick{0};
+                size_t entry_count{0};
+
+                std::array<Entry*, kWheelLevel0Slots> level0{};
+                std::array<Entry*, kWheelLevel1Slots> level1{};
+                Entry* far{nullptr};
+            };
+
             std::mutex entry_lock;
-            std::deque<std::shared_ptr<Entry>> entries;
+            std::array<std::array<std::shared_ptr<Entry>, kWindowSize>, kWindowTypes> window{};
+            std::deque<std::shared_ptr<Entry>> window_overflow{};
+            size_t entry_count{0};
+            TimerWheel timer_wheel{};
+
             protocol::RtoCalculator rto_calculator_{};
+
+            [[nodiscard]] static int64_t wheel_tick(const std::chrono::system_clock::time_point& /* timestamp */, bool /* round up */);
+
+            /* All methods below require the entry lock to be held */
+            [[nodiscard]] std::shared_ptr<Entry>* find_entry(uint8_t /* packet type */, uint16_t /* packet id */);
+            [[nodiscard]] std::shared_ptr<Entry>* locate_entry(const Entry* /* entry */);
+            [[nodiscard]] std::shared_ptr<Entry> remove_entry(Entry* /* entry */);
+
+            void wheel_schedule(Entry* /* entry */, const std::chrono::system_clock::time_point& /* deadline */);
+            void wheel_unschedule(Entry* /* entry */);
+            void wheel_insert(Entry* /* entry */);
+            void wheel_cascade(Entry*& /* slot */);
+            void wheel_advance(int64_t /* tick */, std::vector<Entry*>& /* expired */);
+            [[nodiscard]] std::chrono::system_clock::time_point wheel_next_deadline() const;
     };
-}
\ No newline at end of file
+}
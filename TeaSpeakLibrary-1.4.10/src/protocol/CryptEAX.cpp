@@ -0,0 +1,365 @@
+#include <atomic>
+#include <cstring>
+#include <tomcrypt.h>
+#include "./CryptEAX.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define EAX_HAVE_AESNI
+    #include <cpuid.h>
+    #include <immintrin.h>
+
+    #define EAX_AESNI_TARGET __attribute__((target("aes,sse2")))
+#endif
+
+using namespace ts::connection;
+
+namespace {
+    constexpr size_t kTemporaryBufferLength{2048};
+
+    bool aesni_supported() {
+#ifdef EAX_HAVE_AESNI
+        unsigned int eax, ebx, ecx, edx;
+        if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+            return false;
+        }
+
+        return (ecx & bit_AES) != 0;
+#else
+        return false;
+#endif
+    }
+
+    std::atomic<eax::Backend> selected_backend{aesni_supported() ? eax::Backend::AESNI : eax::Backend::TOMCRYPT};
+
+    inline bool tags_equal(const uint8_t* tag_a, const uint8_t* tag_b) {
+        /* constant time compare */
+        uint8_t difference{0};
+        for(size_t index{0}; index < eax::kTagLength; index++) {
+            difference |= tag_a[index] ^ tag_b[index];
+        }
+        return difference == 0;
+    }
+
+    /* Multiplication by x within GF(2^128) (OMAC subkey generation) */
+    inline void gf_double(const uint8_t* in, uint8_t* out) {
+        auto carry = in[0] >> 7U;
+        for(size_t index{0}; index < 15; index++) {
+            out[index] = (uint8_t) ((in[index] << 1U) | (in[index + 1] >> 7U));
+        }
+        out[15] = (uint8_t) ((in[15] << 1U) ^ (carry ? 0x87U : 0U));
+    }
+
+    int tomcrypt_cipher() {
+        static int cipher{find_cipher("rijndael")};
+        return cipher;
+    }
+
+    bool tomcrypt_encrypt(const uint8_t* key, const uint8_t* nonce, const void* header, size_t header_length, const void* plain, void* cipher, size_t length, uint8_t* tag, std::string& error) {
+        eax_state state{};
+        uint8_t tag_buffer[16];
+        unsigned long tag_length{sizeof(tag_buffer)};
+
+        int err;
+        if((err = eax_init(&state, tomcrypt_cipher(), key, eax::kKeyLength, nonce, eax::kNonceLength, (const uint8_t*) header, header_length)) != CRYPT_OK) {
+            goto error_exit;
+        }
+
+        if(length > 0 && (err = eax_encrypt(&state, (const uint8_t*) plain, (uint8_t*) cipher, length)) != CRYPT_OK) {
+            goto error_exit;
+        }
+
+        if((err = eax_done(&state, tag_buffer, &tag_length)) != CRYPT_OK) {
+            goto error_exit;
+        }
+
+        memcpy(tag, tag_buffer, eax::kTagLength);
+        return true;
+
+        error_exit:
+        error = "encrypt returned " + std::string{error_to_string(err)};
+        return false;
+    }
+
+    bool tomcrypt_decrypt(const uint8_t* key, const uint8_t* nonce, const void* header, size_t header_length, const void* cipher, void* plain, size_t length, const uint8_t* tag, std::string& error) {
+        if(length > kTemporaryBufferLength) {
+            error = "packet too large";
+            return false;
+        }
+
+        eax_state state{};
+        uint8_t plain_buffer[kTemporaryBufferLength];
+        uint8_t tag_buffer[16];
+        unsigned long tag_length{sizeof(tag_buffer)};
+
+        int err;
+        if((err = eax_init(&state, tomcrypt_cipher(), key, eax::kKeyLength, nonce, eax::kNonceLength, (const uint8_t*) header, header_length)) != CRYPT_OK) {
+            goto error_exit;
+        }
+
+        if(length > 0 && (err = eax_decrypt(&state, (const uint8_t*) cipher, plain_buffer, length)) != CRYPT_OK) {
+            goto error_exit;
+        }
+
+        if((err = eax_done(&state, tag_buffer, &tag_length)) != CRYPT_OK) {
+            goto error_exit;
+        }
+
+        if(!tags_equal(tag_buffer, tag)) {
+            error = "failed to verify packet";
+            return false;
+        }
+
+        memcpy(plain, plain_buffer, length);
+        return true;
+
+        error_exit:
+        error = "decrypt returned " + std::string{error_to_string(err)};
+        return false;
+    }
+
+#ifdef EAX_HAVE_AESNI
+    struct AesniContext {
+        __m128i round_keys[11];
+
+        /* OMAC subkeys for complete and padded final blocks */
+        __m128i subkey_complete;
+        __m128i subkey_padded;
+    };
+
+    EAX_AESNI_TARGET inline __m128i aes128_key_step(__m128i key, __m128i assist) {
+        assist = _mm_shuffle_epi32(assist, 0xFF);
+        key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+        key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+        key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+        return _mm_xor_si128(key, assist);
+    }
+
+    EAX_AESNI_TARGET inline __m128i aes128_encrypt(const __m128i* round_keys, __m128i block) {
+        block = _mm_xor_si128(block, round_keys[0]);
+        for(size_t round{1}; round < 10; round++) {
+            block = _mm_aesenc_si128(block, round_keys[round]);
+        }
+        return _mm_aesenclast_si128(block, round_keys[10]);
+    }
+
+    EAX_AESNI_TARGET inline void aes128_encrypt4(const __m128i* round_keys, __m128i& block0, __m128i& block1, __m128i& block2, __m128i& block3) {
+        block0 = _mm_xor_si128(block0, round_keys[0]);
+        block1 = _mm_xor_si128(block1, round_keys[0]);
+        block2 = _mm_xor_si128(block2, round_keys[0]);
+        block3 = _mm_xor_si128(block3, round_keys[0]);
+        for(size_t round{1}; round < 10; round++) {
+            block0 = _mm_aesenc_si128(block0, round_keys[round]);
+            block1 = _mm_aesenc_si128(block1, round_keys[round]);
+            block2 = _mm_aesenc_si128(block2, round_keys[round]);
+            block3 = _mm_aesenc_si128(block3, round_keys[round]);
+        }
+        block0 = _mm_aesenclast_si128(block0, round_keys[10]);
+        block1 = _mm_aesenclast_si128(block1, round_keys[10]);
+        block2 = _mm_aesenclast_si128(block2, round_keys[10]);
+        block3 = _mm_aesenclast_si128(block3, round_keys[10]);
+    }
+
+    #define AES128_KEY_STEP(index, rcon) \
+        context.round_keys[index] = aes128_key_step(context.round_keys[index - 1], _mm_aeskeygenassist_si128(context.round_keys[index - 1], rcon))
+
+    EAX_AESNI_TARGET void aesni_initialize(AesniContext& context, const uint8_t* key) {
+        context.round_keys[0] = _mm_loadu_si128((const __m128i*) key);
+        AES128_KEY_STEP(1, 0x01);
+        AES128_KEY_STEP(2, 0x02);
+        AES128_KEY_STEP(3, 0x04);
+        AES128_KEY_STEP(4, 0x08);
+        AES128_KEY_STEP(5, 0x10);
+        AES128_KEY_STEP(6, 0x20);
+        AES128_KEY_STEP(7, 0x40);
+        AES128_KEY_STEP(8, 0x80);
+        AES128_KEY_STEP(9, 0x1B);
+        AES128_KEY_STEP(10, 0x36);
+
+        uint8_t subkey_base[16], subkey_complete[16], subkey_padded[16];
+        _mm_storeu_si128((__m128i*) subkey_base, aes128_encrypt(context.round_keys, _mm_setzero_si128()));
+        gf_double(subkey_base, subkey_complete);
+        gf_double(subkey_complete, subkey_padded);
+
+        context.subkey_complete = _mm_loadu_si128((const __m128i*) subkey_complete);
+        context.subkey_padded = _mm_loadu_si128((const __m128i*) subkey_padded);
+    }
+
+    #undef AES128_KEY_STEP
+
+    /* OMAC of the tweak block [0, ..., 0, tweak] followed by the data */
+    EAX_AESNI_TARGET __m128i aesni_omac(const AesniContext& context, uint8_t tweak, const uint8_t* data, size_t length) {
+        auto state = _mm_set_epi8((char) tweak, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        if(length == 0) {
+            return aes128_encrypt(context.round_keys, _mm_xor_si128(state, context.subkey_complete));
+        }
+
+        state = aes128_encrypt(context.round_keys, state);
+        while(length > 16) {
+            state = aes128_encrypt(context.round_keys, _mm_xor_si128(state, _mm_loadu_si128((const __m128i*) data)));
+            data += 16;
+            length -= 16;
+        }
+
+        if(length == 16) {
+            state = _mm_xor_si128(state, _mm_loadu_si128((const __m128i*) data));
+            state = _mm_xor_si128(state, context.subkey_complete);
+        } else {
+            uint8_t last_block[16]{};
+            memcpy(last_block, data, length);
+            last_block[length] = 0x80;
+
+            state = _mm_xor_si128(state, _mm_loadu_si128((const __m128i*) last_block));
+            state = _mm_xor_si128(state, context.subkey_padded);
+        }
+
+        return aes128_encrypt(context.round_keys, state);
+    }
+
+    EAX_AESNI_TARGET inline __m128i ctr_next_block(uint64_t& counter_high, uint64_t& counter_low) {
+        /* the counter is a 128 bit big endian number */
+        auto block = _mm_set_epi64x((long long) __builtin_bswap64(counter_low), (long long) __builtin_bswap64(counter_high));
+        if(++counter_low == 0) {
+            counter_high++;
+        }
+        return block;
+    }
+
+    EAX_AESNI_TARGET void aesni_ctr(const AesniContext& context, __m128i initial_counter, const uint8_t* in, uint8_t* out, size_t length) {
+        uint8_t counter_bytes[16];
+        _mm_storeu_si128((__m128i*) counter_bytes, initial_counter);
+
+        uint64_t counter_high, counter_low;
+        memcpy(&counter_high, counter_bytes, 8);
+        memcpy(&counter_low, counter_bytes + 8, 8);
+        counter_high = __builtin_bswap64(counter_high);
+        counter_low = __builtin_bswap64(counter_low);
+
+        while(length >= 64) {
+            auto block0 = ctr_next_block(counter_high, counter_low);
+            auto block1 = ctr_next_block(counter_high, counter_low);
+            auto block2 = ctr_next_block(counter_high, counter_low);
+            auto block3 = ctr_next_block(counter_high, counter_low);
+            aes128_encrypt4(context.round_keys, block0, block1, block2, block3);
+
+            _mm_storeu_si128((__m128i*) (out + 0), _mm_xor_si128(block0, _mm_loadu_si128((const __m128i*) (in + 0))));
+            _mm_storeu_si128((__m128i*) (out + 16), _mm_xor_si128(block1, _mm_loadu_si128((const __m128i*) (in + 16))));
+            _mm_storeu_si128((__m128i*) (out + 32), _mm_xor_si128(block2, _mm_loadu_si128((const __m128i*) (in + 32))));
+            _mm_storeu_si128((__m128i*) (out + 48), _mm_xor_si128(block3, _mm_loadu_si128((const __m128i*) (in + 48))));
+
+            in += 64;
+            out += 64;
+            length -= 64;
+        }
+
+        while(length >= 16) {
+            auto block = aes128_encrypt(context.round_keys, ctr_next_block(counter_high, counter_low));
+            _mm_storeu_si128((__m128i*) out, _mm_xor_si128(block, _mm_loadu_si128((const __m128i*) in)));
+
+            in += 16;
+            out += 16;
+            length -= 16;
+        }
+
+        if(length > 0) {
+            uint8_t key_stream[16];
+            _mm_storeu_si128((__m128i*) key_stream, aes128_encrypt(context.round_keys, ctr_next_block(counter_high, counter_low)));
+            for(size_t index{0}; index < length; index++) {
+                out[index] = in[index] ^ key_stream[index];
+            }
+        }
+    }
+
+    EAX_AESNI_TARGET void aesni_encrypt(const uint8_t* key, const uint8_t* nonce, const void* header, size_t header_length, const void* plain, void* cipher, size_t length, uint8_t* tag) {
+        AesniContext context;
+        aesni_initialize(context, key);
+
+        auto nonce_tag = aesni_omac(context, 0, nonce, eax::kNonceLength);
+        auto header_tag = aesni_omac(context, 1, (const uint8_t*) header, header_length);
+        aesni_ctr(context, nonce_tag, (const uint8_t*) plain, (uint8_t*) cipher, length);
+        auto cipher_tag = aesni_omac(context, 2, (const uint8_t*) cipher, length);
+
+        uint8_t full_tag[16];
+        _mm_storeu_si128((__m128i*) full_tag, _mm_xor_si128(_mm_xor_si128(nonce_tag, header_tag), cipher_tag));
+        memcpy(tag, full_tag, eax::kTagLength);
+    }
+
+    EAX_AESNI_TARGET bool aesni_decrypt(const uint8_t* key, const uint8_t* nonce, const void* header, size_t header_length, const void* cipher, void* plain, size_t length, const uint8_t* tag) {
+        AesniContext context;
+        aesni_initialize(context, key);
+
+        auto nonce_tag = aesni_omac(context, 0, nonce, eax::kNonceLength);
+        auto header_tag = aesni_omac(context, 1, (const uint8_t*) header, header_length);
+        auto cipher_tag = aesni_omac(context, 2, (const uint8_t*) cipher, length);
+
+        uint8_t full_tag[16];
+        _mm_storeu_si128((__m128i*) full_tag, _mm_xor_si128(_mm_xor_si128(nonce_tag, header_tag), cipher_tag));
+        if(!tags_equal(full_tag, tag)) {
+            return false;
+        }
+
+        /* The tag only covers the cipher text, so we're able to decrypt in place after verifying */
+        aesni_ctr(context, nonce_tag, (const uint8_t*) cipher, (uint8_t*) plain, length);
+        return true;
+    }
+#endif
+}
+
+eax::Backend eax::active_backend() {
+    return selected_backend.load(std::memory_order_relaxed);
+}
+
+const char* eax::backend_name(Backend backend) {
+    switch(backend) {
+        case Backend::TOMCRYPT:
+            return "tomcrypt";
+        case Backend::AESNI:
+            return "AES-NI";
+        default:
+            return "unknown";
+    }
+}
+
+bool eax::backend_supported(Backend backend) {
+    switch(backend) {
+        case Backend::TOMCRYPT:
+            return true;
+        case Backend::AESNI:
+            return aesni_supported();
+        default:
+            return false;
+    }
+}
+
+bool eax::select_backend(Backend backend) {
+    if(!eax::backend_supported(backend)) {
+        return false;
+    }
+
+    selected_backend.store(backend);
+    return true;
+}
+
+bool eax::encrypt(const uint8_t *key, const uint8_t *nonce, const void *header, size_t header_length, const void *plain, void *cipher, size_t length, uint8_t *tag, std::string &error) {
+#ifdef EAX_HAVE_AESNI
+    if(eax::active_backend() == Backend::AESNI) {
+        aesni_encrypt(key, nonce, header, header_length, plain, cipher, length, tag);
+        return true;
+    }
+#endif
+
+    return tomcrypt_encrypt(key, nonce, header, header_length, plain, cipher, length, tag, error);
+}
+
+bool eax::decrypt(const uint8_t *key, const uint8_t *nonce, const void *header, size_t header_length, const void *cipher, void *plain, size_t length, const uint8_t *tag, std::string &error) {
+#ifdef EAX_HAVE_AESNI
+    if(eax::active_backend() == Backend::AESNI) {
+        if(!aesni_decrypt(key, nonce, header, header_length, cipher, plain, length, tag)) {
+            error = "failed to verify packet";
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    return tomcrypt_decrypt(key, nonce, header, header_length, cipher, plain, length, tag, error);
+}
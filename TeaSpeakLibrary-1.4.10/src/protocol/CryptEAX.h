@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ts::connection::eax {
+    /*
+     * EAX mode with AES-128, a 16 byte nonce and a 8 byte tag as used by the packet encryption.
+     * AES-NI will be used if supported by the CPU, else we're falling back to libtomcrypt.
+     */
+    enum struct Backend {
+        TOMCRYPT,
+        AESNI
+    };
+
+    constexpr size_t kKeyLength{16};
+    constexpr size_t kNonceLength{16};
+    constexpr size_t kTagLength{8};
+
+    [[nodiscard]] Backend active_backend();
+    [[nodiscard]] const char* backend_name(Backend /* backend */);
+    [[nodiscard]] bool backend_supported(Backend /* backend */);
+
+    /**
+     * Override the backend selected by the CPU features.
+     * Used by the tests and benchmarks only.
+     * @returns false if the backend isn't supported by this CPU
+     */
+    bool select_backend(Backend /* backend */);
+
+    /**
+     * Encrypt the plain text and calculate the tag.
+     * The plain and the cipher buffer may be equal.
+     */
+    bool encrypt(
+            const uint8_t* /* key */, const uint8_t* /* nonce */,
+            const void* /* header */, size_t /* header length */,
+            const void* /* plain */, void* /* cipher */, size_t /* length */,
+            uint8_t* /* tag */,
+            std::string& /* error */);
+
+    /**
+     * Verify the tag and decrypt the cipher text.
+     * The cipher and the plain buffer may be equal.
+     * If the verification fails the plain buffer will not be touched.
+     */
+    bool decrypt(
+            const uint8_t* /* key */, const uint8_t* /* nonce */,
+            const void* /* header */, size_t /* header length */,
+            const void* /* cipher */, void* /* plain */, size_t /* length */,
+            const uint8_t* /* tag */,
+            std::string& /* error */);
+}
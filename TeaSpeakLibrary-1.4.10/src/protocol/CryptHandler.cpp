@@ -6,6 +6,7 @@
 #include <mutex>
 
 #include "./CryptHandler.h"
+#include "./CryptEAX.h"
 #include "../misc/endianness.h"
 #include "../misc/memtracker.h"
 #include "../misc/digest.h"
@@ -215,9 +216,6 @@ bool CryptHandler::generate_key_nonce(
 }
 
 bool CryptHandler::verify_encryption(const pipes::buffer_view &packet, uint16_t packet_id, uint16_t generation) {
-    int err;
-    int success = false;
-
     key_t key{};
     nonce_t nonce{};
     if(!generate_key_nonce(true, (protocol::PacketType) ((uint8_t) packet[12] & 0xFU), packet_id, generation, key, nonce)) {
@@ -228,67 +226,33 @@ bool CryptHandler::verify_encryption(const pipes::buffer_view &packet, uint16_t
     auto header = packet.view(8, 5);
     auto data = packet.view(13);
 
-    auto length = data.length();
-
-    const static unsigned long void_target_length{2048};
     uint8_t void_target_buffer[2048];
-    if(void_target_length < length) {
+    if(sizeof(void_target_buffer) < data.length()) {
         return false;
     }
 
-    err = eax_decrypt_verify_memory(this->cipher_code,
-                                    (uint8_t *) key.data(), /* the key */
-                                    (size_t)    key.size(), /* key is 16 bytes */
-                                    (uint8_t *) nonce.data(), /* the nonce */
-                                    (size_t)    nonce.size(), /* nonce is 16 bytes */
-                                    (uint8_t *) header.data_ptr(), /* example header */
-                                    (unsigned long) header.length(), /* header length */
-                                    (const unsigned char *) data.data_ptr(),
-                                    (unsigned long) data.length(),
-                                    (unsigned char *) void_target_buffer,
-                                    (unsigned char *) mac.data_ptr(),
-                                    (unsigned long) mac.length(),
-                                    &success
+    std::string error{};
+    return eax::decrypt(
+            key.data(), nonce.data(),
+            header.data_ptr(), header.length(),
+            data.data_ptr(), void_target_buffer, data.length(),
+            (const uint8_t*) mac.data_ptr(),
+            error
     );
-
-    return err == CRYPT_OK && success;
 }
 
-bool CryptHandler::decrypt(const void *header, size_t header_length, void *payload, size_t payload_length, const void *mac, const key_t &key, const nonce_t &nonce, std::string &error) const {
-    const static unsigned long kTempBufferLength{2048};
-    uint8_t tmp_buffer[kTempBufferLength];
-    if(kTempBufferLength < payload_length) {
-        error = "packet too large";
-        return false;
-    }
-
-    int success;
-    auto err = eax_decrypt_verify_memory(this->cipher_code,
-                                    (const uint8_t *) key.data(), /* the key */
-                                    (unsigned long)    key.size(), /* key is 16 bytes */
-                                    (const uint8_t *) nonce.data(), /* the nonce */
-                                    (unsigned long)    nonce.size(), /* nonce is 16 bytes */
-                                    (const uint8_t *) header, /* example header */
-                                    (unsigned long) header_length, /* header length */
-                                    (const unsigned char *) payload,
-                                    (unsigned long) payload_length,
-                                    (unsigned char *) tmp_buffer,
-                                    (unsigned char *) mac,
-                                    (unsigned long) 8,
-                                    &success
-    );
-    if(err != CRYPT_OK) {
-        error = "decrypt returned " + std::string{error_to_string(err)};
-        return false;
-    }
+CryptHandler::crypt_timing_callback_t CryptHandler::crypt_timing_callback{nullptr};
 
-    if(!success) {
-        error = "failed to verify packet";
-        return false;
+bool CryptHandler::decrypt(const void *header, size_t header_length, void *payload, size_t payload_length, const void *mac, const key_t &key, const nonce_t &nonce, std::string &error) const {
+    /* The payload will only be overridden if the packet could be verified */
+    if(!CryptHandler::crypt_timing_callback) {
+        return eax::decrypt(key.data(), nonce.data(), header, header_length, payload, payload, payload_length, (const uint8_t*) mac, error);
     }
 
-    memcpy(payload, tmp_buffer, payload_length);
-    return true;
+    auto begin = std::chrono::steady_clock::now();
+    auto result = eax::decrypt(key.data(), nonce.data(), header, header_length, payload, payload, payload_length, (const uint8_t*) mac, error);
+    CryptHandler::crypt_timing_callback(false, std::chrono::steady_clock::now() - begin);
+    return result;
 }
 
 bool CryptHandler::encrypt(
@@ -296,30 +260,20 @@ bool CryptHandler::encrypt(
         void *payload, size_t payload_length,
         void *mac,
         const key_t &key, const nonce_t &nonce, std::string &error) {
-    size_t tag_length{8};
-    uint8_t tag_buffer[16];
-
-    static_assert(sizeof(unsigned long) <= sizeof(tag_length));
-    auto err = eax_encrypt_authenticate_memory(this->cipher_code,
-                                          (uint8_t *) key.data(), /* the key */
-                                          (unsigned long)    key.size(), /* key is 16 bytes */
-                                          (uint8_t *) nonce.data(), /* the nonce */
-                                          (unsigned long)    nonce.size(), /* nonce is 16 bytes */
-                                          (uint8_t *) header, /* example header */
-                                          (unsigned long) header_length, /* header length */
-                                          (uint8_t *) payload, /* The plain text */
-                                          (unsigned long) payload_length, /* Plain text length */
-                                          (uint8_t *) payload, /* The result buffer */
-                                          (uint8_t *) tag_buffer,
-                                          (unsigned long *)  &tag_length
-    );
-    assert(tag_length <= 16);
+    return this->encrypt(header, header_length, payload, payload, payload_length, mac, key, nonce, error);
+}
 
-    if(err != CRYPT_OK) {
-        error = "encrypt returned " + std::string{error_to_string(err)};
-        return false;
+bool CryptHandler::encrypt(
+        const void *header, size_t header_length,
+        const void *plain_payload, void *cipher_payload, size_t payload_length,
+        void *mac,
+        const key_t &key, const nonce_t &nonce, std::string &error) {
+    if(!CryptHandler::crypt_timing_callback) {
+        return eax::encrypt(key.data(), nonce.data(), header, header_length, plain_payload, cipher_payload, payload_length, (uint8_t*) mac, error);
     }
 
-    memcpy(mac, tag_buffer, 8);
-    return true;
+    auto begin = std::chrono::steady_clock::now();
+    auto result = eax::encrypt(key.data(), nonce.data(), header, header_length, plain_payload, cipher_payload, payload_length, (uint8_t*) mac, error);
+    CryptHandler::crypt_timing_callback(true, std::chrono::steady_clock::now() - begin);
+    return result;
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <string>
 #include <tomcrypt.h>
 #include "./Packet.h"
@@ -28,6 +29,14 @@ namespace ts::connection {
                     const key_t& /* key */, const nonce_t& /* nonce */,
                     std::string& /* error */);
 
+            /* Encrypts the plain text into the cipher buffer. Both buffers must have the same length and may be equal. */
+            bool encrypt(
+                    const void* /* header */, size_t /* header length */,
+                    const void* /* plain payload */, void* /* cipher payload */, size_t /* payload length */,
+                    void* /* mac */, /* mac must be 8 bytes long! */
+                    const key_t& /* key */, const nonce_t& /* nonce */,
+                    std::string& /* error */);
+
             bool decrypt(
                     const void* /* header */, size_t /* header length */,
                     void* /* payload */, size_t /* payload length */,
@@ -44,6 +53,13 @@ namespace ts::connection {
 
             [[nodiscard]] inline bool encryption_initialized() const { return !this->encryption_initialized_; }
 
+            /*
+             * Optional observer for the time spent within encrypt and decrypt.
+             * Must be set before any packet gets processed.
+             */
+            typedef void(*crypt_timing_callback_t)(bool /* encrypt */, std::chrono::nanoseconds /* duration */);
+            static crypt_timing_callback_t crypt_timing_callback;
+
             static constexpr key_t kDefaultKey{'c', ':', '\\', 'w', 'i', 'n', 'd', 'o', 'w', 's', '\\', 's', 'y', 's', 't', 'e'}; //c:\windows\syste
             static constexpr nonce_t kDefaultNonce{'m', '\\', 'f', 'i', 'r', 'e', 'w', 'a', 'l', 'l', '3', '2', '.', 'c', 'p', 'l'}; //m\firewall32.cpl
         private:
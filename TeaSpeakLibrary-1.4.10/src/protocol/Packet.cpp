@@ -5,6 +5,10 @@
 #include <cstring>
 #include <bitset>
 #include <mutex>
+#include <array>
+#include <atomic>
+#include <vector>
+#include <algorithm>
 #include "./Packet.h"
 #include "../misc/endianness.h"
 #include "../misc/spin_mutex.h"
@@ -47,24 +51,73 @@ namespace ts {
 
     void reset_osp(protocol::OutgoingServerPacket* packet, size_t payload_size) {
         packet->next = nullptr;
+        packet->gather_payload = nullptr;
         packet->payload_size = payload_size;
         packet->type_and_flags_ = 0;
         packet->generation = 0;
     }
 
 #if 1
-    #define BUKKIT_ENTRY_SIZE (1650)
-    #define BUKKIT_MAX_ENTRIES (3000)
+    /*
+     * Outgoing server packets are allocated for every voice frame and every listener.
+     * Released packets are cached within per thread magazines of a fixed size class.
+     * Full and empty magazines are exchanged in bulk with a global depot, so the depot lock
+     * will only be taken once every kMagazineSize allocations or deallocations.
+     * (See Bonwick and Adams, "Magazines and Vmem")
+     */
+    constexpr size_t kMagazineSize{64};
+    constexpr size_t kDepotMaxFullMagazines{32}; /* per size class */
+    constexpr std::array<size_t, 4> kSizeClasses{
+        64, /* acknowledges, pings and small voice packets */
+        256, /* voice packets */
+        512, /* command fragments (max 487 bytes payload) */
+        1650 /* everything else fitting into a datagram */
+    };
+    constexpr uint8_t kSizeClassExtraAllocated{0xFF};
+
+    struct alignas(alignof(std::max_align_t)) OSPBukkitEntry {
+        uint8_t size_class;
+    };
 
-    struct OSPBukkitEntry {
-        bool extra_allocated;
-        OSPBukkitEntry* next;
+    struct OSPMagazine {
+        size_t count{0};
+        OSPMagazine* next{nullptr};
+        OSPBukkitEntry* entries[kMagazineSize];
     };
 
-    spin_mutex osp_mutex{};
-    size_t sdp_count{0};
-    OSPBukkitEntry* osp_head{nullptr};
-    OSPBukkitEntry** osp_tail{&osp_head};
+    struct OSPDepot {
+        spin_mutex mutex{};
+        OSPMagazine* full_magazines{nullptr};
+        size_t full_magazine_count{0};
+        OSPMagazine* empty_magazines{nullptr};
+    };
+    std::array<OSPDepot, kSizeClasses.size()> osp_depots{};
+
+    struct OSPCacheCounters {
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> oversized{0};
+        std::atomic<uint64_t> depot_transfers{0};
+
+        /* Only the owning thread writes the counters */
+        static inline void increment(std::atomic<uint64_t>& counter) {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    };
+
+    std::mutex osp_statistics_mutex{};
+    std::vector<OSPCacheCounters*> osp_thread_counters{};
+    protocol::OutgoingServerPacketCacheStatistics osp_retired_statistics{};
+
+    inline uint8_t osp_size_class(size_t payload_size) {
+        for(uint8_t size_class{0}; size_class < kSizeClasses.size(); size_class++) {
+            if(payload_size <= kSizeClasses[size_class]) {
+                return size_class;
+            }
+        }
+
+        return kSizeClassExtraAllocated;
+    }
 
     protocol::OutgoingServerPacket* osp_from_bosp(OSPBukkitEntry* bops) {
         return reinterpret_cast<protocol::OutgoingServerPacket*>((char*) bops + sizeof(OSPBukkitEntry));
@@ -84,76 +137,234 @@ namespace ts {
         auto full_size = base_size + payload_size;
         auto bentry = (OSPBukkitEntry*) malloc(full_size);
 
-        bentry->next = nullptr;
-        bentry->extra_allocated = false;
+        bentry->size_class = kSizeClassExtraAllocated;
 
         construct_osp(osp_from_bosp(bentry));
         return bentry;
     }
 
+    OSPMagazine* depot_take_full(uint8_t size_class) {
+        auto& depot = osp_depots[size_class];
+
+        std::lock_guard depot_lock{depot.mutex};
+        auto magazine = depot.full_magazines;
+        if(magazine) {
+            depot.full_magazines = std::exchange(magazine->next, nullptr);
+            depot.full_magazine_count--;
+        }
+        return magazine;
+    }
+
+    OSPMagazine* depot_take_empty(uint8_t size_class) {
+        auto& depot = osp_depots[size_class];
+        {
+            std::lock_guard depot_lock{depot.mutex};
+            auto magazine = depot.empty_magazines;
+            if(magazine) {
+                depot.empty_magazines = std::exchange(magazine->next, nullptr);
+                return magazine;
+            }
+        }
+
+        return new OSPMagazine{};
+    }
+
+    void depot_put_empty(uint8_t size_class, OSPMagazine* magazine) {
+        assert(magazine->count == 0);
+        auto& depot = osp_depots[size_class];
+
+        std::lock_guard depot_lock{depot.mutex};
+        magazine->next = depot.empty_magazines;
+        depot.empty_magazines = magazine;
+    }
+
+    void depot_put_full(uint8_t size_class, OSPMagazine* magazine) {
+        auto& depot = osp_depots[size_class];
+        {
+            std::lock_guard depot_lock{depot.mutex};
+            if(depot.full_magazine_count < kDepotMaxFullMagazines) {
+                magazine->next = depot.full_magazines;
+                depot.full_magazines = magazine;
+                depot.full_magazine_count++;
+                return;
+            }
+        }
+
+        /* The depot is full. Release the packets back to the system. */
+        while(magazine->count > 0) {
+            destroy_bosp(magazine->entries[--magazine->count]);
+        }
+        depot_put_empty(size_class, magazine);
+    }
+
+    /*
+     * Packets might be released after the thread cache has been destroyed
+     * (e.g. by the destructor of another thread local or during the static teardown).
+     * The flag is trivially destructible and could be accessed at any time.
+     */
+    thread_local bool osp_thread_cache_destroyed{false};
+
+    struct OSPThreadCache {
+        struct SizeClassCache {
+            OSPMagazine* loaded{nullptr};
+            OSPMagazine* previous{nullptr};
+        };
+
+        std::array<SizeClassCache, kSizeClasses.size()> caches{};
+        OSPCacheCounters counters{};
+
+        OSPThreadCache() {
+            std::lock_guard statistics_lock{osp_statistics_mutex};
+            osp_thread_counters.push_back(&this->counters);
+        }
+
+        ~OSPThreadCache() {
+            osp_thread_cache_destroyed = true;
+            for(uint8_t size_class{0}; size_class < kSizeClasses.size(); size_class++) {
+                auto& cache = this->caches[size_class];
+                for(auto magazine : {cache.loaded, cache.previous}) {
+                    if(!magazine) {
+                        continue;
+                    }
+
+                    if(magazine->count > 0) {
+                        depot_put_full(size_class, magazine);
+                    } else {
+                        depot_put_empty(size_class, magazine);
+                    }
+                }
+            }
+
+            std::lock_guard statistics_lock{osp_statistics_mutex};
+            osp_retired_statistics.hits += this->counters.hits;
+            osp_retired_statistics.misses += this->counters.misses;
+            osp_retired_statistics.oversized += this->counters.oversized;
+            osp_retired_statistics.depot_transfers += this->counters.depot_transfers;
+            osp_thread_counters.erase(std::find(osp_thread_counters.begin(), osp_thread_counters.end(), &this->counters));
+        }
+
+        OSPBukkitEntry* allocate(uint8_t size_class) {
+            auto& cache = this->caches[size_class];
+            if(!cache.loaded || cache.loaded->count == 0) {
+                if(cache.previous && cache.previous->count > 0) {
+                    std::swap(cache.loaded, cache.previous);
+                } else {
+                    auto full_magazine = depot_take_full(size_class);
+                    if(!full_magazine) {
+                        OSPCacheCounters::increment(this->counters.misses);
+                        return nullptr;
+                    }
+
+                    OSPCacheCounters::increment(this->counters.depot_transfers);
+                    if(cache.loaded) {
+                        depot_put_empty(size_class, cache.loaded);
+                    }
+                    cache.loaded = full_magazine;
+                }
+            }
+
+            OSPCacheCounters::increment(this->counters.hits);
+            return cache.loaded->entries[--cache.loaded->count];
+        }
+
+        void deallocate(OSPBukkitEntry* entry) {
+            auto size_class = entry->size_class;
+            auto& cache = this->caches[size_class];
+            if(!cache.loaded) {
+                cache.loaded = depot_take_empty(size_class);
+            }
+
+            if(cache.loaded->count == kMagazineSize) {
+                if(cache.previous && cache.previous->count == 0) {
+                    std::swap(cache.loaded, cache.previous);
+                } else {
+                    if(cache.previous) {
+                        OSPCacheCounters::increment(this->counters.depot_transfers);
+                        depot_put_full(size_class, cache.previous);
+                    }
+
+                    cache.previous = cache.loaded;
+                    cache.loaded = depot_take_empty(size_class);
+                }
+            }
+
+            cache.loaded->entries[cache.loaded->count++] = entry;
+        }
+    };
+
+    thread_local OSPThreadCache osp_thread_cache{};
+
     void protocol::OutgoingServerPacket::free_object() {
+        if(this->gather_payload) {
+            std::exchange(this->gather_payload, nullptr)->unref();
+        }
+
         auto bentry = (OSPBukkitEntry*) bosp_from_osp(this);
-        if(bentry->extra_allocated) {
+        if(bentry->size_class == kSizeClassExtraAllocated) {
             destroy_bosp(bentry);
             return;
         }
 
-        std::unique_lock block{osp_mutex};
-        if(sdp_count >= BUKKIT_MAX_ENTRIES) {
-            block.unlock();
+        if(osp_thread_cache_destroyed) {
             destroy_bosp(bentry);
             return;
         }
 
-        assert(!bentry->next);
-        *osp_tail = bentry;
-        osp_tail = &bentry->next;
-        sdp_count++;
+        osp_thread_cache.deallocate(bentry);
     }
 
     protocol::OutgoingServerPacket* protocol::allocate_outgoing_server_packet(size_t payload_size) {
-        if(BUKKIT_ENTRY_SIZE >= payload_size) {
-            std::lock_guard block{osp_mutex};
-            if(osp_head) {
-                assert(sdp_count > 0);
-                sdp_count--;
-                auto entry = osp_head;
-                if(osp_head->next) {
-                    assert(osp_tail != &osp_head->next);
-                    osp_head = osp_head->next;
-                } else {
-                    assert(osp_tail == &osp_head->next);
-                    osp_head = nullptr;
-                    osp_tail = &osp_head;
-                }
-
-                entry->next = nullptr;
-
-                auto result = osp_from_bosp(entry);
-                reset_osp(result, payload_size);
-                result->ref_count++;
-                return result;
-            } else if(sdp_count < BUKKIT_MAX_ENTRIES) {
-                auto entry = construct_bosp(BUKKIT_ENTRY_SIZE);
-                entry->extra_allocated = false;
-
-                auto result = osp_from_bosp(entry);
-                reset_osp(result, payload_size);
-                result->ref_count++;
-                return result;
+        auto size_class = osp_size_class(payload_size);
+
+        OSPBukkitEntry* entry{nullptr};
+        if(osp_thread_cache_destroyed) {
+            entry = construct_bosp(size_class == kSizeClassExtraAllocated ? payload_size : kSizeClasses[size_class]);
+            entry->size_class = size_class;
+        } else if(size_class == kSizeClassExtraAllocated) {
+            OSPCacheCounters::increment(osp_thread_cache.counters.oversized);
+            entry = construct_bosp(payload_size);
+        } else {
+            entry = osp_thread_cache.allocate(size_class);
+            if(!entry) {
+                entry = construct_bosp(kSizeClasses[size_class]);
+                entry->size_class = size_class;
             }
         }
 
-        auto entry = construct_bosp(payload_size);
-        entry->extra_allocated = true;
-
         auto result = osp_from_bosp(entry);
         reset_osp(result, payload_size);
         result->ref_count++;
         return result;
     }
+
+    protocol::OutgoingServerPacketCacheStatistics protocol::outgoing_server_packet_cache_statistics() {
+        OutgoingServerPacketCacheStatistics result{};
+        {
+            std::lock_guard statistics_lock{osp_statistics_mutex};
+            result = osp_retired_statistics;
+            for(const auto& counters : osp_thread_counters) {
+                result.hits += counters->hits.load(std::memory_order_relaxed);
+                result.misses += counters->misses.load(std::memory_order_relaxed);
+                result.oversized += counters->oversized.load(std::memory_order_relaxed);
+                result.depot_transfers += counters->depot_transfers.load(std::memory_order_relaxed);
+            }
+            result.threads = osp_thread_counters.size();
+        }
+
+        for(size_t size_class{0}; size_class < kSizeClasses.size(); size_class++) {
+            auto& depot = osp_depots[size_class];
+
+            std::lock_guard depot_lock{depot.mutex};
+            result.depot_packets += depot.full_magazine_count * kMagazineSize;
+        }
+        return result;
+    }
 #else
     void protocol::OutgoingServerPacket::free_object() {
+        if(this->gather_payload) {
+            std::exchange(this->gather_payload, nullptr)->unref();
+        }
+
         deconstruct_osp(this);
         ::free(this);
     }
@@ -172,6 +383,28 @@ namespace ts {
     }
 #endif
 
+    protocol::OutgoingServerPacket* protocol::allocate_shared_outgoing_server_packet(SharedPacketPayload* shared_payload) {
+        auto result = protocol::allocate_outgoing_server_packet(shared_payload->payload_size);
+        result->gather_payload = shared_payload->ref();
+        return result;
+    }
+
+    void protocol::SharedPacketPayload::free_object() {
+        this->~SharedPacketPayload();
+        ::free(this);
+    }
+
+    protocol::SharedPacketPayload* protocol::allocate_shared_packet_payload(size_t payload_size) {
+        auto base_size = sizeof(protocol::SharedPacketPayload) - 1;
+        /* Allocate at least one payload byte since we're our payload array of length 1 */
+        auto full_size = base_size + std::max(payload_size, (size_t) 1);
+        auto result = (protocol::SharedPacketPayload*) malloc(full_size);
+
+        new (result) protocol::SharedPacketPayload{};
+        result->payload_size = payload_size;
+        return result;
+    }
+
     void protocol::OutgoingClientPacket::free_object() {
         deconstruct_ocp(this);
         ::free(this);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <string>
 #include <map>
@@ -284,12 +285,42 @@ namespace ts::protocol {
             void free_object() override;
     };
 
+    /**
+     * Payload which is shared between multiple outgoing packets (e.g. a voice frame which gets send to every listener).
+     * The payload will be copied (or encrypted) into the packet while encoding it.
+     */
+    struct SharedPacketPayload {
+        public:
+            std::atomic<uint32_t> ref_count{1};
+            size_t payload_size;
+            uint8_t payload[1]; /* variable size */
+
+            inline SharedPacketPayload* ref() {
+                this->ref_count++;
+                return this;
+            }
+
+            inline void unref() {
+                if(--this->ref_count == 0) {
+                    this->free_object();
+                }
+            }
+        private:
+            void free_object();
+    };
+
     struct OutgoingServerPacket : public OutgoingPacket {
         public:
             virtual ~OutgoingServerPacket() = default;
 
             OutgoingServerPacket* next; /* used within the write/process queue */
 
+            /*
+             * If set the payload hasn't been written yet and will be gathered from the shared payload while encoding.
+             * The packet holds one reference to the shared payload.
+             */
+            SharedPacketPayload* gather_payload;
+
             /* actual packet data */
             uint8_t mac[8];
             uint8_t packet_id_bytes_[2];
@@ -308,6 +339,17 @@ namespace ts::protocol {
                 return this->payload_size + (8 + 2 + 1);
             }
 
+            /* Copy the shared payload into the packet payload and release it */
+            inline void gather_shared_payload() {
+                if(!this->gather_payload) {
+                    return;
+                }
+
+                assert(this->gather_payload->payload_size == this->payload_size);
+                memcpy(this->payload, this->gather_payload->payload, this->payload_size);
+                std::exchange(this->gather_payload, nullptr)->unref();
+            }
+
             [[nodiscard]] inline OutgoingPacket* next_in_queue() const override {
                 return this->next;
             }
@@ -332,6 +374,25 @@ namespace ts::protocol {
     OutgoingServerPacket* allocate_outgoing_server_packet(size_t /* payload size */);
     OutgoingClientPacket* allocate_outgoing_client_packet(size_t /* payload size */);
 
+    /* This will allocate a new shared payload with one reference. To delete just unref the payload! */
+    SharedPacketPayload* allocate_shared_packet_payload(size_t /* payload size */);
+
+    /* Allocate a new outgoing packet which gathers its payload from the shared payload. The packet takes its own reference. */
+    OutgoingServerPacket* allocate_shared_outgoing_server_packet(SharedPacketPayload* /* payload */);
+
+    struct OutgoingServerPacketCacheStatistics {
+        uint64_t hits{0}; /* allocations served by a thread local magazine */
+        uint64_t misses{0}; /* allocations which required a new heap allocation */
+        uint64_t oversized{0}; /* allocations too large for any size class */
+        uint64_t depot_transfers{0}; /* magazines exchanged with the global depot */
+
+        size_t depot_packets{0}; /* packets cached within the global depot */
+        size_t threads{0}; /* threads owning a packet cache */
+    };
+
+    /* Statistics of the outgoing server packet cache */
+    [[nodiscard]] OutgoingServerPacketCacheStatistics outgoing_server_packet_cache_statistics();
+
     inline PacketFlags& operator|=(PacketFlags& flags, const PacketFlag& flag) {
         flags |= (uint8_t) flag;
         return flags;
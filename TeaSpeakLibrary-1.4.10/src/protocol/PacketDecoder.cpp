@@ -28,6 +28,11 @@ PacketDecoder::~PacketDecoder() {
 }
 
 void PacketDecoder::reset() {
+    std::unique_lock owner_lock_{this->owner_lock, std::defer_lock};
+    if(this->single_owner) {
+        owner_lock_.lock();
+    }
+
     {
         std::lock_guard buffer_lock(this->packet_buffer_lock);
         for(auto& buffer : this->_command_fragment_buffers) {
@@ -44,6 +49,69 @@ void PacketDecoder::reset() {
 }
 
 PacketProcessResult PacketDecoder::process_incoming_data(PacketParser &packet_parser, std::string& error) {
+    ProcessBatch batch{};
+    this->begin_batch(batch);
+    auto result = this->process_incoming_data(batch, packet_parser, error);
+    this->finish_batch(batch);
+    return result;
+}
+
+void PacketDecoder::begin_batch(ProcessBatch &batch) {
+    assert(!batch.owner_locked);
+    if(this->single_owner) {
+        this->owner_lock.lock();
+        batch.owner_locked = true;
+    }
+}
+
+void PacketDecoder::finish_batch(ProcessBatch &batch) {
+    if(batch.owner_locked) {
+        this->owner_lock.unlock();
+        batch.owner_locked = false;
+    }
+
+    auto commands = std::exchange(batch.commands_head, nullptr);
+    batch.commands_tail = &batch.commands_head;
+
+    if(this->callback_decoded_commands) {
+        if(commands) {
+            this->callback_decoded_commands(this->callback_argument, commands);
+        }
+
+        while(commands) {
+            /* ownership hasn't transferred */
+            auto next = commands->next_command;
+            ReassembledCommand::free(commands);
+            commands = next;
+        }
+        return;
+    }
+
+    while(commands) {
+        auto command = commands;
+        commands = std::exchange(command->next_command, nullptr);
+
+        this->callback_decoded_command(this->callback_argument, command);
+        if(command) {
+            /* ownership hasn't transferred */
+            ReassembledCommand::free(command);
+        }
+    }
+}
+
+void PacketDecoder::flush_crypt_setup_commands(ProcessBatch &batch) {
+    if(!batch.commands_head || this->crypt_handler_->encryption_initialized()) {
+        return;
+    }
+
+    this->finish_batch(batch);
+
+    /* The commands might have initialized the encryption. Don't reuse the key of the previous packets. */
+    batch.key_packet_type = 0xFF;
+    this->begin_batch(batch);
+}
+
+PacketProcessResult PacketDecoder::process_incoming_data(ProcessBatch& batch, PacketParser &packet_parser, std::string& error) {
 #ifdef FUZZING_TESTING_INCOMMING
     if(rand() % 100 < 20) {
         return PacketProcessResult::FUZZ_DROPPED;
@@ -64,11 +132,14 @@ PacketProcessResult PacketDecoder::process_incoming_data(PacketParser &packet_pa
 
     auto& generation_estimator = this->incoming_generation_estimators[packet_parser.type()];
     {
-        std::lock_guard glock{this->incoming_generation_estimator_lock};
+        std::unique_lock glock{this->incoming_generation_estimator_lock, std::defer_lock};
+        if(!batch.owner_locked) {
+            glock.lock();
+        }
         packet_parser.set_estimated_generation(generation_estimator.visit_packet(packet_parser.packet_id()));
     }
 
-    auto result = this->decrypt_incoming_packet(error, packet_parser);
+    auto result = this->decrypt_incoming_packet(batch, error, packet_parser);
     if(result != PacketProcessResult::SUCCESS) {
         return result;
     }
@@ -88,11 +159,17 @@ PacketProcessResult PacketDecoder::process_incoming_data(PacketParser &packet_pa
                 packet_parser.payload().own_buffer()
         };
 
-        std::unique_lock queue_lock(fragment_buffer.buffer_lock);
+        /* In single owner mode we've already exclusive access */
+        std::unique_lock queue_lock(fragment_buffer.buffer_lock, std::defer_lock);
+        if(!batch.owner_locked) {
+            queue_lock.lock();
+        }
 
         auto insert_result = fragment_buffer.insert_index2(packet_parser.full_packet_id(), std::move(fragment_entry));
         if(insert_result != 0) {
-            queue_lock.unlock();
+            if(queue_lock.owns_lock()) {
+                queue_lock.unlock();
+            }
 
             error = "pid: " + std::to_string(packet_parser.packet_id()) + ", ";
             error += "bidx: " + std::to_string(fragment_buffer.current_index()) + ", ";
@@ -116,14 +193,17 @@ PacketProcessResult PacketDecoder::process_incoming_data(PacketParser &packet_pa
         ReassembledCommand* command{nullptr};
         CommandReassembleResult assemble_result;
         do {
-            if(!queue_lock.owns_lock()) {
+            if(!batch.owner_locked && !queue_lock.owns_lock()) {
                 queue_lock.lock();
             }
 
             assemble_result = this->try_reassemble_ordered_packet(fragment_buffer, queue_lock, command);
 
             if(assemble_result == CommandReassembleResult::SUCCESS || assemble_result == CommandReassembleResult::MORE_COMMANDS_PENDING) {
-                this->callback_decoded_command(this->callback_argument, command);
+                /* the commands will be handed over when the batch gets finished */
+                assert(!command->next_command);
+                *batch.commands_tail = std::exchange(command, nullptr);
+                batch.commands_tail = &(*batch.commands_tail)->next_command;
             }
 
             if(command) {
@@ -159,7 +239,7 @@ PacketProcessResult PacketDecoder::process_incoming_data(PacketParser &packet_pa
     return PacketProcessResult::SUCCESS;
 }
 
-PacketProcessResult PacketDecoder::decrypt_incoming_packet(std::string& error, PacketParser &packet_parser) {
+PacketProcessResult PacketDecoder::decrypt_incoming_packet(ProcessBatch& batch, std::string& error, PacketParser &packet_parser) {
     /* decrypt the packet if needed */
     if(packet_parser.is_encrypted()) {
         CryptHandler::key_t crypt_key{};
@@ -172,9 +252,21 @@ PacketProcessResult PacketDecoder::decrypt_incoming_packet(std::string& error, P
             crypt_key = CryptHandler::kDefaultKey;
             crypt_nonce = CryptHandler::kDefaultNonce;
         } else {
-            if(!this->crypt_handler_->generate_key_nonce(this->is_server, packet_parser.type(), packet_parser.packet_id(), packet_parser.estimated_generation(), crypt_key, crypt_nonce)) {
-                return PacketProcessResult::DECRYPT_KEY_GEN_FAILED;
+            /* Packets of a batch mostly share the same type and generation. Only the packet id differs. */
+            if(batch.key_packet_type != packet_parser.type() || batch.key_generation != packet_parser.estimated_generation()) {
+                if(!this->crypt_handler_->generate_key_nonce(this->is_server, packet_parser.type(), 0, packet_parser.estimated_generation(), batch.key, batch.nonce)) {
+                    batch.key_packet_type = 0xFF;
+                    return PacketProcessResult::DECRYPT_KEY_GEN_FAILED;
+                }
+
+                batch.key_packet_type = packet_parser.type();
+                batch.key_generation = packet_parser.estimated_generation();
             }
+
+            crypt_key = batch.key;
+            crypt_nonce = batch.nonce;
+            crypt_key[0] ^= (uint8_t) (packet_parser.packet_id() >> 8U);
+            crypt_key[1] ^= (uint8_t) packet_parser.packet_id();
         }
 
         auto mac = packet_parser.mac();
@@ -216,6 +308,11 @@ bool PacketDecoder::verify_encryption_client_packet(const protocol::ClientPacket
 }
 
 void PacketDecoder::register_initiv_packet() {
+    std::unique_lock owner_lock_{this->owner_lock, std::defer_lock};
+    if(this->single_owner) {
+        owner_lock_.lock();
+    }
+
     auto& fragment_buffer = this->_command_fragment_buffers[command_fragment_buffer_index(protocol::COMMAND)];
     std::unique_lock buffer_lock(fragment_buffer.buffer_lock);
     fragment_buffer.set_full_index_to(1); /* the first packet (0) is already the clientinitiv packet */
@@ -225,7 +322,7 @@ CommandReassembleResult PacketDecoder::try_reassemble_ordered_packet(
         command_fragment_buffer_t &buffer,
         std::unique_lock<std::mutex> &buffer_lock,
         ReassembledCommand *&assembled_command) {
-    assert(buffer_lock.owns_lock());
+    assert(buffer_lock.owns_lock() || this->single_owner);
 
     if(!buffer.front_set()) {
         return CommandReassembleResult::NO_COMMANDS_PENDING;
@@ -296,7 +393,9 @@ CommandReassembleResult PacketDecoder::try_reassemble_ordered_packet(
     }
 
     auto more_commands_pending = buffer.front_set(); /* set the more flag if we have more to process */
-    buffer_lock.unlock();
+    if(buffer_lock.owns_lock()) {
+        buffer_lock.unlock();
+    }
 
     if(packet_flags & PacketFlag::Compressed) {
         std::string error{};
@@ -3,6 +3,7 @@
 #include <misc/spin_mutex.h>
 #include <mutex>
 #include <deque>
+#include <array>
 #include <protocol/Packet.h>
 #include <protocol/generation.h>
 #include <protocol/ringbuffer.h>
@@ -55,27 +56,77 @@ namespace ts::protocol {
             /* direct function calls are better optimized out */
             typedef void(*callback_decoded_packet_t)(void* /* cb argument */, const protocol::PacketParser&);
             typedef void(*callback_decoded_command_t)(void* /* cb argument */, ReassembledCommand*& /* command */); /* must move the command, else it gets freed */
+            typedef void(*callback_decoded_commands_t)(void* /* cb argument */, ReassembledCommand*& /* commands linked via next_command */); /* must move the commands, else they get freed */
             typedef void(*callback_send_acknowledge_t)(void* /* cb argument */, uint16_t /* packet id */, bool /* is command low */);
 
+            /**
+             * State of datagrams which are getting processed back to back.
+             * The decrypt key of the last packet type and generation will be reused and all decoded
+             * commands are collected and handed over at once when the batch gets finished.
+             */
+            struct ProcessBatch {
+                uint8_t key_packet_type{0xFF};
+                uint16_t key_generation{0};
+                std::array<uint8_t, 16> key{}; /* without the packet id applied */
+                std::array<uint8_t, 16> nonce{};
+
+                ReassembledCommand* commands_head{nullptr};
+                ReassembledCommand** commands_tail{&this->commands_head};
+
+                bool owner_locked{false};
+            };
+
             explicit PacketDecoder(connection::CryptHandler* /* crypt handler */, bool /* is server */);
             ~PacketDecoder();
 
             void reset();
 
+            /**
+             * Enable the single owner mode.
+             * Use this if all datagrams of the connection are getting processed by the same thread.
+             * The decoder will be locked once per batch and the generation estimation as well as the
+             * command reassembly run without any further locks.
+             * Attention: This must be set before the first datagram gets processed.
+             */
+            inline void set_single_owner(bool enabled) { this->single_owner = enabled; }
+            [[nodiscard]] inline bool is_single_owner() const { return this->single_owner; }
+
             bool verify_encryption_client_packet(const protocol::ClientPacketParser& /* packet */);
 
             /* true if commands might be pending */
             PacketProcessResult process_incoming_data(protocol::PacketParser &/* packet */, std::string& /* error detail */);
+
+            void begin_batch(ProcessBatch& /* batch */);
+            PacketProcessResult process_incoming_data(ProcessBatch& /* batch */, protocol::PacketParser &/* packet */, std::string& /* error detail */);
+
+            /**
+             * Hand all decoded commands of the batch to callback_decoded_commands (or callback_decoded_command if not set).
+             * The decoder will be unlocked before the callbacks get called.
+             */
+            void finish_batch(ProcessBatch& /* batch */);
+
+            /**
+             * Hand the decoded commands over right away if the encryption hasn't been initialized yet.
+             * The crypt setup commands must be handled before the following packets of the batch can be decrypted.
+             * The batch will be continued afterwards.
+             */
+            void flush_crypt_setup_commands(ProcessBatch& /* batch */);
+
             void register_initiv_packet();
 
             void* callback_argument{nullptr};
             callback_decoded_packet_t callback_decoded_packet{[](auto, auto&){}}; /* needs to be valid all the time! */
             callback_decoded_command_t callback_decoded_command{[](auto, auto&){}}; /* needs to be valid all the time! */
+            callback_decoded_commands_t callback_decoded_commands{nullptr}; /* optional, used by finish_batch */
             callback_send_acknowledge_t callback_send_acknowledge{[](auto, auto, auto){}}; /* needs to be valid all the time! */
         private:
             bool is_server;
+            bool single_owner{false};
             connection::CryptHandler* crypt_handler_{nullptr};
 
+            /* Only used in single owner mode. Acquired once per batch. */
+            spin_mutex owner_lock{};
+
             spin_mutex incoming_generation_estimator_lock{};
             std::array<protocol::GenerationEstimator, 9> incoming_generation_estimators{}; /* implementation is thread save */
 
@@ -86,7 +137,9 @@ namespace ts::protocol {
                 return packet_index & 0x1U; /* use 0 for command and 1 for command low */
             }
 
-            PacketProcessResult decrypt_incoming_packet(std::string &error /* error */, protocol::PacketParser &packet_parser/* packet */);
+            PacketProcessResult decrypt_incoming_packet(ProcessBatch& /* batch */, std::string &error /* error */, protocol::PacketParser &packet_parser/* packet */);
+
+            /* The buffer lock will not be owned in single owner mode */
             CommandReassembleResult try_reassemble_ordered_packet(command_fragment_buffer_t& /* buffer */, std::unique_lock<std::mutex>& /* buffer lock */, ReassembledCommand*& /* command */);
     };
 }
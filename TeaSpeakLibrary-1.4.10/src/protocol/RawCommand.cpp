@@ -11,6 +11,7 @@ ReassembledCommand *ReassembledCommand::allocate(size_t size) {
     instance->length_ = size;
     instance->capacity_ = size;
     instance->next_command = nullptr;
+    instance->enqueue_timestamp = {};
     return instance;
 }
 
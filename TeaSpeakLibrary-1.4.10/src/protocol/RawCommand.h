@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <string_view>
 #include <pipes/buffer.h>
@@ -43,6 +44,8 @@ namespace ts::command {
             [[nodiscard]] inline std::string_view command_view() const { return std::string_view{this->command(), this->length()}; }
 
             mutable ReassembledCommand* next_command; /* nullptr by default */
+            /* Set by the command queue, used to account the time the command has been waiting for its execution */
+            std::chrono::steady_clock::time_point enqueue_timestamp;
         private:
             explicit ReassembledCommand() = default;
 
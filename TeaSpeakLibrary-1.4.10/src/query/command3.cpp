@@ -3,6 +3,7 @@
 //
 
 #include <iostream>
+#include <algorithm>
 #include "command3.h"
 
 using namespace ts;
@@ -23,6 +24,8 @@ bool command_parser::parse(bool command) {
         index++;
     }
 
+    /* reserve all bulks at once so a parse only requires one allocation */
+    this->_bulks.reserve(std::count(this->data.begin() + index, this->data.end(), '|') + 1);
     while(index < this->data.size()) {
         findex = this->data.find('|', index);
         if(findex == std::string::npos) {
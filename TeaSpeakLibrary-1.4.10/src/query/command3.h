@@ -2,10 +2,13 @@
 
 #include <string>
 #include <cstddef>
+#include <charconv>
+#include <algorithm>
 #include <vector>
 #include <deque>
 #include <optional>
 #include <string_view>
+#include <type_traits>
 
 #include "escape.h"
 #include "converters/converter.h"
@@ -89,6 +92,18 @@ namespace ts {
                     static_assert(converter<T>::supported, "Target type isn't supported!");
                     static_assert(!converter<T>::supported || converter<T>::from_string_view, "Target type dosn't support parsing");
 
+                    if constexpr(std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+                        /* numeric values don't contain escape sequences, convert them without unescaping them into a copy */
+                        const auto raw_value = this->value_raw(key);
+                        if(raw_value.find('\\') == std::string_view::npos) {
+                            try {
+                                return converter<T>::from_string_view(raw_value);
+                            } catch (std::exception& ex) {
+                                throw command_value_cast_failed{this->key_command_character_index(key), std::string{key}, std::string{raw_value}, typeid(T)};
+                            }
+                        }
+                    }
+
                     auto value = this->value(key);
                     try {
                         return converter<T>::from_string_view(value);
@@ -161,7 +176,10 @@ namespace ts {
             };
 
             explicit command_parser(std::string_view command) : impl::command_string_parser{std::string::npos, 0, command} { }
-            explicit command_parser(std::string command) : impl::command_string_parser{std::string::npos, 0, command}, _command_memory{std::move(command)} { }
+            explicit command_parser(std::string command) : impl::command_string_parser{std::string::npos, 0, {}}, _command_memory{std::move(command)} {
+                /* the view has to reference our own memory since moving a short string invalidates its data pointer */
+                this->data = this->_command_memory;
+            }
 
             bool parse(bool /* contains identifier */);
 
@@ -205,14 +223,14 @@ namespace ts {
                 } while(true);
             }
 
-            [[nodiscard]] const std::deque<command_bulk>& bulks() const { return this->_bulks; }
+            [[nodiscard]] const std::vector<command_bulk>& bulks() const { return this->_bulks; }
 
             [[nodiscard]]  std::string_view payload_view(size_t bulk_index) const noexcept;
             [[nodiscard]] std::optional<size_t> next_bulk_containing(const std::string_view& /* key */, size_t /* bulk offset */) const;
         private:
             const std::string _command_memory{};
             std::string_view command_type{};
-            std::deque<command_bulk> _bulks{};
+            std::vector<command_bulk> _bulks{};
     };
 
     class command_builder_bulk {
@@ -287,13 +305,17 @@ namespace ts {
             std::string* bulk;
 
             void impl_put_unchecked(const std::string_view& key, const std::string_view& value) {
-                auto escaped_value = ts::query::escape(std::string{value});
+                auto escaped_length = ts::query::escaped_length(value);
 
-                this->bulk->reserve(this->bulk->length() + key.size() + escaped_value.size() + 2);
+                this->bulk->reserve(this->bulk->length() + key.size() + escaped_length + 2);
                 this->bulk->append(key);
-                if(!escaped_value.empty()) {
+                if(escaped_length > 0) {
                     this->bulk->append("=");
-                    this->bulk->append(escaped_value);
+
+                    /* escape the value directly into the bulk */
+                    auto offset = this->bulk->length();
+                    this->bulk->resize(offset + escaped_length);
+                    ts::query::escape_into(this->bulk->data() + offset, value);
                 }
                 this->bulk->append(" ");
                 *this->flag_changed = true;
@@ -421,6 +443,123 @@ namespace ts {
     };
 
     using command_builder = command_builder_impl<>;
+
+    /**
+     * Command builder writing all bulks into one continuous buffer.
+     * Bulks have to be written in order and keys will not be checked for duplicates,
+     * which makes it suitable for large responses like channellist or clientlist.
+     * Numbers will be formatted via std::to_chars (floating point numbers like std::to_string) and strings are escaped directly into the buffer.
+     */
+    class command_arena_builder {
+        public:
+            explicit command_arena_builder(const std::string_view& identifier, size_t expected_size = 1024, size_t expected_bulks = 1) {
+                this->buffer_.reserve(std::max(expected_size, identifier.size() + 1));
+                this->buffer_.append(identifier);
+                this->bulk_offsets_.reserve(expected_bulks);
+            }
+
+            /* Finish the current bulk. Bulks without any entries will be skipped. */
+            inline void next_bulk() { this->bulk_open_ = false; }
+
+            [[nodiscard]] inline size_t bulk_count() const { return this->bulk_offsets_.size(); }
+            [[nodiscard]] inline size_t current_size() const { return this->buffer_.size(); }
+
+            /* The bulk payload without the command identifier and the bulk separator */
+            [[nodiscard]] inline std::string_view bulk(size_t index) const {
+                if(index >= this->bulk_offsets_.size())
+                    return std::string_view{};
+
+                auto begin = this->bulk_offsets_[index];
+                auto end = index + 1 < this->bulk_offsets_.size() ? this->bulk_offsets_[index + 1] - 1 : this->buffer_.size();
+                return std::string_view{this->buffer_}.substr(begin, end - begin);
+            }
+
+            /* The whole command as it would be returned by command_builder::build() */
+            [[nodiscard]] inline std::string_view view() const { return this->buffer_; }
+
+            /* Take the underlying buffer. The builder should not be used afterwards. */
+            [[nodiscard]] inline std::string release() {
+                this->bulk_offsets_.clear();
+                return std::move(this->buffer_);
+            }
+
+            inline void put(const std::string_view& key, const std::string_view& value) {
+                this->begin_entry(key);
+
+                auto escaped_length = ts::query::escaped_length(value);
+                if(escaped_length == 0)
+                    return;
+
+                this->buffer_.push_back('=');
+                auto offset = this->buffer_.size();
+                this->buffer_.resize(offset + escaped_length);
+                ts::query::escape_into(this->buffer_.data() + offset, value);
+            }
+
+            template <typename T>
+            inline void put(const std::string_view& key, const T& value) {
+                if constexpr(std::is_convertible_v<const T&, std::string_view>) {
+                    this->put(key, std::string_view{value});
+                } else if constexpr(std::is_same_v<T, bool>) {
+                    this->put_formatted(key, value ? "1" : "0");
+                } else if constexpr(std::is_enum_v<T>) {
+                    this->put(key, (std::underlying_type_t<T>) value);
+                } else if constexpr(std::is_floating_point_v<T>) {
+                    /* Same format as std::to_string (%f) which is used by the command_builder */
+                    char buffer[64];
+                    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, 6);
+                    if(result.ec == std::errc{}) {
+                        this->put_formatted(key, std::string_view{buffer, (size_t) (result.ptr - buffer)});
+                    } else {
+                        /* huge values */
+                        this->put_formatted(key, std::to_string(value));
+                    }
+                } else if constexpr(std::is_arithmetic_v<T>) {
+                    char buffer[64];
+                    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+                    this->put_formatted(key, std::string_view{buffer, (size_t) (result.ptr - buffer)});
+                } else {
+                    static_assert(converter<T>::supported, "Target type isn't supported!");
+                    static_assert(!converter<T>::supported || converter<T>::to_string, "Target type dosn't support building");
+                    auto data = converter<T>::to_string(value);
+                    this->put(key, std::string_view{data});
+                }
+            }
+
+#ifdef PROPERTIES_DEFINED
+            template <typename PropertyType, typename T, std::enable_if_t<std::is_enum<PropertyType>::value, int> = 0>
+            inline void put(PropertyType key, const T& value) {
+                this->put(property::name(key), value);
+            }
+#endif
+        private:
+            std::string buffer_{};
+            /* offset of the first key of every bulk */
+            std::vector<size_t> bulk_offsets_{};
+            bool bulk_open_{false};
+
+            inline void begin_entry(const std::string_view& key) {
+                if(this->bulk_open_) {
+                    this->buffer_.push_back(' ');
+                } else {
+                    if(!this->bulk_offsets_.empty())
+                        this->buffer_.push_back('|');
+                    else if(!this->buffer_.empty())
+                        this->buffer_.push_back(' '); /* separate the identifier */
+
+                    this->bulk_offsets_.push_back(this->buffer_.size());
+                    this->bulk_open_ = true;
+                }
+                this->buffer_.append(key);
+            }
+
+            /* the value must not contain any characters which need to be escaped */
+            inline void put_formatted(const std::string_view& key, const std::string_view& value) {
+                this->begin_entry(key);
+                this->buffer_.push_back('=');
+                this->buffer_.append(value);
+            }
+    };
 }
 
 #define COMMAND_BUILDER_DEFINED
\ No newline at end of file
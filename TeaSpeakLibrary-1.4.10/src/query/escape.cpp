@@ -1,42 +1,334 @@
 #include "escape.h"
+#include <atomic>
+#include <cstring>
+#include <cstdint>
 #include <stdexcept>
 
+#if defined(__x86_64__) || defined(__i386__)
+    #define ESCAPE_HAVE_SIMD
+    #include <immintrin.h>
+
+    #define ESCAPE_SSE2_TARGET __attribute__((target("sse2")))
+    #define ESCAPE_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
 using namespace ts;
 using namespace std;
 
-std::string query::escape(std::string in) {
-    size_t index = 0;
-    while(index < in.length()) {
-        if(in[index] == '\\')
-            in.replace(index, 1, "\\\\", 2);
-        else if(in[index] == ' ')
-            in.replace(index, 1, "\\s", 2);
-        else if(in[index] == '/')
-            in.replace(index, 1, "\\/", 2);
-        else if(in[index] == '|')
-            in.replace(index, 1, "\\p", 2);
-        else if(in[index] == '\b')
-            in.replace(index, 1, "\\b", 2);
-        else if(in[index] == '\f')
-            in.replace(index, 1, "\\f", 2);
-        else if(in[index] == '\n')
-            in.replace(index, 1, "\\n", 2);
-        else if(in[index] == '\r')
-            in.replace(index, 1, "\\r", 2);
-        else if(in[index] == '\t')
-            in.replace(index, 1, "\\t", 2);
-        else if(in[index] == '\x07')
-            in.replace(index, 1, "\\a", 2);
-        else if(in[index] == '\x0B')
-            in.replace(index, 1, "\\v", 2);
-        else {
-            index += 1;
-            continue;
+namespace {
+    /* \a \b \t \n \v \f \r, space, slash, pipe and the backslash itself */
+    inline bool escape_required(uint8_t character) {
+        return (character >= 0x07 && character <= 0x0D) || character == ' ' || character == '/' || character == '|' || character == '\\';
+    }
+
+    inline char escape_character(char character) {
+        switch(character) {
+            case '\\': return '\\';
+            case ' ': return 's';
+            case '/': return '/';
+            case '|': return 'p';
+            case '\b': return 'b';
+            case '\f': return 'f';
+            case '\n': return 'n';
+            case '\r': return 'r';
+            case '\t': return 't';
+            case '\x07': return 'a';
+            case '\x0B': return 'v';
+            default: return character;
         }
-        index += 2;
     }
 
-    return in;
+    /* Escape sequences, control characters which will be replaced by a space and everything which isn't ASCII */
+    inline bool unescape_required(uint8_t character) {
+        return character == '\\' || character < 0x0A || character >= 0x80;
+    }
+
+    /* Write the block, all bytes marked within the mask will be escaped */
+    inline char* write_escaped_block(const char* data, size_t length, uint32_t mask, char* output) {
+        size_t index{0};
+        while(mask) {
+            auto next = (size_t) __builtin_ctz(mask);
+            memcpy(output, data + index, next - index);
+            output += next - index;
+
+            *output++ = '\\';
+            *output++ = escape_character(data[next]);
+
+            index = next + 1;
+            mask &= mask - 1;
+        }
+
+        memcpy(output, data + index, length - index);
+        return output + length - index;
+    }
+
+    size_t scalar_count_escape(const char* data, size_t length) {
+        size_t result{0};
+        for(size_t index{0}; index < length; index++) {
+            result += escape_required((uint8_t) data[index]);
+        }
+        return result;
+    }
+
+    size_t scalar_escape(const char* data, size_t length, char* buffer) {
+        auto output = buffer;
+        for(size_t index{0}; index < length; index++) {
+            if(escape_required((uint8_t) data[index])) {
+                *output++ = '\\';
+                *output++ = escape_character(data[index]);
+            } else {
+                *output++ = data[index];
+            }
+        }
+        return output - buffer;
+    }
+
+    size_t scalar_find_unescape(const char* data, size_t length) {
+        for(size_t index{0}; index < length; index++) {
+            if(unescape_required((uint8_t) data[index])) {
+                return index;
+            }
+        }
+        return length;
+    }
+
+#ifdef ESCAPE_HAVE_SIMD
+    ESCAPE_SSE2_TARGET inline __m128i sse2_escape_mask(__m128i block) {
+        /* unsigned range check for 0x07 - 0x0D */
+        auto control = _mm_sub_epi8(block, _mm_set1_epi8(0x07));
+        auto result = _mm_cmpeq_epi8(_mm_min_epu8(control, _mm_set1_epi8(0x06)), control);
+        result = _mm_or_si128(result, _mm_cmpeq_epi8(block, _mm_set1_epi8(' ')));
+        result = _mm_or_si128(result, _mm_cmpeq_epi8(block, _mm_set1_epi8('/')));
+        result = _mm_or_si128(result, _mm_cmpeq_epi8(block, _mm_set1_epi8('|')));
+        return _mm_or_si128(result, _mm_cmpeq_epi8(block, _mm_set1_epi8('\\')));
+    }
+
+    ESCAPE_SSE2_TARGET inline __m128i sse2_unescape_mask(__m128i block) {
+        /* the signed compare also matches all bytes >= 0x80 */
+        auto result = _mm_cmplt_epi8(block, _mm_set1_epi8(0x0A));
+        return _mm_or_si128(result, _mm_cmpeq_epi8(block, _mm_set1_epi8('\\')));
+    }
+
+    ESCAPE_SSE2_TARGET size_t sse2_count_escape(const char* data, size_t length) {
+        size_t result{0}, index{0};
+        for(; index + 16 <= length; index += 16) {
+            auto mask = (uint32_t) _mm_movemask_epi8(sse2_escape_mask(_mm_loadu_si128((const __m128i*) (data + index))));
+            result += __builtin_popcount(mask);
+        }
+        return result + scalar_count_escape(data + index, length - index);
+    }
+
+    ESCAPE_SSE2_TARGET size_t sse2_escape(const char* data, size_t length, char* buffer) {
+        auto output = buffer;
+        size_t index{0};
+        for(; index + 16 <= length; index += 16) {
+            auto block = _mm_loadu_si128((const __m128i*) (data + index));
+            auto mask = (uint32_t) _mm_movemask_epi8(sse2_escape_mask(block));
+            if(!mask) {
+                _mm_storeu_si128((__m128i*) output, block);
+                output += 16;
+                continue;
+            }
+
+            output = write_escaped_block(data + index, 16, mask, output);
+        }
+        return (output - buffer) + scalar_escape(data + index, length - index, output);
+    }
+
+    ESCAPE_SSE2_TARGET size_t sse2_find_unescape(const char* data, size_t length) {
+        size_t index{0};
+        for(; index + 16 <= length; index += 16) {
+            auto mask = (uint32_t) _mm_movemask_epi8(sse2_unescape_mask(_mm_loadu_si128((const __m128i*) (data + index))));
+            if(mask) {
+                return index + __builtin_ctz(mask);
+            }
+        }
+        return index + scalar_find_unescape(data + index, length - index);
+    }
+
+    ESCAPE_AVX2_TARGET inline __m256i avx2_escape_mask(__m256i block) {
+        auto control = _mm256_sub_epi8(block, _mm256_set1_epi8(0x07));
+        auto result = _mm256_cmpeq_epi8(_mm256_min_epu8(control, _mm256_set1_epi8(0x06)), control);
+        result = _mm256_or_si256(result, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')));
+        result = _mm256_or_si256(result, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('/')));
+        result = _mm256_or_si256(result, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('|')));
+        return _mm256_or_si256(result, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\\')));
+    }
+
+    ESCAPE_AVX2_TARGET inline __m256i avx2_unescape_mask(__m256i block) {
+        auto result = _mm256_cmpgt_epi8(_mm256_set1_epi8(0x0A), block);
+        return _mm256_or_si256(result, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\\')));
+    }
+
+    ESCAPE_AVX2_TARGET size_t avx2_count_escape(const char* data, size_t length) {
+        size_t result{0}, index{0};
+        for(; index + 32 <= length; index += 32) {
+            auto mask = (uint32_t) _mm256_movemask_epi8(avx2_escape_mask(_mm256_loadu_si256((const __m256i*) (data + index))));
+            result += __builtin_popcount(mask);
+        }
+
+        /* the tail is handled by the SSE2 kernel, avoid the AVX to SSE transition penalty */
+        _mm256_zeroupper();
+        return result + sse2_count_escape(data + index, length - index);
+    }
+
+    ESCAPE_AVX2_TARGET size_t avx2_escape(const char* data, size_t length, char* buffer) {
+        auto output = buffer;
+        size_t index{0};
+        for(; index + 32 <= length; index += 32) {
+            auto block = _mm256_loadu_si256((const __m256i*) (data + index));
+            auto mask = (uint32_t) _mm256_movemask_epi8(avx2_escape_mask(block));
+            if(!mask) {
+                _mm256_storeu_si256((__m256i*) output, block);
+                output += 32;
+                continue;
+            }
+
+            output = write_escaped_block(data + index, 32, mask, output);
+        }
+
+        _mm256_zeroupper();
+        return (output - buffer) + sse2_escape(data + index, length - index, output);
+    }
+
+    ESCAPE_AVX2_TARGET size_t avx2_find_unescape(const char* data, size_t length) {
+        size_t index{0};
+        for(; index + 32 <= length; index += 32) {
+            auto mask = (uint32_t) _mm256_movemask_epi8(avx2_unescape_mask(_mm256_loadu_si256((const __m256i*) (data + index))));
+            if(mask) {
+                return index + __builtin_ctz(mask);
+            }
+        }
+
+        _mm256_zeroupper();
+        return index + sse2_find_unescape(data + index, length - index);
+    }
+#endif
+
+    bool backend_supported(query::EscapeBackend backend) {
+#ifdef ESCAPE_HAVE_SIMD
+        /* we might get called by a static initializer before the CPU model has been initialized */
+        __builtin_cpu_init();
+#endif
+        switch(backend) {
+            case query::EscapeBackend::SCALAR:
+                return true;
+#ifdef ESCAPE_HAVE_SIMD
+            case query::EscapeBackend::SSE2:
+                return __builtin_cpu_supports("sse2");
+            case query::EscapeBackend::AVX2:
+                return __builtin_cpu_supports("avx2");
+#endif
+            default:
+                return false;
+        }
+    }
+
+    query::EscapeBackend detect_backend() {
+        for(auto backend : {query::EscapeBackend::AVX2, query::EscapeBackend::SSE2}) {
+            if(backend_supported(backend)) {
+                return backend;
+            }
+        }
+        return query::EscapeBackend::SCALAR;
+    }
+
+    std::atomic<query::EscapeBackend> selected_backend{detect_backend()};
+
+    inline size_t count_escape(const char* data, size_t length) {
+        switch(selected_backend.load(std::memory_order_relaxed)) {
+#ifdef ESCAPE_HAVE_SIMD
+            case query::EscapeBackend::AVX2:
+                return avx2_count_escape(data, length);
+            case query::EscapeBackend::SSE2:
+                return sse2_count_escape(data, length);
+#endif
+            default:
+                return scalar_count_escape(data, length);
+        }
+    }
+
+    inline size_t find_unescape(const char* data, size_t length) {
+        switch(selected_backend.load(std::memory_order_relaxed)) {
+#ifdef ESCAPE_HAVE_SIMD
+            case query::EscapeBackend::AVX2:
+                return avx2_find_unescape(data, length);
+            case query::EscapeBackend::SSE2:
+                return sse2_find_unescape(data, length);
+#endif
+            default:
+                return scalar_find_unescape(data, length);
+        }
+    }
+
+    inline bool utf8_continuation(uint8_t character) {
+        return character >= 128 && character <= 191;
+    }
+}
+
+query::EscapeBackend query::active_escape_backend() {
+    return selected_backend.load(std::memory_order_relaxed);
+}
+
+const char* query::escape_backend_name(EscapeBackend backend) {
+    switch(backend) {
+        case EscapeBackend::SCALAR:
+            return "scalar";
+        case EscapeBackend::SSE2:
+            return "SSE2";
+        case EscapeBackend::AVX2:
+            return "AVX2";
+        default:
+            return "unknown";
+    }
+}
+
+bool query::escape_backend_supported(EscapeBackend backend) {
+    return backend_supported(backend);
+}
+
+bool query::select_escape_backend(EscapeBackend backend) {
+    if(!backend_supported(backend)) {
+        return false;
+    }
+
+    selected_backend.store(backend);
+    return true;
+}
+
+size_t query::escaped_length(const std::string_view &value) {
+    return value.length() + count_escape(value.data(), value.length());
+}
+
+size_t query::escape_into(char *buffer, const std::string_view &value) {
+    switch(selected_backend.load(std::memory_order_relaxed)) {
+#ifdef ESCAPE_HAVE_SIMD
+        case EscapeBackend::AVX2:
+            return avx2_escape(value.data(), value.length(), buffer);
+        case EscapeBackend::SSE2:
+            return sse2_escape(value.data(), value.length(), buffer);
+#endif
+        default:
+            return scalar_escape(value.data(), value.length(), buffer);
+    }
+}
+
+void query::escape_append(std::string &target, const std::string_view &value) {
+    auto offset = target.length();
+    target.resize(offset + query::escaped_length(value));
+    query::escape_into(target.data() + offset, value);
+}
+
+std::string query::escape(std::string in) {
+    auto length = query::escaped_length(in);
+    if(length == in.length()) {
+        return in;
+    }
+
+    std::string result{};
+    result.resize(length);
+    query::escape_into(result.data(), in);
+    return result;
 }
 
 /*
@@ -54,14 +346,51 @@ end
 else
 output := output + AnsiChar(input);
  */
+/*
+ * The input will be unescaped in place since the result never grows.
+ * Everything in front of write_index is final, plain ASCII runs are located via the SIMD kernels.
+ */
 std::string query::unescape(std::string in, bool throw_error) {
-    size_t index = 0;
-    while(index < in.length()){
-        if(in[index] == '\\'){
-            if(in.length() <= index + 1) break;
-            char replace = 0;
+    auto data = (uint8_t*) in.data();
+    const auto length = in.length();
+
+    size_t read_index = find_unescape((const char*) data, length);
+    if(read_index == length) {
+        return in;
+    }
+
+    size_t write_index{read_index};
+    auto copy_plain = [&](size_t count) {
+        if(write_index != read_index) {
+            memmove(data + write_index, data + read_index, count);
+        }
+        write_index += count;
+        read_index += count;
+    };
+
+    auto invalid_character = [&] {
+        if(throw_error) {
+            throw invalid_argument("Invalid UTF-8 character at index " + to_string(write_index));
+        }
+    };
+
+    while(read_index < length) {
+        copy_plain(find_unescape((const char*) data + read_index, length - read_index));
+        if(read_index >= length) {
+            break;
+        }
+
+        const auto remaining = length - read_index;
+        const uint8_t current = data[read_index];
+        if(current == '\\') {
+            if(remaining <= 1) {
+                /* trailing backslash, keep it */
+                copy_plain(1);
+                break;
+            }
 
-            switch (in[index + 1]){
+            char replace;
+            switch (data[read_index + 1]){
                 case 's': replace = ' '; break;
                 case '/': replace = '/'; break;
                 case 'p': replace = '|'; break;
@@ -76,85 +405,91 @@ std::string query::unescape(std::string in, bool throw_error) {
                 default:
                     replace = '\x00'; break;
             }
-            if(replace != 0x00)
-                in.replace(index, 2, string(&replace, 1));
+
+            if(replace == 0x00) {
+                /* unknown escape sequence, keep the backslash */
+                copy_plain(1);
+                continue;
+            }
+
+            /* the control characters below \n will be replaced by a space as well */
+            data[write_index++] = (uint8_t) replace < 0x0A ? ' ' : replace;
+            read_index += 2;
+            continue;
         }
 
-        uint8_t current = (uint8_t) in[index];
-        if(in.length() - index >= 6) { //Check for CESU-8
-            if((current == 0xED) && ((uint8_t) in[index + 3] == 0xED) && ((((uint8_t) in[index + 1] | 0xF) == 0xAF)) && ((((uint8_t) in[index + 4] | 0xF) == 0xBF))){
-                char replaced[4];
+        if(current < 0x0A) {
+            data[write_index++] = ' ';
+            read_index++;
+            continue;
+        }
 
-                replaced[0] = (((((uint8_t) in[index + 1] & 0xF) + 1) >> 2) & 7) | 0xF0;
-                replaced[1] = ((((uint8_t) in[index + 2] >> 2) & 0xF) + (((((uint8_t) in[index + 1] & 0xF)) + (1 << 4)) | 0x80));
-                replaced[2] = (((uint8_t) in[index + 4] & 0xF) + (((uint8_t) in[index + 2] << 4) & 0x30)) | 0x80;
-                replaced[3] = ((uint8_t) in[index + 5]);
+        if(remaining >= 6) { //Check for CESU-8
+            const uint8_t* input = data + read_index;
+            if((current == 0xED) && (input[3] == 0xED) && (((input[1] | 0xF) == 0xAF)) && (((input[4] | 0xF) == 0xBF))){
+                uint8_t replaced[4];
 
-                in.replace(index, 6, string(replaced, 4));
-                index -= 2; //Substract the replace difference
+                replaced[0] = ((((input[1] & 0xF) + 1) >> 2) & 7) | 0xF0;
+                replaced[1] = (((input[2] >> 2) & 0xF) + ((((input[1] & 0xF)) + (1 << 4)) | 0x80));
+                replaced[2] = ((input[4] & 0xF) + ((input[2] << 4) & 0x30)) | 0x80;
+                replaced[3] = input[5];
+                read_index += 6;
 
-                index += 5; //Skip 5 bytes (CESU-8 length for emoty)
+                data[write_index++] = replaced[0];
+                data[write_index++] = replaced[1];
+                data[write_index++] = replaced[2];
+
+                /* the replaced surrogate pair will be validated as a three byte sequence starting with its last byte */
+                if(length - read_index < 2) {
+                    read_index = length;
+                } else if(utf8_continuation(data[read_index]) && utf8_continuation(data[read_index + 1])) {
+                    data[write_index++] = replaced[3];
+                    data[write_index++] = data[read_index++];
+                    data[write_index++] = data[read_index++];
+                } else {
+                    invalid_character();
+                    read_index += 2;
+                }
+                continue;
             }
         }
-        //"\221\210\200\200\200\210\221\221\221\221\204\210\221\221\221\221\221\221\221\221\221\204\210\221\221\221\221\221\204\210\221\221"
-        if(current >= 128) { //UTF8 check
-            if(current >= 192 && (current <= 193 || current >= 245)) {
-                in.replace(index, 1, "", 0); //Cut the character out
-                index--;
-            } else if(current >= 194 && current <= 223) {
-                if(in.length() - index <= 1) {
-                    in.replace(index, in.length() - index, "", 0);
-                } else if((uint8_t) in[index + 1] >= 128 && (uint8_t) in[index + 1] <= 191) {
-                    index += 1; //Valid
-                } else {
-                    if(throw_error) {
-                        throw invalid_argument("Invalid UTF-8 character at index " + to_string(index));
-                    }
 
-                    in.replace(index, 2, "", 0); //Cut the two characters out
-                    index--;
-                }
-            } else if(current >= 224 && current <= 239) {
-                if(in.length() - index <= 2) {
-                    in.replace(index, in.length() - index, "", 0);
-                } else if((uint8_t) in[index + 1] >= 128 && (uint8_t) in[index + 1] <= 191 &&
-                        (uint8_t) in[index + 2] >= 128 && (uint8_t) in[index + 2] <= 191) {
-                    index += 2; //Valid
-                } else {
-                    if(throw_error) {
-                        throw invalid_argument("Invalid UTF-8 character at index " + to_string(index));
-                    }
+        //UTF8 check
+        size_t sequence_length;
+        if(current >= 192 && (current <= 193 || current >= 245)) {
+            read_index++; //Cut the character out
+            continue;
+        } else if(current >= 194 && current <= 223) {
+            sequence_length = 2;
+        } else if(current >= 224 && current <= 239) {
+            sequence_length = 3;
+        } else if(current >= 240 && current <= 244) {
+            sequence_length = 4;
+        } else {
+            invalid_character();
+            read_index++; //Cut the character out
+            continue;
+        }
 
-                    in.replace(index, 3, "", 0); //Cut the three characters out
-                    index--;
-                }
-            } else if(current >= 240 && current <= 244) {
-                if(in.length() - index <= 3) {
-                    in.replace(index, in.length() - index, "", 0);
-                } else if((uint8_t) in[index + 1] >= 128 && (uint8_t) in[index + 1] <= 191 &&
-                        (uint8_t) in[index + 2] >= 128 && (uint8_t) in[index + 2] <= 191 &&
-                        (uint8_t) in[index + 3] >= 128 && (uint8_t) in[index + 3] <= 191) {
-                    index += 3; //Valid
-                } else {
-                    if(throw_error) {
-                        throw invalid_argument("Invalid UTF-8 character at index " + to_string(index));
-                    }
+        if(remaining < sequence_length) {
+            /* truncated sequence, cut off the rest */
+            read_index = length;
+            break;
+        }
 
-                    in.replace(index, 4, "", 0); //Cut the three characters out
-                    index--;
-                }
-            } else {
-                if(throw_error) {
-                    throw invalid_argument("Invalid UTF-8 character at index " + to_string(index));
-                }
+        bool valid{true};
+        for(size_t index{1}; index < sequence_length; index++) {
+            valid &= utf8_continuation(data[read_index + index]);
+        }
 
-                in.replace(index, 1, "", 0); //Cut the character out
-                index--;
-            }
-        } else if(current < 0x0A) {
-            in.replace(index, 1, " ", 1);
+        if(valid) {
+            copy_plain(sequence_length);
+        } else {
+            invalid_character();
+            read_index += sequence_length; //Cut the characters out
         }
-        index++;
     }
+
+    in.resize(write_index);
     return in;
-}
\ No newline at end of file
+}
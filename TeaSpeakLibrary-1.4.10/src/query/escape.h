@@ -1,8 +1,43 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 namespace ts::query {
+    /*
+     * The escaped bytes are located in 16 (SSE2) or 32 (AVX2) byte blocks if supported by the CPU,
+     * else we're falling back to the scalar implementation.
+     */
+    enum struct EscapeBackend {
+        SCALAR,
+        SSE2,
+        AVX2
+    };
+
+    [[nodiscard]] extern EscapeBackend active_escape_backend();
+    [[nodiscard]] extern const char* escape_backend_name(EscapeBackend /* backend */);
+    [[nodiscard]] extern bool escape_backend_supported(EscapeBackend /* backend */);
+
+    /**
+     * Override the backend selected by the CPU features.
+     * Used by the tests and benchmarks only.
+     * @returns false if the backend isn't supported by this CPU
+     */
+    extern bool select_escape_backend(EscapeBackend /* backend */);
+
     extern std::string escape(std::string);
     extern std::string unescape(std::string, bool /* throw error */);
-}
\ No newline at end of file
+
+    /* Length of the value after escaping it */
+    [[nodiscard]] extern size_t escaped_length(const std::string_view& /* value */);
+
+    /**
+     * Write the escaped value into the buffer.
+     * The buffer must be able to hold at least escaped_length(value) bytes.
+     * @returns the bytes written
+     */
+    extern size_t escape_into(char* /* buffer */, const std::string_view& /* value */);
+
+    /* Append the escaped value to the target. The target will only be resized once. */
+    extern void escape_append(std::string& /* target */, const std::string_view& /* value */);
+}
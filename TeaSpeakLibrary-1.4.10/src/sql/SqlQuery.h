@@ -6,6 +6,7 @@
 #include <sqlite3.h>
 #include <functional>
 #include <utility>
+#include <chrono>
 #include <ThreadPool/ThreadPool.h>
 #include <ThreadPool/Future.h>
 #include <misc/memtracker.h>
@@ -100,6 +101,15 @@ namespace sql {
 
             SqlType getType(){ return this->type; }
 
+            /*
+             * Optional observer which will be called after every executed statement.
+             * Must be set before any statement gets executed.
+             */
+            typedef void(*statement_observer_t)(const std::string& /* sql */, std::chrono::nanoseconds /* duration */);
+            statement_observer_t statement_observer{nullptr};
+
+            template <typename callback_t>
+            inline result observe_statement(const std::shared_ptr<CommandData>& /* command */, const callback_t& /* execute */);
         protected:
             virtual std::shared_ptr<CommandData> allocateCommandData() = 0;
             virtual std::shared_ptr<CommandData> copyCommandData(std::shared_ptr<CommandData>) = 0;
@@ -366,7 +376,9 @@ namespace sql {
             ~command() override = default;;
 
             result execute() {
-                return this->_data->handle->executeCommand(this->_data);
+                return this->_data->handle->observe_statement(this->_data, [&]{
+                    return this->_data->handle->executeCommand(this->_data);
+                });
             }
 
             threads::Future<result> executeLater();
@@ -408,10 +420,24 @@ namespace sql {
                 auto standard_return = ret_transformer::transform(callback);
                 auto standard_function = args_transformer::transform(standard_return, SQL_FWD(parms)...);
 
-                return this->_data->handle->queryCommand(this->_data, standard_function);
+                return this->_data->handle->observe_statement(this->_data, [&]{
+                    return this->_data->handle->queryCommand(this->_data, standard_function);
+                });
             }
     };
 
+    template <typename callback_t>
+    inline result SqlManager::observe_statement(const std::shared_ptr<CommandData>& command, const callback_t& execute) {
+        if(!this->statement_observer) {
+            return execute();
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        auto result = execute();
+        this->statement_observer(command->sql_command, std::chrono::steady_clock::now() - begin);
+        return result;
+    }
+
     class AsyncSqlPool {
         public:
             explicit AsyncSqlPool(size_t threads);
@@ -0,0 +1,90 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <protocol/AcknowledgeManager.h>
+
+using namespace ts::connection;
+using namespace ts::protocol;
+using namespace std::chrono;
+
+static size_t destroyed_packets{0};
+static size_t failed_packets{0};
+
+void send_packets(AcknowledgeManager& manager, PacketType type, uint32_t begin, uint32_t end) {
+    for(auto id{begin}; id < end; id++) {
+        manager.process_packet(type, id, nullptr, nullptr);
+    }
+}
+
+int main() {
+    {
+        AcknowledgeManager manager{};
+        manager.destroy_packet = [](void*) { destroyed_packets++; };
+        manager.callback_resend_failed = [](void*, const auto&) { failed_packets++; };
+
+        /* more packets than the window size to test the overflow list */
+        auto begin = system_clock::now();
+        send_packets(manager, PacketType::COMMAND, 0, 600);
+        send_packets(manager, PacketType::COMMAND_LOW, 0, 10);
+        assert(manager.awaiting_acknowledge() == 610);
+
+        std::string error{};
+        std::deque<std::shared_ptr<AcknowledgeManager::Entry>> buffers{};
+
+        /* Nothing is due yet. The initial RTO is one second. */
+        auto next = begin + seconds(10);
+        manager.execute_resend(begin, next, buffers);
+        assert(buffers.empty());
+        assert(next > begin + milliseconds(900) && next < begin + milliseconds(1100));
+
+        for(uint16_t id{0}; id < 300; id++) {
+            assert(manager.process_acknowledge(PacketType::ACK, id, error));
+        }
+        assert(manager.process_acknowledge(PacketType::ACK_LOW, 5, error));
+        assert(!manager.process_acknowledge(PacketType::ACK_LOW, 5, error));
+        assert(!manager.process_acknowledge(PacketType::ACK, 1000, error));
+        assert(manager.awaiting_acknowledge() == 309);
+        assert(destroyed_packets == 301);
+
+        /* every packet which hasn't been acknowledged must be resend exactly once */
+        next = begin + seconds(10);
+        manager.execute_resend(begin + milliseconds(1100), next, buffers);
+        assert(buffers.size() == 309);
+        assert(next > begin + milliseconds(1100));
+
+        buffers.clear();
+        next = begin + seconds(10);
+        manager.execute_resend(begin + milliseconds(1200), next, buffers);
+        assert(buffers.empty());
+
+        /* The packet has been send twice. The entry will be kept for the second acknowledge. */
+        assert(manager.process_acknowledge(PacketType::ACK, 300, error));
+        assert(manager.awaiting_acknowledge() == 309);
+        assert(manager.process_acknowledge(PacketType::ACK, 300, error));
+        assert(manager.awaiting_acknowledge() == 308);
+
+        /* An acknowledged packet gets dropped after some time even if the second acknowledge never arrives */
+        assert(manager.process_acknowledge(PacketType::ACK, 301, error));
+        manager.execute_resend(begin + seconds(8), next, buffers);
+        assert(manager.awaiting_acknowledge() == 307);
+        assert(buffers.size() == 307);
+
+        /* Resends should fail after 15 seconds if a packet has been resend too often */
+        for(auto& buffer : buffers) {
+            buffer->resend_count = 16;
+        }
+        buffers.clear();
+        manager.execute_resend(begin + seconds(20), next, buffers);
+        assert(buffers.empty());
+        assert(failed_packets == 307);
+        assert(manager.awaiting_acknowledge() == 0);
+
+        send_packets(manager, PacketType::COMMAND, 0x10000, 0x10010);
+        assert(manager.process_acknowledge(PacketType::ACK, 0x0005, error));
+        assert(manager.awaiting_acknowledge() == 15);
+    }
+
+    assert(destroyed_packets == 626);
+    std::cout << "Acknowledge manager test passed" << std::endl;
+    return 0;
+}
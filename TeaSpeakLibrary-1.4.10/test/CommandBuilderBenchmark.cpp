@@ -0,0 +1,161 @@
+#include <iostream>
+#include <chrono>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <src/query/command3.h>
+
+using namespace ts;
+
+/*
+ * Compares the ts::command_builder with the ts::command_arena_builder for a large clientlist like response.
+ * Every heap allocation is counted via the global operator new.
+ */
+static std::atomic<size_t> allocation_count{0};
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if(auto result = std::malloc(size ? size : 1); result) {
+        return result;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+
+enum ClientKind : uint8_t {
+    VOICE,
+    QUERY
+};
+DEFINE_CONVERTER_ENUM(ClientKind, uint8_t);
+
+/* writes the same entries into both builders */
+template <typename writer_t>
+void write_clients(size_t client_count, writer_t&& put) {
+    for(size_t index{0}; index < client_count; index++) {
+        put(index, "clid", (uint16_t) (index + 1));
+        put(index, "cid", (uint64_t) (index % 20));
+        put(index, "client_database_id", (uint64_t) (index * 7 + 2));
+        put(index, "client_nickname", std::string_view{"Some user name | with spaces"});
+        put(index, "client_type", index % 2 ? ClientKind::QUERY : ClientKind::VOICE);
+        put(index, "client_unique_identifier", std::string_view{"zvmWMKeIJzHqB9VuXEC/ZYwZnJE="});
+        put(index, "client_away", false);
+        put(index, "client_away_message", std::string_view{});
+        put(index, "client_idle_time", (int64_t) -12);
+        put(index, "client_servergroups", std::string_view{"6,7,8"});
+    }
+}
+
+/* the arena builder is written sequentially, start a new bulk as soon as the index changes */
+auto arena_writer(command_arena_builder& builder) {
+    return [&builder, current_index = (size_t) 0](size_t index, const std::string_view& key, const auto& value) mutable {
+        if(index != current_index) {
+            builder.next_bulk();
+            current_index = index;
+        }
+        builder.put(key, value);
+    };
+}
+
+void test_equivalence() {
+    command_builder builder{"notifyclientlist"};
+    command_arena_builder arena{"notifyclientlist"};
+
+    write_clients(3, [&](size_t index, const std::string_view& key, const auto& value) {
+        builder.put_unchecked(index, key, value);
+    });
+    write_clients(3, arena_writer(arena));
+
+    assert(arena.bulk_count() == 3);
+    assert(builder.build() == arena.view());
+
+    command_parser parser{arena.view()};
+    [[maybe_unused]] auto parsed = parser.parse(true);
+    assert(parsed);
+    assert(parser.bulk_count() == 3);
+    assert(parser[2].value_as<uint16_t>("clid") == 3);
+    assert(parser[1].value("client_nickname") == "Some user name | with spaces");
+    assert(arena.bulk(1) == parser.payload_view(1).substr(0, arena.bulk(1).size()));
+
+    /* empty bulks will be skipped and an empty identifier doesn't add a separator */
+    command_arena_builder empty{""};
+    empty.next_bulk();
+    empty.put("a", 1.5f);
+    empty.next_bulk();
+    empty.next_bulk();
+    empty.put("b", "x y");
+    assert(empty.view() == "a=1.500000|b=x\\sy");
+    assert(empty.bulk(0) == "a=1.500000");
+    assert(empty.bulk(1) == "b=x\\sy");
+}
+
+void test_floating_point() {
+    command_builder builder{"test"};
+    command_arena_builder arena{"test"};
+
+    auto put = [&](const std::string_view& key, const auto& value) {
+        builder.put_unchecked(0, key, value);
+        arena.put(key, value);
+    };
+    put("a", 0.5f);
+    put("b", 1.0 / 3.0);
+    put("c", -2.25);
+    put("d", 1e-9);
+    put("e", 12345678.875);
+    put("f", 1e300);
+
+    /* values which don't fit into the format buffer will be formatted equally as well */
+    assert(builder.build() == arena.view());
+    assert(arena.view().starts_with("test a=0.500000 b=0.333333 c=-2.250000 d=0.000000 e=12345678.875000 f=1"));
+}
+
+void benchmark(size_t client_count) {
+    constexpr size_t kIterations{2000};
+
+    auto print_result = [&](const std::string& name, const std::chrono::steady_clock::duration& duration, size_t allocations) {
+        auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        std::cout << "  " << client_count << " clients " << name << ": " << (double) microseconds / kIterations << "us, " << (double) allocations / kIterations << " allocations per response" << std::endl;
+    };
+
+    size_t sink{0};
+    {
+        auto allocations = allocation_count.load();
+        auto begin = std::chrono::steady_clock::now();
+        for(size_t iteration{0}; iteration < kIterations; iteration++) {
+            command_builder builder{"", 1024, client_count};
+            write_clients(client_count, [&](size_t index, const std::string_view& key, const auto& value) {
+                builder.put_unchecked(index, key, value);
+            });
+            sink += builder.build().size();
+        }
+        print_result("ts::command_builder", std::chrono::steady_clock::now() - begin, allocation_count.load() - allocations);
+    }
+
+    {
+        auto allocations = allocation_count.load();
+        auto begin = std::chrono::steady_clock::now();
+        for(size_t iteration{0}; iteration < kIterations; iteration++) {
+            command_arena_builder builder{"", client_count * 256, client_count};
+            write_clients(client_count, arena_writer(builder));
+            sink += builder.view().size();
+        }
+        print_result("ts::command_arena_builder", std::chrono::steady_clock::now() - begin, allocation_count.load() - allocations);
+    }
+
+    if(sink == 0) {
+        std::cout << "Empty responses" << std::endl;
+    }
+}
+
+int main() {
+    test_equivalence();
+    test_floating_point();
+
+    std::cout << "Benchmark:" << std::endl;
+    for(size_t client_count : {10, 100, 1000}) {
+        benchmark(client_count);
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include <iostream>
+#include <chrono>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <src/query/Command.h>
+#include <src/query/command3.h>
+
+using namespace ts;
+
+/*
+ * Compares the legacy ts::Command with the ts::command_parser view for the hottest client commands.
+ * Every heap allocation is counted via the global operator new.
+ */
+static std::atomic<size_t> allocation_count{0};
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if(auto result = std::malloc(size ? size : 1); result) {
+        return result;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+
+struct BenchmarkCommand {
+    std::string_view name;
+    std::string_view payload;
+    /* consumes the command like the handler would do */
+    void(*legacy)(Command&);
+    void(*parser)(const command_parser&);
+};
+
+static volatile uint64_t sink{0};
+
+static const BenchmarkCommand kCommands[]{
+    {
+        "clientupdate",
+        "clientupdate client_input_muted=1 client_output_muted=0 client_away=0 client_away_message return_code=1:4f",
+        [](Command& command) {
+            for(const auto& key : command[0].keys()) {
+                sink += command[key].string().length();
+            }
+        },
+        [](const command_parser& command) {
+            size_t index{0};
+            std::string_view key{};
+            std::string value{};
+            while(command[0].next_entry(index, key, value)) {
+                sink += value.length();
+            }
+        }
+    },
+    {
+        "sendtextmessage",
+        "sendtextmessage targetmode=2 target=12 msg=Hello\\sworld,\\sthis\\sis\\sa\\schat\\smessage return_code=1:50",
+        [](Command& command) {
+            sink += command["targetmode"].as<uint8_t>();
+            sink += command["target"].as<uint64_t>();
+            sink += command["msg"].string().length();
+        },
+        [](const command_parser& command) {
+            sink += command[0].value_as<uint8_t>("targetmode");
+            sink += command[0].value_as<uint64_t>("target");
+            sink += command[0].value("msg").length();
+        }
+    },
+    {
+        "clientmove",
+        "clientmove clid=3 cid=17 cpw return_code=1:51",
+        [](Command& command) {
+            sink += command["cid"].as<uint64_t>();
+            sink += command["cpw"].string().length();
+            for(size_t index{0}; index < command.bulkCount(); index++) {
+                sink += command[index]["clid"].as<uint16_t>();
+            }
+        },
+        [](const command_parser& command) {
+            sink += command[0].value_as<uint64_t>("cid");
+            sink += command[0].value_raw("cpw").length();
+            for(size_t index{0}; index < command.bulk_count(); index++) {
+                sink += command[index].value_as<uint16_t>("clid");
+            }
+        }
+    },
+    {
+        "channelsubscribe",
+        "channelsubscribe cid=1|cid=2|cid=3|cid=4|cid=5|cid=6|cid=7|cid=8 return_code=1:52",
+        [](Command& command) {
+            for(size_t index{0}; index < command.bulkCount(); index++) {
+                sink += command[index]["cid"].as<uint64_t>();
+            }
+        },
+        [](const command_parser& command) {
+            for(size_t index{0}; index < command.bulk_count(); index++) {
+                sink += command[index].value_as<uint64_t>("cid");
+            }
+        }
+    },
+};
+
+void test_equivalence() {
+    /* both paths must see the same values */
+    auto legacy = Command::parse("sendtextmessage targetmode=2 target=12 msg=a\\sb\\pc", true, true);
+    command_parser parser{std::string_view{"sendtextmessage targetmode=2 target=12 msg=a\\sb\\pc"}};
+    [[maybe_unused]] auto parser_parsed = parser.parse(true);
+    assert(parser_parsed);
+    assert(parser.identifier() == legacy.command());
+    assert(parser[0].value_as<uint64_t>("target") == legacy["target"].as<uint64_t>());
+    assert(parser[0].value("msg") == legacy["msg"].string());
+
+    command_parser bulked{std::string_view{"channelsubscribe cid=1|cid=2|cid=3"}};
+    [[maybe_unused]] auto bulked_parsed = bulked.parse(true);
+    assert(bulked_parsed);
+    assert(bulked.bulk_count() == 3);
+    assert(bulked[2].value_as<uint64_t>("cid") == 3);
+
+    /* numbers containing escape sequences have to be unescaped like the legacy command does */
+    auto legacy_escaped = Command::parse("clientmove cid=\\s5", true, true);
+    command_parser escaped{std::string_view{"clientmove cid=\\s5"}};
+    [[maybe_unused]] auto escaped_parsed = escaped.parse(true);
+    assert(escaped_parsed);
+    assert(escaped[0].value_as<uint64_t>("cid") == legacy_escaped["cid"].as<uint64_t>());
+
+    /* the parser must not reference the moved short string */
+    command_parser owned{std::string{"a b=1"}};
+    [[maybe_unused]] auto owned_parsed = owned.parse(true);
+    assert(owned_parsed);
+    assert(owned[0].value_as<int>("b") == 1);
+}
+
+void benchmark(const BenchmarkCommand& command) {
+    constexpr size_t kIterations{200000};
+
+    auto print_result = [&](const std::string& name, const std::chrono::steady_clock::duration& duration, size_t allocations) {
+        auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        std::cout << "  " << command.name << " " << name << ": " << nanoseconds / kIterations << "ns, " << (double) allocations / kIterations << " allocations per command" << std::endl;
+    };
+
+    {
+        auto allocations = allocation_count.load();
+        auto begin = std::chrono::steady_clock::now();
+        for(size_t index{0}; index < kIterations; index++) {
+            auto parsed = Command::parse(command.payload, true, true);
+            command.legacy(parsed);
+        }
+        print_result("ts::Command", std::chrono::steady_clock::now() - begin, allocation_count.load() - allocations);
+    }
+
+    {
+        auto allocations = allocation_count.load();
+        auto begin = std::chrono::steady_clock::now();
+        for(size_t index{0}; index < kIterations; index++) {
+            command_parser parser{command.payload};
+            (void) parser.parse(true);
+            command.parser(parser);
+        }
+        print_result("ts::command_parser", std::chrono::steady_clock::now() - begin, allocation_count.load() - allocations);
+    }
+}
+
+int main() {
+    test_equivalence();
+
+    std::cout << "Benchmark:" << std::endl;
+    for(const auto& command : kCommands) {
+        benchmark(command);
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cassert>
+#include <cstring>
+#include <tomcrypt.h>
+#include <protocol/CryptEAX.h>
+
+using namespace ts::connection;
+
+struct TestVector {
+    std::vector<uint8_t> key;
+    std::vector<uint8_t> nonce;
+    std::vector<uint8_t> header;
+    std::vector<uint8_t> plain;
+    std::vector<uint8_t> cipher;
+    std::vector<uint8_t> tag; /* full 16 byte tag, we only compare the first 8 bytes */
+};
+
+/* Test vectors from the EAX paper (Bellare, Rogaway, Wagner) and the libtomcrypt self test */
+static const std::vector<TestVector> kTestVectors{
+    {
+        {0x23, 0x39, 0x52, 0xDE, 0xE4, 0xD5, 0xED, 0x5F, 0x9B, 0x9C, 0x6D, 0x6F, 0xF8, 0x0F, 0xF4, 0x78},
+        {0x62, 0xEC, 0x67, 0xF9, 0xC3, 0xA4, 0xA4, 0x07, 0xFC, 0xB2, 0xA8, 0xC4, 0x90, 0x31, 0xA8, 0xB3},
+        {0x6B, 0xFB, 0x91, 0x4F, 0xD0, 0x7E, 0xAE, 0x6B},
+        {},
+        {},
+        {0xE0, 0x37, 0x83, 0x0E, 0x83, 0x89, 0xF2, 0x7B, 0x02, 0x5A, 0x2D, 0x65, 0x27, 0xE7, 0x9D, 0x01}
+    },
+    {
+        {0x91, 0x94, 0x5D, 0x3F, 0x4D, 0xCB, 0xEE, 0x0B, 0xF4, 0x5E, 0xF5, 0x22, 0x55, 0xF0, 0x95, 0xA4},
+        {0xBE, 0xCA, 0xF0, 0x43, 0xB0, 0xA2, 0x3D, 0x84, 0x31, 0x94, 0xBA, 0x97, 0x2C, 0x66, 0xDE, 0xBD},
+        {0xFA, 0x3B, 0xFD, 0x48, 0x06, 0xEB, 0x53, 0xFA},
+        {0xF7, 0xFB},
+        {0x19, 0xDD},
+        {0x5C, 0x4C, 0x93, 0x31, 0x04, 0x9D, 0x0B, 0xDA, 0xB0, 0x27, 0x74, 0x08, 0xF6, 0x79, 0x67, 0xE5}
+    },
+    {
+        {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f},
+        {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f},
+        {},
+        {},
+        {},
+        {0x1c, 0xe1, 0x0d, 0x3e, 0xff, 0xd4, 0xca, 0xdb, 0xe2, 0xe4, 0x4b, 0x58, 0xd6, 0x0a, 0xb9, 0xec}
+    },
+    {
+        {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f},
+        {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f},
+        {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f},
+        {
+            0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+            0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f
+        },
+        {
+            0x29, 0xd8, 0x78, 0xd1, 0xa3, 0xbe, 0x85, 0x7b, 0x6f, 0xb8, 0xc8, 0xea, 0x59, 0x50, 0xa7, 0x78,
+            0x33, 0x1f, 0xbf, 0x2c, 0xcf, 0x33, 0x98, 0x6f, 0x35, 0xe8, 0xcf, 0x12, 0x1d, 0xcb, 0x30, 0xbc
+        },
+        {0x4f, 0xbe, 0x03, 0x38, 0xbe, 0x1c, 0x8c, 0x7e, 0x1d, 0x7a, 0xe7, 0xe4, 0x5b, 0x92, 0xc5, 0x87}
+    }
+};
+
+void test_vectors() {
+    for(const auto& vector : kTestVectors) {
+        std::string error{};
+        uint8_t tag[eax::kTagLength];
+
+        std::vector<uint8_t> buffer{vector.plain};
+        assert(eax::encrypt(vector.key.data(), vector.nonce.data(), vector.header.data(), vector.header.size(), buffer.data(), buffer.data(), buffer.size(), tag, error));
+        assert(buffer == vector.cipher);
+        assert(memcmp(tag, vector.tag.data(), eax::kTagLength) == 0);
+
+        assert(eax::decrypt(vector.key.data(), vector.nonce.data(), vector.header.data(), vector.header.size(), buffer.data(), buffer.data(), buffer.size(), tag, error));
+        assert(buffer == vector.plain);
+
+        /* A modified tag must be rejected without touching the payload */
+        buffer = vector.cipher;
+        tag[3] ^= 0x01U;
+        assert(!eax::decrypt(vector.key.data(), vector.nonce.data(), vector.header.data(), vector.header.size(), buffer.data(), buffer.data(), buffer.size(), tag, error));
+        assert(buffer == vector.cipher);
+    }
+}
+
+/* Compare against the libtomcrypt EAX implementation for all payload lengths used by the protocol */
+void test_equivalence(int cipher) {
+    std::mt19937 random{42};
+    auto random_bytes = [&](size_t length) {
+        std::vector<uint8_t> result(length);
+        for(auto& byte : result) {
+            byte = (uint8_t) random();
+        }
+        return result;
+    };
+
+    for(size_t length{1}; length <= 600; length++) {
+        auto key = random_bytes(16);
+        auto nonce = random_bytes(16);
+        auto header = random_bytes(5);
+        auto plain = random_bytes(length);
+
+        std::vector<uint8_t> expected_cipher(length);
+        uint8_t expected_tag[16];
+        unsigned long expected_tag_length{sizeof(expected_tag)};
+        auto err = eax_encrypt_authenticate_memory(cipher, key.data(), 16, nonce.data(), 16, header.data(), header.size(), plain.data(), length, expected_cipher.data(), expected_tag, &expected_tag_length);
+        assert(err == CRYPT_OK);
+
+        std::string error{};
+        std::vector<uint8_t> buffer(length);
+        uint8_t tag[eax::kTagLength];
+        assert(eax::encrypt(key.data(), nonce.data(), header.data(), header.size(), plain.data(), buffer.data(), length, tag, error));
+        assert(buffer == expected_cipher);
+        assert(memcmp(tag, expected_tag, eax::kTagLength) == 0);
+
+        assert(eax::decrypt(key.data(), nonce.data(), header.data(), header.size(), buffer.data(), buffer.data(), length, tag, error));
+        assert(buffer == plain);
+    }
+}
+
+void benchmark(int cipher, size_t payload_length) {
+    constexpr size_t kIterations{200000};
+
+    uint8_t key[16]{1, 2, 3}, nonce[16]{4, 5, 6}, header[5]{7, 8, 9}, tag[16];
+    std::vector<uint8_t> payload(payload_length, 0xAA);
+    std::string error{};
+
+    auto print_result = [&](const std::string& name, const std::chrono::steady_clock::duration& duration) {
+        auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        std::cout << "  " << name << " (" << payload_length << " bytes): " << nanoseconds / kIterations << "ns per packet" << std::endl;
+    };
+
+    {
+        auto begin = std::chrono::steady_clock::now();
+        for(size_t index{0}; index < kIterations; index++) {
+            unsigned long tag_length{sizeof(tag)};
+            key[0] = (uint8_t) index; /* the packet id is part of the key */
+            eax_encrypt_authenticate_memory(cipher, key, 16, nonce, 16, header, 5, payload.data(), payload.size(), payload.data(), tag, &tag_length);
+        }
+        print_result("eax_encrypt_authenticate_memory", std::chrono::steady_clock::now() - begin);
+    }
+
+    for(auto backend : {eax::Backend::TOMCRYPT, eax::Backend::AESNI}) {
+        if(!eax::select_backend(backend)) {
+            continue;
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        for(size_t index{0}; index < kIterations; index++) {
+            key[0] = (uint8_t) index;
+            eax::encrypt(key, nonce, header, 5, payload.data(), payload.data(), payload.size(), tag, error);
+        }
+        print_result(std::string{"eax::encrypt "} + eax::backend_name(backend), std::chrono::steady_clock::now() - begin);
+    }
+}
+
+int main() {
+    register_cipher(&rijndael_desc);
+    auto cipher = find_cipher("rijndael");
+    assert(cipher >= 0);
+
+    for(auto backend : {eax::Backend::TOMCRYPT, eax::Backend::AESNI}) {
+        if(!eax::select_backend(backend)) {
+            std::cout << "Skipping EAX backend " << eax::backend_name(backend) << " (not supported)" << std::endl;
+            continue;
+        }
+
+        std::cout << "Testing EAX backend " << eax::backend_name(backend) << std::endl;
+        test_vectors();
+        test_equivalence(cipher);
+    }
+
+    std::cout << "Benchmark:" << std::endl;
+    for(size_t payload_length : {64, 200, 500}) {
+        benchmark(cipher, payload_length);
+    }
+    return 0;
+}
@@ -0,0 +1,299 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cassert>
+#include <optional>
+#include <stdexcept>
+#include <src/query/escape.h>
+
+using namespace ts;
+using namespace std;
+
+/* The previous scalar implementations which the new kernels have to be equivalent to */
+namespace legacy {
+    std::string escape(std::string in) {
+        size_t index = 0;
+        while(index < in.length()) {
+            if(in[index] == '\\')
+                in.replace(index, 1, "\\\\", 2);
+            else if(in[index] == ' ')
+                in.replace(index, 1, "\\s", 2);
+            else if(in[index] == '/')
+                in.replace(index, 1, "\\/", 2);
+            else if(in[index] == '|')
+                in.replace(index, 1, "\\p", 2);
+            else if(in[index] == '\b')
+                in.replace(index, 1, "\\b", 2);
+            else if(in[index] == '\f')
+                in.replace(index, 1, "\\f", 2);
+            else if(in[index] == '\n')
+                in.replace(index, 1, "\\n", 2);
+            else if(in[index] == '\r')
+                in.replace(index, 1, "\\r", 2);
+            else if(in[index] == '\t')
+                in.replace(index, 1, "\\t", 2);
+            else if(in[index] == '\x07')
+                in.replace(index, 1, "\\a", 2);
+            else if(in[index] == '\x0B')
+                in.replace(index, 1, "\\v", 2);
+            else {
+                index += 1;
+                continue;
+            }
+            index += 2;
+        }
+
+        return in;
+    }
+
+    std::string unescape(std::string in, bool throw_error) {
+        size_t index = 0;
+        while(index < in.length()){
+            if(in[index] == '\\'){
+                if(in.length() <= index + 1) break;
+                char replace = 0;
+
+                switch (in[index + 1]){
+                    case 's': replace = ' '; break;
+                    case '/': replace = '/'; break;
+                    case 'p': replace = '|'; break;
+                    case 'b': replace = '\b'; break;
+                    case 'f': replace = '\f'; break;
+                    case 'n': replace = '\n'; break;
+                    case 'r': replace = '\r'; break;
+                    case 't': replace = '\t'; break;
+                    case 'a': replace = '\x07'; break;
+                    case 'v': replace = '\x0B'; break;
+                    case '\\': replace = '\\'; break;
+                    default:
+                        replace = '\x00'; break;
+                }
+                if(replace != 0x00)
+                    in.replace(index, 2, string(&replace, 1));
+            }
+
+            uint8_t current = (uint8_t) in[index];
+            if(in.length() - index >= 6) { //Check for CESU-8
+                if((current == 0xED) && ((uint8_t) in[index + 3] == 0xED) && ((((uint8_t) in[index + 1] | 0xF) == 0xAF)) && ((((uint8_t) in[index + 4] | 0xF) == 0xBF))){
+                    char replaced[4];
+
+                    replaced[0] = (((((uint8_t) in[index + 1] & 0xF) + 1) >> 2) & 7) | 0xF0;
+                    replaced[1] = ((((uint8_t) in[index + 2] >> 2) & 0xF) + (((((uint8_t) in[index + 1] & 0xF)) + (1 << 4)) | 0x80));
+                    replaced[2] = (((uint8_t) in[index + 4] & 0xF) + (((uint8_t) in[index + 2] << 4) & 0x30)) | 0x80;
+                    replaced[3] = ((uint8_t) in[index + 5]);
+
+                    in.replace(index, 6, string(replaced, 4));
+                    index -= 2;
+
+                    index += 5;
+                }
+            }
+            if(current >= 128) {
+                if(current >= 192 && (current <= 193 || current >= 245)) {
+                    in.replace(index, 1, "", 0);
+                    index--;
+                } else if(current >= 194 && current <= 223) {
+                    if(in.length() - index <= 1) {
+                        in.replace(index, in.length() - index, "", 0);
+                    } else if((uint8_t) in[index + 1] >= 128 && (uint8_t) in[index + 1] <= 191) {
+                        index += 1;
+                    } else {
+                        if(throw_error) {
+                            throw invalid_argument("Invalid UTF-8 character at index " + to_string(index));
+                        }
+
+                        in.replace(index, 2, "", 0);
+                        index--;
+                    }
+                } else if(current >= 224 && current <= 239) {
+                    if(in.length() - index <= 2) {
+                        in.replace(index, in.length() - index, "", 0);
+                    } else if((uint8_t) in[index + 1] >= 128 && (uint8_t) in[index + 1] <= 191 &&
+                            (uint8_t) in[index + 2] >= 128 && (uint8_t) in[index + 2] <= 191) {
+                        index += 2;
+                    } else {
+                        if(throw_error) {
+                            throw invalid_argument("Invalid UTF-8 character at index " + to_string(index));
+                        }
+
+                        in.replace(index, 3, "", 0);
+                        index--;
+                    }
+                } else if(current >= 240 && current <= 244) {
+                    if(in.length() - index <= 3) {
+                        in.replace(index, in.length() - index, "", 0);
+                    } else if((uint8_t) in[index + 1] >= 128 && (uint8_t) in[index + 1] <= 191 &&
+                            (uint8_t) in[index + 2] >= 128 && (uint8_t) in[index + 2] <= 191 &&
+                            (uint8_t) in[index + 3] >= 128 && (uint8_t) in[index + 3] <= 191) {
+                        index += 3;
+                    } else {
+                        if(throw_error) {
+                            throw invalid_argument("Invalid UTF-8 character at index " + to_string(index));
+                        }
+
+                        in.replace(index, 4, "", 0);
+                        index--;
+                    }
+                } else {
+                    if(throw_error) {
+                        throw invalid_argument("Invalid UTF-8 character at index " + to_string(index));
+                    }
+
+                    in.replace(index, 1, "", 0);
+                    index--;
+                }
+            } else if(current < 0x0A) {
+                in.replace(index, 1, " ", 1);
+            }
+            index++;
+        }
+        return in;
+    }
+}
+
+/* Bytes which are likely to trigger special handling, mixed with plain ASCII */
+static const std::string kInterestingBytes{
+    "\\\\\\\\ /|spbfnrtav\x01\x07\x08\x09\x0A\x0B\x0C\x0D"
+    "\x80\xA0\xAF\xB0\xBF\xC0\xC1\xC2\xDF\xE0\xED\xEF\xF0\xF4\xF5\xFF"
+};
+
+std::string random_input(std::mt19937& random) {
+    std::uniform_int_distribution<size_t> length_distribution{0, 3};
+    size_t length;
+    switch(length_distribution(random)) {
+        case 0: length = random() % 8; break;
+        case 1: length = random() % 40; break;
+        case 2: length = random() % 100; break;
+        default: length = random() % 400; break;
+    }
+
+    /* the density of special bytes varies so we hit the all plain blocks as well */
+    auto special_density = random() % 101;
+
+    std::string result{};
+    while(result.length() < length) {
+        if(random() % 100 >= special_density) {
+            result += (char) ('A' + random() % 58);
+        } else if(random() % 16 == 0) {
+            /* a (not necessarily valid) CESU-8 surrogate pair */
+            result += '\xED';
+            result += (char) (0xA0 | (random() % 16));
+            result += (char) (0x80 | (random() % 64));
+            result += '\xED';
+            result += (char) (0xB0 | (random() % 16));
+            result += (char) (0x80 | (random() % 80));
+        } else if(random() % 8 == 0) {
+            result += (char) (random() % 256);
+        } else {
+            result += kInterestingBytes[random() % kInterestingBytes.length()];
+        }
+    }
+    return result;
+}
+
+std::optional<std::string> unescape_or_error(std::string(*function)(std::string, bool), const std::string& input, bool throw_error, std::string& error) {
+    try {
+        return function(input, throw_error);
+    } catch(std::invalid_argument& ex) {
+        error = ex.what();
+        return std::nullopt;
+    }
+}
+
+void test_vectors() {
+    assert(query::escape("") == "");
+    assert(query::escape("hello world|a/b\\c") == "hello\\sworld\\pa\\/b\\\\c");
+    assert(query::escape("\a\b\t\n\v\f\r") == "\\a\\b\\t\\n\\v\\f\\r");
+    assert(query::unescape("hello\\sworld\\pa\\/b\\\\c", true) == "hello world|a/b\\c");
+    assert(query::unescape("a\\", true) == "a\\");
+    assert(query::unescape("a\\xb", true) == "a\\xb");
+    assert(query::unescape("\xC3\xA4\xE2\x82\xAC", true) == "\xC3\xA4\xE2\x82\xAC");
+
+    std::string appended{"key="};
+    query::escape_append(appended, "a b");
+    assert(appended == "key=a\\sb");
+    assert(query::escaped_length("a b|c") == 7);
+}
+
+void test_equivalence(size_t iterations) {
+    std::mt19937 random{42};
+
+    for(size_t iteration{0}; iteration < iterations; iteration++) {
+        auto input = random_input(random);
+
+        auto expected_escaped = legacy::escape(input);
+        if(query::escape(input) != expected_escaped || query::escaped_length(input) != expected_escaped.length()) {
+            std::cerr << "Escape mismatch for input of length " << input.length() << std::endl;
+            abort();
+        }
+
+        /* escaping and unescaping an ASCII string has to be lossless */
+        for(bool throw_error : {false, true}) {
+            for(const auto& value : {input, expected_escaped}) {
+                std::string expected_error{}, error{};
+                auto expected = unescape_or_error(legacy::unescape, value, throw_error, expected_error);
+                auto result = unescape_or_error(query::unescape, value, throw_error, error);
+                if(expected != result || expected_error != error) {
+                    std::cerr << "Unescape mismatch for input of length " << value.length() << " (throw: " << throw_error << ")" << std::endl;
+                    std::cerr << "  expected: " << (expected ? *expected : expected_error) << std::endl;
+                    std::cerr << "  result:   " << (result ? *result : error) << std::endl;
+                    abort();
+                }
+            }
+        }
+    }
+}
+
+void benchmark(size_t length) {
+    constexpr size_t kIterations{20000};
+
+    /* a channel description like text */
+    std::string plain{};
+    while(plain.length() < length) {
+        plain += "Welcome to our channel! Please read the rules/guidelines | no spam\n";
+    }
+    plain.resize(length);
+    auto escaped = query::escape(plain);
+
+    auto measure = [&](const std::string& name, auto&& callback) {
+        size_t sink{0};
+        auto begin = std::chrono::steady_clock::now();
+        for(size_t index{0}; index < kIterations; index++) {
+            sink += callback().length();
+        }
+        auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << "  " << name << " (" << length << " bytes): " << nanoseconds / kIterations << "ns" << (sink == 0 ? " " : "") << std::endl;
+    };
+
+    measure("legacy escape", [&]{ return legacy::escape(plain); });
+    measure("escape", [&]{ return query::escape(plain); });
+    measure("legacy unescape", [&]{ return legacy::unescape(escaped, false); });
+    measure("unescape", [&]{ return query::unescape(escaped, false); });
+}
+
+int main() {
+    for(auto backend : {query::EscapeBackend::SCALAR, query::EscapeBackend::SSE2, query::EscapeBackend::AVX2}) {
+        if(!query::select_escape_backend(backend)) {
+            std::cout << "Skipping escape backend " << query::escape_backend_name(backend) << " (not supported)" << std::endl;
+            continue;
+        }
+
+        std::cout << "Testing escape backend " << query::escape_backend_name(backend) << std::endl;
+        test_vectors();
+        test_equivalence(200000);
+    }
+
+    std::cout << "Benchmark:" << std::endl;
+    for(auto backend : {query::EscapeBackend::SCALAR, query::EscapeBackend::SSE2, query::EscapeBackend::AVX2}) {
+        if(!query::select_escape_backend(backend)) {
+            continue;
+        }
+
+        std::cout << " Backend " << query::escape_backend_name(backend) << std::endl;
+        for(size_t length : {32, 256, 4096}) {
+            benchmark(length);
+        }
+    }
+    return 0;
+}